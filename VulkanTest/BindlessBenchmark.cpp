@@ -0,0 +1,537 @@
+#include "BindlessBenchmark.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	//matches DrawData in bindless.vert (std430)
+	struct DrawData {
+		float rect[4];
+		uint32_t material;
+		uint32_t pad[3];
+	};
+}
+
+BindlessBenchmark::BindlessBenchmark(const BindlessBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void BindlessBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("BindlessBenchmark");
+	createDevice();
+	try {
+		createTextures();
+		createDrawData();
+		createDescriptors();
+		target = context.createOffscreenTarget(extent, VK_FORMAT_R8G8B8A8_UNORM, true);
+		createPipelines();
+		context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+
+		std::cout << "bindless benchmark: " << context.properties.deviceName << ", " << textures.size() << " materials, "
+			<< settings.draws << " draws, " << settings.frames << " frames" << std::endl;
+		std::vector<uint8_t> boundImage, bindlessImage;
+		runPath(Path::Bound, "per material sets", boundImage);
+		runPath(Path::Bindless, "bindless        ", bindlessImage);
+
+		size_t mismatched = 0;
+		for (size_t i = 0; i < boundImage.size(); i++) {
+			mismatched += boundImage[i] != bindlessImage[i];
+		}
+		if (mismatched != 0) {
+			throw std::runtime_error("bindless benchmark failed, the two paths rendered different images (" + std::to_string(mismatched) + " bytes differ)!");
+		}
+		std::cout << "  both paths rendered identical images" << std::endl;
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+/*
+	Vulkan 1.2 for descriptor indexing in core, plus multiDrawIndirect and drawIndirectFirstInstance when available
+*/
+void BindlessBenchmark::createDevice()
+{
+	context.createInstance("Bindless Benchmark", VK_API_VERSION_1_2);
+
+	VkPhysicalDeviceDescriptorIndexingFeatures indexing = {};
+	indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	VkPhysicalDeviceFeatures2 supported = {};
+	supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supported.pNext = &indexing;
+	vkGetPhysicalDeviceFeatures2(context.physicalDevice, &supported);
+
+	if (!BindlessTextures::supported(indexing)) {
+		throw std::runtime_error("failed to run bindless benchmark, descriptor indexing is not supported!");
+	}
+	if (!supported.features.drawIndirectFirstInstance) {
+		throw std::runtime_error("failed to run bindless benchmark, drawIndirectFirstInstance is not supported!");
+	}
+	multiDrawIndirect = supported.features.multiDrawIndirect == VK_TRUE;
+
+	VkPhysicalDeviceDescriptorIndexingFeatures enabledIndexing = {};
+	enabledIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	BindlessTextures::enableFeatures(enabledIndexing);
+	VkPhysicalDeviceFeatures2 enabled = {};
+	enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	enabled.pNext = &enabledIndexing;
+	enabled.features.drawIndirectFirstInstance = VK_TRUE;
+	enabled.features.multiDrawIndirect = supported.features.multiDrawIndirect;
+
+	context.createDevice({}, &enabled);
+}
+
+/*
+	one small texture per material: a two colour checker board with colours derived from the material index,
+	uploaded through a single staging buffer in one command buffer
+*/
+void BindlessBenchmark::createTextures()
+{
+	VkDevice device = context.device;
+	bindless.init(device, context.physicalDevice, settings.materials);
+	uint32_t materialCount = std::min(settings.materials, bindless.capacity());
+	textures.resize(materialCount);
+	textureViews.resize(materialCount);
+
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO; //struct type
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent = { TEXTURE_SIZE, TEXTURE_SIZE, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	for (auto& texture : textures) {
+		if (vkCreateImage(device, &imageInfo, nullptr, &texture) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create image!");
+		}
+	}
+
+	//identical images have identical requirements, so one allocation with a fixed stride holds them all
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, textures[0], &memRequirements);
+	VkDeviceSize stride = (memRequirements.size + memRequirements.alignment - 1) / memRequirements.alignment * memRequirements.alignment;
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO; //struct type
+	allocInfo.allocationSize = stride * materialCount;
+	allocInfo.memoryTypeIndex = findMemoryType(context.physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (allocateDeviceMemory(device, &allocInfo, nullptr, &textureMemory) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate image memory!");
+	}
+	for (uint32_t i = 0; i < materialCount; i++) {
+		vkBindImageMemory(device, textures[i], textureMemory, stride * i);
+		textureViews[i] = createImageView(device, textures[i], VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
+
+	const VkDeviceSize textureBytes = TEXTURE_SIZE * TEXTURE_SIZE * 4;
+	VkBuffer staging;
+	VkDeviceMemory stagingMemory;
+	createBuffer(device, context.physicalDevice, textureBytes * materialCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, stagingMemory);
+	uint8_t* texels;
+	vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&texels));
+	for (uint32_t i = 0; i < materialCount; i++) {
+		uint32_t hash = (i + 1) * 2654435761u; //spread neighbouring indices over the colour space
+		uint8_t a[4] = { static_cast<uint8_t>(hash), static_cast<uint8_t>(hash >> 8), static_cast<uint8_t>(hash >> 16), 255 };
+		uint8_t b[4] = { static_cast<uint8_t>(255 - a[0]), static_cast<uint8_t>(255 - a[1]), static_cast<uint8_t>(255 - a[2]), 255 };
+		for (uint32_t y = 0; y < TEXTURE_SIZE; y++) {
+			for (uint32_t x = 0; x < TEXTURE_SIZE; x++) {
+				memcpy(texels + i * textureBytes + (y * TEXTURE_SIZE + x) * 4, ((x / 4 + y / 4) & 1) ? a : b, 4);
+			}
+		}
+	}
+	vkUnmapMemory(device, stagingMemory);
+
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	for (uint32_t i = 0; i < materialCount; i++) {
+		imageBarrier(commandBuffer, textures[i], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		VkBufferImageCopy region = {};
+		region.bufferOffset = textureBytes * i;
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { TEXTURE_SIZE, TEXTURE_SIZE, 1 };
+		vkCmdCopyBufferToImage(commandBuffer, staging, textures[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		imageBarrier(commandBuffer, textures[i], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+	context.endSingleTimeCommands(commandBuffer);
+	vkDestroyBuffer(device, staging, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+
+	materialSlots.resize(materialCount);
+	for (uint32_t i = 0; i < materialCount; i++) {
+		materialSlots[i] = bindless.add(textureViews[i]);
+	}
+}
+
+/*
+	a grid of quads covering the target, each with a random material, and the matching indirect commands
+*/
+void BindlessBenchmark::createDrawData()
+{
+	VkDevice device = context.device;
+	const uint32_t drawCount = settings.draws;
+	const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(drawCount))));
+	const uint32_t rows = (drawCount + columns - 1) / columns;
+	const float width = 2.0f / columns, height = 2.0f / rows;
+
+	std::mt19937 random(1234); //fixed seed so both paths and every run draw the same frame
+	std::uniform_int_distribution<uint32_t> material(0, static_cast<uint32_t>(textures.size()) - 1);
+	drawMaterials.resize(drawCount);
+
+	createBuffer(device, context.physicalDevice, sizeof(DrawData) * drawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, drawBuffer, drawMemory);
+	createBuffer(device, context.physicalDevice, sizeof(VkDrawIndirectCommand) * drawCount, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indirectBuffer, indirectMemory);
+
+	DrawData* draws;
+	VkDrawIndirectCommand* commands;
+	vkMapMemory(device, drawMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&draws));
+	vkMapMemory(device, indirectMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&commands));
+	for (uint32_t i = 0; i < drawCount; i++) {
+		drawMaterials[i] = material(random);
+		DrawData draw = {};
+		draw.rect[0] = -1.0f + (i % columns) * width;
+		draw.rect[1] = -1.0f + (i / columns) * height;
+		draw.rect[2] = width;
+		draw.rect[3] = height;
+		draw.material = materialSlots[drawMaterials[i]];
+		draws[i] = draw;
+		commands[i] = { 6, 1, 0, i }; //firstInstance is the draw index, gl_InstanceIndex picks the draw data with it
+	}
+	vkUnmapMemory(device, drawMemory);
+	vkUnmapMemory(device, indirectMemory);
+}
+
+/*
+	set 0 (both paths): the draw data SSBO
+	set 1 (bound path): one combined image sampler per material, (bindless path): the BindlessTextures set
+*/
+void BindlessBenchmark::createDescriptors()
+{
+	VkDevice device = context.device;
+	const uint32_t materialCount = static_cast<uint32_t>(textures.size());
+
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO; //struct type
+	samplerInfo.magFilter = VK_FILTER_LINEAR; //same state as the bindless table's sampler so both paths render the same image
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	if (vkCreateSampler(device, &samplerInfo, nullptr, &materialSampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture sampler!");
+	}
+
+	VkDescriptorSetLayoutBinding drawBinding = {};
+	drawBinding.binding = 0;
+	drawBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	drawBinding.descriptorCount = 1;
+	drawBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &drawBinding;
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &drawSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorSetLayoutBinding materialBinding = {};
+	materialBinding.binding = 0;
+	materialBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	materialBinding.descriptorCount = 1;
+	materialBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	layoutInfo.pBindings = &materialBinding;
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &materialSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[0].descriptorCount = 1;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = materialCount;
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.maxSets = materialCount + 1;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(materialCount + 1, materialSetLayout);
+	layouts[0] = drawSetLayout;
+	std::vector<VkDescriptorSet> sets(materialCount + 1);
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = materialCount + 1;
+	allocInfo.pSetLayouts = layouts.data();
+	if (vkAllocateDescriptorSets(device, &allocInfo, sets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor sets!");
+	}
+	drawSet = sets[0];
+	materialSets.assign(sets.begin() + 1, sets.end());
+
+	VkDescriptorBufferInfo bufferInfo = { drawBuffer, 0, VK_WHOLE_SIZE };
+	std::vector<VkDescriptorImageInfo> imageInfos(materialCount);
+	std::vector<VkWriteDescriptorSet> writes(materialCount + 1);
+	writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+	writes[0].dstSet = drawSet;
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writes[0].descriptorCount = 1;
+	writes[0].pBufferInfo = &bufferInfo;
+	for (uint32_t i = 0; i < materialCount; i++) {
+		imageInfos[i] = { materialSampler, textureViews[i], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VkWriteDescriptorSet& write = writes[i + 1];
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+		write.dstSet = materialSets[i];
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfos[i];
+	}
+	vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+/*
+	both pipelines share the vertex shader and all fixed function state, only the fragment shader and set 1 differ
+*/
+void BindlessBenchmark::createPipelines()
+{
+	VkDevice device = context.device;
+
+	VkDescriptorSetLayout boundSets[2] = { drawSetLayout, materialSetLayout };
+	VkDescriptorSetLayout bindlessSets[2] = { drawSetLayout, bindless.layout() };
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.setLayoutCount = 2;
+	layoutInfo.pSetLayouts = boundSets;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &boundLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+	layoutInfo.pSetLayouts = bindlessSets;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &bindlessLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule vertShaderModule = createShaderModule(device, readBinaryFile("../shaders/bindless_vert.spv"));
+	VkShaderModule boundFragModule = createShaderModule(device, readBinaryFile("../shaders/material_frag.spv"));
+	VkShaderModule bindlessFragModule = createShaderModule(device, readBinaryFile("../shaders/bindless_frag.spv"));
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertShaderModule;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].pName = "main";
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //no vertex buffers, the quads are generated in the shader
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.renderPass = target.renderPass;
+	pipelineInfo.subpass = 0;
+
+	stages[1].module = boundFragModule;
+	pipelineInfo.layout = boundLayout;
+	VkResult boundResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &boundPipeline);
+	stages[1].module = bindlessFragModule;
+	pipelineInfo.layout = bindlessLayout;
+	VkResult bindlessResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &bindlessPipeline);
+
+	vkDestroyShaderModule(device, vertShaderModule, nullptr);
+	vkDestroyShaderModule(device, boundFragModule, nullptr);
+	vkDestroyShaderModule(device, bindlessFragModule, nullptr);
+	if (boundResult != VK_SUCCESS || bindlessResult != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+void BindlessBenchmark::recordFrame(VkCommandBuffer commandBuffer, Path path, uint32_t& descriptorBinds, uint32_t& drawCalls)
+{
+	descriptorBinds = 0;
+	drawCalls = 0;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //re-recorded every frame
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+
+	VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+	renderPassInfo.renderPass = target.renderPass;
+	renderPassInfo.framebuffer = target.framebuffer;
+	renderPassInfo.renderArea = { { 0, 0 }, extent };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearColor;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	if (path == Path::Bound) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundPipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundLayout, 0, 1, &drawSet, 0, nullptr);
+		descriptorBinds++;
+		uint32_t boundMaterial = UINT32_MAX;
+		for (uint32_t i = 0; i < settings.draws; i++) {
+			if (drawMaterials[i] != boundMaterial) { //the set only changes when the material does
+				boundMaterial = drawMaterials[i];
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, boundLayout, 1, 1, &materialSets[boundMaterial], 0, nullptr);
+				descriptorBinds++;
+			}
+			vkCmdDraw(commandBuffer, 6, 1, 0, i); //firstInstance selects the draw data, as in the indirect commands
+			drawCalls++;
+		}
+	}
+	else {
+		VkDescriptorSet sets[2] = { drawSet, bindless.set() };
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindlessPipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindlessLayout, 0, 2, sets, 0, nullptr);
+		descriptorBinds++;
+		if (multiDrawIndirect) { //one call unless the draw count is above the device limit
+			const uint32_t maxDraws = context.properties.limits.maxDrawIndirectCount;
+			for (uint32_t first = 0; first < settings.draws; first += maxDraws) {
+				vkCmdDrawIndirect(commandBuffer, indirectBuffer, sizeof(VkDrawIndirectCommand) * first, std::min(maxDraws, settings.draws - first), sizeof(VkDrawIndirectCommand));
+				drawCalls++;
+			}
+		}
+		else { //still no binds between draws, only more calls
+			for (uint32_t i = 0; i < settings.draws; i++) {
+				vkCmdDrawIndirect(commandBuffer, indirectBuffer, sizeof(VkDrawIndirectCommand) * i, 1, sizeof(VkDrawIndirectCommand));
+				drawCalls++;
+			}
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+void BindlessBenchmark::runPath(Path path, const char* name, std::vector<uint8_t>& image)
+{
+	VkDevice device = context.device;
+	std::vector<double> recordTimes;
+	recordTimes.reserve(settings.frames);
+	uint32_t descriptorBinds = 0, drawCalls = 0;
+	size_t frame = 0;
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frame);
+
+		auto recordStart = std::chrono::steady_clock::now();
+		recordFrame(commandBuffers[frame], path, descriptorBinds, drawCalls);
+		if (i >= settings.warmupFrames) {
+			recordTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count());
+		}
+
+		context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+
+	std::cout << "  " << name << " " << descriptorBinds << " descriptor binds, " << drawCalls << " draw calls per frame" << std::endl;
+	std::cout << "    cpu record " << TimingSummary::fromSamples(recordTimes) << std::endl;
+	if (frameTimer.hasGpuTiming()) {
+		std::cout << "    gpu frame  " << frameTimer.gpuSummary() << std::endl;
+	}
+	image = context.readOffscreenTarget(target);
+}
+
+void BindlessBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		vkDestroyPipeline(device, boundPipeline, nullptr);
+		vkDestroyPipeline(device, bindlessPipeline, nullptr);
+		vkDestroyPipelineLayout(device, boundLayout, nullptr);
+		vkDestroyPipelineLayout(device, bindlessLayout, nullptr);
+		context.destroyOffscreenTarget(target);
+		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, drawSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, materialSetLayout, nullptr);
+		vkDestroySampler(device, materialSampler, nullptr);
+		vkDestroyBuffer(device, drawBuffer, nullptr);
+		freeDeviceMemory(device, drawMemory, nullptr);
+		vkDestroyBuffer(device, indirectBuffer, nullptr);
+		freeDeviceMemory(device, indirectMemory, nullptr);
+		bindless.cleanup();
+		for (VkImageView view : textureViews) {
+			vkDestroyImageView(device, view, nullptr);
+		}
+		for (VkImage texture : textures) {
+			vkDestroyImage(device, texture, nullptr);
+		}
+		freeDeviceMemory(device, textureMemory, nullptr);
+	}
+	context.cleanup();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "BindlessTextures.h"
+#include "FrameTimer.h"
+
+/*
+	settings for the many materials benchmark, filled in from the command line
+*/
+struct BindlessBenchmarkSettings {
+	bool enabled = false;
+	uint32_t materials = 1024; //distinct textures
+	uint32_t draws = 16384; //textured quads per frame, each with a random material
+	uint32_t frames = 500; //timed frames per path
+	uint32_t warmupFrames = 20; //untimed frames per path
+};
+
+/*
+	Many materials benchmark: per material descriptor sets against the bindless texture table
+
+	Renders the same frame (a grid of small quads, each sampling one of many textures) headlessly in two ways:
+	- bound: one descriptor set per material, a vkCmdBindDescriptorSets whenever the material changes and one vkCmdDraw per quad
+	- bindless: the BindlessTextures set bound once and a single vkCmdDrawIndirect covering every quad, the material id
+	  comes from a per draw SSBO indexed with the draw's firstInstance
+	and reports the CPU recording cost and GPU time of both, then checks that the two images are identical.
+*/
+class BindlessBenchmark
+{
+public:
+	explicit BindlessBenchmark(const BindlessBenchmarkSettings& settings);
+	void run();
+
+private:
+	enum class Path { Bound, Bindless };
+
+	void createDevice();
+	void createTextures();
+	void createDrawData();
+	void createDescriptors();
+	void createPipelines();
+	void recordFrame(VkCommandBuffer commandBuffer, Path path, uint32_t& descriptorBinds, uint32_t& drawCalls);
+	void runPath(Path path, const char* name, std::vector<uint8_t>& image);
+	void cleanup();
+
+	BindlessBenchmarkSettings settings;
+	HeadlessDevice context;
+	bool multiDrawIndirect = false; //otherwise the indirect draws are issued one call per draw
+
+	//material textures, all suballocated from one allocation
+	static const uint32_t TEXTURE_SIZE = 16;
+	std::vector<VkImage> textures;
+	std::vector<VkImageView> textureViews;
+	VkDeviceMemory textureMemory = VK_NULL_HANDLE;
+	VkSampler materialSampler = VK_NULL_HANDLE; //used by the per material sets
+	BindlessTextures bindless;
+	std::vector<uint32_t> materialSlots; //bindless slot of every material
+
+	//per draw data and indirect commands
+	VkBuffer drawBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory drawMemory = VK_NULL_HANDLE;
+	VkBuffer indirectBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indirectMemory = VK_NULL_HANDLE;
+	std::vector<uint32_t> drawMaterials;
+
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSetLayout drawSetLayout = VK_NULL_HANDLE; //set 0: the per draw SSBO
+	VkDescriptorSetLayout materialSetLayout = VK_NULL_HANDLE; //set 1 of the bound path: one combined image sampler
+	VkDescriptorSet drawSet = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> materialSets;
+
+	VkExtent2D extent = { 1280, 720 };
+	OffscreenTarget target; //R8G8B8A8_UNORM, read back to compare the two paths
+
+	VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+	VkPipelineLayout bindlessLayout = VK_NULL_HANDLE;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkPipeline bindlessPipeline = VK_NULL_HANDLE;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
@@ -0,0 +1,170 @@
+#include "BindlessTextures.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+void BindlessTextures::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t capacity)
+{
+	this->device = device;
+
+	VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+	slotCount = std::min({ capacity, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO; //struct type
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE; //let every texture use all of its mip levels
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+	if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture sampler!");
+	}
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[0].pImmutableSamplers = &sampler; //baked into the layout, never written
+	bindings[1].binding = 1; //the variable sized array has to be the last binding
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	bindings[1].descriptorCount = slotCount; //upper bound, the actual count is given when the set is allocated
+	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorBindingFlags bindingFlags[2] = {
+		0,
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+			| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+	};
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO; //struct type
+	bindingFlagsInfo.bindingCount = 2;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT; //required by the update after bind binding
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create bindless descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+	poolSizes[0].descriptorCount = 1;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	poolSizes[1].descriptorCount = slotCount;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create bindless descriptor pool!");
+	}
+
+	VkDescriptorSetVariableDescriptorCountAllocateInfo countInfo = {};
+	countInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO; //struct type
+	countInfo.descriptorSetCount = 1;
+	countInfo.pDescriptorCounts = &slotCount;
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.pNext = &countInfo;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+
+	if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate bindless descriptor set!");
+	}
+
+	freeSlots.resize(slotCount);
+	for (uint32_t i = 0; i < slotCount; i++) {
+		freeSlots[i] = slotCount - 1 - i;
+	}
+}
+
+void BindlessTextures::cleanup()
+{
+	if (device == VK_NULL_HANDLE) {
+		return;
+	}
+	vkDestroyDescriptorPool(device, pool, nullptr); //frees the set with it
+	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+	vkDestroySampler(device, sampler, nullptr);
+	freeSlots.clear();
+	device = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessTextures::add(VkImageView imageView)
+{
+	if (freeSlots.empty()) {
+		throw std::runtime_error("failed to add texture, the bindless table is full!");
+	}
+	uint32_t slot = freeSlots.back();
+	freeSlots.pop_back();
+	write(slot, imageView);
+	return slot;
+}
+
+void BindlessTextures::remove(uint32_t slot)
+{
+	freeSlots.push_back(slot); //partially bound: the stale descriptor is fine as long as nothing reads the slot
+}
+
+void BindlessTextures::replace(uint32_t slot, VkImageView imageView)
+{
+	write(slot, imageView);
+}
+
+void BindlessTextures::write(uint32_t slot, VkImageView imageView)
+{
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+	write.dstSet = descriptorSet;
+	write.dstBinding = 1;
+	write.dstArrayElement = slot;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.descriptorCount = 1;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+bool BindlessTextures::supported(const VkPhysicalDeviceDescriptorIndexingFeatures& features)
+{
+	return features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound
+		&& features.descriptorBindingVariableDescriptorCount && features.descriptorBindingSampledImageUpdateAfterBind
+		&& features.descriptorBindingUpdateUnusedWhilePending;
+}
+
+void BindlessTextures::enableFeatures(VkPhysicalDeviceDescriptorIndexingFeatures& features)
+{
+	features.runtimeDescriptorArray = VK_TRUE;
+	features.descriptorBindingPartiallyBound = VK_TRUE;
+	features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+	features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+}
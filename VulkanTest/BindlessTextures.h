@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+/*
+	Bindless texture table (descriptor indexing)
+
+	One descriptor set holds an immutable sampler (binding 0) and a large array of sampled images (binding 1) that shaders
+	index with a material id. The array is PARTIALLY_BOUND, so slots that were never written may stay empty as long as no
+	draw reads them, VARIABLE_DESCRIPTOR_COUNT, so the set is allocated with exactly the capacity asked for, and
+	UPDATE_AFTER_BIND and UPDATE_UNUSED_WHILE_PENDING, so textures can be added while the set is bound in a command buffer
+	being recorded or in frames still executing, as long as those do not read the slots being written.
+
+	The set is bound once per frame and never changes, so draws with different textures need no descriptor binds between
+	them and can be merged into one indirect draw.
+
+	Requires descriptorIndexing support: runtimeDescriptorArray, descriptorBindingPartiallyBound,
+	descriptorBindingVariableDescriptorCount, descriptorBindingSampledImageUpdateAfterBind and
+	descriptorBindingUpdateUnusedWhilePending.
+*/
+class BindlessTextures
+{
+public:
+	/*
+		capacity is clamped to maxDescriptorSetUpdateAfterBindSampledImages
+	*/
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t capacity);
+	void cleanup();
+
+	/*
+		write the view into a free slot and return its index, throws when the table is full
+		the slot must not be read by work that is already pending on the GPU
+	*/
+	uint32_t add(VkImageView imageView);
+
+	/*
+		free a slot for reuse, the caller must know no pending work reads it any more
+	*/
+	void remove(uint32_t slot);
+
+	/*
+		point an existing slot at a different view (for example a texture that gained or lost mip levels)
+	*/
+	void replace(uint32_t slot, VkImageView imageView);
+
+	VkDescriptorSetLayout layout() const { return setLayout; }
+	VkDescriptorSet set() const { return descriptorSet; }
+	uint32_t capacity() const { return slotCount; }
+	uint32_t size() const { return slotCount - static_cast<uint32_t>(freeSlots.size()); }
+
+	/*
+		does the physical device support everything the table needs
+	*/
+	static bool supported(const VkPhysicalDeviceDescriptorIndexingFeatures& features);
+
+	/*
+		turn on the features the table needs in a feature struct that will be chained into device creation
+	*/
+	static void enableFeatures(VkPhysicalDeviceDescriptorIndexingFeatures& features);
+
+private:
+	void write(uint32_t slot, VkImageView imageView);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE; //immutable, shared by every texture
+	VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	uint32_t slotCount = 0;
+	std::vector<uint32_t> freeSlots; //handed out from the back, lowest slot first
+};
@@ -0,0 +1,315 @@
+#define GLM_ENABLE_EXPERIMENTAL
+#include "Bvh.h"
+
+#include <glm/gtx/intersect.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+float Aabb::surfaceArea() const
+{
+	glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+bool intersectRayAabb(const Ray& ray, const glm::vec3& inverseDirection, const Aabb& box, float maxDistance, float& entry)
+{
+	glm::vec3 t0 = (box.min - ray.origin) * inverseDirection;
+	glm::vec3 t1 = (box.max - ray.origin) * inverseDirection;
+	glm::vec3 slabEntry = glm::min(t0, t1), slabExit = glm::max(t0, t1);
+	float enter = std::max(std::max(slabEntry.x, slabEntry.y), std::max(slabEntry.z, 0.0f));
+	float exit = std::min(std::min(slabExit.x, slabExit.y), std::min(slabExit.z, maxDistance));
+	entry = enter;
+	return enter <= exit;
+}
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProj)
+{
+	glm::mat4 rows = glm::transpose(viewProj);
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0]; //left
+	frustum.planes[1] = rows[3] - rows[0]; //right
+	frustum.planes[2] = rows[3] + rows[1]; //bottom (top when y is flipped, either way one of the pair)
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[2]; //near, depth 0
+	frustum.planes[5] = rows[3] - rows[2]; //far, depth 1
+	for (auto& plane : frustum.planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+Frustum::Test Frustum::test(const Aabb& box) const
+{
+	glm::vec3 center = box.center(), halfExtent = (box.max - box.min) * 0.5f;
+	Test result = Test::Inside;
+	for (const auto& plane : planes) {
+		glm::vec3 normal(plane);
+		float distance = glm::dot(normal, center) + plane.w;
+		float radius = glm::dot(glm::abs(normal), halfExtent); //projection of the box onto the normal
+		if (distance + radius < 0.0f) {
+			return Test::Outside;
+		}
+		if (distance - radius < 0.0f) {
+			result = Test::Intersects;
+		}
+	}
+	return result;
+}
+
+void Bvh::build(const std::vector<Aabb>& primitiveBounds, uint32_t maxLeafSize, uint32_t binCount)
+{
+	nodes.clear();
+	parents.clear();
+	depth = 0;
+	size_t primitiveCount = primitiveBounds.size();
+	primitiveOrder.resize(primitiveCount);
+	std::iota(primitiveOrder.begin(), primitiveOrder.end(), 0);
+	leafOf.assign(primitiveCount, 0);
+	if (primitiveCount == 0) {
+		return;
+	}
+	std::vector<glm::vec3> centroids(primitiveCount);
+	for (size_t i = 0; i < primitiveCount; i++) {
+		centroids[i] = primitiveBounds[i].center();
+	}
+
+	struct Bin {
+		Aabb bounds;
+		uint32_t count = 0;
+	};
+	std::vector<Bin> bins(binCount);
+	std::vector<float> rightAreas(binCount);
+	std::vector<uint32_t> rightCounts(binCount);
+
+	nodes.reserve(2 * primitiveCount);
+	parents.reserve(2 * primitiveCount);
+	Node root;
+	root.first = 0;
+	root.count = static_cast<uint32_t>(primitiveCount);
+	nodes.push_back(root);
+	parents.push_back(0);
+	std::vector<std::pair<uint32_t, uint32_t>> pending = { { 0, 0 } }; //node and its depth
+
+	while (!pending.empty()) {
+		uint32_t nodeIndex = pending.back().first, nodeDepth = pending.back().second;
+		pending.pop_back();
+		depth = std::max(depth, nodeDepth);
+		uint32_t first = nodes[nodeIndex].first, count = nodes[nodeIndex].count;
+
+		Aabb bounds, centroidBounds;
+		for (uint32_t i = first; i < first + count; i++) {
+			bounds.grow(primitiveBounds[primitiveOrder[i]]);
+			centroidBounds.grow(centroids[primitiveOrder[i]]);
+		}
+		nodes[nodeIndex].bounds = bounds;
+		bool isLeaf = count <= maxLeafSize || nodeDepth + 2 >= STACK_SIZE;
+
+		//cheapest bin boundary over all three axes, costs are in units of the node's surface area
+		int bestAxis = -1;
+		uint32_t bestSplit = 0;
+		float bestCost = std::numeric_limits<float>::max();
+		glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+		for (int axis = 0; axis < 3 && !isLeaf; axis++) {
+			if (extent[axis] <= 0.0f) {
+				continue;
+			}
+			std::fill(bins.begin(), bins.end(), Bin());
+			float scale = binCount / extent[axis];
+			for (uint32_t i = first; i < first + count; i++) {
+				uint32_t primitive = primitiveOrder[i];
+				uint32_t bin = std::min(static_cast<uint32_t>((centroids[primitive][axis] - centroidBounds.min[axis]) * scale), binCount - 1);
+				bins[bin].bounds.grow(primitiveBounds[primitive]);
+				bins[bin].count++;
+			}
+			Aabb right;
+			uint32_t rightCount = 0;
+			for (uint32_t bin = binCount - 1; bin > 0; bin--) {
+				right.grow(bins[bin].bounds);
+				rightCount += bins[bin].count;
+				rightAreas[bin] = rightCount > 0 ? right.surfaceArea() : 0.0f;
+				rightCounts[bin] = rightCount;
+			}
+			Aabb left;
+			uint32_t leftCount = 0;
+			for (uint32_t split = 1; split < binCount; split++) { //split between bin split - 1 and bin split
+				left.grow(bins[split - 1].bounds);
+				leftCount += bins[split - 1].count;
+				if (leftCount == 0 || rightCounts[split] == 0) {
+					continue;
+				}
+				float cost = leftCount * left.surfaceArea() + rightCounts[split] * rightAreas[split];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+		float area = bounds.surfaceArea();
+		//a leaf intersects every primitive, a split pays one more box test and then the children's share
+		if (!isLeaf && bestAxis >= 0 && area > 0.0f && count <= 4 * maxLeafSize && bestCost >= (count - 1.0f) * area) {
+			isLeaf = true;
+		}
+		if (isLeaf) {
+			for (uint32_t i = first; i < first + count; i++) {
+				leafOf[primitiveOrder[i]] = nodeIndex;
+			}
+			continue;
+		}
+
+		uint32_t* begin = primitiveOrder.data() + first;
+		uint32_t* end = begin + count;
+		uint32_t* middle = begin;
+		if (bestAxis >= 0) {
+			float scale = binCount / extent[bestAxis];
+			float minimum = centroidBounds.min[bestAxis];
+			middle = std::partition(begin, end, [&](uint32_t primitive) {
+				return std::min(static_cast<uint32_t>((centroids[primitive][bestAxis] - minimum) * scale), binCount - 1) < bestSplit;
+			});
+		}
+		if (middle == begin || middle == end) { //every centroid in the same place, halve the range instead
+			int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+			middle = begin + count / 2;
+			std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+		}
+
+		uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+		Node leftChild, rightChild;
+		leftChild.first = first;
+		leftChild.count = static_cast<uint32_t>(middle - begin);
+		rightChild.first = first + leftChild.count;
+		rightChild.count = count - leftChild.count;
+		nodes.push_back(leftChild);
+		nodes.push_back(rightChild);
+		parents.push_back(nodeIndex);
+		parents.push_back(nodeIndex);
+		nodes[nodeIndex].first = leftIndex;
+		nodes[nodeIndex].count = 0;
+		pending.push_back({ leftIndex, nodeDepth + 1 });
+		pending.push_back({ leftIndex + 1, nodeDepth + 1 });
+	}
+}
+
+void Bvh::refit(const std::vector<Aabb>& primitiveBounds)
+{
+	for (size_t i = nodes.size(); i-- > 0;) {
+		Node& node = nodes[i];
+		Aabb bounds;
+		if (node.count > 0) {
+			for (uint32_t j = node.first; j < node.first + node.count; j++) {
+				bounds.grow(primitiveBounds[primitiveOrder[j]]);
+			}
+		}
+		else {
+			bounds = nodes[node.first].bounds;
+			bounds.grow(nodes[node.first + 1].bounds);
+		}
+		node.bounds = bounds;
+	}
+}
+
+size_t Bvh::refit(const std::vector<Aabb>& primitiveBounds, const std::vector<uint32_t>& moved)
+{
+	size_t written = 0;
+	for (uint32_t primitive : moved) {
+		uint32_t nodeIndex = leafOf[primitive];
+		Node& leaf = nodes[nodeIndex];
+		Aabb bounds;
+		for (uint32_t j = leaf.first; j < leaf.first + leaf.count; j++) {
+			bounds.grow(primitiveBounds[primitiveOrder[j]]);
+		}
+		if (bounds == leaf.bounds) {
+			continue; //another moved primitive of the same leaf already took care of it
+		}
+		leaf.bounds = bounds;
+		written++;
+		while (nodeIndex != 0) {
+			nodeIndex = parents[nodeIndex];
+			Node& node = nodes[nodeIndex];
+			bounds = nodes[node.first].bounds;
+			bounds.grow(nodes[node.first + 1].bounds);
+			if (bounds == node.bounds) {
+				break; //nothing above changes either
+			}
+			node.bounds = bounds;
+			written++;
+		}
+	}
+	return written;
+}
+
+void Bvh::cullFrustum(const Frustum& frustum, const std::vector<Aabb>& primitiveBounds, std::vector<uint32_t>& visible) const
+{
+	if (nodes.empty()) {
+		return;
+	}
+	const uint32_t INSIDE = 0x80000000; //set on stack entries whose box is already known to be inside
+	uint32_t stack[STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		uint32_t entry = stack[--top];
+		const Node& node = nodes[entry & ~INSIDE];
+		uint32_t inside = entry & INSIDE;
+		if (!inside) {
+			Frustum::Test test = frustum.test(node.bounds);
+			if (test == Frustum::Test::Outside) {
+				continue;
+			}
+			inside = test == Frustum::Test::Inside ? INSIDE : 0;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				uint32_t primitive = primitiveOrder[i];
+				if (inside || node.count == 1 || frustum.test(primitiveBounds[primitive]) != Frustum::Test::Outside) {
+					visible.push_back(primitive);
+				}
+			}
+			continue;
+		}
+		stack[top++] = node.first | inside;
+		stack[top++] = (node.first + 1) | inside;
+	}
+}
+
+void TriangleBvh::build(const Mesh& mesh, uint32_t maxLeafSize)
+{
+	positions.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		positions[i] = mesh.vertices[i].position;
+	}
+	indices = mesh.indices;
+	std::vector<Aabb> triangleBounds(indices.size() / 3);
+	for (size_t i = 0; i < triangleBounds.size(); i++) {
+		for (int corner = 0; corner < 3; corner++) {
+			triangleBounds[i].grow(positions[indices[i * 3 + corner]]);
+		}
+	}
+	bvh.build(triangleBounds, maxLeafSize);
+}
+
+bool TriangleBvh::raycast(const Ray& ray, float maxDistance, TriangleHit& hit) const
+{
+	glm::vec2 barycentric;
+	float distance = maxDistance;
+	uint32_t triangle = 0;
+	bool found = bvh.raycast(ray, distance, triangle, [&](uint32_t primitive, const Ray& r, float closest, float& hitDistance) {
+		const uint32_t* corners = &indices[primitive * 3];
+		glm::vec2 weights;
+		if (!glm::intersectRayTriangle(r.origin, r.direction, positions[corners[0]], positions[corners[1]], positions[corners[2]], weights, hitDistance)) {
+			return false;
+		}
+		if (hitDistance < 0.0f || hitDistance >= closest) { //glm reports hits behind the origin too
+			return false;
+		}
+		barycentric = weights;
+		return true;
+	});
+	if (found) {
+		hit.triangle = triangle;
+		hit.distance = distance;
+		hit.barycentric = barycentric;
+	}
+	return found;
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "Mesh.h"
+
+/*
+	axis aligned box, empty (min above max) until something is added
+*/
+struct Aabb {
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+	void grow(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); }
+	void grow(const Aabb& box) { min = glm::min(min, box.min); max = glm::max(max, box.max); }
+	glm::vec3 center() const { return (min + max) * 0.5f; }
+	float surfaceArea() const;
+	bool operator==(const Aabb& other) const { return min == other.min && max == other.max; }
+};
+
+struct Ray {
+	glm::vec3 origin;
+	glm::vec3 direction; //need not be normalised, distances are in multiples of it
+};
+
+/*
+	slab test, entry receives the distance at which the ray enters the box (0 when it starts inside)
+	inverseDirection is 1 / direction, infinities for zero components work as intended
+*/
+bool intersectRayAabb(const Ray& ray, const glm::vec3& inverseDirection, const Aabb& box, float maxDistance, float& entry);
+
+/*
+	the six planes of a view frustum (normals pointing inwards), extracted from a view projection matrix with Vulkan's
+	0 to 1 depth range
+*/
+struct Frustum {
+	enum class Test { Outside, Intersects, Inside };
+
+	glm::vec4 planes[6];
+
+	static Frustum fromViewProjection(const glm::mat4& viewProj);
+	Test test(const Aabb& box) const;
+};
+
+/*
+	Bounding volume hierarchy over a set of boxes
+
+	Built top down with the binned surface area heuristic: at every node the primitive centroids are dropped into a fixed
+	number of bins along each axis and the split between bins with the lowest estimated traversal cost wins, with a
+	median split as the fallback when the centroids cannot be separated. Children are stored next to each other and
+	after their parent, so a reverse walk over the nodes visits every child before its parent.
+
+	Moving primitives are handled by refitting rather than rebuilding: the tree keeps its shape and only the boxes grow
+	or shrink, walking up from each moved primitive's leaf until a box stops changing. The tree gets looser as things
+	move far from where it was built, rebuild once queries slow down.
+
+	Queries use a small fixed stack instead of recursion. Rays visit the nearer child first and skip boxes entered
+	beyond the closest hit so far; frustum queries take whole subtrees without further tests once a box is inside.
+*/
+class Bvh
+{
+public:
+	struct Node {
+		Aabb bounds;
+		uint32_t first = 0; //leaf: first entry in primitiveOrder, inner: index of the left child (right is first + 1)
+		uint32_t count = 0; //primitives in a leaf, 0 for inner nodes
+	};
+
+	void build(const std::vector<Aabb>& primitiveBounds, uint32_t maxLeafSize = 4, uint32_t binCount = 16);
+
+	/*
+		recompute every box from the primitives, bottom up
+	*/
+	void refit(const std::vector<Aabb>& primitiveBounds);
+
+	/*
+		recompute only the leaves of the moved primitives and the boxes above them, returns the nodes written
+	*/
+	size_t refit(const std::vector<Aabb>& primitiveBounds, const std::vector<uint32_t>& moved);
+
+	/*
+		appends every primitive whose box is inside or intersects the frustum
+	*/
+	void cullFrustum(const Frustum& frustum, const std::vector<Aabb>& primitiveBounds, std::vector<uint32_t>& visible) const;
+
+	/*
+		closest hit along the ray closer than distance, intersect(primitive, ray, maxDistance, hitDistance) tests one
+		primitive and returns whether it was hit closer than maxDistance. On a hit distance and primitive are updated.
+	*/
+	template<typename Intersect>
+	bool raycast(const Ray& ray, float& distance, uint32_t& primitive, Intersect intersect) const;
+
+	const std::vector<Node>& getNodes() const { return nodes; }
+	uint32_t getDepth() const { return depth; }
+	bool empty() const { return nodes.empty(); }
+
+private:
+	static const int STACK_SIZE = 64; //the build stops splitting at this depth, so traversal can never overflow
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> parents; //per node, the root's is its own index
+	std::vector<uint32_t> primitiveOrder; //primitive indices, each leaf owns a contiguous range
+	std::vector<uint32_t> leafOf; //per primitive, the leaf holding it
+	uint32_t depth = 0;
+};
+
+template<typename Intersect>
+bool Bvh::raycast(const Ray& ray, float& distance, uint32_t& primitive, Intersect intersect) const
+{
+	if (nodes.empty()) {
+		return false;
+	}
+	glm::vec3 inverseDirection = 1.0f / ray.direction;
+	uint32_t stack[STACK_SIZE];
+	float entries[STACK_SIZE];
+	int top = 0;
+	float entry;
+	if (!intersectRayAabb(ray, inverseDirection, nodes[0].bounds, distance, entry)) {
+		return false;
+	}
+	stack[top] = 0;
+	entries[top++] = entry;
+
+	bool hit = false;
+	while (top > 0) {
+		top--;
+		if (entries[top] >= distance) {
+			continue; //a closer hit was found since this was pushed
+		}
+		const Node& node = nodes[stack[top]];
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				float hitDistance;
+				if (intersect(primitiveOrder[i], ray, distance, hitDistance)) {
+					distance = hitDistance;
+					primitive = primitiveOrder[i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		float leftEntry, rightEntry;
+		bool left = intersectRayAabb(ray, inverseDirection, nodes[node.first].bounds, distance, leftEntry);
+		bool right = intersectRayAabb(ray, inverseDirection, nodes[node.first + 1].bounds, distance, rightEntry);
+		if (left && right) { //the nearer child goes on top so it is visited first
+			bool leftNearer = leftEntry <= rightEntry;
+			stack[top] = leftNearer ? node.first + 1 : node.first;
+			entries[top++] = leftNearer ? rightEntry : leftEntry;
+			stack[top] = leftNearer ? node.first : node.first + 1;
+			entries[top++] = leftNearer ? leftEntry : rightEntry;
+		}
+		else if (left || right) {
+			stack[top] = left ? node.first : node.first + 1;
+			entries[top++] = left ? leftEntry : rightEntry;
+		}
+	}
+	return hit;
+}
+
+/*
+	hit of a ray with a triangle mesh
+*/
+struct TriangleHit {
+	uint32_t triangle = 0;
+	float distance = 0.0f;
+	glm::vec2 barycentric = glm::vec2(0.0f); //weights of the second and third corner
+};
+
+/*
+	a BVH over the triangles of a mesh for picking, keeps its own copy of the positions and indices
+*/
+class TriangleBvh
+{
+public:
+	void build(const Mesh& mesh, uint32_t maxLeafSize = 4);
+	bool raycast(const Ray& ray, float maxDistance, TriangleHit& hit) const;
+	size_t triangleCount() const { return indices.size() / 3; }
+	const Bvh& getBvh() const { return bvh; }
+
+private:
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	Bvh bvh;
+};
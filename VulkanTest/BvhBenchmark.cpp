@@ -0,0 +1,230 @@
+#define GLM_ENABLE_EXPERIMENTAL
+#include "BvhBenchmark.h"
+#include "Bvh.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/intersect.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+
+namespace {
+	const float WORLD_SIZE = 1000.0f; //objects are spread over a cube this wide
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool intersectBox(const std::vector<Aabb>& boxes, uint32_t primitive, const Ray& ray, float maxDistance, float& hitDistance)
+	{
+		return intersectRayAabb(ray, 1.0f / ray.direction, boxes[primitive], maxDistance, hitDistance) && hitDistance < maxDistance;
+	}
+
+	/*
+		rolling hills on a regular grid over [0, 1]^2 in x and z
+	*/
+	Mesh generateTerrain(uint32_t size)
+	{
+		Mesh terrain;
+		for (uint32_t z = 0; z <= size; z++) {
+			for (uint32_t x = 0; x <= size; x++) {
+				glm::vec2 position(static_cast<float>(x) / size, static_cast<float>(z) / size);
+				float height = 0.05f * std::sin(position.x * 17.0f) * std::cos(position.y * 13.0f) + 0.02f * std::sin((position.x + position.y) * 41.0f);
+				MeshVertex vertex;
+				vertex.position = glm::vec3(position.x, height, position.y);
+				vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+				vertex.texCoord = position;
+				terrain.vertices.push_back(vertex);
+			}
+		}
+		for (uint32_t z = 0; z < size; z++) {
+			for (uint32_t x = 0; x < size; x++) {
+				uint32_t a = z * (size + 1) + x, b = a + size + 1;
+				uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+				terrain.indices.insert(terrain.indices.end(), quad, quad + 6);
+			}
+		}
+		return terrain;
+	}
+
+	glm::mat4 randomCamera(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> coordinate(0.0f, WORLD_SIZE), angle(0.0f, 6.2831853f);
+		glm::vec3 eye(coordinate(random), coordinate(random), coordinate(random));
+		glm::vec3 forward(std::cos(angle(random)), std::sin(angle(random)) * 0.5f, std::sin(angle(random)));
+		glm::mat4 view = glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+		projection[1][1] *= -1.0f;
+		return projection * view;
+	}
+}
+
+BvhBenchmark::BvhBenchmark(const BvhBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void BvhBenchmark::run()
+{
+	runObjects();
+	runTerrain();
+}
+
+void BvhBenchmark::runObjects()
+{
+	std::mt19937 random(99);
+	std::uniform_real_distribution<float> coordinate(0.0f, WORLD_SIZE), size(0.5f, 5.0f), step(-2.0f, 2.0f);
+	std::vector<Aabb> boxes(settings.objects);
+	for (auto& box : boxes) {
+		glm::vec3 center(coordinate(random), coordinate(random), coordinate(random));
+		glm::vec3 halfExtent = glm::vec3(size(random), size(random), size(random)) * 0.5f;
+		box.min = center - halfExtent;
+		box.max = center + halfExtent;
+	}
+
+	Bvh bvh;
+	auto buildStart = std::chrono::steady_clock::now();
+	bvh.build(boxes);
+	double buildMilliseconds = millisecondsSince(buildStart);
+	std::cout << "bvh benchmark: " << settings.objects << " objects, built in " << buildMilliseconds << " ms ("
+		<< settings.objects / (buildMilliseconds * 1000.0) << "M objects/s), " << bvh.getNodes().size() << " nodes, depth " << bvh.getDepth() << std::endl;
+
+	//moving objects drift a little every frame, the incremental refit only walks up from their leaves
+	uint32_t movingCount = std::max(static_cast<uint32_t>(settings.objects * settings.movingFraction), 1u);
+	std::vector<uint32_t> moving(movingCount);
+	for (auto& object : moving) {
+		object = random() % settings.objects;
+	}
+	const int REFITS = 20;
+	double incrementalMilliseconds = 0.0, fullMilliseconds = 0.0;
+	size_t nodesWritten = 0;
+	for (int frame = 0; frame < REFITS; frame++) {
+		for (uint32_t object : moving) {
+			glm::vec3 offset(step(random), step(random), step(random));
+			boxes[object].min += offset;
+			boxes[object].max += offset;
+		}
+		auto refitStart = std::chrono::steady_clock::now();
+		nodesWritten += bvh.refit(boxes, moving);
+		incrementalMilliseconds += millisecondsSince(refitStart);
+	}
+	for (int frame = 0; frame < REFITS; frame++) {
+		auto refitStart = std::chrono::steady_clock::now();
+		bvh.refit(boxes);
+		fullMilliseconds += millisecondsSince(refitStart);
+	}
+	std::cout << "  refit after moving " << movingCount << " objects: incremental " << incrementalMilliseconds / REFITS << " ms ("
+		<< nodesWritten / REFITS << " nodes written), full " << fullMilliseconds / REFITS << " ms" << std::endl;
+
+	//frustum culling, as done before recording a frame's draws
+	std::vector<glm::mat4> cameras(settings.frustums);
+	for (auto& camera : cameras) {
+		camera = randomCamera(random);
+	}
+	std::vector<uint32_t> visible;
+	size_t visibleTotal = 0, mismatches = 0;
+	auto cullStart = std::chrono::steady_clock::now();
+	for (const auto& camera : cameras) {
+		visible.clear();
+		bvh.cullFrustum(Frustum::fromViewProjection(camera), boxes, visible);
+		visibleTotal += visible.size();
+	}
+	double cullMilliseconds = millisecondsSince(cullStart);
+	size_t bruteTotal = 0;
+	auto bruteStart = std::chrono::steady_clock::now();
+	for (const auto& camera : cameras) {
+		Frustum frustum = Frustum::fromViewProjection(camera);
+		size_t count = 0;
+		for (const auto& box : boxes) {
+			count += frustum.test(box) != Frustum::Test::Outside;
+		}
+		bruteTotal += count;
+	}
+	double bruteMilliseconds = millisecondsSince(bruteStart);
+	mismatches = visibleTotal > bruteTotal ? visibleTotal - bruteTotal : bruteTotal - visibleTotal;
+	std::cout << "  frustum culling: " << cullMilliseconds * 1000.0 / cameras.size() << " us per frustum, " << visibleTotal / cameras.size()
+		<< " visible on average, brute force " << bruteMilliseconds * 1000.0 / cameras.size() << " us (" << bruteMilliseconds / cullMilliseconds
+		<< "x), " << mismatches << " differences" << std::endl;
+
+	//picking rays from random points in random directions
+	std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+	std::vector<Ray> rays(settings.rays);
+	for (auto& ray : rays) {
+		ray.origin = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+		ray.direction = glm::normalize(glm::vec3(direction(random), direction(random), direction(random)) + glm::vec3(1e-4f));
+	}
+	size_t hits = 0;
+	auto rayStart = std::chrono::steady_clock::now();
+	for (const auto& ray : rays) {
+		float distance = WORLD_SIZE * 2.0f;
+		uint32_t object;
+		hits += bvh.raycast(ray, distance, object, [&](uint32_t primitive, const Ray& r, float closest, float& hitDistance) {
+			return intersectBox(boxes, primitive, r, closest, hitDistance);
+		});
+	}
+	double rayMilliseconds = millisecondsSince(rayStart);
+	size_t wrong = 0;
+	for (size_t i = 0; i < std::min<size_t>(rays.size(), 200); i++) {
+		float distance = WORLD_SIZE * 2.0f, bruteDistance = distance;
+		uint32_t object = 0;
+		bvh.raycast(rays[i], distance, object, [&](uint32_t primitive, const Ray& r, float closest, float& hitDistance) {
+			return intersectBox(boxes, primitive, r, closest, hitDistance);
+		});
+		for (uint32_t primitive = 0; primitive < boxes.size(); primitive++) {
+			float hitDistance;
+			if (intersectBox(boxes, primitive, rays[i], bruteDistance, hitDistance)) {
+				bruteDistance = hitDistance;
+			}
+		}
+		wrong += distance != bruteDistance;
+	}
+	std::cout << "  object picking: " << rays.size() / (rayMilliseconds * 1000.0) << "M rays/s, " << hits * 100.0 / rays.size()
+		<< "% hit, " << wrong << " of 200 differ from brute force" << std::endl;
+}
+
+void BvhBenchmark::runTerrain()
+{
+	Mesh terrain = generateTerrain(settings.terrainSize);
+	TriangleBvh bvh;
+	auto buildStart = std::chrono::steady_clock::now();
+	bvh.build(terrain);
+	double buildMilliseconds = millisecondsSince(buildStart);
+	std::cout << "  terrain: " << bvh.triangleCount() << " triangles, built in " << buildMilliseconds << " ms ("
+		<< bvh.triangleCount() / (buildMilliseconds * 1000.0) << "M triangles/s), depth " << bvh.getBvh().getDepth() << std::endl;
+
+	//rays from a camera above the terrain looking down at an angle, like a cursor over a ground plane
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> coordinate(0.0f, 1.0f), tilt(-0.5f, 0.5f);
+	std::vector<Ray> rays(settings.rays);
+	for (auto& ray : rays) {
+		ray.origin = glm::vec3(coordinate(random), 0.5f, coordinate(random));
+		ray.direction = glm::normalize(glm::vec3(tilt(random), -1.0f, tilt(random)));
+	}
+	size_t hits = 0;
+	auto rayStart = std::chrono::steady_clock::now();
+	for (const auto& ray : rays) {
+		TriangleHit hit;
+		hits += bvh.raycast(ray, 10.0f, hit);
+	}
+	double rayMilliseconds = millisecondsSince(rayStart);
+
+	size_t wrong = 0;
+	for (size_t i = 0; i < std::min<size_t>(rays.size(), 20); i++) {
+		TriangleHit hit;
+		float distance = bvh.raycast(rays[i], 10.0f, hit) ? hit.distance : 10.0f;
+		float bruteDistance = 10.0f;
+		for (size_t t = 0; t < terrain.indices.size(); t += 3) {
+			glm::vec2 barycentric;
+			float hitDistance;
+			if (glm::intersectRayTriangle(rays[i].origin, rays[i].direction, terrain.vertices[terrain.indices[t]].position, terrain.vertices[terrain.indices[t + 1]].position,
+				terrain.vertices[terrain.indices[t + 2]].position, barycentric, hitDistance) && hitDistance >= 0.0f && hitDistance < bruteDistance) {
+				bruteDistance = hitDistance;
+			}
+		}
+		wrong += distance != bruteDistance;
+	}
+	std::cout << "  terrain picking: " << rays.size() / (rayMilliseconds * 1000.0) << "M rays/s, " << hits * 100.0 / rays.size()
+		<< "% hit, " << wrong << " of 20 differ from brute force" << std::endl;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+	settings for the BVH benchmark, filled in from the command line
+*/
+struct BvhBenchmarkSettings {
+	bool enabled = false;
+	uint32_t objects = 100000; //boxes in the object hierarchy
+	uint32_t terrainSize = 512; //the picking mesh is a terrain of terrainSize x terrainSize quads
+	uint32_t rays = 1000000; //rays per raycast test
+	uint32_t frustums = 200; //cameras for the culling test
+	float movingFraction = 0.01f; //share of the objects moved before each refit
+};
+
+/*
+	BVH benchmark
+
+	Builds the hierarchy over a field of object boxes and over the triangles of a terrain mesh and reports the build time,
+	the time of an incremental refit after moving a share of the objects next to a full refit, and the throughput of
+	frustum culling and of ray picking against both, each checked against a brute force loop over every primitive.
+	Runs on the CPU only.
+*/
+class BvhBenchmark
+{
+public:
+	explicit BvhBenchmark(const BvhBenchmarkSettings& settings);
+	void run();
+
+private:
+	void runObjects();
+	void runTerrain();
+
+	BvhBenchmarkSettings settings;
+};
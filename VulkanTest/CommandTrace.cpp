@@ -0,0 +1,349 @@
+#include "CommandTrace.h"
+
+#include <fstream>
+
+void CommandTrace::save(const std::string& filename) const
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open trace file " + filename + "!");
+	}
+	uint32_t header[2] = { MAGIC, VERSION };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	for (const auto& record : records) {
+		uint32_t recordHeader[2] = { static_cast<uint32_t>(record.op), static_cast<uint32_t>(record.payload.size()) };
+		file.write(reinterpret_cast<const char*>(recordHeader), sizeof(recordHeader));
+		file.write(reinterpret_cast<const char*>(record.payload.data()), record.payload.size());
+	}
+}
+
+CommandTrace CommandTrace::load(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open trace file " + filename + "!");
+	}
+	uint32_t header[2] = {};
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!file || header[0] != MAGIC) {
+		throw std::runtime_error("failed to load trace, " + filename + " is not a command stream trace!");
+	}
+	if (header[1] != VERSION) {
+		throw std::runtime_error("failed to load trace, unsupported version " + std::to_string(header[1]) + "!");
+	}
+
+	CommandTrace trace;
+	uint32_t recordHeader[2];
+	while (file.read(reinterpret_cast<char*>(recordHeader), sizeof(recordHeader))) {
+		TraceRecord record;
+		record.op = static_cast<TraceOp>(recordHeader[0]);
+		record.payload.resize(recordHeader[1]);
+		if (!file.read(reinterpret_cast<char*>(record.payload.data()), record.payload.size())) {
+			throw std::runtime_error("failed to load trace, " + filename + " is truncated!");
+		}
+		trace.records.push_back(std::move(record));
+	}
+	return trace;
+}
+
+std::string TraceReader::getString()
+{
+	std::vector<char> characters = getArray<char>();
+	return std::string(characters.begin(), characters.end());
+}
+
+void CommandTraceRecorder::begin()
+{
+	trace.records.clear();
+	shaderModuleIds.clear();
+	renderPassIds.clear();
+	pipelineLayoutIds.clear();
+	bufferIds.clear();
+	pipelineIds.clear();
+	framebufferIds.clear();
+	recording = true;
+}
+
+void CommandTraceRecorder::add(TraceOp op, Payload& payload)
+{
+	trace.records.push_back({ op, std::move(payload.data) });
+}
+
+void CommandTraceRecorder::shaderModule(VkShaderModule module, const std::vector<char>& code)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(shaderModuleIds, module, true));
+	payload.putArray(code.data(), static_cast<uint32_t>(code.size()));
+	add(TraceOp::ShaderModule, payload);
+}
+
+/*
+	attachments and dependencies contain no pointers and are stored directly, subpasses only keep their colour and depth references
+*/
+void CommandTraceRecorder::renderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo& info)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(renderPassIds, renderPass, true));
+	payload.putArray(info.pAttachments, info.attachmentCount);
+	payload.put(info.subpassCount);
+	for (uint32_t i = 0; i < info.subpassCount; i++) {
+		const VkSubpassDescription& subpass = info.pSubpasses[i];
+		if (subpass.inputAttachmentCount != 0 || subpass.pResolveAttachments != nullptr || subpass.preserveAttachmentCount != 0) {
+			throw std::runtime_error("failed to trace render pass, only colour and depth attachments are supported!");
+		}
+		payload.put(subpass.pipelineBindPoint);
+		payload.putArray(subpass.pColorAttachments, subpass.colorAttachmentCount);
+		payload.putArray(subpass.pDepthStencilAttachment, 1);
+	}
+	payload.putArray(info.pDependencies, info.dependencyCount);
+	add(TraceOp::RenderPass, payload);
+}
+
+/*
+	only the push constant ranges are traced, descriptor set layouts are not supported by the replayer
+*/
+void CommandTraceRecorder::pipelineLayout(VkPipelineLayout layout, const VkPipelineLayoutCreateInfo& info)
+{
+	if (!recording) {
+		return;
+	}
+	if (info.setLayoutCount != 0) {
+		throw std::runtime_error("failed to trace pipeline layout, descriptor set layouts are not supported!");
+	}
+	Payload payload;
+	payload.put(idOf(pipelineLayoutIds, layout, true));
+	payload.putArray(info.pPushConstantRanges, info.pushConstantRangeCount);
+	add(TraceOp::PipelineLayout, payload);
+}
+
+/*
+	the contents go into the trace so the replayer can recreate the buffer with the same data
+*/
+void CommandTraceRecorder::buffer(VkBuffer buffer, const VkBufferCreateInfo& info, const void* contents)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(bufferIds, buffer, true));
+	payload.put(info.usage);
+	payload.putArray(static_cast<const uint8_t*>(contents), static_cast<uint32_t>(info.size));
+	add(TraceOp::Buffer, payload);
+}
+
+/*
+	the fixed function state is flattened field by field, the reading side is TraceReplayer::createPipeline
+*/
+void CommandTraceRecorder::graphicsPipeline(VkPipeline pipeline, const VkGraphicsPipelineCreateInfo& info)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(pipelineIds, pipeline, true));
+	payload.put(idOf(renderPassIds, info.renderPass, false));
+	payload.put(info.subpass);
+	payload.put(idOf(pipelineLayoutIds, info.layout, false));
+
+	payload.put(info.stageCount);
+	for (uint32_t i = 0; i < info.stageCount; i++) {
+		payload.put(info.pStages[i].stage);
+		payload.put(idOf(shaderModuleIds, info.pStages[i].module, false));
+		payload.putString(info.pStages[i].pName);
+	}
+
+	const VkPipelineVertexInputStateCreateInfo* vertexInput = info.pVertexInputState;
+	payload.putArray(vertexInput ? vertexInput->pVertexBindingDescriptions : nullptr, vertexInput ? vertexInput->vertexBindingDescriptionCount : 0);
+	payload.putArray(vertexInput ? vertexInput->pVertexAttributeDescriptions : nullptr, vertexInput ? vertexInput->vertexAttributeDescriptionCount : 0);
+
+	payload.put(info.pInputAssemblyState->topology);
+	payload.put(info.pInputAssemblyState->primitiveRestartEnable);
+
+	const VkPipelineViewportStateCreateInfo* viewport = info.pViewportState;
+	payload.putArray(viewport ? viewport->pViewports : nullptr, viewport ? viewport->viewportCount : 0);
+	payload.putArray(viewport ? viewport->pScissors : nullptr, viewport ? viewport->scissorCount : 0);
+
+	const VkPipelineRasterizationStateCreateInfo& rasterizer = *info.pRasterizationState;
+	payload.put(rasterizer.depthClampEnable);
+	payload.put(rasterizer.rasterizerDiscardEnable);
+	payload.put(rasterizer.polygonMode);
+	payload.put(rasterizer.cullMode);
+	payload.put(rasterizer.frontFace);
+	payload.put(rasterizer.depthBiasEnable);
+	payload.put(rasterizer.depthBiasConstantFactor);
+	payload.put(rasterizer.depthBiasClamp);
+	payload.put(rasterizer.depthBiasSlopeFactor);
+	payload.put(rasterizer.lineWidth);
+
+	const VkPipelineMultisampleStateCreateInfo& multisampling = *info.pMultisampleState;
+	payload.put(multisampling.rasterizationSamples);
+	payload.put(multisampling.sampleShadingEnable);
+	payload.put(multisampling.minSampleShading);
+	payload.put(multisampling.alphaToCoverageEnable);
+	payload.put(multisampling.alphaToOneEnable);
+
+	const VkPipelineDepthStencilStateCreateInfo* depthStencil = info.pDepthStencilState;
+	payload.put(static_cast<uint32_t>(depthStencil != nullptr));
+	if (depthStencil) {
+		payload.put(depthStencil->depthTestEnable);
+		payload.put(depthStencil->depthWriteEnable);
+		payload.put(depthStencil->depthCompareOp);
+		payload.put(depthStencil->depthBoundsTestEnable);
+		payload.put(depthStencil->stencilTestEnable);
+		payload.put(depthStencil->front);
+		payload.put(depthStencil->back);
+		payload.put(depthStencil->minDepthBounds);
+		payload.put(depthStencil->maxDepthBounds);
+	}
+
+	const VkPipelineColorBlendStateCreateInfo* blending = info.pColorBlendState;
+	payload.put(static_cast<uint32_t>(blending != nullptr));
+	if (blending) {
+		payload.put(blending->logicOpEnable);
+		payload.put(blending->logicOp);
+		payload.putArray(blending->pAttachments, blending->attachmentCount);
+		for (float constant : blending->blendConstants) {
+			payload.put(constant);
+		}
+	}
+
+	const VkPipelineDynamicStateCreateInfo* dynamic = info.pDynamicState;
+	payload.putArray(dynamic ? dynamic->pDynamicStates : nullptr, dynamic ? dynamic->dynamicStateCount : 0);
+	add(TraceOp::GraphicsPipeline, payload);
+}
+
+void CommandTraceRecorder::framebuffer(VkFramebuffer framebuffer, const VkFramebufferCreateInfo& info)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(framebufferIds, framebuffer, true));
+	payload.put(idOf(renderPassIds, info.renderPass, false));
+	payload.put(info.width);
+	payload.put(info.height);
+	payload.put(info.layers);
+	add(TraceOp::Framebuffer, payload);
+}
+
+void CommandTraceRecorder::beginFrame()
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	add(TraceOp::BeginFrame, payload);
+}
+
+void CommandTraceRecorder::cmdBeginRenderPass(const VkRenderPassBeginInfo& info, VkSubpassContents contents)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(renderPassIds, info.renderPass, false));
+	payload.put(idOf(framebufferIds, info.framebuffer, false));
+	payload.put(info.renderArea);
+	payload.putArray(info.pClearValues, info.clearValueCount);
+	payload.put(contents);
+	add(TraceOp::CmdBeginRenderPass, payload);
+}
+
+void CommandTraceRecorder::cmdBindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(bindPoint);
+	payload.put(idOf(pipelineIds, pipeline, false));
+	add(TraceOp::CmdBindPipeline, payload);
+}
+
+void CommandTraceRecorder::cmdBindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(firstBinding);
+	payload.put(bindingCount);
+	for (uint32_t i = 0; i < bindingCount; i++) {
+		payload.put(idOf(bufferIds, buffers[i], false));
+		payload.put(offsets[i]);
+	}
+	add(TraceOp::CmdBindVertexBuffers, payload);
+}
+
+void CommandTraceRecorder::cmdPushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(idOf(pipelineLayoutIds, layout, false));
+	payload.put(stageFlags);
+	payload.put(offset);
+	payload.putArray(static_cast<const uint8_t*>(values), size);
+	add(TraceOp::CmdPushConstants, payload);
+}
+
+void CommandTraceRecorder::cmdSetViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* viewports)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(firstViewport);
+	payload.putArray(viewports, viewportCount);
+	add(TraceOp::CmdSetViewport, payload);
+}
+
+void CommandTraceRecorder::cmdSetScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* scissors)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(firstScissor);
+	payload.putArray(scissors, scissorCount);
+	add(TraceOp::CmdSetScissor, payload);
+}
+
+void CommandTraceRecorder::cmdDraw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	payload.put(vertexCount);
+	payload.put(instanceCount);
+	payload.put(firstVertex);
+	payload.put(firstInstance);
+	add(TraceOp::CmdDraw, payload);
+}
+
+void CommandTraceRecorder::cmdEndRenderPass()
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	add(TraceOp::CmdEndRenderPass, payload);
+}
+
+void CommandTraceRecorder::endFrame()
+{
+	if (!recording) {
+		return;
+	}
+	Payload payload;
+	add(TraceOp::EndFrame, payload);
+	recording = false; //one frame is all the replayer needs
+}
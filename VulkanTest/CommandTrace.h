@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+	opcodes of the records in a command stream trace
+	resource records describe how an object was created, command records are the vkCmd* calls of the recorded frame
+*/
+enum class TraceOp : uint32_t {
+	ShaderModule = 1, //id, SPIR-V code
+	RenderPass, //id, attachments, subpasses, dependencies
+	GraphicsPipeline, //id, render pass id, shader stages and fixed function state
+	Framebuffer, //id, render pass id, dimensions (the replayer creates its own attachment images)
+	BeginFrame, //start of the recorded command buffer
+	CmdBeginRenderPass,
+	CmdBindPipeline,
+	CmdSetViewport,
+	CmdSetScissor,
+	CmdDraw,
+	CmdEndRenderPass,
+	EndFrame, //end of the recorded command buffer
+	PipelineLayout, //id, push constant ranges
+	Buffer, //id, size, usage, contents
+	CmdBindVertexBuffers,
+	CmdPushConstants
+};
+
+/*
+	one record of a trace: the opcode and its payload
+*/
+struct TraceRecord {
+	TraceOp op;
+	std::vector<uint8_t> payload;
+};
+
+/*
+	Command stream trace
+
+	Compact binary file: a header ("VKTR", version) followed by records of [opcode, payload size, payload].
+	Handles are replaced by small ids so the trace can be replayed against a different device.
+	Vulkan structs that contain no pointers are stored as they are in memory, so a trace is only
+	meant to be replayed on the architecture it was recorded on.
+*/
+struct CommandTrace {
+	static const uint32_t MAGIC = 0x52544B56; //"VKTR"
+	static const uint32_t VERSION = 2;
+
+	std::vector<TraceRecord> records;
+
+	void save(const std::string& filename) const;
+	static CommandTrace load(const std::string& filename);
+};
+
+/*
+	cursor reading values back out of a record's payload in the order they were written
+*/
+class TraceReader
+{
+public:
+	explicit TraceReader(const TraceRecord& record) : data(record.payload.data()), size(record.payload.size()) {}
+
+	template<typename T>
+	T get() {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read from a trace");
+		T value;
+		read(&value, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	std::vector<T> getArray() {
+		static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read from a trace");
+		std::vector<T> values(get<uint32_t>());
+		if (!values.empty()) {
+			read(values.data(), values.size() * sizeof(T));
+		}
+		return values;
+	}
+
+	std::string getString();
+
+private:
+	void read(void* out, size_t bytes) {
+		if (offset + bytes > size) {
+			throw std::runtime_error("failed to read trace, record is truncated!");
+		}
+		std::memcpy(out, data + offset, bytes);
+		offset += bytes;
+	}
+
+	const uint8_t* data;
+	size_t size;
+	size_t offset = 0;
+};
+
+/*
+	Records the resource creations and the vkCmd* calls of one frame from TriangleApp
+
+	The application calls the recorder next to the real Vulkan calls with the same create infos, so what is traced is
+	exactly what was submitted. Recording stops at endFrame, after which every call is ignored.
+*/
+class CommandTraceRecorder
+{
+public:
+	void begin(); //start a new trace
+	bool isRecording() const { return recording; }
+
+	void shaderModule(VkShaderModule module, const std::vector<char>& code);
+	void renderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo& info);
+	void pipelineLayout(VkPipelineLayout layout, const VkPipelineLayoutCreateInfo& info);
+	void buffer(VkBuffer buffer, const VkBufferCreateInfo& info, const void* contents); //contents are the info.size bytes uploaded to it
+	void graphicsPipeline(VkPipeline pipeline, const VkGraphicsPipelineCreateInfo& info);
+	void framebuffer(VkFramebuffer framebuffer, const VkFramebufferCreateInfo& info);
+
+	void beginFrame();
+	void cmdBeginRenderPass(const VkRenderPassBeginInfo& info, VkSubpassContents contents);
+	void cmdBindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+	void cmdBindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets);
+	void cmdPushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values);
+	void cmdSetViewport(uint32_t firstViewport, uint32_t viewportCount, const VkViewport* viewports);
+	void cmdSetScissor(uint32_t firstScissor, uint32_t scissorCount, const VkRect2D* scissors);
+	void cmdDraw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+	void cmdEndRenderPass();
+	void endFrame(); //stops recording
+
+	void save(const std::string& filename) const { trace.save(filename); }
+	size_t recordCount() const { return trace.records.size(); }
+
+private:
+	//appends plain values to the record being written
+	class Payload
+	{
+	public:
+		template<typename T>
+		void put(const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "only plain data can be written to a trace");
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			data.insert(data.end(), bytes, bytes + sizeof(T));
+		}
+
+		template<typename T>
+		void putArray(const T* values, uint32_t count) {
+			put(values != nullptr ? count : 0u);
+			for (uint32_t i = 0; values != nullptr && i < count; i++) {
+				put(values[i]);
+			}
+		}
+
+		void putString(const char* string) {
+			putArray(string, static_cast<uint32_t>(std::strlen(string)));
+		}
+
+		std::vector<uint8_t> data;
+	};
+
+	void add(TraceOp op, Payload& payload);
+
+	//handles are mapped to ids in creation order, separately per object type
+	template<typename Handle>
+	uint32_t idOf(std::map<Handle, uint32_t>& ids, Handle handle, bool create) {
+		auto it = ids.find(handle);
+		if (it != ids.end()) {
+			return it->second;
+		}
+		if (!create) {
+			throw std::runtime_error("failed to trace command, it uses an object that was not traced!");
+		}
+		uint32_t id = static_cast<uint32_t>(ids.size());
+		ids[handle] = id;
+		return id;
+	}
+
+	bool recording = false;
+	CommandTrace trace;
+	std::map<VkShaderModule, uint32_t> shaderModuleIds;
+	std::map<VkRenderPass, uint32_t> renderPassIds;
+	std::map<VkPipelineLayout, uint32_t> pipelineLayoutIds;
+	std::map<VkBuffer, uint32_t> bufferIds;
+	std::map<VkPipeline, uint32_t> pipelineIds;
+	std::map<VkFramebuffer, uint32_t> framebufferIds;
+};
@@ -0,0 +1,26 @@
+#include "DeletionQueue.h"
+
+#include <utility>
+
+void DeletionQueue::push(uint64_t lastUse, Deleter deleter)
+{
+	entries.push_back({ lastUse, std::move(deleter) });
+}
+
+void DeletionQueue::collect(uint64_t completed)
+{
+	while (!entries.empty() && entries.front().lastUse <= completed) {
+		Deleter deleter = std::move(entries.front().deleter);
+		entries.pop_front(); //pop first so a deleter that pushes more work cannot invalidate the entry being run
+		deleter();
+	}
+}
+
+void DeletionQueue::flush()
+{
+	while (!entries.empty()) {
+		Deleter deleter = std::move(entries.front().deleter);
+		entries.pop_front();
+		deleter();
+	}
+}
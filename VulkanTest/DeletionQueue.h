@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+/*
+	Deferred destruction of Vulkan objects
+
+	Objects that may still be referenced by submitted work are not destroyed straight away, they are pushed here tagged
+	with the serial of the last submission that could use them. Once the fence of that submission has been waited on
+	(or seen signalled) the owner calls collect() with the newest completed serial and everything up to it is destroyed.
+	Submissions complete in order on a single queue, so the serials only ever increase and the queue stays sorted.
+*/
+class DeletionQueue
+{
+public:
+	using Deleter = std::function<void()>;
+
+	void push(uint64_t lastUse, Deleter deleter); //lastUse is the serial of the newest submission that may reference the objects
+	void collect(uint64_t completed); //destroy everything last used by a submission that has completed
+	void flush(); //destroy everything now, only valid once the device has finished all submitted work
+	size_t pending() const { return entries.size(); }
+
+private:
+	struct Entry {
+		uint64_t lastUse;
+		Deleter deleter;
+	};
+	std::deque<Entry> entries; //oldest first
+};
@@ -0,0 +1,185 @@
+#include "DepthPyramid.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+	const uint32_t GROUP_SIZE = 8; //hiz.comp's workgroup is GROUP_SIZE x GROUP_SIZE
+}
+
+void DepthPyramid::init(VkDevice device, VkPhysicalDevice physicalDevice, VkImageView depthView, VkExtent2D depthExtent)
+{
+	if (depthExtent.width != depthExtent.height || depthExtent.width < 2 || (depthExtent.width & (depthExtent.width - 1)) != 0) {
+		throw std::runtime_error("failed to create depth pyramid, the depth buffer has to be square with a power of two size!");
+	}
+	this->device = device;
+	pyramidExtent = { depthExtent.width / 2, depthExtent.height / 2 };
+	levelCount = 1;
+	while ((pyramidExtent.width >> levelCount) > 0) {
+		levelCount++;
+	}
+
+	DeviceMemoryScope memoryScope("DepthPyramid", "pyramid");
+	createImage(device, physicalDevice, pyramidExtent, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		pyramid, pyramidMemory, nullptr, levelCount);
+	pyramidView = createImageView(device, pyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+	for (uint32_t level = 0; level < levelCount; level++) {
+		levelViews.push_back(createImageView(device, pyramid, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 1, level));
+	}
+
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO; //struct type
+	samplerInfo.magFilter = VK_FILTER_NEAREST; //only ever read with texelFetch
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	if (vkCreateSampler(device, &samplerInfo, nullptr, &pyramidSampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create depth pyramid sampler!");
+	}
+
+	createPipeline();
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		VkDescriptorImageInfo sourceInfo = { pyramidSampler, level == 0 ? depthView : levelViews[level - 1],
+			level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL };
+		VkDescriptorImageInfo destinationInfo = { VK_NULL_HANDLE, levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+		VkWriteDescriptorSet writes[2] = {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+		writes[0].dstSet = levelSets[level];
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &sourceInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+		writes[1].dstSet = levelSets[level];
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &destinationInfo;
+		vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+	}
+}
+
+void DepthPyramid::createPipeline()
+{
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	setLayoutInfo.bindingCount = 2;
+	setLayoutInfo.pBindings = bindings;
+	if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSizes[2] = {
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levelCount },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levelCount },
+	};
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.maxSets = levelCount;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> setLayouts(levelCount, descriptorSetLayout);
+	levelSets.resize(levelCount);
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = levelCount;
+	allocInfo.pSetLayouts = setLayouts.data();
+	if (vkAllocateDescriptorSets(device, &allocInfo, levelSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor sets!");
+	}
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &descriptorSetLayout;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule computeModule = createShaderModule(device, readBinaryFile("../shaders/hiz_comp.spv"));
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(device, computeModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline!");
+	}
+}
+
+void DepthPyramid::recordClear(VkCommandBuffer commandBuffer)
+{
+	imageBarrier(commandBuffer, pyramid, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	VkClearColorValue farPlane = {};
+	farPlane.float32[0] = 1.0f;
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+	vkCmdClearColorImage(commandBuffer, pyramid, VK_IMAGE_LAYOUT_GENERAL, &farPlane, 1, &range);
+	imageBarrier(commandBuffer, pyramid, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+}
+
+/*
+	one dispatch per level, each waiting for the level before it
+*/
+void DepthPyramid::recordBuild(VkCommandBuffer commandBuffer)
+{
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; //the previous build, and the tests that read it
+	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	for (uint32_t level = 0; level < levelCount; level++) {
+		uint32_t width = std::max(pyramidExtent.width >> level, 1u);
+		uint32_t height = std::max(pyramidExtent.height >> level, 1u);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &levelSets[level], 0, nullptr);
+		vkCmdDispatch(commandBuffer, (width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+void DepthPyramid::cleanup()
+{
+	if (device == VK_NULL_HANDLE) {
+		return;
+	}
+	vkDestroyPipeline(device, pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	vkDestroySampler(device, pyramidSampler, nullptr);
+	for (VkImageView levelView : levelViews) {
+		vkDestroyImageView(device, levelView, nullptr);
+	}
+	vkDestroyImageView(device, pyramidView, nullptr);
+	vkDestroyImage(device, pyramid, nullptr);
+	freeDeviceMemory(device, pyramidMemory, nullptr);
+	*this = DepthPyramid();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+/*
+	Hierarchical depth (Hi-Z) pyramid
+
+	A single channel float image whose level 0 is half the size of the depth buffer and whose every level keeps the
+	farthest depth of the 2x2 texels under it, reduced by hiz.comp one level per dispatch. Depth here runs from 0 at the
+	near plane to 1 at the far plane, so farthest is the maximum (a reversed depth buffer would take the minimum). A box
+	whose nearest depth is farther than the pyramid texels covering its screen rectangle is hidden behind what was drawn
+	there, and one level always has few enough texels under the rectangle to test with four fetches.
+
+	The depth buffer has to be square with a power of two size so that every level halves exactly, and has to be sampled
+	(VK_IMAGE_USAGE_SAMPLED_BIT) in DEPTH_STENCIL_READ_ONLY_OPTIMAL. The pyramid stays in GENERAL, written as a storage
+	image by the reduction and read through sampler() by whoever tests against it.
+*/
+class DepthPyramid
+{
+public:
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, VkImageView depthView, VkExtent2D depthExtent);
+	void cleanup();
+
+	/*
+		move the pyramid to GENERAL and fill it with the far plane, so that nothing is occluded before the first build
+	*/
+	void recordClear(VkCommandBuffer commandBuffer);
+
+	/*
+		reduce the depth buffer into every level. the depth writes have to be visible to compute shader reads already, the
+		pyramid is left visible to compute shader reads
+	*/
+	void recordBuild(VkCommandBuffer commandBuffer);
+
+	VkImageView view() const { return pyramidView; } //every level
+	VkSampler sampler() const { return pyramidSampler; } //nearest, for texelFetch
+	VkExtent2D extent() const { return pyramidExtent; } //level 0
+	uint32_t levels() const { return levelCount; }
+
+private:
+	void createPipeline();
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkExtent2D pyramidExtent = {};
+	uint32_t levelCount = 0;
+
+	VkImage pyramid = VK_NULL_HANDLE;
+	VkDeviceMemory pyramidMemory = VK_NULL_HANDLE;
+	VkImageView pyramidView = VK_NULL_HANDLE;
+	std::vector<VkImageView> levelViews;
+	VkSampler pyramidSampler = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> levelSets; //level n reads the depth buffer (n = 0) or level n - 1 and writes level n
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+};
@@ -0,0 +1,135 @@
+#include "DeviceFeatures.h"
+
+#include <cstring>
+
+void DeviceFeatures::init(VkPhysicalDevice physicalDevice)
+{
+	this->physicalDevice = physicalDevice;
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	features2 = properties.apiVersion >= VK_API_VERSION_1_1;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &core);
+	enabled = {};
+	enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	chainedFeatures.clear();
+	extensions.clear();
+	names.clear();
+
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+	availableExtensions.resize(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+}
+
+bool DeviceFeatures::supportsExtension(const char* name) const
+{
+	for (const auto& extension : availableExtensions) {
+		if (strcmp(extension.extensionName, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool DeviceFeatures::wantExtension(const char* name)
+{
+	for (const char* extension : extensions) {
+		if (strcmp(extension, name) == 0) {
+			return true;
+		}
+	}
+	if (!supportsExtension(name)) {
+		return false;
+	}
+	extensions.push_back(name);
+	return true;
+}
+
+void DeviceFeatures::requireExtension(const char* name)
+{
+	if (!wantExtension(name)) {
+		throw std::runtime_error(std::string("failed to enable device extension ") + name + ", the device does not support it!");
+	}
+}
+
+bool DeviceFeatures::want(VkBool32 VkPhysicalDeviceFeatures::* feature, const char* name)
+{
+	if (core.*feature != VK_TRUE) {
+		return false;
+	}
+	if (enabled.features.*feature != VK_TRUE) {
+		enabled.features.*feature = VK_TRUE;
+		names.push_back(name);
+	}
+	return true;
+}
+
+void DeviceFeatures::require(VkBool32 VkPhysicalDeviceFeatures::* feature, const char* name)
+{
+	if (!want(feature, name)) {
+		throw std::runtime_error(std::string("failed to enable device feature ") + name + ", the device does not support it!");
+	}
+}
+
+/*
+	the supported features of a chained struct are queried on its own the first time it is asked for, on a 1.0 device
+	they all stay false
+*/
+DeviceFeatures::ChainedFeatures& DeviceFeatures::chained(VkStructureType sType, size_t size)
+{
+	for (auto& features : chainedFeatures) {
+		if (features->sType == sType) {
+			return *features;
+		}
+	}
+	chainedFeatures.emplace_back(new ChainedFeatures());
+	ChainedFeatures& features = *chainedFeatures.back();
+	features.sType = sType;
+	features.supported.assign(size, 0);
+	features.enabled.assign(size, 0);
+	reinterpret_cast<VkBaseOutStructure*>(features.supported.data())->sType = sType;
+	reinterpret_cast<VkBaseOutStructure*>(features.enabled.data())->sType = sType;
+	if (features2) {
+		VkPhysicalDeviceFeatures2 query = {};
+		query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		query.pNext = features.supported.data();
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &query);
+		reinterpret_cast<VkBaseOutStructure*>(features.supported.data())->pNext = nullptr;
+	}
+	return features;
+}
+
+const void* DeviceFeatures::chain()
+{
+	VkBaseOutStructure* last = reinterpret_cast<VkBaseOutStructure*>(&enabled);
+	last->pNext = nullptr;
+	for (auto& features : chainedFeatures) {
+		if (features->used) {
+			VkBaseOutStructure* next = reinterpret_cast<VkBaseOutStructure*>(features->enabled.data());
+			next->pNext = nullptr;
+			last->pNext = next;
+			last = next;
+		}
+	}
+	return enabled.pNext != nullptr ? &enabled : nullptr;
+}
+
+void DeviceFeatures::apply(VkDeviceCreateInfo& createInfo)
+{
+	createInfo.pNext = chain();
+	createInfo.pEnabledFeatures = createInfo.pNext == nullptr ? &enabled.features : nullptr; //the two are mutually exclusive
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
+}
+
+std::string DeviceFeatures::summary() const
+{
+	std::string text;
+	for (const auto& name : names) {
+		text += (text.empty() ? "" : ", ") + name;
+	}
+	for (const char* extension : extensions) {
+		text += (text.empty() ? "" : ", ") + std::string(extension);
+	}
+	return text.empty() ? "none" : text;
+}
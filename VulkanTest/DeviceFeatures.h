@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stdexcept>
+
+/*
+	Device feature negotiation
+
+	Passing the whole of vkGetPhysicalDeviceFeatures to vkCreateDevice turns on every feature the device has, and some
+	of them cost time on every access whether the app needs them or not: robustBufferAccess bounds checks every buffer
+	read and write, and drivers may pick slower paths for others. Instead every subsystem declares what it needs before
+	the device is created:
+
+		require  the feature or extension has to be there, throws when the device lacks it
+		want     enabled when the device has it, returns whether it was, so the caller can fall back
+
+	Core features are named by their member of VkPhysicalDeviceFeatures. Features of extension and newer core structs
+	(VkPhysicalDeviceDescriptorIndexingFeatures, VkPhysicalDevicePresentWaitFeaturesKHR ...) are named by the struct's
+	sType and member. The struct is queried through the VkPhysicalDeviceFeatures2 chain the first time it is asked for,
+	which needs a 1.1 instance and device, and only structs with an enabled feature are chained to the device. The
+	extension a struct belongs to has to be asked for separately.
+
+	Nothing is enabled unless asked for, so robustness is off unless a subsystem wants it.
+*/
+class DeviceFeatures
+{
+public:
+	void init(VkPhysicalDevice physicalDevice);
+
+	bool supportsExtension(const char* name) const;
+	bool wantExtension(const char* name);
+	void requireExtension(const char* name);
+
+	bool supports(VkBool32 VkPhysicalDeviceFeatures::* feature) const { return core.*feature == VK_TRUE; }
+	bool want(VkBool32 VkPhysicalDeviceFeatures::* feature, const char* name);
+	void require(VkBool32 VkPhysicalDeviceFeatures::* feature, const char* name);
+
+	template<typename T> bool supports(VkStructureType sType, VkBool32 T::* feature);
+	template<typename T> bool want(VkStructureType sType, VkBool32 T::* feature, const char* name);
+	template<typename T> void require(VkStructureType sType, VkBool32 T::* feature, const char* name);
+
+	/*
+		points createInfo at the enabled features and extensions: a VkPhysicalDeviceFeatures2 chain in pNext when a
+		chained struct has an enabled feature, pEnabledFeatures otherwise. they stay valid until the next change
+	*/
+	void apply(VkDeviceCreateInfo& createInfo);
+	const void* chain(); //the pNext chain on its own, null when only core features are enabled
+	const VkPhysicalDeviceFeatures& enabledCore() const { return enabled.features; }
+	const std::vector<const char*>& enabledExtensions() const { return extensions; }
+	std::string summary() const; //the enabled features and extensions, for the logs
+
+private:
+	struct ChainedFeatures {
+		VkStructureType sType;
+		std::vector<unsigned char> supported;
+		std::vector<unsigned char> enabled;
+		bool used = false; //an enabled feature, so it goes into the chain
+	};
+
+	ChainedFeatures& chained(VkStructureType sType, size_t size);
+
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	bool features2 = false; //the device is 1.1 or newer, chained structs can be queried
+	VkPhysicalDeviceFeatures core = {}; //supported
+	VkPhysicalDeviceFeatures2 enabled = {};
+	std::vector<std::unique_ptr<ChainedFeatures>> chainedFeatures;
+	std::vector<VkExtensionProperties> availableExtensions;
+	std::vector<const char*> extensions;
+	std::vector<std::string> names; //every enabled feature
+};
+
+template<typename T> bool DeviceFeatures::supports(VkStructureType sType, VkBool32 T::* feature)
+{
+	return reinterpret_cast<const T*>(chained(sType, sizeof(T)).supported.data())->*feature == VK_TRUE;
+}
+
+template<typename T> bool DeviceFeatures::want(VkStructureType sType, VkBool32 T::* feature, const char* name)
+{
+	ChainedFeatures& features = chained(sType, sizeof(T));
+	if (reinterpret_cast<const T*>(features.supported.data())->*feature != VK_TRUE) {
+		return false;
+	}
+	T& enabledFeatures = *reinterpret_cast<T*>(features.enabled.data());
+	if (enabledFeatures.*feature != VK_TRUE) {
+		enabledFeatures.*feature = VK_TRUE;
+		features.used = true;
+		names.push_back(name);
+	}
+	return true;
+}
+
+template<typename T> void DeviceFeatures::require(VkStructureType sType, VkBool32 T::* feature, const char* name)
+{
+	if (!want(sType, feature, name)) {
+		throw std::runtime_error(std::string("failed to enable device feature ") + name + ", the device does not support it!");
+	}
+}
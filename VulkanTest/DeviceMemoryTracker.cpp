@@ -0,0 +1,310 @@
+#include "DeviceMemoryTracker.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+	const char* UNTAGGED = "untagged"; //subsystem of allocations made outside any DeviceMemoryScope
+
+	double megabytes(VkDeviceSize bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	//subsystem and resource names are ours, but file names can carry backslashes and quotes
+	std::string jsonString(const std::string& text)
+	{
+		std::string escaped = "\"";
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+				escaped += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				const char* hex = "0123456789abcdef";
+				escaped += "\\u00";
+				escaped += hex[(c >> 4) & 0xf];
+				escaped += hex[c & 0xf];
+			}
+			else {
+				escaped += c;
+			}
+		}
+		return escaped + "\"";
+	}
+}
+
+thread_local const DeviceMemoryScope* DeviceMemoryTracker::currentScope = nullptr;
+
+VkResult allocateDeviceMemory(VkDevice device, const VkMemoryAllocateInfo* allocateInfo, const VkAllocationCallbacks* allocator, VkDeviceMemory* memory)
+{
+	VkResult result = vkAllocateMemory(device, allocateInfo, allocator, memory);
+	if (result == VK_SUCCESS) {
+		DeviceMemoryTracker::global().recordAllocation(device, *memory, *allocateInfo);
+	}
+	else {
+		DeviceMemoryTracker::global().recordFailure(device, *allocateInfo);
+	}
+	return result;
+}
+
+void freeDeviceMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* allocator)
+{
+	if (memory != VK_NULL_HANDLE) {
+		DeviceMemoryTracker::global().recordFree(device, memory); //before the handle can be handed out again
+	}
+	vkFreeMemory(device, memory, allocator);
+}
+
+DeviceMemoryScope::DeviceMemoryScope(std::string subsystem, std::string name) : subsystem(std::move(subsystem)), name(std::move(name))
+{
+	outer = DeviceMemoryTracker::currentScope;
+	DeviceMemoryTracker::currentScope = this;
+}
+
+DeviceMemoryScope::~DeviceMemoryScope()
+{
+	DeviceMemoryTracker::currentScope = outer;
+}
+
+DeviceMemoryTracker& DeviceMemoryTracker::global()
+{
+	static DeviceMemoryTracker tracker;
+	return tracker;
+}
+
+/*
+	the subsystem of the innermost scope, and the name of the innermost scope that has one
+*/
+void DeviceMemoryTracker::currentTags(std::string& subsystem, std::string& name)
+{
+	subsystem = currentScope != nullptr ? currentScope->subsystem : UNTAGGED;
+	name.clear();
+	for (const DeviceMemoryScope* scope = currentScope; scope != nullptr && name.empty(); scope = scope->outer) {
+		name = scope->name;
+	}
+}
+
+void DeviceMemoryTracker::registerDevice(VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudgetExtension)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Device& state = devices[device];
+	state = Device();
+	state.physicalDevice = physicalDevice;
+	state.memoryBudgetExtension = memoryBudgetExtension;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &state.memoryProperties);
+	state.heaps.resize(state.memoryProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < state.memoryProperties.memoryHeapCount; i++) {
+		state.heaps[i].size = state.memoryProperties.memoryHeaps[i].size;
+		state.heaps[i].deviceLocal = (state.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	}
+}
+
+/*
+	everything still allocated when the device goes away was never freed, list it with what it was made for
+*/
+size_t DeviceMemoryTracker::unregisterDevice(VkDevice device, std::ostream& out)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	if (found == devices.end()) {
+		return 0;
+	}
+	const Device& state = found->second;
+	size_t leaks = state.allocations.size();
+	if (leaks != 0) {
+		VkDeviceSize bytes = 0;
+		for (const auto& allocation : state.allocations) {
+			bytes += allocation.second.size;
+		}
+		out << "device memory: " << leaks << " allocations (" << megabytes(bytes) << " MB) leaked\n";
+		for (const Allocation* allocation : sortedAllocations(state)) {
+			out << "  " << allocation->subsystem << (allocation->name.empty() ? "" : " " + allocation->name) << ": " << allocation->size
+				<< " bytes, memory type " << allocation->memoryType << ", heap " << allocation->heap << "\n";
+		}
+	}
+	devices.erase(found);
+	return leaks;
+}
+
+void DeviceMemoryTracker::recordAllocation(VkDevice device, VkDeviceMemory memory, const VkMemoryAllocateInfo& allocateInfo)
+{
+	Allocation allocation;
+	allocation.size = allocateInfo.allocationSize;
+	allocation.memoryType = allocateInfo.memoryTypeIndex;
+	currentTags(allocation.subsystem, allocation.name); //outside the lock, the scopes belong to this thread
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	if (found == devices.end()) {
+		return;
+	}
+	Device& state = found->second;
+	allocation.heap = state.memoryProperties.memoryTypes[allocation.memoryType].heapIndex;
+	allocation.serial = state.nextSerial++;
+
+	DeviceHeapUsage& heap = state.heaps[allocation.heap];
+	heap.trackedBytes += allocation.size;
+	heap.peakBytes = std::max(heap.peakBytes, heap.trackedBytes);
+	heap.allocations++;
+	SubsystemUsage& subsystem = state.subsystems[allocation.subsystem];
+	subsystem.bytes += allocation.size;
+	subsystem.peakBytes = std::max(subsystem.peakBytes, subsystem.bytes);
+	subsystem.allocations++;
+	state.allocations[memory] = std::move(allocation);
+}
+
+void DeviceMemoryTracker::recordFailure(VkDevice device, const VkMemoryAllocateInfo& allocateInfo)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	if (found != devices.end()) {
+		found->second.heaps[found->second.memoryProperties.memoryTypes[allocateInfo.memoryTypeIndex].heapIndex].failures++;
+	}
+}
+
+void DeviceMemoryTracker::recordFree(VkDevice device, VkDeviceMemory memory)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	if (found == devices.end()) {
+		return;
+	}
+	Device& state = found->second;
+	auto allocation = state.allocations.find(memory);
+	if (allocation == state.allocations.end()) {
+		return; //allocated before the device was registered
+	}
+	DeviceHeapUsage& heap = state.heaps[allocation->second.heap];
+	heap.trackedBytes -= allocation->second.size;
+	heap.allocations--;
+	SubsystemUsage& subsystem = state.subsystems[allocation->second.subsystem];
+	subsystem.bytes -= allocation->second.size;
+	subsystem.allocations--;
+	state.allocations.erase(allocation);
+}
+
+std::vector<DeviceHeapUsage> DeviceMemoryTracker::heapUsage(VkDevice device) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	return found != devices.end() ? heapUsage(found->second) : std::vector<DeviceHeapUsage>();
+}
+
+/*
+	the tracked numbers with the budget and process usage filled in, queried now as both change with the rest of the system
+*/
+std::vector<DeviceHeapUsage> DeviceMemoryTracker::heapUsage(const Device& state) const
+{
+	std::vector<DeviceHeapUsage> heaps = state.heaps;
+	if (!state.memoryBudgetExtension) { //and without a 1.1 instance vkGetPhysicalDeviceMemoryProperties2 cannot be called at all
+		for (auto& heap : heaps) {
+			heap.budget = heap.size;
+		}
+		return heaps;
+	}
+	std::vector<HeapBudget> budgets = queryHeapBudgets(state.physicalDevice, true);
+	for (size_t i = 0; i < heaps.size() && i < budgets.size(); i++) {
+		heaps[i].budget = budgets[i].budget;
+		heaps[i].processUsage = budgets[i].usage;
+	}
+	return heaps;
+}
+
+std::vector<const DeviceMemoryTracker::Allocation*> DeviceMemoryTracker::sortedAllocations(const Device& state) const
+{
+	std::vector<const Allocation*> sorted;
+	sorted.reserve(state.allocations.size());
+	for (const auto& allocation : state.allocations) {
+		sorted.push_back(&allocation.second);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Allocation* a, const Allocation* b) { return a->serial < b->serial; });
+	return sorted;
+}
+
+void DeviceMemoryTracker::report(VkDevice device, std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	if (found == devices.end()) {
+		return;
+	}
+	const Device& state = found->second;
+	std::vector<DeviceHeapUsage> heaps = heapUsage(state);
+
+	out << "device memory: " << state.allocations.size() << " allocations" << (state.memoryBudgetExtension ? "" : " (no VK_EXT_memory_budget, budget is the heap size)") << "\n";
+	out << std::fixed << std::setprecision(1);
+	for (size_t i = 0; i < heaps.size(); i++) {
+		const DeviceHeapUsage& heap = heaps[i];
+		if (heap.peakBytes == 0 && heap.failures == 0 && heap.processUsage == 0) {
+			continue; //nothing of ours lives there
+		}
+		out << "  heap " << i << (heap.deviceLocal ? " (device local)" : "") << ": tracked " << megabytes(heap.trackedBytes) << " MB in "
+			<< heap.allocations << " allocations, peak " << megabytes(heap.peakBytes) << " MB";
+		if (state.memoryBudgetExtension) {
+			out << ", process usage " << megabytes(heap.processUsage) << " MB";
+		}
+		out << ", budget " << megabytes(heap.budget) << " of " << megabytes(heap.size) << " MB ("
+			<< (heap.budget != 0 ? 100.0 * std::max(heap.trackedBytes, heap.processUsage) / heap.budget : 0.0) << "% used)";
+		if (heap.failures != 0) {
+			out << ", " << heap.failures << " failed allocations";
+		}
+		if (std::max(heap.trackedBytes, heap.processUsage) > heap.budget) {
+			out << ", OVER BUDGET";
+		}
+		out << "\n";
+	}
+	for (const auto& subsystem : state.subsystems) {
+		out << "  " << std::setw(20) << std::left << subsystem.first << std::right << " " << megabytes(subsystem.second.bytes) << " MB in "
+			<< subsystem.second.allocations << " allocations, peak " << megabytes(subsystem.second.peakBytes) << " MB\n";
+	}
+	out << std::defaultfloat;
+}
+
+void DeviceMemoryTracker::writeJson(VkDevice device, std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = devices.find(device);
+	if (found == devices.end()) {
+		out << "{}\n";
+		return;
+	}
+	const Device& state = found->second;
+	std::vector<DeviceHeapUsage> heaps = heapUsage(state);
+
+	out << "{\n  \"memoryBudgetExtension\": " << (state.memoryBudgetExtension ? "true" : "false") << ",\n  \"heaps\": [";
+	for (size_t i = 0; i < heaps.size(); i++) {
+		const DeviceHeapUsage& heap = heaps[i];
+		out << (i == 0 ? "\n" : ",\n") << "    { \"index\": " << i << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+			<< ", \"size\": " << heap.size << ", \"budget\": " << heap.budget << ", \"processUsage\": " << heap.processUsage
+			<< ", \"trackedBytes\": " << heap.trackedBytes << ", \"peakBytes\": " << heap.peakBytes << ", \"allocations\": " << heap.allocations
+			<< ", \"failures\": " << heap.failures << " }";
+	}
+	out << "\n  ],\n  \"subsystems\": [";
+	bool first = true;
+	for (const auto& subsystem : state.subsystems) {
+		out << (first ? "\n" : ",\n") << "    { \"name\": " << jsonString(subsystem.first) << ", \"bytes\": " << subsystem.second.bytes
+			<< ", \"peakBytes\": " << subsystem.second.peakBytes << ", \"allocations\": " << subsystem.second.allocations << " }";
+		first = false;
+	}
+	out << "\n  ],\n  \"allocations\": [";
+	first = true;
+	for (const Allocation* allocation : sortedAllocations(state)) {
+		out << (first ? "\n" : ",\n") << "    { \"subsystem\": " << jsonString(allocation->subsystem) << ", \"name\": " << jsonString(allocation->name)
+			<< ", \"size\": " << allocation->size << ", \"memoryType\": " << allocation->memoryType << ", \"heap\": " << allocation->heap << " }";
+		first = false;
+	}
+	out << "\n  ]\n}\n";
+}
+
+void DeviceMemoryTracker::writeJson(VkDevice device, const std::string& filename) const
+{
+	std::ofstream file(filename);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open file " + filename + "!");
+	}
+	writeJson(device, file);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <mutex>
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+/*
+	vkAllocateMemory and vkFreeMemory with the allocation recorded in DeviceMemoryTracker, every device allocation in the
+	app goes through these. the allocation is tagged with the subsystem and resource name of the innermost
+	DeviceMemoryScope on the calling thread
+*/
+VkResult allocateDeviceMemory(VkDevice device, const VkMemoryAllocateInfo* allocateInfo, const VkAllocationCallbacks* allocator, VkDeviceMemory* memory);
+void freeDeviceMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* allocator);
+
+/*
+	tags the device allocations made on this thread while it is alive, scopes nest and the innermost one wins
+*/
+class DeviceMemoryScope
+{
+public:
+	explicit DeviceMemoryScope(std::string subsystem, std::string name = std::string());
+	~DeviceMemoryScope();
+
+	DeviceMemoryScope(const DeviceMemoryScope&) = delete;
+	DeviceMemoryScope& operator=(const DeviceMemoryScope&) = delete;
+
+private:
+	friend class DeviceMemoryTracker;
+	std::string subsystem;
+	std::string name; //empty keeps the name of the enclosing scope
+	const DeviceMemoryScope* outer;
+};
+
+/*
+	one heap's numbers: what the tracker saw allocated in it, and what VK_EXT_memory_budget says the process uses and may use
+*/
+struct DeviceHeapUsage {
+	VkDeviceSize size = 0;
+	VkDeviceSize budget = 0; //the heap size without VK_EXT_memory_budget
+	VkDeviceSize processUsage = 0; //everything the process uses (driver internal allocations included), 0 without VK_EXT_memory_budget
+	VkDeviceSize trackedBytes = 0; //live allocations made through allocateDeviceMemory
+	VkDeviceSize peakBytes = 0;
+	uint64_t allocations = 0; //live
+	uint64_t failures = 0; //allocations the driver refused
+	bool deviceLocal = false;
+};
+
+/*
+	Device memory accounting
+
+	Every VkDeviceMemory allocated through allocateDeviceMemory is recorded with its size, memory type and heap and with the
+	subsystem and resource name it was made for, and forgotten again by freeDeviceMemory. A device has to be registered
+	after it is created for its allocations to be mapped to heaps, and unregistered before it is destroyed: whatever is
+	still allocated at that point was leaked and is reported.
+
+	report() prints per heap usage next to the VK_EXT_memory_budget budget and usage (when the device was created with
+	the extension) and the totals per subsystem. writeJson() dumps the same plus every live allocation. Both can be called
+	from any thread, the tracker is locked for every update.
+*/
+class DeviceMemoryTracker
+{
+public:
+	static DeviceMemoryTracker& global(); //the tracker allocateDeviceMemory and freeDeviceMemory update
+
+	void registerDevice(VkDevice device, VkPhysicalDevice physicalDevice, bool memoryBudgetExtension);
+	size_t unregisterDevice(VkDevice device, std::ostream& out); //reports the leaks to out and returns how many there were
+
+	void recordAllocation(VkDevice device, VkDeviceMemory memory, const VkMemoryAllocateInfo& allocateInfo);
+	void recordFailure(VkDevice device, const VkMemoryAllocateInfo& allocateInfo);
+	void recordFree(VkDevice device, VkDeviceMemory memory);
+
+	std::vector<DeviceHeapUsage> heapUsage(VkDevice device) const;
+	void report(VkDevice device, std::ostream& out) const;
+	void writeJson(VkDevice device, std::ostream& out) const;
+	void writeJson(VkDevice device, const std::string& filename) const; //throws when the file cannot be written
+
+private:
+	friend class DeviceMemoryScope;
+
+	struct Allocation {
+		VkDeviceSize size;
+		uint32_t memoryType;
+		uint32_t heap;
+		uint64_t serial; //allocation order, so leaks are listed oldest first
+		std::string subsystem;
+		std::string name;
+	};
+
+	struct SubsystemUsage {
+		VkDeviceSize bytes = 0;
+		VkDeviceSize peakBytes = 0;
+		uint64_t allocations = 0;
+	};
+
+	struct Device {
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		bool memoryBudgetExtension = false;
+		VkPhysicalDeviceMemoryProperties memoryProperties = {};
+		std::vector<DeviceHeapUsage> heaps; //tracked part only, the budget is queried when asked for
+		std::map<std::string, SubsystemUsage> subsystems;
+		std::map<VkDeviceMemory, Allocation> allocations;
+		uint64_t nextSerial = 0;
+	};
+
+	std::vector<DeviceHeapUsage> heapUsage(const Device& state) const;
+	std::vector<const Allocation*> sortedAllocations(const Device& state) const;
+	static void currentTags(std::string& subsystem, std::string& name);
+
+	static thread_local const DeviceMemoryScope* currentScope;
+
+	mutable std::mutex mutex;
+	std::map<VkDevice, Device> devices; //allocations on unregistered devices are passed through untracked
+};
@@ -0,0 +1,386 @@
+#include "FrameCapture.h"
+#include "VulkanUtils.h"
+#include "ImageIO.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+FrameCapture::FrameCapture()
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+}
+
+/*
+	setup the readback ring and start the encoder threads
+*/
+void FrameCapture::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight, const CaptureSettings& settings)
+{
+	this->device = device;
+	this->physicalDevice = physicalDevice;
+	this->settings = settings;
+
+	//every frame in flight may hold a slot that has not completed yet, we need at least one more than that
+	//otherwise waiting for a free slot could wait on a copy that is never going to be collected
+	this->settings.ringSize = std::max(this->settings.ringSize, framesInFlight + 1);
+	this->settings.encoderThreads = std::max(this->settings.encoderThreads, 1u);
+
+	std::filesystem::create_directories(this->settings.outputDirectory); //make sure the output directory exists
+
+	//the copy command buffers are re-recorded for every captured frame (the source image changes) so they need to be individually resettable
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO; //struct type
+	poolInfo.queueFamilyIndex = queueFamilyIndex; //copies are submitted with the frame to the graphics queue
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; //rerecorded often and individually
+
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create capture command pool!");
+	}
+
+	slots.resize(this->settings.ringSize);
+	std::vector<VkCommandBuffer> commandBuffers(slots.size());
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
+	allocInfo.commandPool = commandPool; //pool to allocate from
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; //submitted directly alongside the frame's command buffer
+	allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size()); //one per slot
+
+	if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate capture command buffers!");
+	}
+
+	for (size_t i = 0; i < slots.size(); i++) {
+		slots[i].commandBuffer = commandBuffers[i];
+	}
+	//buffers are allocated lazily on first use so they always match the current swap chain size
+
+	stopping = false;
+	for (uint32_t i = 0; i < this->settings.encoderThreads; i++) {
+		encoders.emplace_back(&FrameCapture::encoderLoop, this);
+	}
+
+	startTime = std::chrono::steady_clock::now();
+	active = true;
+}
+
+/*
+	find a free slot, waiting for an encoder or giving up depending on the backpressure policy
+	returns -1 if the frame should not be captured
+*/
+int FrameCapture::acquireSlot()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	auto findFree = [this]() {
+		for (size_t i = 0; i < slots.size(); i++) {
+			if (slots[i].state == SlotState::Free) {
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	};
+
+	int slot = findFree();
+	if (slot < 0) {
+		if (settings.dropWhenFull) { //do not hold up the frame loop, just skip this frame
+			framesDropped++;
+			return -1;
+		}
+		//backpressure: the encoders are behind, wait until one of them returns a slot
+		producerStalls++;
+		auto waitStart = std::chrono::steady_clock::now();
+		slotFreed.wait(lock, [&]() { return (slot = findFree()) >= 0; });
+		stallTime += std::chrono::steady_clock::now() - waitStart;
+	}
+	return slot;
+}
+
+/*
+	(re)allocate the readback buffer of a slot if it is too small for the image being copied
+	only ever called on a slot owned by the frame loop, so no encoder is reading it
+*/
+void FrameCapture::ensureCapacity(ReadbackSlot& slot, VkDeviceSize size)
+{
+	if (slot.capacity >= size) {
+		return;
+	}
+	destroySlotBuffer(slot);
+
+	//host coherent so the encoders can read without invalidating, host cached because reading uncached memory from the CPU is very slow
+	DeviceMemoryScope memoryScope("FrameCapture", "readback");
+	createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+		slot.buffer, slot.memory);
+
+	if (vkMapMemory(device, slot.memory, 0, size, 0, &slot.mapped) != VK_SUCCESS) { //keep it mapped for its whole lifetime
+		throw std::runtime_error("failed to map capture buffer!");
+	}
+	slot.capacity = size;
+}
+
+void FrameCapture::destroySlotBuffer(ReadbackSlot& slot)
+{
+	if (slot.buffer != VK_NULL_HANDLE) {
+		vkUnmapMemory(device, slot.memory);
+		vkDestroyBuffer(device, slot.buffer, nullptr);
+		freeDeviceMemory(device, slot.memory, nullptr);
+	}
+	slot.buffer = VK_NULL_HANDLE;
+	slot.memory = VK_NULL_HANDLE;
+	slot.mapped = nullptr;
+	slot.capacity = 0;
+}
+
+/*
+	record: current layout -> transfer source, copy to the readback buffer, transfer source -> current layout
+	the command buffer is submitted in the same batch as the frame, before the render finished semaphore is signalled,
+	so presentation always happens after the copy
+*/
+VkCommandBuffer FrameCapture::recordCopy(VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent, size_t frameIndex)
+{
+	if (!active) {
+		return VK_NULL_HANDLE;
+	}
+
+	int index = acquireSlot();
+	if (index < 0) {
+		return VK_NULL_HANDLE;
+	}
+	ReadbackSlot& slot = slots[index];
+
+	ensureCapacity(slot, static_cast<VkDeviceSize>(extent.width) * extent.height * texelSize(format)); //throws for formats the encoders cannot convert
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //recorded again for the next capture
+
+	if (vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS) { //implicitly resets the buffer
+		throw std::runtime_error("failed to begin recording capture command buffer!");
+	}
+
+	//wait for the render pass to finish writing the image and move it into a layout we can copy from
+	VkImageMemoryBarrier toTransfer = {};
+	toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER; //struct type
+	toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT; //writes of the render pass
+	toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT; //must be visible to the copy
+	toTransfer.oldLayout = layout; //final layout of the render pass
+	toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; //layout for copying from
+	toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED; //no ownership transfer
+	toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.image = image;
+	toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }; //colour, single mip and layer
+	vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0; //tightly packed rows
+	region.bufferImageHeight = 0; //tightly packed image
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer(slot.commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+	//give the image back in the layout it came in (the presentation engine expects PRESENT_SRC)
+	VkImageMemoryBarrier toPresent = toTransfer;
+	toPresent.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	toPresent.dstAccessMask = 0; //presentation is synchronised by the semaphore
+	toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toPresent.newLayout = layout;
+
+	//make the copied data visible to the host once the fence signals
+	VkBufferMemoryBarrier toHost = {};
+	toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER; //struct type
+	toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.buffer = slot.buffer;
+	toHost.offset = 0;
+	toHost.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+		0, nullptr, 1, &toHost, 1, &toPresent);
+
+	if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record capture command buffer!");
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		slot.state = SlotState::Pending;
+		slot.frameIndex = frameIndex;
+		slot.captureNumber = nextCaptureNumber++;
+		slot.extent = extent;
+		slot.format = format;
+	}
+
+	if (settings.maxFrames != 0 && nextCaptureNumber >= settings.maxFrames) {
+		active = false; //captured as many frames as were asked for
+	}
+	return slot.commandBuffer;
+}
+
+/*
+	hand every copy that was submitted with this frame over to the encoders
+*/
+void FrameCapture::frameCompleted(size_t frameIndex)
+{
+	if (slots.empty()) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].state == SlotState::Pending && slots[i].frameIndex == frameIndex) {
+			slots[i].state = SlotState::Queued;
+			encodeQueue.push_back(i);
+		}
+	}
+	workAvailable.notify_all();
+}
+
+void FrameCapture::flush()
+{
+	if (slots.empty()) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	for (size_t i = 0; i < slots.size(); i++) {
+		if (slots[i].state == SlotState::Pending) {
+			slots[i].state = SlotState::Queued;
+			encodeQueue.push_back(i);
+		}
+	}
+	workAvailable.notify_all();
+}
+
+void FrameCapture::drain()
+{
+	if (slots.empty()) {
+		return;
+	}
+	flush();
+	std::unique_lock<std::mutex> lock(mutex);
+	slotFreed.wait(lock, [this]() {
+		return std::all_of(slots.begin(), slots.end(), [](const ReadbackSlot& slot) { return slot.state == SlotState::Free; });
+	});
+}
+
+/*
+	body of every encoder thread: take a completed slot, encode it straight from the mapped buffer and give the slot back
+*/
+void FrameCapture::encoderLoop()
+{
+	for (;;) {
+		size_t index;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workAvailable.wait(lock, [this]() { return stopping || !encodeQueue.empty(); });
+			if (encodeQueue.empty()) { //stopping and nothing left to do
+				return;
+			}
+			index = encodeQueue.front();
+			encodeQueue.pop_front();
+			slots[index].state = SlotState::Encoding;
+		}
+
+		try {
+			encode(slots[index]);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "frame capture: " << e.what() << std::endl; //an unwritable file should not take down the application
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			slots[index].state = SlotState::Free;
+		}
+		slotFreed.notify_all(); //the frame loop and drain may both be waiting
+	}
+}
+
+/*
+	convert the copied texels into the requested file format and write the file, or hand them to the sink
+*/
+void FrameCapture::encode(const ReadbackSlot& slot)
+{
+	const size_t size = static_cast<size_t>(slot.extent.width) * slot.extent.height * texelSize(slot.format);
+	const uint8_t* texels = static_cast<const uint8_t*>(slot.mapped);
+
+	if (sink) { //someone else consumes the frames, nothing is written
+		sink(slot.captureNumber, texels, slot.extent, slot.format);
+	}
+	else if (settings.format == CaptureFormat::RAW) {
+		saveRaw(frameFileName(slot), texels, size);
+		bytesWritten += size;
+	}
+	else {
+		RgbImage image = rgbFromTexels(texels, slot.extent, slot.format); //swap chain images are usually BGRA, the image formats want RGB
+		if (settings.format == CaptureFormat::PPM) {
+			savePPM(frameFileName(slot), image);
+		}
+		else {
+			savePNG(frameFileName(slot), image);
+		}
+		bytesWritten += image.pixels.size();
+	}
+	framesWritten++;
+}
+
+std::string FrameCapture::frameFileName(const ReadbackSlot& slot) const
+{
+	std::ostringstream name;
+	name << settings.outputDirectory << "/frame_" << std::setw(6) << std::setfill('0') << slot.captureNumber;
+	switch (settings.format) {
+	case CaptureFormat::PPM:
+		name << ".ppm";
+		break;
+	case CaptureFormat::PNG:
+		name << ".png";
+		break;
+	case CaptureFormat::RAW: //raw files carry no header, so record what is needed to interpret them in the name
+		name << "_" << slot.extent.width << "x" << slot.extent.height << "_vkformat" << static_cast<int>(slot.format) << ".raw";
+		break;
+	}
+	return name.str();
+}
+
+/*
+	make sure every captured frame reaches the disk, then release everything
+*/
+void FrameCapture::cleanup()
+{
+	if (slots.empty()) {
+		return;
+	}
+	flush(); //the device is idle at this point, so every pending copy is complete
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true; //encoders exit once the queue is drained
+	}
+	workAvailable.notify_all();
+	for (auto& encoder : encoders) {
+		encoder.join();
+	}
+	encoders.clear();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "frame capture: " << framesWritten << " frames written to " << settings.outputDirectory
+		<< " (" << std::fixed << std::setprecision(1) << bytesWritten / (1024.0 * 1024.0) / std::max(seconds, 1e-6) << " MB/s), "
+		<< framesDropped << " dropped, " << producerStalls << " stalls (" << stallTime.count() << " ms waiting)" << std::endl;
+
+	for (auto& slot : slots) {
+		destroySlotBuffer(slot);
+	}
+	slots.clear();
+	vkDestroyCommandPool(device, commandPool, nullptr); //also frees the command buffers allocated from it
+	commandPool = VK_NULL_HANDLE;
+	active = false;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+/*
+	file formats the capture encoders can write
+*/
+enum class CaptureFormat {
+	PPM, //binary P6 portable pixmap, RGB 8 bit
+	PNG, //RGB 8 bit png using stored (uncompressed) deflate blocks so no external library is needed
+	RAW //texels exactly as they were copied out of the swap chain image
+};
+
+/*
+	settings for the capture mode, filled in from the command line
+*/
+struct CaptureSettings {
+	bool enabled = false; //is capture mode on
+	std::string outputDirectory = "capture"; //directory the encoded frames are written to
+	CaptureFormat format = CaptureFormat::PPM; //file format of the encoded frames
+	uint32_t maxFrames = 0; //stop capturing after this many frames, 0 captures until the window is closed
+	uint32_t ringSize = 6; //number of host visible readback buffers, this bounds the number of frames waiting to be encoded
+	uint32_t encoderThreads = 2; //number of background threads encoding and writing frames
+	bool dropWhenFull = false; //when every readback buffer is busy either drop the frame (true) or wait for an encoder to free one (false)
+};
+
+/*
+	Asynchronous readback of rendered frames
+
+	The swap chain image is copied into one of a ring of host visible buffers by a small command buffer that is submitted
+	together with the frame's own command buffer, so no extra queue submission or wait is needed.
+	The copy is known to be complete once the frame's in-flight fence has been waited on (which drawFrame already does),
+	at that point the buffer is handed to a pool of encoder threads which convert and write it to disk.
+	The ring bounds the amount of memory and the number of frames queued for encoding. When it is exhausted the frame loop
+	either waits for an encoder (backpressure, lossless) or skips capturing the frame, depending on the settings.
+*/
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	/*
+		create the command pool, readback slots and encoder threads
+		framesInFlight is needed to size the ring so that there is always a slot that will eventually be freed
+	*/
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight, const CaptureSettings& settings);
+
+	/*
+		receives the texels of every completed copy on an encoder thread instead of writing them to disk
+	*/
+	using FrameSink = std::function<void(uint64_t captureNumber, const uint8_t* texels, VkExtent2D extent, VkFormat format)>;
+	void setFrameSink(FrameSink sink) { this->sink = sink; }
+
+	/*
+		record the commands copying image into a free readback slot, returns the command buffer to submit along with the frame
+		or VK_NULL_HANDLE if this frame is not captured. image must be in the given layout (PRESENT_SRC for swap chain images)
+		and is returned to it
+	*/
+	VkCommandBuffer recordCopy(VkImage image, VkImageLayout layout, VkFormat format, VkExtent2D extent, size_t frameIndex);
+
+	/*
+		the in-flight fence of frameIndex has been waited on, so every copy submitted with it is complete and can be encoded
+	*/
+	void frameCompleted(size_t frameIndex);
+
+	/*
+		every submitted copy is complete (the device is idle), queue all of them for encoding
+	*/
+	void flush();
+
+	/*
+		flush and wait until the encoders have finished with every slot, everything the sink received is then visible to the caller
+	*/
+	void drain();
+
+	/*
+		flush, wait for the encoders to finish, print statistics and destroy all resources
+	*/
+	void cleanup();
+
+	bool isActive() const { return active; } //true while frames are still being captured
+
+private:
+	enum class SlotState {
+		Free, //can be used for a new copy
+		Pending, //copy has been submitted but the frame has not completed yet
+		Queued, //copy is complete and waiting for an encoder
+		Encoding //an encoder is reading from the buffer
+	};
+
+	//one readback buffer and the command buffer that fills it
+	struct ReadbackSlot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize capacity = 0; //size of the buffer, reallocated when the swap chain grows
+		void* mapped = nullptr; //persistently mapped pointer to the buffer contents
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		SlotState state = SlotState::Free;
+		size_t frameIndex = 0; //in-flight frame the copy was submitted with
+		uint64_t captureNumber = 0; //sequence number used for the file name
+		VkExtent2D extent = {}; //dimensions of the copied image
+		VkFormat format = VK_FORMAT_UNDEFINED; //format of the copied image
+	};
+
+	int acquireSlot();
+	void ensureCapacity(ReadbackSlot& slot, VkDeviceSize size);
+	void destroySlotBuffer(ReadbackSlot& slot);
+	void encoderLoop();
+	void encode(const ReadbackSlot& slot);
+	std::string frameFileName(const ReadbackSlot& slot) const;
+
+	CaptureSettings settings;
+	FrameSink sink; //replaces writing files when set
+	bool active = false;
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE; //separate pool so the copy command buffers can be reset individually
+
+	std::vector<ReadbackSlot> slots;
+	uint64_t nextCaptureNumber = 0;
+
+	//encoder thread pool, slots and the queue are protected by the mutex
+	std::vector<std::thread> encoders;
+	std::deque<size_t> encodeQueue; //indices of slots ready to encode
+	std::mutex mutex;
+	std::condition_variable workAvailable; //signalled when a slot is queued for encoding or when stopping
+	std::condition_variable slotFreed; //signalled when an encoder returns a slot to the ring
+	bool stopping = false;
+
+	//statistics
+	uint64_t framesDropped = 0; //frames skipped because the ring was full
+	uint64_t producerStalls = 0; //times the frame loop had to wait for a free slot
+	std::chrono::duration<double, std::milli> stallTime{ 0 }; //total time spent waiting
+	std::atomic<uint64_t> framesWritten{ 0 };
+	std::atomic<uint64_t> bytesWritten{ 0 };
+	std::chrono::steady_clock::time_point startTime;
+};
@@ -0,0 +1,197 @@
+#include "FrameTimer.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <numeric>
+#include <iomanip>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+TimingSummary TimingSummary::fromSamples(std::vector<double> samples)
+{
+	TimingSummary summary;
+	if (samples.empty()) {
+		return summary;
+	}
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&](double p) { //nearest rank percentile
+		size_t rank = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+		return samples[std::min(rank, samples.size() - 1)];
+	};
+	summary.count = samples.size();
+	summary.average = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+	summary.minimum = samples.front();
+	summary.p50 = percentile(0.50);
+	summary.p95 = percentile(0.95);
+	summary.p99 = percentile(0.99);
+	summary.maximum = samples.back();
+	return summary;
+}
+
+std::ostream& operator<<(std::ostream& out, const TimingSummary& summary)
+{
+	std::ios state(nullptr);
+	state.copyfmt(out); //don't leak the formatting into the caller's stream
+	out << std::fixed << std::setprecision(3) << "avg " << summary.average << " ms, p50 " << summary.p50 << ", p95 " << summary.p95
+		<< ", p99 " << summary.p99 << ", max " << summary.maximum << " (" << summary.count << " frames)";
+	out.copyfmt(state);
+	return out;
+}
+
+double processCpuMilliseconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+		return 0.0;
+	}
+	auto toTicks = [](const FILETIME& time) { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+	return (toTicks(kernel) + toTicks(user)) / 10000.0; //100 ns ticks
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0.0;
+	}
+	auto toMilliseconds = [](const timeval& time) { return time.tv_sec * 1000.0 + time.tv_usec / 1000.0; };
+	return toMilliseconds(usage.ru_utime) + toMilliseconds(usage.ru_stime);
+#endif
+}
+
+/*
+	create the query pool and pre-record the timestamp command buffers, they never change
+*/
+void FrameTimer::init(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, uint32_t framesInFlight, uint32_t timestampValidBits)
+{
+	this->device = device;
+	this->commandPool = commandPool;
+	written.assign(framesInFlight, false);
+	cpuStarted = false;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	timestampPeriod = properties.limits.timestampPeriod;
+	gpuTiming = timestampValidBits != 0 && timestampPeriod > 0.0f; //the queue can't write timestamps
+	if (!gpuTiming) {
+		return;
+	}
+	timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+
+	VkQueryPoolCreateInfo queryPoolInfo = {};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO; //struct type
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP; //timestamp queries
+	queryPoolInfo.queryCount = framesInFlight * 2; //start and end of each frame
+
+	if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create timestamp query pool!");
+	}
+
+	beginCommandBuffers.resize(framesInFlight);
+	endCommandBuffers.resize(framesInFlight);
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = framesInFlight;
+
+	if (vkAllocateCommandBuffers(device, &allocInfo, beginCommandBuffers.data()) != VK_SUCCESS ||
+		vkAllocateCommandBuffers(device, &allocInfo, endCommandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate timestamp command buffers!");
+	}
+
+	for (uint32_t i = 0; i < framesInFlight; i++) {
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+
+		//first command buffer of the frame: reset this frame's pair of queries and stamp the start
+		if (vkBeginCommandBuffer(beginCommandBuffers[i], &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording timestamp command buffer!");
+		}
+		vkCmdResetQueryPool(beginCommandBuffers[i], queryPool, i * 2, 2);
+		vkCmdWriteTimestamp(beginCommandBuffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, i * 2);
+		if (vkEndCommandBuffer(beginCommandBuffers[i]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record timestamp command buffer!");
+		}
+
+		//last command buffer of the frame: stamp once all previous work has drained out of the pipeline
+		if (vkBeginCommandBuffer(endCommandBuffers[i], &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording timestamp command buffer!");
+		}
+		vkCmdWriteTimestamp(endCommandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, i * 2 + 1);
+		if (vkEndCommandBuffer(endCommandBuffers[i]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record timestamp command buffer!");
+		}
+	}
+}
+
+void FrameTimer::cleanup()
+{
+	if (queryPool != VK_NULL_HANDLE) {
+		vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(beginCommandBuffers.size()), beginCommandBuffers.data());
+		vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(endCommandBuffers.size()), endCommandBuffers.data());
+		vkDestroyQueryPool(device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+	beginCommandBuffers.clear();
+	endCommandBuffers.clear();
+	gpuTiming = false;
+}
+
+void FrameTimer::beginFrame(size_t frameIndex)
+{
+	auto now = std::chrono::steady_clock::now();
+	if (cpuStarted) {
+		cpuSamples.push_back(std::chrono::duration<double, std::milli>(now - lastFrameStart).count());
+	}
+	lastFrameStart = now;
+	cpuStarted = true;
+
+	collect(frameIndex);
+}
+
+VkCommandBuffer FrameTimer::endCommandBuffer(size_t frameIndex)
+{
+	if (!gpuTiming) {
+		return VK_NULL_HANDLE;
+	}
+	written[frameIndex] = true; //the caller is submitting the pair for this frame
+	return endCommandBuffers[frameIndex];
+}
+
+/*
+	read back the pair of timestamps of a completed frame, the fence has signalled so the results are available
+*/
+void FrameTimer::collect(size_t frameIndex)
+{
+	if (!gpuTiming || !written[frameIndex]) {
+		return;
+	}
+	uint64_t timestamps[2];
+	VkResult result = vkGetQueryPoolResults(device, queryPool, static_cast<uint32_t>(frameIndex * 2), 2, sizeof(timestamps), timestamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	written[frameIndex] = false;
+	if (result == VK_SUCCESS) {
+		uint64_t ticks = ((timestamps[1] & timestampMask) - (timestamps[0] & timestampMask)) & timestampMask; //handles the counter wrapping
+		gpuSamples.push_back(ticks * timestampPeriod / 1e6); //ticks -> nanoseconds -> milliseconds
+	}
+}
+
+void FrameTimer::flush()
+{
+	for (size_t i = 0; i < written.size(); i++) {
+		collect(i);
+	}
+}
+
+void FrameTimer::reset()
+{
+	cpuSamples.clear();
+	gpuSamples.clear();
+	cpuStarted = false;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ostream>
+
+/*
+	summary of a set of timing samples in milliseconds
+*/
+struct TimingSummary {
+	size_t count = 0;
+	double average = 0.0;
+	double minimum = 0.0;
+	double p50 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+	double maximum = 0.0;
+
+	static TimingSummary fromSamples(std::vector<double> samples);
+};
+
+std::ostream& operator<<(std::ostream& out, const TimingSummary& summary);
+
+/*
+	CPU time used so far by every thread of the process, user and kernel, in milliseconds
+*/
+double processCpuMilliseconds();
+
+/*
+	Per-frame CPU and GPU timing
+
+	GPU time is measured with a pair of timestamp queries per frame in flight, written by two tiny command buffers that are
+	submitted before and after the frame's own command buffers. Results are read back without waiting once the frame's
+	in-flight fence has been waited on. CPU time is the interval between consecutive calls to beginFrame.
+*/
+class FrameTimer
+{
+public:
+	/*
+		timestampValidBits comes from the queue family the frames are submitted to, 0 disables GPU timing
+	*/
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, uint32_t framesInFlight, uint32_t timestampValidBits);
+	void cleanup();
+
+	/*
+		the fence of frameIndex has been waited on, collect its GPU time and start timing a new CPU frame
+	*/
+	void beginFrame(size_t frameIndex);
+
+	/*
+		command buffers to submit first and last in the frame's batch, VK_NULL_HANDLE if GPU timing is not available
+	*/
+	VkCommandBuffer beginCommandBuffer(size_t frameIndex) const { return gpuTiming ? beginCommandBuffers[frameIndex] : VK_NULL_HANDLE; }
+	VkCommandBuffer endCommandBuffer(size_t frameIndex);
+
+	/*
+		collect every outstanding result, the device must be idle
+	*/
+	void flush();
+
+	/*
+		drop the samples collected so far (for example after warm up frames)
+	*/
+	void reset();
+
+	bool hasGpuTiming() const { return gpuTiming; }
+	TimingSummary cpuSummary() const { return TimingSummary::fromSamples(cpuSamples); }
+	TimingSummary gpuSummary() const { return TimingSummary::fromSamples(gpuSamples); }
+	const std::vector<double>& cpuFrameTimes() const { return cpuSamples; }
+	const std::vector<double>& gpuFrameTimes() const { return gpuSamples; }
+
+private:
+	void collect(size_t frameIndex);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkQueryPool queryPool = VK_NULL_HANDLE; //two timestamps per frame in flight
+	std::vector<VkCommandBuffer> beginCommandBuffers; //reset the frame's queries and write the first timestamp
+	std::vector<VkCommandBuffer> endCommandBuffers; //write the second timestamp
+	std::vector<bool> written; //has the frame's query pair been submitted since it was last read
+	bool gpuTiming = false;
+	double timestampPeriod = 1.0; //nanoseconds per timestamp tick
+	uint64_t timestampMask = ~0ull; //only timestampValidBits of each result are meaningful
+
+	bool cpuStarted = false;
+	std::chrono::steady_clock::time_point lastFrameStart;
+	std::vector<double> cpuSamples;
+	std::vector<double> gpuSamples;
+};
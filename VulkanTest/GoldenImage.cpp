@@ -0,0 +1,38 @@
+#include "GoldenImage.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+
+/*
+	per pixel comparison, a pixel mismatches when any of its channels differs by more than the tolerance
+*/
+ImageComparison compareImages(const RgbImage& actual, const RgbImage& reference, uint32_t tolerance)
+{
+	ImageComparison result;
+	result.sizeMatches = actual.width == reference.width && actual.height == reference.height;
+	if (!result.sizeMatches) {
+		return result;
+	}
+
+	result.diff.width = actual.width;
+	result.diff.height = actual.height;
+	result.diff.pixels.resize(actual.pixels.size());
+
+	for (size_t i = 0; i < actual.pixels.size(); i += 3) {
+		uint32_t pixelDifference = 0;
+		for (size_t c = 0; c < 3; c++) {
+			uint32_t difference = static_cast<uint32_t>(std::abs(int(actual.pixels[i + c]) - int(reference.pixels[i + c])));
+			pixelDifference = std::max(pixelDifference, difference);
+			result.diff.pixels[i + c] = static_cast<uint8_t>(std::min(difference * 8u, 255u)); //amplify small differences so they show up
+		}
+		result.maxDifference = std::max(result.maxDifference, pixelDifference);
+		if (pixelDifference > tolerance) {
+			result.mismatchedPixels++;
+			result.diff.pixels[i + 0] = 255; //failing pixels are solid red
+			result.diff.pixels[i + 1] = 0;
+			result.diff.pixels[i + 2] = 0;
+		}
+	}
+	return result;
+}
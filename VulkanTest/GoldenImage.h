@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "ImageIO.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+	settings for the headless golden image run, filled in from the command line
+*/
+struct GoldenSettings {
+	bool enabled = false; //render the golden scenes headlessly instead of opening a window
+	std::string referenceDirectory = "../golden"; //where the reference images are stored (one <scene>.ppm per scene)
+	std::string outputDirectory = "golden_out"; //where actual images, diff images and timings are written
+	bool update = false; //write the rendered images as the new references instead of comparing
+	uint32_t tolerance = 2; //largest per channel difference that still counts as matching
+	uint32_t maxMismatchedPixels = 0; //number of pixels allowed to exceed the tolerance before the scene fails
+	uint32_t warmupFrames = 10; //frames rendered before timing starts (pipeline and driver warm up)
+	uint32_t frames = 100; //timed frames per scene, the last one is compared against the reference
+};
+
+/*
+	a fixed scene rendered by the golden run
+*/
+struct GoldenScene {
+	std::string name; //also the file name of the reference image
+	VkExtent2D extent; //size of the render target
+};
+
+/*
+	result of comparing a rendered image against its reference
+*/
+struct ImageComparison {
+	bool sizeMatches = false; //the images have the same dimensions, nothing else is valid otherwise
+	uint32_t maxDifference = 0; //largest per channel difference found
+	uint64_t mismatchedPixels = 0; //pixels with at least one channel above the tolerance
+	RgbImage diff; //absolute difference scaled up for visibility, pixels above the tolerance are red
+};
+
+ImageComparison compareImages(const RgbImage& actual, const RgbImage& reference, uint32_t tolerance);
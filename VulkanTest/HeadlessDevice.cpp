@@ -0,0 +1,314 @@
+#include "HeadlessDevice.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+void HeadlessDevice::createInstance(const char* applicationName, uint32_t apiVersion)
+{
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO; //struct type
+	appInfo.pApplicationName = applicationName;
+	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.pEngineName = "No Engine";
+	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.apiVersion = apiVersion;
+
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO; //struct type
+	instanceInfo.pApplicationInfo = &appInfo;
+
+	if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create instance!");
+	}
+
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	std::vector<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+	for (const auto& candidate : devices) {
+		VkPhysicalDeviceProperties candidateProperties;
+		vkGetPhysicalDeviceProperties(candidate, &candidateProperties);
+		if (candidateProperties.apiVersion < apiVersion) {
+			continue;
+		}
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, queueFamilies.data());
+		for (uint32_t i = 0; i < queueFamilyCount; i++) {
+			if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) { //graphics queues can also do compute and transfer
+				physicalDevice = candidate;
+				properties = candidateProperties;
+				queueFamily = i;
+				timestampValidBits = queueFamilies[i].timestampValidBits;
+				break;
+			}
+		}
+		if (physicalDevice != VK_NULL_HANDLE) {
+			break;
+		}
+	}
+	if (physicalDevice == VK_NULL_HANDLE) {
+		throw std::runtime_error("failed to find a suitable GPU!");
+	}
+}
+
+void HeadlessDevice::createDevice(const std::vector<const char*>& extensions, const void* features, const VkPhysicalDeviceFeatures* enabledFeatures)
+{
+	float queuePriority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO; //struct type
+	queueInfo.queueFamilyIndex = queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &queuePriority;
+
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO; //struct type
+	deviceInfo.pNext = features;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+	deviceInfo.ppEnabledExtensionNames = extensions.data();
+	deviceInfo.pEnabledFeatures = features == nullptr ? enabledFeatures : nullptr; //the two are mutually exclusive
+
+	if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create logical device!");
+	}
+	bool memoryBudgetExtension = std::any_of(extensions.begin(), extensions.end(), [](const char* name) { return strcmp(name, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0; });
+	DeviceMemoryTracker::global().registerDevice(device, physicalDevice, memoryBudgetExtension);
+	vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO; //struct type
+	poolInfo.queueFamilyIndex = queueFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; //benchmarks re-record their frames
+
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create command pool!");
+	}
+}
+
+void HeadlessDevice::cleanup()
+{
+	if (device != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(device, commandPool, nullptr);
+		DeviceMemoryTracker::global().unregisterDevice(device, std::cout); //the benchmark has freed everything by now
+		vkDestroyDevice(device, nullptr);
+		device = VK_NULL_HANDLE;
+	}
+	if (instance != VK_NULL_HANDLE) {
+		vkDestroyInstance(instance, nullptr);
+		instance = VK_NULL_HANDLE;
+	}
+	physicalDevice = VK_NULL_HANDLE; //picked again by the next createInstance
+}
+
+bool HeadlessDevice::supportsExtension(const char* name) const
+{
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> available(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, available.data());
+	for (const auto& extension : available) {
+		if (strcmp(extension.extensionName, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+VkCommandBuffer HeadlessDevice::beginSingleTimeCommands()
+{
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = commandPool;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //submitted once and freed
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	return commandBuffer;
+}
+
+void HeadlessDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+{
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; //struct type
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit command buffer!");
+	}
+	vkQueueWaitIdle(queue); //set up work only, nothing else is in flight
+	vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+}
+
+OffscreenTarget HeadlessDevice::createOffscreenTarget(VkExtent2D extent, VkFormat format, bool readback)
+{
+	OffscreenTarget target;
+	target.extent = extent;
+	target.format = format;
+	target.readback = readback;
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (readback ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+	createImage(device, physicalDevice, extent, format, usage, target.image, target.memory);
+	target.view = createImageView(device, target.image, format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format = format;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; //cleared every frame
+	colorAttachment.finalLayout = readback ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+
+	VkSubpassDependency dependency = {};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL; //the previous frame's writes, and the readback if there is one
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | (readback ? VK_PIPELINE_STAGE_TRANSFER_BIT : 0);
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (readback ? VK_ACCESS_TRANSFER_READ_BIT : 0);
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO; //struct type
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &target.renderPass) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create render pass!");
+	}
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO; //struct type
+	framebufferInfo.renderPass = target.renderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &target.view;
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+	if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &target.framebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create framebuffer!");
+	}
+	return target;
+}
+
+void HeadlessDevice::destroyOffscreenTarget(OffscreenTarget& target)
+{
+	vkDestroyFramebuffer(device, target.framebuffer, nullptr);
+	vkDestroyRenderPass(device, target.renderPass, nullptr);
+	vkDestroyImageView(device, target.view, nullptr);
+	vkDestroyImage(device, target.image, nullptr);
+	freeDeviceMemory(device, target.memory, nullptr);
+	target = OffscreenTarget();
+}
+
+std::vector<uint8_t> HeadlessDevice::readOffscreenTarget(const OffscreenTarget& target)
+{
+	if (!target.readback) {
+		throw std::runtime_error("offscreen target was not created for readback!");
+	}
+	const VkDeviceSize size = static_cast<VkDeviceSize>(target.extent.width) * target.extent.height * 4;
+	VkBuffer readback;
+	VkDeviceMemory readbackMemory;
+	createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, readback, readbackMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+	VkBufferImageCopy region = {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { target.extent.width, target.extent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback, 1, &region);
+	endSingleTimeCommands(commandBuffer);
+
+	std::vector<uint8_t> pixels(size);
+	void* data;
+	vkMapMemory(device, readbackMemory, 0, VK_WHOLE_SIZE, 0, &data);
+	memcpy(pixels.data(), data, size);
+	vkUnmapMemory(device, readbackMemory);
+	vkDestroyBuffer(device, readback, nullptr);
+	freeDeviceMemory(device, readbackMemory, nullptr);
+	return pixels;
+}
+
+void HeadlessDevice::createFrameResources(uint32_t framesInFlight, std::vector<VkCommandBuffer>& commandBuffers, std::vector<VkFence>& fences, FrameTimer& frameTimer)
+{
+	commandBuffers.resize(framesInFlight);
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = framesInFlight;
+	if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	fences.resize(framesInFlight);
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO; //struct type
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; //the first wait on each fence returns straight away
+	for (auto& fence : fences) {
+		if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create fence!");
+		}
+	}
+	frameTimer.init(device, physicalDevice, commandPool, framesInFlight, timestampValidBits);
+}
+
+void HeadlessDevice::destroyFrameResources(std::vector<VkFence>& fences, FrameTimer& frameTimer)
+{
+	vkDeviceWaitIdle(device);
+	frameTimer.cleanup();
+	for (VkFence fence : fences) {
+		vkDestroyFence(device, fence, nullptr);
+	}
+	fences.clear();
+}
+
+void HeadlessDevice::submitTimedFrame(FrameTimer& frameTimer, size_t frame, VkCommandBuffer commandBuffer, VkFence fence)
+{
+	VkCommandBuffer submitCommandBuffers[3];
+	uint32_t commandBufferCount = 0;
+	if (frameTimer.beginCommandBuffer(frame) != VK_NULL_HANDLE) {
+		submitCommandBuffers[commandBufferCount++] = frameTimer.beginCommandBuffer(frame);
+	}
+	submitCommandBuffers[commandBufferCount++] = commandBuffer;
+	VkCommandBuffer timerEnd = frameTimer.endCommandBuffer(frame);
+	if (timerEnd != VK_NULL_HANDLE) {
+		submitCommandBuffers[commandBufferCount++] = timerEnd;
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; //struct type
+	submitInfo.commandBufferCount = commandBufferCount;
+	submitInfo.pCommandBuffers = submitCommandBuffers;
+	vkResetFences(device, 1, &fence);
+	if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit frame command buffer!");
+	}
+}
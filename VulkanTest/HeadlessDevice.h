@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "FrameTimer.h"
+
+/*
+	colour image with a single subpass render pass and framebuffer over it, the target the benchmarks draw into
+	with readback the image is also a transfer source and the render pass leaves it in TRANSFER_SRC_OPTIMAL for
+	HeadlessDevice::readOffscreenTarget, without it the image stays in COLOR_ATTACHMENT_OPTIMAL
+*/
+struct OffscreenTarget {
+	VkExtent2D extent = {};
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	bool readback = false;
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkImageView view = VK_NULL_HANDLE;
+	VkRenderPass renderPass = VK_NULL_HANDLE; //clears on load, compatible with every pipeline drawing into the target
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+};
+
+/*
+	Instance, device, queue and command pool for the benchmarks that run without a window
+
+	Creation is split in two so a benchmark can inspect the picked physical device (API version, features, extensions)
+	before deciding what to enable on the logical device.
+*/
+class HeadlessDevice
+{
+public:
+	/*
+		create the instance and pick the first device with a graphics queue that supports apiVersion
+	*/
+	void createInstance(const char* applicationName, uint32_t apiVersion);
+
+	/*
+		create the logical device with one graphics queue and a resettable command pool
+		features is the pNext chain of VkDeviceCreateInfo (usually a VkPhysicalDeviceFeatures2), enabledFeatures is used when it is null
+	*/
+	void createDevice(const std::vector<const char*>& extensions, const void* features, const VkPhysicalDeviceFeatures* enabledFeatures = nullptr);
+	void cleanup();
+
+	bool supportsExtension(const char* name) const;
+
+	/*
+		one off command buffer, endSingleTimeCommands submits it and waits for it to complete
+	*/
+	VkCommandBuffer beginSingleTimeCommands();
+	void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+
+	OffscreenTarget createOffscreenTarget(VkExtent2D extent, VkFormat format, bool readback);
+	void destroyOffscreenTarget(OffscreenTarget& target);
+
+	/*
+		copy a readback target to the host, tightly packed rows of 4 byte texels (the benchmarks render to R8G8B8A8)
+	*/
+	std::vector<uint8_t> readOffscreenTarget(const OffscreenTarget& target);
+
+	/*
+		a primary command buffer and a signaled fence per frame in flight, and the frame timer for them
+		destroyFrameResources waits for the device to go idle, the command buffers go with the command pool
+	*/
+	void createFrameResources(uint32_t framesInFlight, std::vector<VkCommandBuffer>& commandBuffers, std::vector<VkFence>& fences, FrameTimer& frameTimer);
+	void destroyFrameResources(std::vector<VkFence>& fences, FrameTimer& frameTimer);
+
+	/*
+		submit a recorded frame between the frame timer's timestamp command buffers, the fence has been waited on and is reset here
+	*/
+	void submitTimedFrame(FrameTimer& frameTimer, size_t frame, VkCommandBuffer commandBuffer, VkFence fence);
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties = {};
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint32_t queueFamily = 0;
+	uint32_t timestampValidBits = 0;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+};
@@ -0,0 +1,388 @@
+#include "HostAllocator.h"
+
+#include <new>
+#include <set>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+	//allocators currently alive, thread caches check this before touching the allocator that filled them
+	std::mutex& registryMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::set<uint64_t>& liveAllocators()
+	{
+		static std::set<uint64_t> live;
+		return live;
+	}
+
+	std::atomic<uint64_t> nextGeneration{ 1 };
+
+	const char* scopeNames[HostAllocationSnapshot::SCOPE_COUNT] = { "command", "object", "cache", "device", "instance" };
+}
+
+uint64_t HostAllocationSnapshot::totalAllocations() const
+{
+	uint64_t total = 0;
+	for (size_t i = 0; i < SCOPE_COUNT; i++) {
+		total += allocations[i];
+	}
+	return total;
+}
+
+std::ostream& operator<<(std::ostream& out, const HostAllocationSnapshot& snapshot)
+{
+	for (size_t i = 0; i < HostAllocationSnapshot::SCOPE_COUNT; i++) {
+		out << "  " << std::setw(8) << std::left << scopeNames[i] << std::right << " allocations " << snapshot.allocations[i]
+			<< ", frees " << snapshot.frees[i] << ", live " << snapshot.liveBytes[i] / 1024.0 << " KB, peak " << snapshot.peakBytes[i] / 1024.0
+			<< " KB, driver internal " << snapshot.internalBytes[i] / 1024.0 << " KB\n";
+	}
+	return out;
+}
+
+HostAllocator::HostAllocator()
+{
+	vkCallbacks = {};
+	vkCallbacks.pUserData = this; //the callbacks are static, they find the allocator through the user data
+	vkCallbacks.pfnAllocation = &HostAllocator::allocation;
+	vkCallbacks.pfnReallocation = &HostAllocator::reallocation;
+	vkCallbacks.pfnFree = &HostAllocator::free;
+	vkCallbacks.pfnInternalAllocation = &HostAllocator::internalAllocation;
+	vkCallbacks.pfnInternalFree = &HostAllocator::internalFree;
+
+	generation = nextGeneration++;
+	std::lock_guard<std::mutex> lock(registryMutex());
+	liveAllocators().insert(generation);
+}
+
+/*
+	the driver has released everything by now (the instance is destroyed), so the chunks can go
+	other threads' caches still pointing into them are ignored from here on because the generation is no longer live
+*/
+HostAllocator::~HostAllocator()
+{
+	{
+		std::lock_guard<std::mutex> lock(registryMutex());
+		liveAllocators().erase(generation);
+	}
+	ThreadCache& cache = threadCache();
+	if (cache.owner == this && cache.generation == generation) {
+		cache = ThreadCache(); //forget the blocks, they are freed with the chunks below
+	}
+	for (auto& group : pools) {
+		for (auto& pool : group) {
+			for (void* chunk : pool.chunks) {
+				::operator delete(chunk, std::align_val_t(BLOCK_ALIGNMENT));
+			}
+		}
+	}
+}
+
+HostAllocator::ThreadCache::~ThreadCache()
+{
+	std::lock_guard<std::mutex> lock(registryMutex());
+	if (owner != nullptr && liveAllocators().count(generation) != 0) {
+		owner->flush(*this); //the thread is exiting, give its blocks back so other threads can use them
+	}
+}
+
+HostAllocator::ThreadCache& HostAllocator::threadCache()
+{
+	static thread_local ThreadCache cache;
+	return cache;
+}
+
+/*
+	make sure the calling thread's cache belongs to this allocator, the common case is a single comparison
+*/
+HostAllocator::ThreadCache& HostAllocator::cacheFor(ThreadCache& cache)
+{
+	if (cache.owner == this && cache.generation == generation) {
+		return cache;
+	}
+	{
+		std::lock_guard<std::mutex> lock(registryMutex());
+		if (cache.owner != nullptr && liveAllocators().count(cache.generation) != 0) {
+			cache.owner->flush(cache); //the thread switched allocators, the old one keeps its blocks
+		}
+	}
+	cache = ThreadCache();
+	cache.owner = this;
+	cache.generation = generation;
+	return cache;
+}
+
+void HostAllocator::flush(ThreadCache& cache)
+{
+	for (size_t group = 0; group < POOL_GROUPS; group++) {
+		for (size_t sizeClass = 0; sizeClass < CLASS_COUNT; sizeClass++) {
+			FreeBlock* first = cache.lists[group][sizeClass];
+			if (first == nullptr) {
+				continue;
+			}
+			FreeBlock* last = first;
+			while (last->next != nullptr) {
+				last = last->next;
+			}
+			returnToPool(group, sizeClass, first, last);
+			cache.lists[group][sizeClass] = nullptr;
+			cache.counts[group][sizeClass] = 0;
+		}
+	}
+}
+
+size_t HostAllocator::sizeClassOf(size_t size)
+{
+	size_t sizeClass = 0;
+	while (blockSize(sizeClass) < size) {
+		sizeClass++;
+	}
+	return sizeClass;
+}
+
+size_t HostAllocator::groupOf(VkSystemAllocationScope scope)
+{
+	return (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND || scope == VK_SYSTEM_ALLOCATION_SCOPE_OBJECT) ? 0 : 1;
+}
+
+/*
+	take half a cache worth of blocks from the shared free list, carving a new chunk when it is empty
+	returns the blocks as a linked list
+*/
+HostAllocator::FreeBlock* HostAllocator::refill(size_t group, size_t sizeClass)
+{
+	Pool& pool = pools[group][sizeClass];
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	if (pool.freeList == nullptr) {
+		char* chunk = static_cast<char*>(::operator new(CHUNK_SIZE, std::align_val_t(BLOCK_ALIGNMENT), std::nothrow));
+		if (chunk == nullptr) {
+			return nullptr;
+		}
+		pool.chunks.push_back(chunk);
+		const size_t size = blockSize(sizeClass);
+		for (size_t offset = 0; offset + size <= CHUNK_SIZE; offset += size) { //link back to front so blocks are handed out in address order
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + CHUNK_SIZE / size * size - size - offset);
+			block->next = pool.freeList;
+			pool.freeList = block;
+		}
+	}
+
+	FreeBlock* first = pool.freeList;
+	FreeBlock* last = first;
+	for (uint32_t i = 1; i < THREAD_CACHE_LIMIT / 2 && last->next != nullptr; i++) {
+		last = last->next;
+	}
+	pool.freeList = last->next;
+	last->next = nullptr;
+	return first;
+}
+
+void HostAllocator::returnToPool(size_t group, size_t sizeClass, FreeBlock* first, FreeBlock* last)
+{
+	Pool& pool = pools[group][sizeClass];
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	last->next = pool.freeList;
+	pool.freeList = first;
+}
+
+void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (size == 0) {
+		return nullptr;
+	}
+	BlockHeader* header;
+	const size_t total = size + sizeof(BlockHeader);
+	if (alignment <= BLOCK_ALIGNMENT && total <= MAX_POOLED_SIZE) {
+		//pooled: thread cache first, shared pool when the cache is empty
+		const size_t sizeClass = sizeClassOf(total);
+		const size_t group = groupOf(scope);
+		ThreadCache& cache = cacheFor(threadCache());
+		FreeBlock* block = cache.lists[group][sizeClass];
+		if (block == nullptr) {
+			block = refill(group, sizeClass);
+			if (block == nullptr) {
+				return nullptr;
+			}
+			uint32_t count = 0;
+			for (FreeBlock* it = block; it != nullptr; it = it->next) {
+				count++;
+			}
+			cache.counts[group][sizeClass] = count;
+		}
+		cache.lists[group][sizeClass] = block->next;
+		cache.counts[group][sizeClass]--;
+
+		header = reinterpret_cast<BlockHeader*>(block);
+		header->sizeClass = static_cast<uint16_t>(sizeClass);
+		header->group = static_cast<uint8_t>(group);
+		header->offset = 0;
+	}
+	else {
+		//large or over-aligned: the header sits right in front of the aligned user pointer
+		const size_t align = alignment > BLOCK_ALIGNMENT ? alignment : BLOCK_ALIGNMENT;
+		char* base = static_cast<char*>(::operator new(size + align, std::align_val_t(align), std::nothrow));
+		if (base == nullptr) {
+			return nullptr;
+		}
+		header = reinterpret_cast<BlockHeader*>(base + align) - 1;
+		header->sizeClass = CLASS_COUNT;
+		header->group = 0;
+		header->offset = static_cast<uint32_t>(align);
+	}
+	header->requestedSize = size;
+	header->scope = static_cast<uint8_t>(scope);
+
+	ScopeCounters& scopeCounters = counters[scope];
+	scopeCounters.allocations++;
+	int64_t live = scopeCounters.liveBytes += static_cast<int64_t>(size);
+	int64_t peak = scopeCounters.peakBytes.load(std::memory_order_relaxed);
+	while (live > peak && !scopeCounters.peakBytes.compare_exchange_weak(peak, live)) {
+	}
+	return header + 1;
+}
+
+void HostAllocator::release(void* memory)
+{
+	if (memory == nullptr) {
+		return;
+	}
+	BlockHeader* header = static_cast<BlockHeader*>(memory) - 1;
+	ScopeCounters& scopeCounters = counters[header->scope];
+	scopeCounters.frees++;
+	scopeCounters.liveBytes -= static_cast<int64_t>(header->requestedSize);
+
+	if (header->sizeClass == CLASS_COUNT) {
+		::operator delete(static_cast<char*>(memory) - header->offset, std::align_val_t(header->offset));
+		return;
+	}
+
+	//pooled: back into this thread's cache, overflow goes to the shared pool in one batch
+	const size_t sizeClass = header->sizeClass;
+	const size_t group = header->group;
+	ThreadCache& cache = cacheFor(threadCache());
+	FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+	block->next = cache.lists[group][sizeClass];
+	cache.lists[group][sizeClass] = block;
+	if (++cache.counts[group][sizeClass] > THREAD_CACHE_LIMIT) {
+		FreeBlock* last = block;
+		for (uint32_t i = 1; i < THREAD_CACHE_LIMIT / 2; i++) {
+			last = last->next;
+		}
+		cache.lists[group][sizeClass] = last->next;
+		cache.counts[group][sizeClass] -= THREAD_CACHE_LIMIT / 2;
+		returnToPool(group, sizeClass, block, last);
+	}
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocation(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+}
+
+/*
+	grow or shrink in place when the block's size class still fits, otherwise move
+	on failure the original allocation must be left untouched
+*/
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocation(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	HostAllocator* allocator = static_cast<HostAllocator*>(userData);
+	if (original == nullptr) {
+		return allocator->allocate(size, alignment, scope);
+	}
+	if (size == 0) {
+		allocator->release(original);
+		return nullptr;
+	}
+
+	BlockHeader* header = static_cast<BlockHeader*>(original) - 1;
+	if (header->sizeClass != CLASS_COUNT && alignment <= BLOCK_ALIGNMENT && size + sizeof(BlockHeader) <= blockSize(header->sizeClass)) {
+		ScopeCounters& scopeCounters = allocator->counters[header->scope];
+		scopeCounters.reallocations++;
+		scopeCounters.liveBytes += static_cast<int64_t>(size) - static_cast<int64_t>(header->requestedSize);
+		header->requestedSize = size;
+		return original;
+	}
+
+	void* moved = allocator->allocate(size, alignment, scope);
+	if (moved == nullptr) {
+		return nullptr;
+	}
+	std::memcpy(moved, original, std::min<size_t>(size, header->requestedSize));
+	allocator->counters[scope].reallocations++;
+	allocator->release(original);
+	return moved;
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::free(void* userData, void* memory)
+{
+	static_cast<HostAllocator*>(userData)->release(memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocation(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+	static_cast<HostAllocator*>(userData)->counters[scope].internalBytes += static_cast<int64_t>(size);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFree(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope scope)
+{
+	static_cast<HostAllocator*>(userData)->counters[scope].internalBytes -= static_cast<int64_t>(size);
+}
+
+HostAllocationSnapshot HostAllocator::snapshot() const
+{
+	HostAllocationSnapshot snapshot;
+	for (size_t i = 0; i < HostAllocationSnapshot::SCOPE_COUNT; i++) {
+		snapshot.allocations[i] = counters[i].allocations.load(std::memory_order_relaxed);
+		snapshot.frees[i] = counters[i].frees.load(std::memory_order_relaxed);
+		snapshot.liveBytes[i] = counters[i].liveBytes.load(std::memory_order_relaxed);
+		snapshot.peakBytes[i] = counters[i].peakBytes.load(std::memory_order_relaxed);
+		snapshot.internalBytes[i] = counters[i].internalBytes.load(std::memory_order_relaxed);
+	}
+	return snapshot;
+}
+
+void FrameAllocationTracker::init(const HostAllocator* allocator, uint32_t reportInterval)
+{
+	this->allocator = allocator;
+	this->reportInterval = reportInterval;
+	last = allocator->snapshot();
+}
+
+void FrameAllocationTracker::endFrame()
+{
+	if (allocator == nullptr) {
+		return;
+	}
+	HostAllocationSnapshot now = allocator->snapshot();
+	uint64_t allocations = now.totalAllocations() - last.totalAllocations();
+	last = now;
+
+	frames++;
+	allocationsInFrames += allocations;
+	intervalAllocations += allocations;
+	maxPerFrame = std::max(maxPerFrame, allocations);
+	if (allocations != 0) {
+		framesWithAllocations++;
+	}
+
+	if (reportInterval != 0 && frames % reportInterval == 0) {
+		std::cout << "host allocations: " << static_cast<double>(intervalAllocations) / reportInterval << " per frame over the last "
+			<< reportInterval << " frames" << std::endl;
+		intervalAllocations = 0;
+	}
+}
+
+void FrameAllocationTracker::print(std::ostream& out) const
+{
+	if (allocator == nullptr) {
+		return;
+	}
+	out << "host allocations: " << frames << " frames, " << allocationsInFrames << " allocations during frames ("
+		<< (frames != 0 ? static_cast<double>(allocationsInFrames) / frames : 0.0) << " per frame, max " << maxPerFrame << "), "
+		<< framesWithAllocations << " frames allocated\n" << allocator->snapshot();
+}
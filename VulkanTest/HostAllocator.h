@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+/*
+	counters for one VkSystemAllocationScope, updated concurrently from any thread the driver allocates on
+*/
+struct ScopeCounters {
+	std::atomic<uint64_t> allocations{ 0 }; //pfnAllocation calls plus reallocations that moved the memory
+	std::atomic<uint64_t> frees{ 0 };
+	std::atomic<uint64_t> reallocations{ 0 };
+	std::atomic<int64_t> liveBytes{ 0 }; //bytes currently handed out to the driver
+	std::atomic<int64_t> peakBytes{ 0 };
+	std::atomic<int64_t> internalBytes{ 0 }; //allocations the driver made itself and only told us about
+};
+
+/*
+	plain copy of the counters, used to compute per frame deltas
+*/
+struct HostAllocationSnapshot {
+	static const size_t SCOPE_COUNT = 5; //COMMAND, OBJECT, CACHE, DEVICE, INSTANCE
+	uint64_t allocations[SCOPE_COUNT] = {};
+	uint64_t frees[SCOPE_COUNT] = {};
+	int64_t liveBytes[SCOPE_COUNT] = {};
+	int64_t peakBytes[SCOPE_COUNT] = {};
+	int64_t internalBytes[SCOPE_COUNT] = {};
+
+	uint64_t totalAllocations() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const HostAllocationSnapshot& snapshot);
+
+/*
+	per frame view of the allocator counters, the goal is a steady state with no driver host allocations at all
+*/
+class FrameAllocationTracker
+{
+public:
+	void init(const class HostAllocator* allocator, uint32_t reportInterval);
+	void endFrame(); //call once per frame after the frame has been submitted
+	void print(std::ostream& out) const;
+
+private:
+	const class HostAllocator* allocator = nullptr;
+	uint32_t reportInterval = 0; //print every this many frames, 0 only prints on request
+	HostAllocationSnapshot last;
+	uint64_t frames = 0;
+	uint64_t framesWithAllocations = 0;
+	uint64_t maxPerFrame = 0;
+	uint64_t allocationsInFrames = 0; //allocations made between the first and the last endFrame
+	uint64_t intervalAllocations = 0; //since the last periodic report
+};
+
+/*
+	Host memory allocator for the Vulkan driver (VkAllocationCallbacks)
+
+	Small requests (up to MAX_POOLED_SIZE with alignment up to BLOCK_ALIGNMENT) are served from size class pools:
+	fixed size blocks carved out of large chunks, recycled through a per-thread cache first and a shared free list second,
+	so the steady state does not touch the general purpose heap or take a lock. Larger or over-aligned requests go to the
+	system allocator. Every block carries a small header in front of it recording its size class and scope.
+
+	Long lived scopes (DEVICE, INSTANCE, CACHE) and short lived ones (COMMAND, OBJECT) use separate pools so short lived
+	blocks are recycled among themselves and do not fragment the chunks holding long lived objects.
+	Pool chunks are kept until the allocator is destroyed, which must happen after the instance is.
+*/
+class HostAllocator
+{
+public:
+	HostAllocator();
+	~HostAllocator();
+
+	HostAllocator(const HostAllocator&) = delete;
+	HostAllocator& operator=(const HostAllocator&) = delete;
+
+	const VkAllocationCallbacks* callbacks() const { return &vkCallbacks; }
+
+	HostAllocationSnapshot snapshot() const;
+
+	static const size_t BLOCK_ALIGNMENT = 16; //alignment of every pooled block, enough for any fundamental type
+	static const size_t MAX_POOLED_SIZE = 4096; //larger requests go to the system allocator
+
+private:
+	static const size_t CLASS_COUNT = 9; //16, 32, ... 4096 bytes
+	static const size_t CHUNK_SIZE = 64 * 1024; //pool memory is requested from the system in chunks of this size
+
+	//in front of every block handed out
+	struct alignas(16) BlockHeader {
+		uint64_t requestedSize; //what the driver asked for, needed to copy on reallocation
+		uint16_t sizeClass; //CLASS_COUNT for system allocations
+		uint8_t group; //which pool group the block belongs to
+		uint8_t scope; //VkSystemAllocationScope, for the counters
+		uint32_t offset; //system allocations only: distance from the start of the allocation, which is also its alignment
+	};
+
+	//singly linked list threaded through the free blocks
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	//one pool per size class per lifetime group
+	struct Pool {
+		std::mutex mutex; //protects the shared free list and the chunk list
+		FreeBlock* freeList = nullptr;
+		std::vector<void*> chunks;
+	};
+
+	static const size_t POOL_GROUPS = 2; //short lived (COMMAND, OBJECT) and long lived (everything else)
+
+	static VKAPI_ATTR void* VKAPI_CALL allocation(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static VKAPI_ATTR void* VKAPI_CALL reallocation(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static VKAPI_ATTR void VKAPI_CALL free(void* userData, void* memory);
+	static VKAPI_ATTR void VKAPI_CALL internalAllocation(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+	static VKAPI_ATTR void VKAPI_CALL internalFree(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+	void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void release(void* memory);
+	FreeBlock* refill(size_t group, size_t sizeClass);
+	void returnToPool(size_t group, size_t sizeClass, FreeBlock* first, FreeBlock* last);
+
+	static size_t sizeClassOf(size_t size);
+	static size_t blockSize(size_t sizeClass) { return size_t(16) << sizeClass; }
+	static size_t groupOf(VkSystemAllocationScope scope);
+
+	//thread local cache of free blocks, one list per pool
+	struct ThreadCache {
+		HostAllocator* owner = nullptr;
+		uint64_t generation = 0; //guards against a cache outliving its allocator
+		FreeBlock* lists[POOL_GROUPS][CLASS_COUNT] = {};
+		uint32_t counts[POOL_GROUPS][CLASS_COUNT] = {};
+		~ThreadCache();
+	};
+	static const uint32_t THREAD_CACHE_LIMIT = 64; //blocks per list before half of them go back to the shared pool
+	static ThreadCache& threadCache();
+	ThreadCache& cacheFor(ThreadCache& cache);
+	void flush(ThreadCache& cache);
+
+	VkAllocationCallbacks vkCallbacks;
+	Pool pools[POOL_GROUPS][CLASS_COUNT];
+	ScopeCounters counters[HostAllocationSnapshot::SCOPE_COUNT];
+	uint64_t generation; //unique per allocator instance
+};
@@ -0,0 +1,423 @@
+#include "ImageIO.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+uint32_t texelSize(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		return 4;
+	default:
+		throw std::runtime_error("cannot capture images in VkFormat " + std::to_string(format) + ", only 8 bit RGBA and BGRA (UNORM or SRGB) are supported!");
+	}
+}
+
+RgbImage rgbFromTexels(const uint8_t* texels, VkExtent2D extent, VkFormat format)
+{
+	const uint32_t stride = texelSize(format);
+	RgbImage image;
+	image.width = extent.width;
+	image.height = extent.height;
+	image.pixels.resize(static_cast<size_t>(extent.width) * extent.height * 3);
+
+	bool bgra = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB; //swap chain style formats store blue first
+	for (size_t i = 0; i < static_cast<size_t>(extent.width) * extent.height; i++) {
+		const uint8_t* texel = texels + i * stride;
+		image.pixels[i * 3 + 0] = bgra ? texel[2] : texel[0];
+		image.pixels[i * 3 + 1] = texel[1];
+		image.pixels[i * 3 + 2] = bgra ? texel[0] : texel[2];
+	}
+	return image;
+}
+
+/*
+	read a binary (P6) ppm with a max value of 255, comments in the header are skipped
+*/
+RgbImage loadPPM(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("unable to open " + filename);
+	}
+
+	auto nextToken = [&]() { //header tokens are separated by whitespace and may be followed by # comments
+		std::string token;
+		while (file >> token && token[0] == '#') {
+			std::string comment;
+			std::getline(file, comment);
+		}
+		return token;
+	};
+
+	if (nextToken() != "P6") {
+		throw std::runtime_error(filename + " is not a binary ppm");
+	}
+	RgbImage image;
+	image.width = static_cast<uint32_t>(std::stoul(nextToken()));
+	image.height = static_cast<uint32_t>(std::stoul(nextToken()));
+	if (std::stoul(nextToken()) != 255) {
+		throw std::runtime_error(filename + " is not an 8 bit ppm");
+	}
+	file.get(); //single whitespace character before the pixel data
+
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+	file.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size());
+	if (!file) {
+		throw std::runtime_error(filename + " is truncated");
+	}
+	return image;
+}
+
+void savePPM(const std::string& filename, const RgbImage& image)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("unable to open " + filename);
+	}
+	file << "P6\n" << image.width << " " << image.height << "\n255\n";
+	file.write(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size());
+}
+
+void saveRaw(const std::string& filename, const void* data, size_t size)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("unable to open " + filename);
+	}
+	file.write(static_cast<const char*>(data), size);
+}
+
+namespace {
+	//crc32 used for png chunks (polynomial 0xEDB88320)
+	uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0xFFFFFFFFu)
+	{
+		static uint32_t table[256];
+		static bool tableReady = [] {
+			for (uint32_t n = 0; n < 256; n++) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			return true;
+		}();
+		(void)tableReady;
+		for (size_t i = 0; i < length; i++) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+	void appendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	void writeChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> chunk;
+		appendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		uint32_t crc = crc32(chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFFu; //crc covers the type and the data
+		appendBigEndian(chunk, crc);
+		file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+	}
+}
+
+/*
+	the image data is stored in uncompressed deflate blocks, the zlib stream still needs its header and adler32 checksum
+*/
+void savePNG(const std::string& filename, const RgbImage& image)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("unable to open " + filename);
+	}
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	std::vector<uint8_t> header;
+	appendBigEndian(header, image.width);
+	appendBigEndian(header, image.height);
+	header.push_back(8); //bit depth
+	header.push_back(2); //colour type: truecolour RGB
+	header.push_back(0); //compression method: deflate
+	header.push_back(0); //filter method: adaptive
+	header.push_back(0); //no interlacing
+	writeChunk(file, "IHDR", header);
+
+	//filtered scanlines: each row is prefixed with filter type 0 (none)
+	const size_t rowBytes = static_cast<size_t>(image.width) * 3;
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((rowBytes + 1) * image.height);
+	for (uint32_t y = 0; y < image.height; y++) {
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), image.pixels.begin() + y * rowBytes, image.pixels.begin() + (y + 1) * rowBytes);
+	}
+
+	//zlib stream: header, stored deflate blocks of at most 65535 bytes, adler32 of the uncompressed data
+	std::vector<uint8_t> zlib;
+	zlib.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	size_t offset = 0;
+	do {
+		size_t blockSize = std::min<size_t>(65535, scanlines.size() - offset);
+		bool last = offset + blockSize == scanlines.size();
+		zlib.push_back(last ? 1 : 0); //BFINAL bit, BTYPE 00 (stored)
+		zlib.push_back(static_cast<uint8_t>(blockSize));
+		zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+		zlib.push_back(static_cast<uint8_t>(~blockSize));
+		zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+		zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < scanlines.size());
+
+	uint32_t a = 1, b = 0;
+	for (uint8_t byte : scanlines) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	appendBigEndian(zlib, (b << 16) | a);
+	writeChunk(file, "IDAT", zlib);
+
+	writeChunk(file, "IEND", {});
+}
+
+uint32_t compressedBlockSize(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK: case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK: case VK_FORMAT_BC4_SNORM_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+	case VK_FORMAT_EAC_R11_UNORM_BLOCK: case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+		return 8; //half a byte per texel
+	case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK: case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK: case VK_FORMAT_BC5_SNORM_BLOCK: case VK_FORMAT_BC6H_UFLOAT_BLOCK: case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK: case VK_FORMAT_BC7_SRGB_BLOCK:
+	case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+	case VK_FORMAT_EAC_R11G11_UNORM_BLOCK: case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+		return 16; //a byte per texel
+	default:
+		return 0;
+	}
+}
+
+size_t textureLevelSize(VkFormat format, VkExtent2D extent)
+{
+	uint32_t blockSize = compressedBlockSize(format);
+	if (blockSize == 0) {
+		return static_cast<size_t>(extent.width) * extent.height * 4;
+	}
+	return static_cast<size_t>((extent.width + 3) / 4) * ((extent.height + 3) / 4) * blockSize;
+}
+
+namespace {
+	VkFormat formatFromGL(uint32_t glInternalFormat)
+	{
+		switch (glInternalFormat) {
+		case 0x8058: return VK_FORMAT_R8G8B8A8_UNORM; //GL_RGBA8
+		case 0x8C43: return VK_FORMAT_R8G8B8A8_SRGB; //GL_SRGB8_ALPHA8
+		case 0x83F0: return VK_FORMAT_BC1_RGB_UNORM_BLOCK; //GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		case 0x83F1: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case 0x83F2: return VK_FORMAT_BC2_UNORM_BLOCK;
+		case 0x83F3: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case 0x8C4C: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		case 0x8C4D: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case 0x8C4E: return VK_FORMAT_BC2_SRGB_BLOCK;
+		case 0x8C4F: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case 0x8DBB: return VK_FORMAT_BC4_UNORM_BLOCK; //GL_COMPRESSED_RED_RGTC1
+		case 0x8DBC: return VK_FORMAT_BC4_SNORM_BLOCK;
+		case 0x8DBD: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case 0x8DBE: return VK_FORMAT_BC5_SNORM_BLOCK;
+		case 0x8E8C: return VK_FORMAT_BC7_UNORM_BLOCK; //GL_COMPRESSED_RGBA_BPTC_UNORM
+		case 0x8E8D: return VK_FORMAT_BC7_SRGB_BLOCK;
+		case 0x8E8E: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+		case 0x8E8F: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case 0x9270: return VK_FORMAT_EAC_R11_UNORM_BLOCK;
+		case 0x9271: return VK_FORMAT_EAC_R11_SNORM_BLOCK;
+		case 0x9272: return VK_FORMAT_EAC_R11G11_UNORM_BLOCK;
+		case 0x9273: return VK_FORMAT_EAC_R11G11_SNORM_BLOCK;
+		case 0x9274: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK; //GL_COMPRESSED_RGB8_ETC2
+		case 0x9275: return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
+		case 0x9276: return VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK;
+		case 0x9277: return VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK;
+		case 0x9278: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+		case 0x9279: return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	VkFormat formatFromDXGI(uint32_t dxgiFormat)
+	{
+		switch (dxgiFormat) {
+		case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+		case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+		case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+		case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+		case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+		case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+		case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+		case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+		case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+		case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+		case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+		case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+		default: return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	std::vector<uint8_t> readFile(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			throw std::runtime_error("unable to open " + filename);
+		}
+		std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+		return bytes;
+	}
+
+	uint32_t readUint32(const std::vector<uint8_t>& bytes, size_t offset)
+	{
+		uint32_t value;
+		std::memcpy(&value, bytes.data() + offset, 4); //both containers are little endian, as is every platform this runs on
+		return value;
+	}
+}
+
+TextureData loadKTX(const std::string& filename)
+{
+	static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	std::vector<uint8_t> bytes = readFile(filename);
+	if (bytes.size() < 64 || std::memcmp(bytes.data(), identifier, 12) != 0) {
+		throw std::runtime_error(filename + " is not a ktx 1.1 file");
+	}
+	if (readUint32(bytes, 12) != 0x04030201) {
+		throw std::runtime_error(filename + " has big endian data");
+	}
+
+	TextureData texture;
+	texture.format = formatFromGL(readUint32(bytes, 28)); //glInternalFormat
+	if (texture.format == VK_FORMAT_UNDEFINED) {
+		throw std::runtime_error(filename + " has an unsupported internal format");
+	}
+	texture.extent = { readUint32(bytes, 36), std::max(readUint32(bytes, 40), 1u) };
+	if (readUint32(bytes, 44) > 1 || readUint32(bytes, 48) > 1 || readUint32(bytes, 52) > 1) {
+		throw std::runtime_error(filename + " is not a single 2D texture");
+	}
+	uint32_t levelCount = std::max(readUint32(bytes, 56), 1u); //0 asks the loader to generate the chain
+	size_t offset = 64 + readUint32(bytes, 60); //skip the key/value data
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		if (offset + 4 > bytes.size()) {
+			throw std::runtime_error(filename + " is truncated");
+		}
+		uint32_t imageSize = readUint32(bytes, offset);
+		VkExtent2D extent = { std::max(texture.extent.width >> level, 1u), std::max(texture.extent.height >> level, 1u) };
+		if (imageSize != textureLevelSize(texture.format, extent) || offset + 4 + imageSize > bytes.size()) {
+			throw std::runtime_error(filename + " has a malformed mip level");
+		}
+		texture.levels.emplace_back(bytes.begin() + offset + 4, bytes.begin() + offset + 4 + imageSize);
+		offset += 4 + ((imageSize + 3) & ~3u); //mip padding
+	}
+	return texture;
+}
+
+TextureData loadDDS(const std::string& filename)
+{
+	std::vector<uint8_t> bytes = readFile(filename);
+	if (bytes.size() < 128 || std::memcmp(bytes.data(), "DDS ", 4) != 0) {
+		throw std::runtime_error(filename + " is not a dds file");
+	}
+
+	TextureData texture;
+	texture.extent = { readUint32(bytes, 16), readUint32(bytes, 12) }; //the header stores height first
+	uint32_t levelCount = (readUint32(bytes, 8) & 0x20000) ? std::max(readUint32(bytes, 28), 1u) : 1; //DDSD_MIPMAPCOUNT
+	uint32_t pixelFlags = readUint32(bytes, 80);
+	uint32_t fourCC = readUint32(bytes, 84);
+	size_t offset = 128;
+
+	auto code = [](const char* text) { return uint32_t(text[0]) | uint32_t(text[1]) << 8 | uint32_t(text[2]) << 16 | uint32_t(text[3]) << 24; };
+	if ((pixelFlags & 0x4) && fourCC == code("DX10")) { //DDPF_FOURCC with the extended header
+		if (bytes.size() < 148) {
+			throw std::runtime_error(filename + " is truncated");
+		}
+		texture.format = formatFromDXGI(readUint32(bytes, 128));
+		if (readUint32(bytes, 132) != 3 || readUint32(bytes, 140) > 1) { //D3D10_RESOURCE_DIMENSION_TEXTURE2D, one element
+			throw std::runtime_error(filename + " is not a single 2D texture");
+		}
+		offset = 148;
+	}
+	else if (pixelFlags & 0x4) {
+		if (fourCC == code("DXT1")) texture.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+		else if (fourCC == code("DXT3")) texture.format = VK_FORMAT_BC2_UNORM_BLOCK;
+		else if (fourCC == code("DXT5")) texture.format = VK_FORMAT_BC3_UNORM_BLOCK;
+		else if (fourCC == code("ATI1") || fourCC == code("BC4U")) texture.format = VK_FORMAT_BC4_UNORM_BLOCK;
+		else if (fourCC == code("ATI2") || fourCC == code("BC5U")) texture.format = VK_FORMAT_BC5_UNORM_BLOCK;
+	}
+	else if ((pixelFlags & 0x40) && readUint32(bytes, 88) == 32 && readUint32(bytes, 92) == 0xFF && readUint32(bytes, 100) == 0xFF0000) {
+		texture.format = VK_FORMAT_R8G8B8A8_UNORM; //DDPF_RGB with red in the low byte
+	}
+	if (texture.format == VK_FORMAT_UNDEFINED) {
+		throw std::runtime_error(filename + " has an unsupported pixel format");
+	}
+
+	for (uint32_t level = 0; level < levelCount; level++) {
+		VkExtent2D extent = { std::max(texture.extent.width >> level, 1u), std::max(texture.extent.height >> level, 1u) };
+		size_t size = textureLevelSize(texture.format, extent);
+		if (offset + size > bytes.size()) {
+			throw std::runtime_error(filename + " is truncated");
+		}
+		texture.levels.emplace_back(bytes.begin() + offset, bytes.begin() + offset + size);
+		offset += size;
+	}
+	return texture;
+}
+
+TextureData loadTexture(const std::string& filename)
+{
+	auto endsWith = [&](const char* extension) {
+		size_t length = std::strlen(extension);
+		return filename.size() >= length && filename.compare(filename.size() - length, length, extension) == 0;
+	};
+	if (endsWith(".ktx")) {
+		return loadKTX(filename);
+	}
+	if (endsWith(".dds")) {
+		return loadDDS(filename);
+	}
+	if (endsWith(".ppm")) {
+		RgbImage image = loadPPM(filename);
+		TextureData texture;
+		texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+		texture.extent = { image.width, image.height };
+		texture.levels.emplace_back(static_cast<size_t>(image.width) * image.height * 4);
+		uint8_t* texels = texture.levels[0].data();
+		for (size_t i = 0; i < static_cast<size_t>(image.width) * image.height; i++) {
+			texels[i * 4 + 0] = image.pixels[i * 3 + 0];
+			texels[i * 4 + 1] = image.pixels[i * 3 + 1];
+			texels[i * 4 + 2] = image.pixels[i * 3 + 2];
+			texels[i * 4 + 3] = 255;
+		}
+		return texture;
+	}
+	throw std::runtime_error("unknown texture file type " + filename);
+}
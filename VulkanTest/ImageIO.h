@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+	8 bit RGB image, rows top to bottom
+*/
+struct RgbImage {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/*
+	bytes per texel of the formats rgbFromTexels converts: R8G8B8A8 and B8G8R8A8, UNORM or SRGB. throws for any other
+	format, so a capture of a swap chain in, say, a 10 bit packed or 16 bit float format is refused rather than misread
+*/
+uint32_t texelSize(VkFormat format);
+
+/*
+	convert texels copied out of a colour image in one of the formats above into RGB
+*/
+RgbImage rgbFromTexels(const uint8_t* texels, VkExtent2D extent, VkFormat format);
+
+/*
+	binary (P6) portable pixmap
+*/
+RgbImage loadPPM(const std::string& filename);
+void savePPM(const std::string& filename, const RgbImage& image);
+
+/*
+	RGB png using stored (uncompressed) deflate blocks so no external library is needed
+	files are larger than a compressed png but encoding is just a copy
+*/
+void savePNG(const std::string& filename, const RgbImage& image);
+
+/*
+	write bytes to a file as they are
+*/
+void saveRaw(const std::string& filename, const void* data, size_t size);
+
+/*
+	texture ready for upload: uncompressed RGBA8 or a block compressed format, with as many mip levels as the file stored
+	(a single level means the mip chain still has to be generated)
+*/
+struct TextureData {
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkExtent2D extent = { 0, 0 };
+	std::vector<std::vector<uint8_t>> levels; //level 0 first, block compressed levels hold whole 4x4 blocks
+};
+
+/*
+	bytes per 4x4 block of a BCn / ETC2 / EAC format, 0 for formats that are not block compressed
+*/
+uint32_t compressedBlockSize(VkFormat format);
+
+/*
+	bytes of one mip level of the given size, whole blocks for compressed formats, 4 bytes per texel otherwise
+*/
+size_t textureLevelSize(VkFormat format, VkExtent2D extent);
+
+/*
+	KTX 1.1 with a single 2D face: BCn, ETC2 / EAC or RGBA8
+*/
+TextureData loadKTX(const std::string& filename);
+
+/*
+	DDS with a legacy (DXT1, DXT3, DXT5, ATI1, ATI2) or DX10 header: BCn or RGBA8
+*/
+TextureData loadDDS(const std::string& filename);
+
+/*
+	.ktx, .dds or .ppm by extension, a ppm is expanded to RGBA8 with opaque alpha
+*/
+TextureData loadTexture(const std::string& filename);
@@ -0,0 +1,254 @@
+#include "JobBenchmark.h"
+#include "FrameTimer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	const uint32_t MESH_COUNT = 32; //objects share this many meshes, one instanced draw each per view
+	const float WORLD_SIZE = 400.0f;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/*
+		a made up mesh table: mesh m has 36 * (m + 1) indices and 8 * (m + 1) vertices, packed one after the other
+	*/
+	uint32_t meshIndexCount(uint32_t mesh) { return 36 * (mesh + 1); }
+	uint32_t meshFirstIndex(uint32_t mesh) { return 18 * mesh * (mesh + 1); }
+	int32_t meshVertexOffset(uint32_t mesh) { return static_cast<int32_t>(4 * mesh * (mesh + 1)); }
+
+	uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull; //FNV-1a
+		}
+		return hash;
+	}
+}
+
+JobBenchmark::JobBenchmark(const JobBenchmarkSettings& settings) : settings(settings), views(std::max(settings.views, 1u))
+{
+	std::mt19937 random(2024);
+	std::uniform_real_distribution<float> coordinate(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f), component(-1.0f, 1.0f), speed(0.2f, 2.0f), size(0.5f, 3.0f);
+	positions.resize(settings.objects);
+	spinAxes.resize(settings.objects);
+	spinSpeeds.resize(settings.objects);
+	halfExtents.resize(settings.objects);
+	meshes.resize(settings.objects);
+	for (uint32_t i = 0; i < settings.objects; i++) {
+		positions[i] = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+		glm::vec3 axis(component(random), component(random), component(random));
+		spinAxes[i] = glm::length(axis) > 1e-3f ? glm::normalize(axis) : glm::vec3(0.0f, 1.0f, 0.0f);
+		spinSpeeds[i] = speed(random);
+		halfExtents[i] = glm::vec3(size(random), size(random), size(random));
+		meshes[i] = random() % MESH_COUNT;
+	}
+	worlds.resize(settings.objects);
+	bounds.resize(settings.objects);
+	size_t batches = (settings.objects + std::max(settings.batch, 1u) - 1) / std::max(settings.batch, 1u);
+	for (auto& view : views) {
+		view.visibleByBatch.resize(batches);
+		view.instanceBuffer.resize(settings.objects);
+	}
+}
+
+/*
+	move the clock on and point the cameras for the frame: they circle the middle of the world, each looking another way
+*/
+void JobBenchmark::prepareFrame(uint32_t frame)
+{
+	time = frame / 60.0f;
+	for (size_t v = 0; v < views.size(); v++) {
+		float angle = time * 0.5f + glm::two_pi<float>() * v / views.size();
+		glm::vec3 eye(std::cos(angle) * WORLD_SIZE * 0.3f, 20.0f, std::sin(angle) * WORLD_SIZE * 0.3f);
+		glm::vec3 target(std::cos(angle + 1.0f) * WORLD_SIZE * 0.5f, 0.0f, std::sin(angle + 1.0f) * WORLD_SIZE * 0.5f);
+		glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, WORLD_SIZE);
+		projection[1][1] *= -1.0f;
+		views[v].frustum = Frustum::fromViewProjection(projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+}
+
+/*
+	animate a range of objects: world matrix and the world box around the object's spinning local box
+*/
+void JobBenchmark::transformRange(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++) {
+		glm::mat4 world = glm::rotate(glm::translate(glm::mat4(1.0f), positions[i]), time * spinSpeeds[i], spinAxes[i]);
+		worlds[i] = world;
+		//the box of a rotated box: every axis of the new box collects the absolute extents of the rotated axes
+		glm::mat3 rotation(world);
+		glm::vec3 extent = glm::abs(rotation[0]) * halfExtents[i].x + glm::abs(rotation[1]) * halfExtents[i].y + glm::abs(rotation[2]) * halfExtents[i].z;
+		bounds[i].min = positions[i] - extent;
+		bounds[i].max = positions[i] + extent;
+	}
+}
+
+void JobBenchmark::cullRange(View& view, size_t begin, size_t end)
+{
+	std::vector<uint32_t>& visible = view.visibleByBatch[begin / settings.batch];
+	visible.clear();
+	for (size_t i = begin; i < end; i++) {
+		if (view.frustum.test(bounds[i]) != Frustum::Test::Outside) {
+			visible.push_back(static_cast<uint32_t>(i));
+		}
+	}
+}
+
+/*
+	counting sort of the visible objects by mesh, then one instanced draw per mesh that has any
+*/
+void JobBenchmark::record(View& view)
+{
+	uint32_t counts[MESH_COUNT] = {};
+	size_t total = 0;
+	for (const auto& visible : view.visibleByBatch) {
+		for (uint32_t object : visible) {
+			counts[meshes[object]]++;
+		}
+		total += visible.size();
+	}
+	uint32_t starts[MESH_COUNT];
+	uint32_t start = 0;
+	view.draws.clear();
+	for (uint32_t mesh = 0; mesh < MESH_COUNT; mesh++) {
+		starts[mesh] = start;
+		if (counts[mesh] > 0) {
+			view.draws.push_back({ meshIndexCount(mesh), counts[mesh], meshFirstIndex(mesh), meshVertexOffset(mesh), start });
+		}
+		start += counts[mesh];
+	}
+	view.instances.resize(total);
+	for (const auto& visible : view.visibleByBatch) {
+		for (uint32_t object : visible) {
+			view.instances[starts[meshes[object]]++] = object;
+		}
+	}
+}
+
+void JobBenchmark::uploadRange(View& view, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++) {
+		view.instanceBuffer[i] = worlds[view.instances[i]];
+	}
+}
+
+/*
+	the same frame in plain loops on the calling thread, the reference for the timings and the results
+*/
+void JobBenchmark::runSerialFrame()
+{
+	transformRange(0, settings.objects);
+	for (auto& view : views) {
+		for (size_t begin = 0; begin < settings.objects; begin += settings.batch) {
+			cullRange(view, begin, std::min<size_t>(begin + settings.batch, settings.objects));
+		}
+		record(view);
+		uploadRange(view, 0, view.instances.size());
+	}
+}
+
+/*
+	hand the whole frame over as a task graph, then help out until the last upload is done
+	the parallel loops of culling and uploads are started by continuations, which also signal the counter the loop's
+	jobs signal, so the counter cannot reach zero between the continuation being released and the loop being scheduled
+*/
+void JobBenchmark::runJobFrame(JobSystem& jobs)
+{
+	std::function<void(size_t, size_t)> transform = [this](size_t begin, size_t end) { transformRange(begin, end); };
+	jobs.parallelFor(settings.objects, settings.batch, transform, &transformed);
+
+	std::vector<std::function<void(size_t, size_t)>> culls(views.size()), uploads(views.size());
+	for (size_t v = 0; v < views.size(); v++) {
+		View& view = views[v];
+		culls[v] = [this, &view](size_t begin, size_t end) { cullRange(view, begin, end); };
+		uploads[v] = [this, &view](size_t begin, size_t end) { uploadRange(view, begin, end); };
+		jobs.runAfter(transformed, [this, &jobs, &view, &culls, v]() {
+			jobs.parallelFor(settings.objects, settings.batch, culls[v], &view.culled);
+		}, &view.culled);
+		jobs.runAfter(view.culled, [this, &view]() { record(view); }, &view.recorded);
+		jobs.runAfter(view.recorded, [this, &jobs, &view, &uploads, v]() {
+			jobs.parallelFor(view.instances.size(), settings.batch, uploads[v], &frameDone);
+		}, &frameDone);
+	}
+
+	jobs.wait(frameDone);
+	//every stage is done once the last uploads are, waiting on the rest as well makes sure no job is still inside
+	//releasing them before they are used for the next frame
+	jobs.wait(transformed);
+	for (auto& view : views) {
+		jobs.wait(view.culled);
+		jobs.wait(view.recorded);
+	}
+}
+
+uint64_t JobBenchmark::checksum() const
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (const auto& view : views) {
+		hash = hashBytes(hash, view.draws.data(), view.draws.size() * sizeof(JobDraw));
+		hash = hashBytes(hash, view.instanceBuffer.data(), view.instances.size() * sizeof(glm::mat4));
+	}
+	return hash;
+}
+
+void JobBenchmark::run()
+{
+	uint32_t maxThreads = settings.threads == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : settings.threads;
+	settings.batch = std::max(settings.batch, 1u);
+	std::cout << "job system benchmark: " << settings.objects << " objects, " << views.size() << " views, " << settings.batch
+		<< " objects per job, " << settings.frames << " frames per case, up to " << maxThreads << " threads" << std::endl;
+
+	//the reference: timings and a checksum of every frame's draws and instance buffers
+	std::vector<double> samples;
+	std::vector<uint64_t> expected;
+	size_t visibleTotal = 0;
+	for (uint32_t frame = 0; frame < settings.frames; frame++) {
+		prepareFrame(frame);
+		auto start = std::chrono::steady_clock::now();
+		runSerialFrame();
+		samples.push_back(millisecondsSince(start));
+		expected.push_back(checksum());
+		for (const auto& view : views) {
+			visibleTotal += view.instances.size();
+		}
+	}
+	TimingSummary serial = TimingSummary::fromSamples(samples);
+	std::cout << "  plain loops      " << serial << ", " << visibleTotal / std::max(settings.frames, 1u) << " instances drawn per frame" << std::endl;
+
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+	for (uint32_t threads : threadCounts) {
+		JobSystem jobs(threads);
+		samples.clear();
+		size_t mismatches = 0;
+		for (uint32_t frame = 0; frame < settings.frames; frame++) {
+			prepareFrame(frame);
+			auto start = std::chrono::steady_clock::now();
+			runJobFrame(jobs);
+			samples.push_back(millisecondsSince(start));
+			mismatches += checksum() != expected[frame];
+		}
+		TimingSummary summary = TimingSummary::fromSamples(samples);
+		JobStats stats = jobs.stats();
+		std::cout << "  " << threads << (threads == 1 ? " thread         " : " threads        ") << summary;
+		if (summary.average > 0.0) {
+			std::cout << ", " << serial.average / summary.average << "x the plain loops";
+		}
+		std::cout << ", " << stats.executed / std::max(settings.frames, 1u) << " jobs and " << stats.stolen / std::max(settings.frames, 1u)
+			<< " steals per frame, " << mismatches << " frames differ" << std::endl;
+	}
+}
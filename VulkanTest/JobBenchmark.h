@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "JobSystem.h"
+#include "Bvh.h"
+
+/*
+	settings for the job system benchmark, filled in from the command line
+*/
+struct JobBenchmarkSettings {
+	bool enabled = false;
+	uint32_t objects = 200000;
+	uint32_t views = 4; //cameras culled and recorded every frame, a main view and shadow cascades say
+	uint32_t frames = 60; //frames timed per thread count
+	uint32_t threads = 0; //largest thread count measured, 0 for every hardware thread
+	uint32_t batch = 1024; //objects per transform, culling and upload job
+};
+
+/*
+	an indirect draw as it would be written into a VkDrawIndexedIndirectCommand
+*/
+struct JobDraw {
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t firstInstance;
+};
+
+/*
+	Job system benchmark
+
+	Runs a frame's CPU work as a task graph on the JobSystem:
+
+		transforms (parallel) -> per view: culling (parallel) -> recording (one job) -> uploads (parallel)
+
+	Transforms animate every object and compute its world matrix and box, culling tests the boxes against each view's
+	frustum, recording sorts the visible objects by mesh into instanced indirect draws and uploads copies their world
+	matrices into the view's instance buffer, standing in for a mapped staging buffer. The views are independent, so
+	their stages overlap. The whole graph is handed over at the start of the frame with counters and continuations,
+	and the calling thread only waits at the end.
+
+	The frame is timed with 1, 2, 4 ... up to the given number of threads against the same work done in plain loops,
+	and every frame's draws and instance buffers are checked against the loop version. Runs on the CPU only.
+*/
+class JobBenchmark
+{
+public:
+	explicit JobBenchmark(const JobBenchmarkSettings& settings);
+	void run();
+
+private:
+	struct View {
+		Frustum frustum;
+		std::vector<std::vector<uint32_t>> visibleByBatch; //culling output, one list per object batch
+		std::vector<uint32_t> instances; //visible objects sorted by mesh
+		std::vector<JobDraw> draws;
+		std::vector<glm::mat4> instanceBuffer;
+		JobCounter culled, recorded;
+	};
+
+	void prepareFrame(uint32_t frame);
+	void transformRange(size_t begin, size_t end);
+	void cullRange(View& view, size_t begin, size_t end);
+	void record(View& view);
+	void uploadRange(View& view, size_t begin, size_t end);
+	void runSerialFrame();
+	void runJobFrame(JobSystem& jobs);
+	uint64_t checksum() const;
+
+	JobBenchmarkSettings settings;
+	float time = 0.0f;
+
+	//per object
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> spinAxes;
+	std::vector<float> spinSpeeds;
+	std::vector<glm::vec3> halfExtents;
+	std::vector<uint32_t> meshes;
+	std::vector<glm::mat4> worlds;
+	std::vector<Aabb> bounds;
+
+	std::vector<View> views;
+	JobCounter transformed, frameDone;
+};
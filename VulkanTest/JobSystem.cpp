@@ -0,0 +1,338 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+/*
+	one unit of work, lives in the ring of the thread that made it
+*/
+struct Job {
+	std::function<void()> work;
+	JobCounter* counter = nullptr;
+	Job* next = nullptr; //next continuation waiting on the same counter
+	std::atomic<bool> alive{ false }; //scheduled and not yet finished, the slot cannot be reused
+	bool spilled = false; //allocated on the heap because the ring was full, deleted once finished
+};
+
+/*
+	everything one thread owns
+*/
+struct JobSystem::ThreadQueue {
+	explicit ThreadQueue(uint64_t seed) : deque(JOB_RING_SIZE), jobs(JOB_RING_SIZE), random(seed) {}
+
+	WorkStealingDeque deque;
+	std::vector<Job> jobs;
+	size_t nextJob = 0;
+	uint64_t random; //xorshift state for picking the first victim
+	//written by the owner only, read by stats
+	std::atomic<uint64_t> executed{ 0 };
+	std::atomic<uint64_t> stolen{ 0 };
+	std::atomic<uint64_t> ranInline{ 0 };
+	std::atomic<uint64_t> spilled{ 0 };
+};
+
+namespace {
+	//the job system and queue of the calling thread, set for the workers and for the thread that made the job system
+	thread_local JobSystem* currentSystem = nullptr;
+	thread_local uint32_t currentIndex = 0;
+
+	const int SPINS_BEFORE_SLEEP = 64; //rounds of stealing with a yield in between before a worker goes to sleep
+}
+
+WorkStealingDeque::WorkStealingDeque(size_t capacity)
+{
+	size_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	buffer.reset(new std::atomic<Job*>[size]);
+	mask = static_cast<int64_t>(size) - 1;
+}
+
+bool WorkStealingDeque::push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t > mask) {
+		return false;
+	}
+	buffer[b & mask].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release); //the job is visible before the slot is
+	bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+Job* WorkStealingDeque::pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed); //claim the bottom slot before looking at top
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+	if (t > b) { //empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+	if (t == b) { //the last job, a thief may be after it too
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr; //the thief won
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* WorkStealingDeque::steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+	if (t >= b) {
+		return nullptr;
+	}
+	Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr; //the owner or another thief took it
+	}
+	return job;
+}
+
+JobSystem::JobSystem(uint32_t threads)
+{
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	for (uint32_t i = 0; i < threads; i++) {
+		queues.emplace_back(new ThreadQueue(0x9E3779B97F4A7C15ull * (i + 1)));
+	}
+	currentSystem = this;
+	currentIndex = 0;
+	for (uint32_t i = 1; i < threads; i++) {
+		workers.emplace_back(&JobSystem::workerThread, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	if (currentSystem == this) {
+		currentSystem = nullptr;
+	}
+}
+
+JobSystem::ThreadQueue& JobSystem::currentQueue()
+{
+	if (currentSystem != this) {
+		throw std::runtime_error("failed to schedule a job, the calling thread does not belong to the job system!");
+	}
+	return *queues[currentIndex];
+}
+
+Job* JobSystem::allocate(std::function<void()>&& work, JobCounter* counter)
+{
+	ThreadQueue& queue = currentQueue();
+	Job* job = &queue.jobs[queue.nextJob];
+	if (job->alive.load(std::memory_order_acquire)) {
+		//the ring has come round to a job that has not run yet. waiting for it could deadlock when it is a continuation
+		//of the jobs being made, so this one goes on the heap instead
+		job = new Job();
+		job->spilled = true;
+		queue.spilled.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		queue.nextJob = (queue.nextJob + 1) % JOB_RING_SIZE;
+	}
+	job->work = std::move(work);
+	job->counter = counter;
+	job->next = nullptr;
+	job->alive.store(true, std::memory_order_relaxed);
+	if (counter != nullptr) {
+		counter->value.fetch_add(1); //before the job can possibly run, so the counter never drops to zero early
+	}
+	return job;
+}
+
+void JobSystem::schedule(Job* job)
+{
+	ThreadQueue& queue = currentQueue();
+	if (!queue.deque.push(job)) {
+		queue.ranInline.fetch_add(1, std::memory_order_relaxed);
+		execute(queue, job); //the deque is full, the job is as well done here
+		return;
+	}
+	queued.fetch_add(1);
+	if (sleeping.load() > 0) { //queued was raised first, so a worker about to sleep either sees the job or is woken here
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wake.notify_one();
+	}
+}
+
+void JobSystem::run(std::function<void()> work, JobCounter* counter)
+{
+	schedule(allocate(std::move(work), counter));
+}
+
+/*
+	the job is only scheduled once dependency reaches zero. counter is raised straight away, so anything waiting on it
+	also waits for the continuation
+*/
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter)
+{
+	Job* job = allocate(std::move(work), counter);
+	if (dependency.done()) {
+		schedule(job);
+		return;
+	}
+	Job* head = dependency.continuations.load();
+	do {
+		job->next = head;
+	} while (!dependency.continuations.compare_exchange_weak(head, job));
+	//the last job of the dependency may have finished before the continuation was added, then nobody else releases it
+	if (dependency.value.load() == 0) {
+		release(dependency);
+	}
+}
+
+void JobSystem::parallelFor(size_t count, size_t batch, const std::function<void(size_t begin, size_t end)>& work, JobCounter* counter)
+{
+	batch = std::max<size_t>(batch, 1);
+	for (size_t begin = 0; begin < count; begin += batch) {
+		size_t end = std::min(begin + batch, count);
+		run([&work, begin, end]() { work(begin, end); }, counter); //work has to outlive the jobs, as their counter does
+	}
+}
+
+/*
+	schedule every continuation of a counter that reached zero, each one exactly once: whoever swaps the list out owns it
+*/
+void JobSystem::release(JobCounter& counter)
+{
+	Job* job = counter.continuations.exchange(nullptr);
+	while (job != nullptr) {
+		Job* next = job->next;
+		schedule(job);
+		job = next;
+	}
+}
+
+Job* JobSystem::findJob(ThreadQueue& queue)
+{
+	Job* job = queue.deque.pop();
+	if (job == nullptr && queues.size() > 1) {
+		queue.random ^= queue.random << 13;
+		queue.random ^= queue.random >> 7;
+		queue.random ^= queue.random << 17;
+		size_t first = static_cast<size_t>(queue.random % queues.size());
+		for (size_t i = 0; i < queues.size() && job == nullptr; i++) {
+			ThreadQueue& victim = *queues[(first + i) % queues.size()];
+			if (&victim != &queue) {
+				job = victim.deque.steal();
+			}
+		}
+		if (job != nullptr) {
+			queue.stolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	if (job != nullptr) {
+		queued.fetch_sub(1);
+	}
+	return job;
+}
+
+void JobSystem::execute(ThreadQueue& queue, Job* job)
+{
+	try {
+		job->work();
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(errorMutex);
+		if (!error) {
+			error = std::current_exception();
+		}
+	}
+	JobCounter* counter = job->counter;
+	if (job->spilled) {
+		delete job;
+	}
+	else {
+		job->work = nullptr; //drop the captures now rather than when the slot comes round again
+		job->alive.store(false, std::memory_order_release);
+	}
+	queue.executed.fetch_add(1, std::memory_order_relaxed);
+	if (counter != nullptr) {
+		//a waiter may destroy the counter as soon as it is done, releasing keeps it from looking done until the
+		//continuations are out
+		counter->releasing.fetch_add(1);
+		if (counter->value.fetch_sub(1) == 1) {
+			release(*counter);
+		}
+		counter->releasing.fetch_sub(1);
+	}
+}
+
+/*
+	run jobs, ours or stolen, until the counter is done. never sleeps, the caller is usually the frame's critical path
+*/
+void JobSystem::wait(JobCounter& counter)
+{
+	ThreadQueue& queue = currentQueue();
+	while (!counter.done()) {
+		Job* job = findJob(queue);
+		if (job != nullptr) {
+			execute(queue, job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (error) {
+		std::exception_ptr thrown = error;
+		error = nullptr;
+		std::rethrow_exception(thrown);
+	}
+}
+
+void JobSystem::workerThread(uint32_t index)
+{
+	currentSystem = this;
+	currentIndex = index;
+	ThreadQueue& queue = *queues[index];
+	int idleRounds = 0;
+	while (!stopping) {
+		Job* job = findJob(queue);
+		if (job != nullptr) {
+			execute(queue, job);
+			idleRounds = 0;
+		}
+		else if (++idleRounds < SPINS_BEFORE_SLEEP) {
+			std::this_thread::yield();
+		}
+		else {
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleeping.fetch_add(1);
+			wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+			sleeping.fetch_sub(1);
+			idleRounds = 0;
+		}
+	}
+}
+
+JobStats JobSystem::stats() const
+{
+	JobStats total;
+	for (const auto& queue : queues) {
+		total.executed += queue->executed.load(std::memory_order_relaxed);
+		total.stolen += queue->stolen.load(std::memory_order_relaxed);
+		total.ranInline += queue->ranInline.load(std::memory_order_relaxed);
+		total.spilled += queue->spilled.load(std::memory_order_relaxed);
+	}
+	return total;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+struct Job;
+
+/*
+	Chase-Lev work stealing deque of a fixed capacity (a power of two)
+
+	The owning thread pushes and pops at the bottom like a stack, so it keeps working on the jobs it made last while they
+	are still in its cache, any other thread steals from the top, taking the oldest job, which is usually the biggest
+	piece of the work left. Only the last job is contended, the owner and a thief then race for it with a compare and
+	swap on top. Ordering follows Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory
+	Models" (2013). A full deque refuses the push rather than growing, the caller then runs the job itself.
+*/
+class WorkStealingDeque
+{
+public:
+	explicit WorkStealingDeque(size_t capacity);
+
+	bool push(Job* job); //owner only, false when full
+	Job* pop(); //owner only, nullptr when empty
+	Job* steal(); //any thread, nullptr when empty or when it lost the race for the last job
+
+private:
+	alignas(64) std::atomic<int64_t> top{ 0 }; //thieves move this up
+	alignas(64) std::atomic<int64_t> bottom{ 0 }; //the owner moves this up and down
+	std::unique_ptr<std::atomic<Job*>[]> buffer;
+	int64_t mask;
+};
+
+/*
+	counts the unfinished jobs of a group: every job given the counter adds one when it is scheduled and takes it away
+	when it is done. jobs scheduled with runAfter on a counter wait here until it reaches zero
+	a counter has to outlive every job that signals it, and is only reused after a wait on it has returned
+*/
+struct JobCounter {
+	std::atomic<uint32_t> value{ 0 };
+	std::atomic<uint32_t> releasing{ 0 }; //jobs between their decrement and the end of the release, wait covers them too
+	std::atomic<Job*> continuations{ nullptr }; //intrusive list of jobs to schedule once value reaches zero
+
+	bool done() const { return value.load() == 0 && releasing.load() == 0; }
+};
+
+/*
+	what the workers did since the job system was made
+*/
+struct JobStats {
+	uint64_t executed = 0;
+	uint64_t stolen = 0; //jobs taken from another thread's deque
+	uint64_t ranInline = 0; //jobs run straight away because their deque was full
+	uint64_t spilled = 0; //jobs allocated on the heap because their thread's ring was full
+};
+
+/*
+	Work stealing job system
+
+	Every thread, the one that made the job system included, owns a WorkStealingDeque and a ring of job slots. Jobs are
+	pushed onto the deque of the thread that makes them, an idle thread first pops its own deque and then steals from
+	the others starting at a random one, and sleeps only when no deque has anything left. Dependencies are expressed
+	with counters instead of waits inside jobs: runAfter parks a job on a counter as a continuation, and the job that
+	brings the counter to zero schedules it, so a whole frame's task graph can be handed over up front and no worker
+	ever blocks. wait on the owning thread runs other jobs until the counter is done, it is the only place that blocks.
+
+	Jobs may schedule further jobs from inside, which is how a continuation fans out into a parallelFor. Job slots come
+	from a ring of JOB_RING_SIZE per thread and are reused without a lock once their job has run, a thread with more
+	jobs than that alive falls back to the heap. The first exception thrown by a job is rethrown by the next wait; the
+	remaining jobs still run so that every counter reaches zero.
+*/
+class JobSystem
+{
+public:
+	static const size_t JOB_RING_SIZE = 4096;
+
+	explicit JobSystem(uint32_t threads = 0); //threads includes the calling thread, 0 uses every hardware thread
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	uint32_t threadCount() const { return static_cast<uint32_t>(queues.size()); }
+
+	void run(std::function<void()> work, JobCounter* counter = nullptr);
+	void runAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter = nullptr);
+	void parallelFor(size_t count, size_t batch, const std::function<void(size_t begin, size_t end)>& work, JobCounter* counter);
+	void wait(JobCounter& counter);
+
+	JobStats stats() const;
+
+private:
+	struct ThreadQueue;
+
+	Job* allocate(std::function<void()>&& work, JobCounter* counter);
+	void schedule(Job* job);
+	Job* findJob(ThreadQueue& queue);
+	void execute(ThreadQueue& queue, Job* job);
+	void release(JobCounter& counter);
+	void workerThread(uint32_t index);
+	ThreadQueue& currentQueue();
+
+	std::vector<std::unique_ptr<ThreadQueue>> queues; //queues[0] belongs to the thread that made the job system
+	std::vector<std::thread> workers;
+
+	std::atomic<int64_t> queued{ 0 }; //jobs sitting in a deque, the workers sleep while there are none
+	std::atomic<uint32_t> sleeping{ 0 };
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<bool> stopping{ false };
+
+	std::mutex errorMutex;
+	std::exception_ptr error;
+};
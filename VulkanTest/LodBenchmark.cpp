@@ -0,0 +1,459 @@
+#include "LodBenchmark.h"
+#include "VulkanUtils.h"
+#include "ObjImporter.h"
+#include "MeshOptimizer.h"
+#include "VertexCompression.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	const float SPACING = 4.0f; //distance between neighbouring instances, each is scaled to a radius of about 1
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/*
+		a dense sphere with ripples on it, so the simplifier has curvature to keep. the rows wrap around and the poles are
+		single vertices, so nothing is locked and the chain can go all the way down
+	*/
+	Mesh generateBumpySphere(uint32_t rings, uint32_t segments)
+	{
+		Mesh sphere;
+		auto surface = [](float theta, float phi) {
+			float radius = 1.0f + 0.02f * std::sin(8.0f * phi) * std::sin(8.0f * theta) * std::sin(theta); //flattens out towards the poles
+			return radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+		};
+		MeshVertex pole;
+		pole.position = surface(0.0f, 0.0f);
+		pole.texCoord = glm::vec2(0.5f, 0.0f);
+		sphere.vertices.push_back(pole);
+		for (uint32_t ring = 1; ring < rings; ring++) {
+			float theta = ring * glm::pi<float>() / rings;
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				float phi = segment * glm::two_pi<float>() / segments;
+				MeshVertex vertex;
+				vertex.position = surface(theta, phi);
+				vertex.texCoord = glm::vec2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings);
+				vertex.color = glm::vec4(0.55f + 0.45f * std::cos(phi), 0.6f, 0.55f + 0.45f * std::cos(theta), 1.0f);
+				sphere.vertices.push_back(vertex);
+			}
+		}
+		pole.position = surface(glm::pi<float>(), 0.0f);
+		pole.texCoord = glm::vec2(0.5f, 1.0f);
+		sphere.vertices.push_back(pole);
+
+		uint32_t south = static_cast<uint32_t>(sphere.vertices.size() - 1);
+		auto vertex = [segments](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			uint32_t cap[3] = { 0, vertex(1, segment + 1), vertex(1, segment) };
+			sphere.indices.insert(sphere.indices.end(), cap, cap + 3);
+		}
+		for (uint32_t ring = 1; ring + 1 < rings; ring++) {
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				uint32_t a = vertex(ring, segment), b = vertex(ring + 1, segment), c = vertex(ring + 1, segment + 1), d = vertex(ring, segment + 1);
+				uint32_t quad[6] = { a, c, b, a, d, c };
+				sphere.indices.insert(sphere.indices.end(), quad, quad + 6);
+			}
+		}
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			uint32_t cap[3] = { vertex(rings - 1, segment), vertex(rings - 1, segment + 1), south };
+			sphere.indices.insert(sphere.indices.end(), cap, cap + 3);
+		}
+
+		//area weighted smooth normals
+		for (size_t i = 0; i < sphere.indices.size(); i += 3) {
+			MeshVertex& a = sphere.vertices[sphere.indices[i]];
+			MeshVertex& b = sphere.vertices[sphere.indices[i + 1]];
+			MeshVertex& c = sphere.vertices[sphere.indices[i + 2]];
+			glm::vec3 normal = glm::cross(b.position - a.position, c.position - a.position);
+			a.normal += normal;
+			b.normal += normal;
+			c.normal += normal;
+		}
+		for (auto& v : sphere.vertices) {
+			v.normal = glm::normalize(v.normal);
+		}
+		return sphere;
+	}
+}
+
+LodBenchmark::LodBenchmark(const LodBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void LodBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("LodBenchmark");
+	if (settings.file.empty()) {
+		mesh = generateBumpySphere(512, 1024);
+	}
+	else {
+		ObjImportStats importStats;
+		mesh = importObj(settings.file, 0, &importStats);
+		std::cout << "imported " << settings.file << ": " << importStats << std::endl;
+	}
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	optimizeVertexFetch(mesh);
+	auto buildStart = std::chrono::steady_clock::now();
+	chain = buildLodChain(mesh);
+	double buildMilliseconds = millisecondsSince(buildStart);
+
+	std::cout << "lod benchmark: " << mesh.vertices.size() << " vertices, " << chain.lods.size() << " levels built in "
+		<< buildMilliseconds << " ms, " << mesh.indices.size() * sizeof(uint32_t) / 1024 << " KB shared index buffer" << std::endl;
+	for (size_t lod = 0; lod < chain.lods.size(); lod++) {
+		std::cout << "  lod " << lod << ": " << chain.lods[lod].indexCount / 3 << " triangles, error " << chain.lods[lod].error / chain.radius * 100.0f
+			<< "% of the radius" << std::endl;
+	}
+
+	//instances of varying size on a regular grid, each resting on the ground plane
+	uint32_t instanceCount = settings.grid * settings.grid;
+	placements.resize(instanceCount);
+	instanceLods.resize(instanceCount);
+	for (uint32_t i = 0; i < instanceCount; i++) {
+		uint32_t hash = i * 2654435761u;
+		float size = 0.6f + 0.6f * (hash >> 8) / static_cast<float>(1u << 24);
+		float scale = size / chain.radius;
+		glm::vec3 position((i % settings.grid) * SPACING, size, (i / settings.grid) * SPACING);
+		placements[i] = glm::vec4(position - chain.center * scale, scale);
+	}
+
+	createDevice();
+	try {
+		createBuffers();
+		target = context.createOffscreenTarget(extent, VK_FORMAT_R8G8B8A8_UNORM, false);
+		createPipeline();
+		context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+
+		std::cout << "  " << instanceCount << " instances, " << settings.frames << " frames per mode on " << context.properties.deviceName
+			<< ", at most " << settings.pixelError << " pixels of error" << std::endl;
+		ModeResult full = runMode(Mode::Full);
+		ModeResult selected = runMode(Mode::Selected);
+		const char* names[2] = { "full detail", "selected   " };
+		const ModeResult* results[2] = { &full, &selected };
+		for (int i = 0; i < 2; i++) {
+			std::cout << "  " << names[i] << " " << results[i]->trianglesPerFrame / 1e6 << "M triangles per frame, selection "
+				<< results[i]->selectMicroseconds << " us";
+			if (results[i]->gpuMilliseconds > 0.0) {
+				std::cout << ", gpu frame p50 " << results[i]->gpuMilliseconds << " ms";
+			}
+			std::cout << std::endl;
+		}
+		std::cout << "  instances per level:";
+		uint64_t total = 0;
+		for (uint64_t count : selected.instancesPerLod) {
+			total += count;
+		}
+		for (size_t lod = 0; lod < selected.instancesPerLod.size(); lod++) {
+			std::cout << " " << lod << ": " << selected.instancesPerLod[lod] * 100.0 / total << "%";
+		}
+		std::cout << std::endl;
+		std::cout << "  " << (1.0 - selected.trianglesPerFrame / full.trianglesPerFrame) * 100.0 << "% fewer triangles";
+		if (full.gpuMilliseconds > 0.0 && selected.gpuMilliseconds > 0.0) {
+			std::cout << ", gpu frame " << (1.0 - selected.gpuMilliseconds / full.gpuMilliseconds) * 100.0 << "% faster";
+		}
+		std::cout << std::endl;
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+void LodBenchmark::createDevice()
+{
+	context.createInstance("LOD Benchmark", VK_API_VERSION_1_0);
+	context.createDevice({}, nullptr);
+}
+
+/*
+	copy data into a new device local buffer through a temporary staging buffer
+*/
+void LodBenchmark::uploadBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory)
+{
+	VkDevice device = context.device;
+	VkBuffer staging;
+	VkDeviceMemory stagingMemory;
+	createBuffer(device, context.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, stagingMemory);
+	void* mapped;
+	vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	memcpy(mapped, data, static_cast<size_t>(size));
+	vkUnmapMemory(device, stagingMemory);
+
+	createBuffer(device, context.physicalDevice, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, buffer, memory);
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	VkBufferCopy region = { 0, 0, size };
+	vkCmdCopyBuffer(commandBuffer, staging, buffer, 1, &region);
+	context.endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(device, staging, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+}
+
+void LodBenchmark::createBuffers()
+{
+	uploadBuffer(mesh.vertices.data(), sizeof(MeshVertex) * mesh.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexMemory);
+	uploadBuffer(mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexMemory);
+
+	VkDeviceSize instanceBytes = sizeof(glm::vec4) * placements.size() * FRAMES_IN_FLIGHT;
+	createBuffer(context.device, context.physicalDevice, instanceBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, instanceBuffer, instanceMemory);
+	void* mapped;
+	vkMapMemory(context.device, instanceMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	mappedInstances = static_cast<glm::vec4*>(mapped);
+}
+
+/*
+	lod.vert reads the mesh vertex from binding 0 and the instance placement from binding 1
+*/
+void LodBenchmark::createPipeline()
+{
+	VkDevice device = context.device;
+
+	VkPushConstantRange transformRange = pushConstantRange(context.physicalDevice, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &transformRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule vertModule = createShaderModule(device, readBinaryFile("../shaders/lod_vert.spv"));
+	VkShaderModule fragModule = createShaderModule(device, readBinaryFile("../shaders/mesh_frag.spv"));
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertModule;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragModule;
+	stages[1].pName = "main";
+
+	VertexInputLayout vertexLayout = fullVertexLayout(0);
+	VkVertexInputBindingDescription bindings[2] = { vertexLayout.binding, { 1, sizeof(glm::vec4), VK_VERTEX_INPUT_RATE_INSTANCE } };
+	std::vector<VkVertexInputAttributeDescription> attributes = vertexLayout.attributes;
+	attributes.push_back({ 4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0 });
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //struct type
+	vertexInputInfo.vertexBindingDescriptionCount = 2;
+	vertexInputInfo.pVertexBindingDescriptions = bindings;
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+	vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE; //imported meshes come with either winding
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = target.renderPass;
+	pipelineInfo.subpass = 0;
+	VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+
+	vkDestroyShaderModule(device, vertModule, nullptr);
+	vkDestroyShaderModule(device, fragModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+/*
+	the camera flies low along the middle of the field, so the nearest instances fill the screen and the far ones are a
+	few pixels across, covering half the field over the frames of a mode
+*/
+glm::mat4 LodBenchmark::cameraAt(uint32_t frame) const
+{
+	float fieldSize = settings.grid * SPACING;
+	float progress = static_cast<float>(frame) / (settings.warmupFrames + settings.frames);
+	glm::vec3 eye(fieldSize * 0.5f, 3.0f, -4.0f + progress * fieldSize * 0.5f);
+	glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.0f, -0.25f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), extent.width / static_cast<float>(extent.height), 0.1f, 1000.0f);
+	projection[1][1] *= -1.0f; //Vulkan clip space has y pointing down
+	return projection * view;
+}
+
+/*
+	selects a level for every instance (all level 0 for the full detail mode) and writes the placements into the frame's
+	region of the instance buffer grouped by level, returns the triangles the frame will draw
+*/
+uint64_t LodBenchmark::prepareInstances(size_t slot, Mode mode, const glm::mat4& viewProj, std::vector<uint32_t>& lodCounts)
+{
+	std::fill(lodCounts.begin(), lodCounts.end(), 0);
+	float viewportHeight = static_cast<float>(extent.height);
+	for (size_t i = 0; i < placements.size(); i++) {
+		uint32_t lod = 0;
+		if (mode == Mode::Selected) {
+			glm::mat4 model(1.0f);
+			model[0][0] = model[1][1] = model[2][2] = placements[i].w;
+			model[3] = glm::vec4(glm::vec3(placements[i]), 1.0f);
+			lod = selectLod(chain, model, viewProj, viewportHeight, settings.pixelError);
+		}
+		instanceLods[i] = lod;
+		lodCounts[lod]++;
+	}
+
+	std::vector<uint32_t> next(lodCounts.size());
+	uint64_t triangles = 0;
+	for (size_t lod = 0, first = 0; lod < lodCounts.size(); lod++) {
+		next[lod] = static_cast<uint32_t>(first);
+		first += lodCounts[lod];
+		triangles += static_cast<uint64_t>(lodCounts[lod]) * chain.lods[lod].indexCount / 3;
+	}
+	glm::vec4* region = mappedInstances + slot * placements.size();
+	for (size_t i = 0; i < placements.size(); i++) {
+		region[next[instanceLods[i]]++] = placements[i];
+	}
+	return triangles;
+}
+
+void LodBenchmark::recordFrame(VkCommandBuffer commandBuffer, size_t slot, const glm::mat4& viewProj, const std::vector<uint32_t>& lodCounts)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //re-recorded every frame
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+
+	VkClearValue clearColor = { 0.45f, 0.6f, 0.8f, 1.0f };
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+	renderPassInfo.renderPass = target.renderPass;
+	renderPassInfo.framebuffer = target.framebuffer;
+	renderPassInfo.renderArea = { { 0, 0 }, extent };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearColor;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkBuffer vertexBuffers[2] = { vertexBuffer, instanceBuffer };
+	VkDeviceSize offsets[2] = { 0, sizeof(glm::vec4) * placements.size() * slot };
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewProj), &viewProj);
+	uint32_t firstInstance = 0;
+	for (size_t lod = 0; lod < lodCounts.size(); lod++) {
+		if (lodCounts[lod] > 0) {
+			vkCmdDrawIndexed(commandBuffer, chain.lods[lod].indexCount, lodCounts[lod], chain.lods[lod].firstIndex, 0, firstInstance);
+			firstInstance += lodCounts[lod];
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+LodBenchmark::ModeResult LodBenchmark::runMode(Mode mode)
+{
+	VkDevice device = context.device;
+	ModeResult result;
+	result.instancesPerLod.resize(chain.lods.size(), 0);
+	std::vector<uint32_t> lodCounts(chain.lods.size());
+	uint64_t triangles = 0;
+	double selectMilliseconds = 0.0;
+	size_t frame = 0;
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		bool timed = i >= settings.warmupFrames;
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frame);
+
+		glm::mat4 viewProj = cameraAt(i);
+		auto selectStart = std::chrono::steady_clock::now();
+		uint64_t frameTriangles = prepareInstances(frame, mode, viewProj, lodCounts);
+		if (timed) {
+			selectMilliseconds += millisecondsSince(selectStart);
+			triangles += frameTriangles;
+			for (size_t lod = 0; lod < lodCounts.size(); lod++) {
+				result.instancesPerLod[lod] += lodCounts[lod];
+			}
+		}
+		recordFrame(commandBuffers[frame], frame, viewProj, lodCounts);
+
+		context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+
+	result.trianglesPerFrame = static_cast<double>(triangles) / settings.frames;
+	result.selectMicroseconds = selectMilliseconds * 1000.0 / settings.frames;
+	if (frameTimer.hasGpuTiming()) {
+		result.gpuMilliseconds = frameTimer.gpuSummary().p50;
+	}
+	return result;
+}
+
+void LodBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		vkDestroyPipeline(device, pipeline, nullptr);
+		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		context.destroyOffscreenTarget(target);
+		vkDestroyBuffer(device, vertexBuffer, nullptr);
+		freeDeviceMemory(device, vertexMemory, nullptr);
+		vkDestroyBuffer(device, indexBuffer, nullptr);
+		freeDeviceMemory(device, indexMemory, nullptr);
+		vkDestroyBuffer(device, instanceBuffer, nullptr); //unmapped by freeing
+		freeDeviceMemory(device, instanceMemory, nullptr);
+	}
+	context.cleanup();
+}
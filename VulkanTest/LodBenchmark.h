@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "FrameTimer.h"
+#include "Mesh.h"
+#include "MeshSimplifier.h"
+
+/*
+	settings for the level of detail benchmark, filled in from the command line
+*/
+struct LodBenchmarkSettings {
+	bool enabled = false;
+	std::string file; //OBJ to instance, a generated bumpy sphere when empty
+	uint32_t grid = 64; //the field is grid x grid instances
+	float pixelError = 1.0f; //largest projected error allowed when selecting a level
+	uint32_t frames = 300; //timed frames per mode
+	uint32_t warmupFrames = 20; //untimed frames per mode
+};
+
+/*
+	Level of detail benchmark
+
+	Builds a LOD chain for one mesh into a shared index buffer and flies a camera over a large instanced field of it,
+	once drawing every instance at full detail and once with each instance at the level selected from its projected
+	screen space error. Instances are sorted by level into a per frame instance buffer on the CPU, so each level is one
+	instanced indexed draw. Reports the triangles submitted, the GPU frame time and the CPU cost of the selection.
+*/
+class LodBenchmark
+{
+public:
+	explicit LodBenchmark(const LodBenchmarkSettings& settings);
+	void run();
+
+private:
+	enum class Mode { Full, Selected };
+	struct ModeResult {
+		double trianglesPerFrame = 0.0;
+		double selectMicroseconds = 0.0; //CPU time of selection and instance upload per frame
+		double gpuMilliseconds = 0.0; //median, 0 without timestamps
+		std::vector<uint64_t> instancesPerLod; //summed over the timed frames
+	};
+
+	void createDevice();
+	void createBuffers();
+	void createPipeline();
+	glm::mat4 cameraAt(uint32_t frame) const;
+	uint64_t prepareInstances(size_t slot, Mode mode, const glm::mat4& viewProj, std::vector<uint32_t>& lodCounts);
+	void recordFrame(VkCommandBuffer commandBuffer, size_t slot, const glm::mat4& viewProj, const std::vector<uint32_t>& lodCounts);
+	ModeResult runMode(Mode mode);
+	void uploadBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory);
+	void cleanup();
+
+	LodBenchmarkSettings settings;
+	HeadlessDevice context;
+	Mesh mesh; //indices hold the whole chain
+	LodChain chain;
+	std::vector<glm::vec4> placements; //xyz translation, w scale of every instance
+	std::vector<uint32_t> instanceLods; //scratch, the level of every instance this frame
+
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+	VkBuffer instanceBuffer = VK_NULL_HANDLE; //one region of placements per frame in flight, persistently mapped
+	VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+	glm::vec4* mappedInstances = nullptr;
+
+	VkExtent2D extent = { 1280, 720 };
+	OffscreenTarget target; //R8G8B8A8_UNORM, never read back
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE; //view projection push constant
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
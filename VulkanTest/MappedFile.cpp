@@ -0,0 +1,88 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& filename)
+{
+	file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+		throw std::runtime_error("unable to open " + filename);
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	length = static_cast<size_t>(fileSize.QuadPart);
+	if (length == 0) {
+		return; //empty files cannot be mapped, data() stays null
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping != nullptr) {
+		view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (view == nullptr) {
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		throw std::runtime_error("unable to map " + filename);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+	}
+	if (mapping != nullptr) {
+		CloseHandle(mapping);
+	}
+	if (file != nullptr) {
+		CloseHandle(file);
+	}
+}
+#else
+MappedFile::MappedFile(const std::string& filename)
+{
+	file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("unable to open " + filename);
+	}
+	struct stat status;
+	fstat(file, &status);
+	length = static_cast<size_t>(status.st_size);
+	if (length == 0) {
+		return;
+	}
+
+	void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+	if (address == MAP_FAILED) {
+		close(file);
+		throw std::runtime_error("unable to map " + filename);
+	}
+	madvise(address, length, MADV_SEQUENTIAL); //every chunk is read front to back
+	view = static_cast<const char*>(address);
+}
+
+MappedFile::~MappedFile()
+{
+	if (view != nullptr) {
+		munmap(const_cast<char*>(view), length);
+	}
+	if (file >= 0) {
+		close(file);
+	}
+}
+#endif
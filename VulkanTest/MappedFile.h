@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+	read only memory mapping of a whole file, the pages are brought in by the OS as they are touched so large files can be
+	parsed without reading them into a buffer first
+*/
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& filename); //throws if the file cannot be opened or mapped
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const { return view; }
+	size_t size() const { return length; }
+
+private:
+	const char* view = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr; //HANDLE
+	void* mapping = nullptr; //HANDLE
+#else
+	int file = -1;
+#endif
+};
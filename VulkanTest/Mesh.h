@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+	full precision vertex as produced by the importers
+*/
+struct MeshVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texCoord;
+	glm::vec4 color = glm::vec4(1.0f); //OBJ files carry none, so imported vertices are white
+};
+
+/*
+	indexed triangle list, three indices per triangle
+*/
+struct Mesh {
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+
+	size_t triangleCount() const { return indices.size() / 3; }
+};
@@ -0,0 +1,120 @@
+#include "MeshBenchmark.h"
+#include "ObjImporter.h"
+#include "MeshOptimizer.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <chrono>
+#include <functional>
+#include <cmath>
+
+namespace {
+	const uint32_t TORUS_RINGS = 1024;
+	const uint32_t TORUS_SIDES = 512;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+MeshBenchmark::MeshBenchmark(const MeshBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+/*
+	a finely tessellated torus written the way exporters do: every position, texcoord and normal once, then quads row by row
+	with the seam vertices duplicated in texcoord space only, so deduplication has real work to do
+*/
+void MeshBenchmark::writeTestMesh(const std::string& filename)
+{
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) {
+		throw std::runtime_error("unable to open " + filename);
+	}
+	out << "# generated by --mesh-bench\no torus\n";
+	const float major = 1.0f, minor = 0.3f;
+	for (uint32_t ring = 0; ring < TORUS_RINGS; ring++) {
+		float u = ring * glm::two_pi<float>() / TORUS_RINGS;
+		for (uint32_t side = 0; side < TORUS_SIDES; side++) {
+			float v = side * glm::two_pi<float>() / TORUS_SIDES;
+			glm::vec3 normal(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v), std::sin(v));
+			glm::vec3 position = glm::vec3(std::cos(u) * major, std::sin(u) * major, 0.0f) + normal * minor;
+			out << "v " << position.x << ' ' << position.y << ' ' << position.z << '\n';
+			out << "vn " << normal.x << ' ' << normal.y << ' ' << normal.z << '\n';
+		}
+	}
+	for (uint32_t ring = 0; ring <= TORUS_RINGS; ring++) {
+		for (uint32_t side = 0; side <= TORUS_SIDES; side++) {
+			out << "vt " << static_cast<float>(ring) / TORUS_RINGS << ' ' << static_cast<float>(side) / TORUS_SIDES << '\n';
+		}
+	}
+	out << "s 1\n";
+	auto position = [](uint32_t ring, uint32_t side) { return (ring % TORUS_RINGS) * TORUS_SIDES + side % TORUS_SIDES + 1; };
+	auto texCoord = [](uint32_t ring, uint32_t side) { return ring * (TORUS_SIDES + 1) + side + 1; };
+	for (uint32_t ring = 0; ring < TORUS_RINGS; ring++) {
+		for (uint32_t side = 0; side < TORUS_SIDES; side++) {
+			out << 'f';
+			const uint32_t corners[4][2] = { { ring, side }, { ring + 1, side }, { ring + 1, side + 1 }, { ring, side + 1 } };
+			for (const auto& corner : corners) {
+				uint32_t p = position(corner[0], corner[1]);
+				out << ' ' << p << '/' << texCoord(corner[0], corner[1]) << '/' << p;
+			}
+			out << '\n';
+		}
+	}
+	if (!out) {
+		throw std::runtime_error("failed to write " + filename);
+	}
+}
+
+void MeshBenchmark::run()
+{
+	std::string filename = settings.file;
+	if (filename.empty()) {
+		filename = "mesh_bench.obj";
+		auto start = std::chrono::steady_clock::now();
+		writeTestMesh(filename);
+		std::cout << "wrote " << TORUS_RINGS * TORUS_SIDES * 2 << " triangle torus to " << filename << " in " << millisecondsSince(start) << " ms" << std::endl;
+	}
+
+	ObjImportStats stats;
+	importObj(filename, 1, &stats); //also brings the file into the page cache so both runs read from memory
+	std::cout << "import, 1 thread:   " << stats << std::endl;
+	double singleThreaded = stats.megabytesPerSecond();
+	Mesh mesh = importObj(filename, settings.threads, &stats);
+	std::cout << "import, " << stats.threads << " threads: " << stats << std::endl;
+	std::cout << "parallel speedup " << stats.megabytesPerSecond() / singleThreaded << "x" << std::endl;
+
+	uint32_t cacheSize = settings.cacheSize;
+	auto report = [&](const char* name, const std::vector<uint32_t>& indices, double milliseconds) {
+		VertexCacheStats cache = analyzeVertexCache(indices, mesh.vertices.size(), cacheSize);
+		std::cout << name << ": ACMR " << cache.acmr << ", ATVR " << cache.atvr << " (" << cache.transformed << " vertex shader invocations)";
+		if (milliseconds > 0.0) {
+			std::cout << " in " << milliseconds << " ms";
+		}
+		std::cout << std::endl;
+		return cache.acmr;
+	};
+	std::cout << mesh.triangleCount() << " triangles, " << mesh.vertices.size() << " vertices, simulated FIFO of " << cacheSize << std::endl;
+	double original = report("original order", mesh.indices, 0.0);
+
+	auto optimize = [&](const char* name, std::function<void(std::vector<uint32_t>&)> optimizer) {
+		std::vector<uint32_t> indices = mesh.indices;
+		auto start = std::chrono::steady_clock::now();
+		optimizer(indices);
+		double acmr = report(name, indices, millisecondsSince(start));
+		std::cout << "  " << (original - acmr) / original * 100.0 << "% fewer transformed vertices than the original order" << std::endl;
+		return indices;
+	};
+	optimize("forsyth", [&](std::vector<uint32_t>& indices) { optimizeVertexCache(indices, mesh.vertices.size()); });
+	optimize("tipsify", [&](std::vector<uint32_t>& indices) { tipsify(indices, mesh.vertices.size(), cacheSize); });
+	mesh.indices = optimize("tipsify + overdraw", [&](std::vector<uint32_t>& indices) { optimizeOverdraw(indices, mesh.vertices, cacheSize); });
+
+	auto start = std::chrono::steady_clock::now();
+	optimizeVertexFetch(mesh);
+	std::cout << "vertex fetch reorder in " << millisecondsSince(start) << " ms" << std::endl;
+}
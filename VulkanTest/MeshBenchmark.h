@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/*
+	settings for the mesh import and optimisation benchmark, filled in from the command line
+*/
+struct MeshBenchmarkSettings {
+	bool enabled = false;
+	std::string file; //OBJ to import, a generated torus is written to mesh_bench.obj when empty
+	uint32_t threads = 0; //import threads, 0 for every hardware thread
+	uint32_t cacheSize = 16; //FIFO size the cache statistics are simulated with and Tipsify optimises for
+};
+
+/*
+	Mesh import benchmark
+
+	Imports an OBJ with one thread and with all of them and reports the throughput, then reorders the triangles with
+	Forsyth's algorithm, with Tipsify and with Tipsify plus overdraw clustering and reports the vertex cache miss ratios
+	(ACMR, ATVR) of each order next to the original one, along with how long each optimisation took. Runs on the CPU only.
+*/
+class MeshBenchmark
+{
+public:
+	explicit MeshBenchmark(const MeshBenchmarkSettings& settings);
+	void run();
+
+private:
+	void writeTestMesh(const std::string& filename);
+
+	MeshBenchmarkSettings settings;
+};
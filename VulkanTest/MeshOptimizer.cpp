@@ -0,0 +1,345 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	/*
+		triangles around every vertex in one flat array, triangles of vertex v are triangles[offsets[v]] up to offsets[v + 1]
+	*/
+	struct Adjacency {
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+
+		Adjacency(const std::vector<uint32_t>& indices, size_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indices.size())
+		{
+			for (uint32_t index : indices) {
+				offsets[index + 1]++;
+			}
+			for (size_t v = 0; v < vertexCount; v++) {
+				offsets[v + 1] += offsets[v];
+			}
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++) {
+				triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		}
+
+		uint32_t count(uint32_t vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+	};
+
+	//constants from Forsyth's article
+	const int FORSYTH_CACHE_SIZE = 32;
+	const float LAST_TRIANGLE_SCORE = 0.75f; //the vertices of the triangle just emitted are scored down slightly
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	float forsythScore(int cachePosition, uint32_t remaining)
+	{
+		if (remaining == 0) {
+			return -1.0f; //no triangles left to pull in
+		}
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+		return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+	}
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1; //a vertex is in the FIFO when fewer than cacheSize misses happened since it was loaded
+	for (uint32_t index : indices) {
+		if (time - timestamps[index] > cacheSize) {
+			timestamps[index] = time++;
+			stats.transformed++;
+		}
+	}
+	size_t used = 0;
+	for (uint32_t timestamp : timestamps) {
+		used += timestamp != 0;
+	}
+	stats.acmr = indices.empty() ? 0.0 : stats.transformed / (indices.size() / 3.0);
+	stats.atvr = used == 0 ? 0.0 : stats.transformed / static_cast<double>(used);
+	return stats;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+	Adjacency adjacency(indices, vertexCount);
+
+	//live triangles of a vertex are kept at the front of its adjacency range, remaining counts them
+	std::vector<uint32_t> remaining(vertexCount);
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		remaining[v] = adjacency.count(v);
+		vertexScore[v] = forsythScore(-1, remaining[v]);
+	}
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (size_t t = 0; t < triangleCount; t++) {
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	std::vector<uint32_t> cache, nextCache; //most recent first, up to three entries over size while being rebuilt
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+	size_t scan = 0; //everything before this has been emitted, for when the cache has nothing left to offer
+
+	uint32_t best = static_cast<uint32_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		if (best == UINT32_MAX) {
+			while (emitted[scan]) scan++;
+			best = static_cast<uint32_t>(scan);
+		}
+		emitted[best] = true;
+		const uint32_t* triangle = &indices[best * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+
+		//take the triangle out of the live lists of its vertices
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t v = triangle[corner];
+			uint32_t* live = &adjacency.triangles[adjacency.offsets[v]];
+			for (uint32_t i = 0; i < remaining[v]; i++) {
+				if (live[i] == best) {
+					std::swap(live[i], live[remaining[v] - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		//new cache: the triangle in front, then the old order without duplicates
+		nextCache.assign(triangle, triangle + 3);
+		for (uint32_t v : cache) {
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+				nextCache.push_back(v);
+			}
+		}
+		for (size_t i = 0; i < nextCache.size(); i++) {
+			uint32_t v = nextCache[i];
+			cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+		}
+
+		//rescore everything whose cache position or valence changed, the best candidate is among their triangles
+		best = UINT32_MAX;
+		float bestScore = -1.0f;
+		for (uint32_t v : nextCache) {
+			float score = forsythScore(cachePosition[v], remaining[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+			const uint32_t* live = &adjacency.triangles[adjacency.offsets[v]];
+			for (uint32_t i = 0; i < remaining[v]; i++) {
+				uint32_t t = live[i];
+				triangleScore[t] += delta;
+				if (triangleScore[t] > bestScore) {
+					bestScore = triangleScore[t];
+					best = t;
+				}
+			}
+		}
+		if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+			nextCache.resize(FORSYTH_CACHE_SIZE);
+		}
+		std::swap(cache, nextCache);
+	}
+	indices.swap(output);
+}
+
+std::vector<uint32_t> tipsify(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	std::vector<uint32_t> clusters;
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return clusters;
+	}
+	Adjacency adjacency(indices, vertexCount);
+	std::vector<uint32_t> live(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		live[v] = adjacency.count(v);
+	}
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds; //recently touched vertices, the cheap place to continue when the fan runs out
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1;
+	uint32_t cursor = 0; //for when the dead end stack is exhausted too
+	uint32_t fanning = 0;
+	while (cursor < vertexCount && live[cursor] == 0) cursor++;
+	fanning = cursor;
+	clusters.push_back(0);
+
+	while (fanning != UINT32_MAX) {
+		candidates.clear();
+		for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++) {
+			uint32_t t = adjacency.triangles[i];
+			if (emitted[t]) {
+				continue;
+			}
+			emitted[t] = true;
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t v = indices[t * 3 + corner];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - timestamps[v] > cacheSize) {
+					timestamps[v] = time++;
+				}
+			}
+		}
+
+		//the 1-ring vertex that will still be in the cache after its remaining fan is emitted and is oldest in it
+		uint32_t next = UINT32_MAX;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates) {
+			if (live[v] == 0) {
+				continue;
+			}
+			int64_t priority = 0;
+			if (time - timestamps[v] + 2 * live[v] <= cacheSize) {
+				priority = time - timestamps[v];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next == UINT32_MAX) {
+			while (!deadEnds.empty()) {
+				uint32_t v = deadEnds.back();
+				deadEnds.pop_back();
+				if (live[v] > 0) {
+					next = v;
+					break;
+				}
+			}
+		}
+		if (next == UINT32_MAX) {
+			while (cursor < vertexCount && live[cursor] == 0) cursor++;
+			if (cursor < vertexCount) {
+				next = cursor;
+				clusters.push_back(static_cast<uint32_t>(output.size())); //a jump to a disconnected part of the mesh
+			}
+		}
+		fanning = next;
+	}
+	indices.swap(output);
+	return clusters;
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, uint32_t cacheSize, float threshold)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+	std::vector<uint32_t> hardBoundaries = tipsify(indices, vertices.size(), cacheSize);
+	double meshAcmr = analyzeVertexCache(indices, vertices.size(), cacheSize).acmr;
+
+	//soft boundaries inside each hard cluster, the cache restarts at each cut since the next cluster may be drawn anywhere
+	std::vector<uint32_t> clusters;
+	std::vector<uint32_t> timestamps(vertices.size(), 0);
+	uint32_t time = cacheSize + 1;
+	hardBoundaries.push_back(static_cast<uint32_t>(indices.size()));
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+		uint32_t start = hardBoundaries[h];
+		clusters.push_back(start);
+		time += cacheSize + 1; //everything counts as evicted
+		uint32_t misses = 0;
+		for (uint32_t i = start; i < hardBoundaries[h + 1]; i += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t v = indices[i + corner];
+				if (time - timestamps[v] > cacheSize) {
+					timestamps[v] = time++;
+					misses++;
+				}
+			}
+			uint32_t triangles = (i + 3 - clusters.back()) / 3;
+			if (i + 3 < hardBoundaries[h + 1] && misses <= threshold * meshAcmr * triangles) {
+				clusters.push_back(i + 3);
+				time += cacheSize + 1;
+				misses = 0;
+			}
+		}
+	}
+	clusters.push_back(static_cast<uint32_t>(indices.size()));
+
+	//area weighted centroid and normal of every cluster
+	struct Cluster {
+		uint32_t begin, end;
+		float sortKey;
+	};
+	std::vector<Cluster> sorted;
+	std::vector<glm::vec3> centroids, normals;
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c + 1 < clusters.size(); c++) {
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (uint32_t i = clusters[c]; i < clusters[c + 1]; i += 3) {
+			const glm::vec3& a = vertices[indices[i]].position;
+			const glm::vec3& b = vertices[indices[i + 1]].position;
+			const glm::vec3& d = vertices[indices[i + 2]].position;
+			glm::vec3 faceNormal = glm::cross(b - a, d - a);
+			float faceArea = glm::length(faceNormal);
+			centroid += (a + b + d) * (faceArea / 3.0f);
+			normal += faceNormal;
+			area += faceArea;
+		}
+		meshCentroid += centroid;
+		meshArea += area;
+		centroids.push_back(area > 0.0f ? centroid / area : vertices[indices[clusters[c]]].position);
+		float length = glm::length(normal);
+		normals.push_back(length > 0.0f ? normal / length : glm::vec3(0.0f));
+		sorted.push_back({ clusters[c], clusters[c + 1], 0.0f });
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+	for (size_t c = 0; c < sorted.size(); c++) {
+		sorted[c].sortKey = glm::dot(centroids[c] - meshCentroid, normals[c]);
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+	for (const auto& cluster : sorted) {
+		output.insert(output.end(), indices.begin() + cluster.begin, indices.begin() + cluster.end);
+	}
+	indices.swap(output);
+}
+
+void optimizeVertexFetch(Mesh& mesh)
+{
+	std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+	std::vector<MeshVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (uint32_t& index : mesh.indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices.swap(vertices);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Mesh.h"
+
+/*
+	post transform cache behaviour of an index order, simulated as a FIFO of cacheSize vertices
+*/
+struct VertexCacheStats {
+	uint32_t transformed = 0; //cache misses, each one a vertex shader invocation
+	double acmr = 0.0; //average cache miss ratio, misses per triangle, 0.5 is the limit for a regular grid
+	double atvr = 0.0; //average transform to vertex ratio, misses per vertex, 1.0 is ideal
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+/*
+	Forsyth's linear speed vertex cache optimisation: triangles are emitted greedily by a score that prefers vertices that
+	are recently used in a simulated LRU cache and vertices that have few triangles left, which finishes off areas instead
+	of leaving islands behind. Works on any cache size without knowing it exactly.
+*/
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+/*
+	Tipsify (Sander, Nehab and Barczak 2007) reorders for a FIFO cache of cacheSize and returns the index offsets at
+	which it had to jump to an unrelated part of the mesh, the natural boundaries for overdraw clusters
+*/
+std::vector<uint32_t> tipsify(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+/*
+	Tipsify followed by the overdraw step of the same paper: the order is cut into clusters at its dead ends and wherever
+	the running ACMR of the cluster is at most threshold times the ACMR of the whole order (so the cache cost of the
+	extra cuts stays bounded), and the clusters are sorted so the ones facing outwards from the mesh centre come first,
+	which are the ones most likely to occlude the rest from any viewpoint
+*/
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, uint32_t cacheSize = 16, float threshold = 1.05f);
+
+/*
+	renumbers the vertices in order of first use so vertex fetch walks the buffer linearly, unused vertices are dropped
+*/
+void optimizeVertexFetch(Mesh& mesh);
@@ -0,0 +1,308 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+namespace {
+	/*
+		symmetric 4x4 plane quadric, the sum of weight * (n.p + d)^2 over its planes, with the total weight kept so the
+		error can be read back as a mean squared distance
+	*/
+	struct Quadric {
+		double a2 = 0.0, b2 = 0.0, c2 = 0.0, ab = 0.0, ac = 0.0, bc = 0.0;
+		double ad = 0.0, bd = 0.0, cd = 0.0, d2 = 0.0;
+		double weight = 0.0;
+
+		void addPlane(const glm::dvec3& n, double d, double w)
+		{
+			a2 += w * n.x * n.x; b2 += w * n.y * n.y; c2 += w * n.z * n.z;
+			ab += w * n.x * n.y; ac += w * n.x * n.z; bc += w * n.y * n.z;
+			ad += w * n.x * d; bd += w * n.y * d; cd += w * n.z * d;
+			d2 += w * d * d;
+			weight += w;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a2 += other.a2; b2 += other.b2; c2 += other.c2;
+			ab += other.ab; ac += other.ac; bc += other.bc;
+			ad += other.ad; bd += other.bd; cd += other.cd;
+			d2 += other.d2;
+			weight += other.weight;
+			return *this;
+		}
+
+		double evaluate(const glm::vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double sum = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+				+ 2.0 * (ad * x + bd * y + cd * z) + d2;
+			return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct PositionHash {
+		size_t operator()(const glm::vec3& p) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	uint64_t edgeKey(uint32_t a, uint32_t b)
+	{
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+
+	/*
+		vertices that must not move: on a border or non-manifold edge, or sharing a position with another vertex
+		edges are counted between welded positions so a seam does not look like a border
+	*/
+	std::vector<bool> findLockedVertices(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<bool> locked(vertices.size(), false);
+		std::vector<uint32_t> welded(vertices.size());
+		std::unordered_map<glm::vec3, uint32_t, PositionHash> firstAtPosition;
+		for (uint32_t i = 0; i < vertices.size(); i++) {
+			auto inserted = firstAtPosition.emplace(vertices[i].position, i);
+			welded[i] = inserted.first->second;
+			if (!inserted.second) {
+				locked[i] = true;
+				locked[inserted.first->second] = true;
+			}
+		}
+
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		edgeUses.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				edgeUses[edgeKey(welded[indices[i + corner]], welded[indices[i + (corner + 1) % 3]])]++;
+			}
+		}
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t a = indices[i + corner], b = indices[i + (corner + 1) % 3];
+				if (edgeUses[edgeKey(welded[a], welded[b])] != 2) {
+					locked[a] = true;
+					locked[b] = true;
+				}
+			}
+		}
+		return locked;
+	}
+
+	glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		return glm::cross(b - a, c - a);
+	}
+
+	/*
+		view space scale of the model in pixels per mesh unit at the near side of its bounding sphere, infinite when the
+		camera is inside the sphere
+	*/
+	float pixelsPerUnit(const LodChain& chain, const glm::mat4& model, const glm::mat4& viewProj, float viewportHeight)
+	{
+		float modelScale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+		glm::vec4 center = viewProj * (model * glm::vec4(chain.center, 1.0f));
+		float distance = center.w - chain.radius * modelScale;
+		if (distance <= 0.0f) {
+			return std::numeric_limits<float>::infinity();
+		}
+		float projectionScale = glm::length(glm::vec3(viewProj[0][1], viewProj[1][1], viewProj[2][1]));
+		return modelScale * projectionScale * 0.5f * viewportHeight / distance;
+	}
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float& error)
+{
+	std::vector<uint32_t> result = indices;
+	error = 0.0f;
+	if (result.size() <= targetIndexCount) {
+		return result;
+	}
+
+	std::vector<bool> locked = findLockedVertices(vertices, indices);
+	std::vector<Quadric> quadrics(vertices.size());
+	for (size_t i = 0; i < result.size(); i += 3) {
+		glm::dvec3 a = vertices[result[i]].position, b = vertices[result[i + 1]].position, c = vertices[result[i + 2]].position;
+		glm::dvec3 normal = glm::cross(b - a, c - a);
+		double length = glm::length(normal);
+		if (length <= 0.0) {
+			continue;
+		}
+		normal /= length;
+		double d = -glm::dot(normal, a);
+		for (int corner = 0; corner < 3; corner++) {
+			quadrics[result[i + corner]].addPlane(normal, d, length * 0.5); //weighted by area so small triangles count for less
+		}
+	}
+
+	struct Collapse {
+		uint32_t from, to;
+		double cost;
+	};
+	std::vector<Collapse> candidates;
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> triangleOffsets(vertices.size() + 1), triangleList; //triangles around each vertex
+	std::vector<uint32_t> collapseTo(vertices.size());
+	std::vector<bool> touched(vertices.size());
+	double maxCost = 0.0;
+
+	while (result.size() > targetIndexCount) {
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (uint32_t index : result) {
+			triangleOffsets[index + 1]++;
+		}
+		std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+		triangleList.resize(result.size());
+		std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++) {
+			triangleList[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		//each directed edge of a manifold mesh belongs to exactly one triangle, so this lists both directions of every edge once
+		candidates.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t from = result[i + corner], to = result[i + (corner + 1) % 3];
+				if (locked[from]) {
+					continue;
+				}
+				Quadric merged = quadrics[from];
+				merged += quadrics[to];
+				candidates.push_back({ from, to, merged.evaluate(vertices[to].position) });
+			}
+		}
+		order.resize(candidates.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return candidates[a].cost < candidates[b].cost; });
+
+		std::iota(collapseTo.begin(), collapseTo.end(), 0);
+		std::fill(touched.begin(), touched.end(), false);
+		size_t removable = (result.size() - targetIndexCount + 2) / 3;
+		size_t removed = 0;
+		for (uint32_t candidate : order) {
+			if (removed >= removable) {
+				break;
+			}
+			const Collapse& collapse = candidates[candidate];
+			if (touched[collapse.from] || touched[collapse.to]) {
+				continue;
+			}
+
+			//moving from onto to must not turn any of the triangles that survive the collapse over
+			glm::vec3 target = vertices[collapse.to].position;
+			bool flips = false;
+			size_t collapsing = 0;
+			for (uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; t++) {
+				const uint32_t* triangle = &result[triangleList[t] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+					collapsing++;
+					continue;
+				}
+				glm::vec3 corners[3], moved[3];
+				for (int corner = 0; corner < 3; corner++) {
+					corners[corner] = vertices[triangle[corner]].position;
+					moved[corner] = triangle[corner] == collapse.from ? target : corners[corner];
+				}
+				glm::vec3 before = triangleNormal(corners[0], corners[1], corners[2]);
+				glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+				flips = glm::dot(before, after) <= 0.0f;
+			}
+			if (flips || collapsing == 0) {
+				continue;
+			}
+
+			collapseTo[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			maxCost = std::max(maxCost, collapse.cost);
+			removed += collapsing;
+			//everything around the collapse has changed, leave it alone for the rest of the pass
+			for (uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++) {
+				const uint32_t* triangle = &result[triangleList[t] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+			}
+		}
+		if (removed == 0) {
+			break; //everything left is locked or would flip
+		}
+
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = collapseTo[result[i]], b = collapseTo[result[i + 1]], c = collapseTo[result[i + 2]];
+			if (a != b && b != c && a != c) {
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+	error = static_cast<float>(std::sqrt(maxCost));
+	return result;
+}
+
+LodChain buildLodChain(Mesh& mesh, uint32_t maxLods, float reduction, size_t minTriangles)
+{
+	LodChain chain;
+	if (mesh.vertices.empty()) {
+		return chain;
+	}
+	glm::vec3 boundsMin = mesh.vertices[0].position, boundsMax = mesh.vertices[0].position;
+	for (const auto& vertex : mesh.vertices) {
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	chain.center = (boundsMin + boundsMax) * 0.5f;
+	for (const auto& vertex : mesh.vertices) {
+		chain.radius = std::max(chain.radius, glm::length(vertex.position - chain.center));
+	}
+
+	MeshLod full;
+	full.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	chain.lods.push_back(full);
+
+	std::vector<uint32_t> previous = mesh.indices;
+	while (chain.lods.size() < maxLods && previous.size() / 3 > minTriangles) {
+		size_t target = std::max(static_cast<size_t>(previous.size() / 3 * reduction), minTriangles) * 3;
+		float stepError;
+		std::vector<uint32_t> simplified = simplifyMesh(mesh.vertices, previous, target, stepError);
+		if (simplified.size() * 10 > previous.size() * 9) {
+			break;
+		}
+		optimizeVertexCache(simplified, mesh.vertices.size());
+
+		MeshLod lod;
+		lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+		lod.indexCount = static_cast<uint32_t>(simplified.size());
+		lod.error = chain.lods.back().error + stepError; //the deviations of the steps can add up, never more than that
+		chain.lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+		previous = std::move(simplified);
+	}
+	return chain;
+}
+
+float projectedError(const LodChain& chain, uint32_t lod, const glm::mat4& model, const glm::mat4& viewProj, float viewportHeight)
+{
+	return chain.lods[lod].error * pixelsPerUnit(chain, model, viewProj, viewportHeight);
+}
+
+uint32_t selectLod(const LodChain& chain, const glm::mat4& model, const glm::mat4& viewProj, float viewportHeight, float pixelThreshold)
+{
+	float scale = pixelsPerUnit(chain, model, viewProj, viewportHeight);
+	uint32_t selected = 0;
+	for (uint32_t lod = 1; lod < chain.lods.size(); lod++) {
+		if (chain.lods[lod].error * scale > pixelThreshold) {
+			break; //errors only grow along the chain
+		}
+		selected = lod;
+	}
+	return selected;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Mesh.h"
+
+/*
+	Quadric error metric simplification (Garland and Heckbert 1997)
+
+	Every vertex accumulates the area weighted planes of the triangles around it, and edges are collapsed cheapest first
+	where the cost of moving a vertex onto its neighbour is the mean squared distance of the new position from the planes
+	of both. Vertices only ever collapse onto existing vertices, so every level of detail indexes the same vertex buffer.
+
+	Collapses are applied in passes: each pass sorts all candidate edges, takes the cheapest ones that share no triangle
+	with a collapse already taken in the pass and that flip no triangle, then rewrites the index buffer. Vertices on a
+	border or non-manifold edge and vertices that share their position with another vertex (texcoord and normal seams)
+	are locked in place, which keeps the silhouette of open meshes and stops seams from tearing.
+
+	Returns the simplified indices, stopping early when no collapse is possible. error receives the largest collapse
+	cost taken as a distance in mesh units, an estimate of how far the result deviates from the input.
+*/
+std::vector<uint32_t> simplifyMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float& error);
+
+/*
+	one level of detail, a range of the shared index buffer
+*/
+struct MeshLod {
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	float error = 0.0f; //geometric deviation from the full mesh in mesh units, 0 for the full mesh
+};
+
+/*
+	levels of detail of one mesh, finest first, with the bounding sphere used to project their error
+*/
+struct LodChain {
+	std::vector<MeshLod> lods;
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+};
+
+/*
+	simplifies the mesh repeatedly to reduction times the previous triangle count and appends each level's indices to
+	mesh.indices, so the index buffer holds the whole chain with the original triangles as level 0. Each level is
+	simplified from the one before it and carries the sum of the errors along the way. Stops after maxLods levels, below
+	minTriangles or when a level fails to remove at least a tenth of the triangles of the one before it.
+*/
+LodChain buildLodChain(Mesh& mesh, uint32_t maxLods = 12, float reduction = 0.5f, size_t minTriangles = 64);
+
+/*
+	error of a level in pixels when drawn with the model matrix through viewProj into a viewport viewportHeight pixels
+	tall. Everything comes from the matrices: the length of the second row of viewProj is the vertical projection scale
+	(the view matrix is a rotation, so it does not change it), the fourth row gives the view distance of the bounding
+	sphere and the largest column of the model matrix its scale. The distance is taken to the near side of the sphere so
+	the estimate never undershoots for any point of the mesh.
+*/
+float projectedError(const LodChain& chain, uint32_t lod, const glm::mat4& model, const glm::mat4& viewProj, float viewportHeight);
+
+/*
+	coarsest level whose projected error is at most pixelThreshold, the finest level when the camera is inside the sphere
+*/
+uint32_t selectLod(const LodChain& chain, const glm::mat4& model, const glm::mat4& viewProj, float viewportHeight, float pixelThreshold = 1.0f);
@@ -0,0 +1,398 @@
+#include "ObjImporter.h"
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	const int32_t MISSING = INT32_MIN; //corner without a texcoord or normal
+
+	//one triangle corner as written in the file, 0 based, relative indices still relative to the chunk
+	struct ObjCorner {
+		int32_t index[3]; //position, texcoord, normal
+		uint8_t relative; //bit n set when index[n] counts back from the elements the chunk had parsed so far
+	};
+
+	struct ObjChunk {
+		const char* begin;
+		const char* end;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> texCoords;
+		std::vector<glm::vec3> normals;
+		std::vector<ObjCorner> corners;
+		size_t base[3] = {}; //elements of each kind in the chunks before this one
+	};
+
+	bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	/*
+		strtof is locale dependent and much slower than it needs to be for the plain decimals exporters write
+	*/
+	const char* parseFloat(const char* p, const char* end, float& value)
+	{
+		while (p < end && isSpace(*p)) p++;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int digits = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			if (digits < 18) {
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+			}
+			else {
+				exponent++; //digits past what fits only scale the value
+			}
+		}
+		if (p < end && *p == '.') {
+			for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+				if (digits < 18) {
+					mantissa = mantissa * 10 + (*p - '0');
+					digits += mantissa != 0;
+					exponent--;
+				}
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			p++;
+			bool negativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+')) {
+				negativeExponent = *p == '-';
+				p++;
+			}
+			int e = 0;
+			for (; p < end && *p >= '0' && *p <= '9'; p++) {
+				e = std::min(e * 10 + (*p - '0'), 1000);
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+		static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		double result = static_cast<double>(mantissa);
+		if (exponent >= 0) {
+			result = exponent <= 22 ? result * powers[exponent] : result * std::pow(10.0, exponent);
+		}
+		else {
+			result = exponent >= -22 ? result / powers[-exponent] : result * std::pow(10.0, exponent);
+		}
+		value = static_cast<float>(negative ? -result : result);
+		return p;
+	}
+
+	const char* parseInt(const char* p, const char* end, int32_t& value)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+		int64_t result = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			result = std::min<int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+		}
+		value = static_cast<int32_t>(negative ? -result : result);
+		return p;
+	}
+
+	/*
+		one face corner: v, v/vt, v//vn or v/vt/vn
+	*/
+	const char* parseCorner(const char* p, const char* end, const ObjChunk& chunk, ObjCorner& corner)
+	{
+		const size_t counts[3] = { chunk.positions.size(), chunk.texCoords.size(), chunk.normals.size() };
+		corner.relative = 0;
+		for (int component = 0; component < 3; component++) {
+			corner.index[component] = MISSING;
+			if (component > 0) {
+				if (p >= end || *p != '/') {
+					continue;
+				}
+				p++;
+				if (p < end && *p == '/') {
+					continue; //v//vn leaves the texcoord out
+				}
+			}
+			if (p >= end || !((*p >= '0' && *p <= '9') || *p == '-' || *p == '+')) {
+				continue;
+			}
+			int32_t index;
+			p = parseInt(p, end, index);
+			if (index > 0) {
+				corner.index[component] = index - 1;
+			}
+			else if (index < 0) {
+				corner.index[component] = static_cast<int32_t>(counts[component]) + index;
+				corner.relative |= 1 << component;
+			}
+			else {
+				throw std::runtime_error("obj face index 0 is not valid");
+			}
+		}
+		return p;
+	}
+
+	void parseChunk(ObjChunk& chunk)
+	{
+		std::vector<ObjCorner> polygon;
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		while (p < end) {
+			const char* lineEnd = p;
+			while (lineEnd < end && *lineEnd != '\n') lineEnd++;
+			while (p < lineEnd && isSpace(*p)) p++;
+
+			if (lineEnd - p > 2 && p[0] == 'v' && isSpace(p[1])) {
+				glm::vec3 position;
+				const char* q = parseFloat(p + 2, lineEnd, position.x);
+				q = parseFloat(q, lineEnd, position.y);
+				parseFloat(q, lineEnd, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2])) {
+				glm::vec2 texCoord;
+				const char* q = parseFloat(p + 3, lineEnd, texCoord.x);
+				parseFloat(q, lineEnd, texCoord.y);
+				chunk.texCoords.push_back(texCoord);
+			}
+			else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+				glm::vec3 normal;
+				const char* q = parseFloat(p + 3, lineEnd, normal.x);
+				q = parseFloat(q, lineEnd, normal.y);
+				parseFloat(q, lineEnd, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if (lineEnd - p > 2 && p[0] == 'f' && isSpace(p[1])) {
+				polygon.clear();
+				const char* q = p + 2;
+				while (true) {
+					while (q < lineEnd && (isSpace(*q) || *q == '\r')) q++;
+					if (q >= lineEnd) {
+						break;
+					}
+					ObjCorner corner;
+					const char* next = parseCorner(q, lineEnd, chunk, corner);
+					if (next == q || corner.index[0] == MISSING) {
+						throw std::runtime_error("malformed obj face");
+					}
+					polygon.push_back(corner);
+					q = next;
+					while (q < lineEnd && !isSpace(*q) && *q != '\r') q++; //anything trailing the corner
+				}
+				for (size_t i = 2; i < polygon.size(); i++) { //fan, polygons are assumed convex
+					chunk.corners.push_back(polygon[0]);
+					chunk.corners.push_back(polygon[i - 1]);
+					chunk.corners.push_back(polygon[i]);
+				}
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	/*
+		turn every index of the chunk into an index into the concatenated arrays and check it
+	*/
+	void resolveChunk(ObjChunk& chunk, const size_t totals[3])
+	{
+		for (auto& corner : chunk.corners) {
+			for (int component = 0; component < 3; component++) {
+				int64_t index = corner.index[component];
+				if (index == MISSING) {
+					continue;
+				}
+				if (corner.relative & (1 << component)) {
+					index += static_cast<int64_t>(chunk.base[component]);
+				}
+				if (index < 0 || static_cast<size_t>(index) >= totals[component]) {
+					throw std::runtime_error("obj face index out of range");
+				}
+				corner.index[component] = static_cast<int32_t>(index);
+			}
+		}
+	}
+
+	/*
+		run work(i) for i in [0, count) on up to threads threads, rethrowing the first exception
+	*/
+	template<typename Work>
+	void parallelFor(uint32_t count, uint32_t threads, Work work)
+	{
+		std::atomic<uint32_t> next(0);
+		std::vector<std::exception_ptr> errors(threads);
+		auto worker = [&](uint32_t thread) {
+			try {
+				for (uint32_t i = next++; i < count; i = next++) {
+					work(i);
+				}
+			}
+			catch (...) {
+				errors[thread] = std::current_exception();
+				next = count; //the others stop after their current item
+			}
+		};
+		std::vector<std::thread> pool;
+		for (uint32_t t = 1; t < threads; t++) {
+			pool.emplace_back(worker, t);
+		}
+		worker(0);
+		for (auto& thread : pool) {
+			thread.join();
+		}
+		for (auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+std::ostream& operator<<(std::ostream& out, const ObjImportStats& stats)
+{
+	out << stats.fileBytes / (1024.0 * 1024.0) << " MB, " << stats.positions << " positions, " << stats.texCoords << " texcoords, "
+		<< stats.normals << " normals" << (stats.generatedNormals ? " (generated)" : "") << ", " << stats.corners / 3 << " triangles, "
+		<< stats.uniqueVertices << " unique vertices; " << stats.threads << " threads over " << stats.chunks << " chunks: map "
+		<< stats.mapMilliseconds << " ms, parse " << stats.parseMilliseconds << " ms, dedup " << stats.resolveMilliseconds
+		<< " ms, total " << stats.totalMilliseconds << " ms (" << stats.megabytesPerSecond() << " MB/s)";
+	return out;
+}
+
+Mesh importObj(const std::string& filename, uint32_t threads, ObjImportStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+	ObjImportStats local;
+	ObjImportStats& result = stats != nullptr ? *stats : local;
+	result = ObjImportStats();
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	MappedFile file(filename);
+	result.fileBytes = file.size();
+	result.mapMilliseconds = millisecondsSince(start);
+
+	//several chunks per thread so a chunk full of faces does not hold everyone up, but none smaller than 256 KB
+	auto phase = std::chrono::steady_clock::now();
+	const size_t minimumChunk = 256 * 1024;
+	uint32_t chunkCount = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(threads * 4, file.size() / minimumChunk)));
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* data = file.data();
+	const char* end = data + file.size();
+	const char* position = data;
+	for (uint32_t i = 0; i < chunkCount; i++) {
+		chunks[i].begin = position;
+		const char* split = i + 1 == chunkCount ? end : std::max(position, data + file.size() / chunkCount * (i + 1));
+		while (split < end && *split != '\n') split++; //chunks end after a whole line
+		position = split < end ? split + 1 : end;
+		chunks[i].end = position;
+	}
+	threads = std::min(threads, chunkCount);
+	parallelFor(chunkCount, threads, [&](uint32_t i) { parseChunk(chunks[i]); });
+	result.parseMilliseconds = millisecondsSince(phase);
+	result.threads = threads;
+	result.chunks = chunkCount;
+
+	phase = std::chrono::steady_clock::now();
+	size_t totals[3] = {};
+	for (auto& chunk : chunks) {
+		chunk.base[0] = totals[0];
+		chunk.base[1] = totals[1];
+		chunk.base[2] = totals[2];
+		totals[0] += chunk.positions.size();
+		totals[1] += chunk.texCoords.size();
+		totals[2] += chunk.normals.size();
+		result.corners += chunk.corners.size();
+	}
+	parallelFor(chunkCount, threads, [&](uint32_t i) { resolveChunk(chunks[i], totals); });
+	result.positions = totals[0];
+	result.texCoords = totals[1];
+	result.normals = totals[2];
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texCoords;
+	std::vector<glm::vec3> normals;
+	positions.reserve(totals[0]);
+	texCoords.reserve(totals[1]);
+	normals.reserve(totals[2]);
+	for (const auto& chunk : chunks) {
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+	}
+
+	//open addressing hash map from corner to vertex, sized for every corner being unique at half load
+	size_t capacity = 1;
+	while (capacity < result.corners * 2) capacity <<= 1;
+	struct Slot {
+		int32_t key[3];
+		uint32_t vertex; //UINT32_MAX for an empty slot
+	};
+	std::vector<Slot> table(capacity, Slot{ { 0, 0, 0 }, UINT32_MAX });
+	Mesh mesh;
+	mesh.indices.reserve(result.corners);
+	std::vector<uint32_t> vertexPositions; //position index of every vertex, for generated normals
+	bool generateNormals = normals.empty();
+
+	for (const auto& chunk : chunks) {
+		for (const auto& corner : chunk.corners) {
+			uint64_t hash = static_cast<uint32_t>(corner.index[0]) * 0x9E3779B97F4A7C15ull;
+			hash ^= static_cast<uint32_t>(corner.index[1]) * 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
+			hash ^= static_cast<uint32_t>(corner.index[2]) * 0x165667B19E3779F9ull + (hash << 6) + (hash >> 2);
+			size_t slot = static_cast<size_t>(hash ^ (hash >> 29)) & (capacity - 1);
+			while (table[slot].vertex != UINT32_MAX && !(table[slot].key[0] == corner.index[0] && table[slot].key[1] == corner.index[1]
+				&& table[slot].key[2] == corner.index[2])) {
+				slot = (slot + 1) & (capacity - 1); //linear probing
+			}
+			if (table[slot].vertex == UINT32_MAX) {
+				table[slot] = { { corner.index[0], corner.index[1], corner.index[2] }, static_cast<uint32_t>(mesh.vertices.size()) };
+				MeshVertex vertex;
+				vertex.position = positions[corner.index[0]];
+				vertex.texCoord = corner.index[1] != MISSING ? texCoords[corner.index[1]] : glm::vec2(0.0f);
+				vertex.normal = corner.index[2] != MISSING ? normals[corner.index[2]] : glm::vec3(0.0f);
+				mesh.vertices.push_back(vertex);
+				if (generateNormals) {
+					vertexPositions.push_back(static_cast<uint32_t>(corner.index[0]));
+				}
+			}
+			mesh.indices.push_back(table[slot].vertex);
+		}
+	}
+
+	if (generateNormals) {
+		//area weighted face normals summed per position, so vertices split at texture seams still share a normal
+		std::vector<glm::vec3> sums(positions.size(), glm::vec3(0.0f));
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			uint32_t a = vertexPositions[mesh.indices[i]], b = vertexPositions[mesh.indices[i + 1]], c = vertexPositions[mesh.indices[i + 2]];
+			glm::vec3 faceNormal = glm::cross(positions[b] - positions[a], positions[c] - positions[a]); //length is twice the area
+			sums[a] += faceNormal;
+			sums[b] += faceNormal;
+			sums[c] += faceNormal;
+		}
+		for (size_t v = 0; v < mesh.vertices.size(); v++) {
+			glm::vec3 sum = sums[vertexPositions[v]];
+			float length = glm::length(sum);
+			mesh.vertices[v].normal = length > 0.0f ? sum / length : glm::vec3(0.0f, 0.0f, 1.0f);
+		}
+		result.generatedNormals = true;
+	}
+
+	result.uniqueVertices = mesh.vertices.size();
+	result.resolveMilliseconds = millisecondsSince(phase);
+	result.totalMilliseconds = millisecondsSince(start);
+	return mesh;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+#include "Mesh.h"
+
+/*
+	where the time of an OBJ import went
+*/
+struct ObjImportStats {
+	size_t fileBytes = 0;
+	uint32_t threads = 0;
+	uint32_t chunks = 0;
+	size_t positions = 0; //v lines
+	size_t texCoords = 0; //vt lines
+	size_t normals = 0; //vn lines
+	size_t corners = 0; //face corners after triangulation, three per triangle
+	size_t uniqueVertices = 0; //distinct position / texcoord / normal combinations
+	bool generatedNormals = false; //the file had none, smooth normals were computed
+	double mapMilliseconds = 0.0;
+	double parseMilliseconds = 0.0; //parallel parse of the chunks
+	double resolveMilliseconds = 0.0; //relative index resolution and vertex deduplication
+	double totalMilliseconds = 0.0;
+
+	double megabytesPerSecond() const { return totalMilliseconds > 0.0 ? fileBytes / (1024.0 * 1024.0) / (totalMilliseconds / 1000.0) : 0.0; }
+};
+
+std::ostream& operator<<(std::ostream& out, const ObjImportStats& stats);
+
+/*
+	Wavefront OBJ importer
+
+	The file is memory mapped and cut into chunks at line boundaries, which worker threads parse in parallel into their own
+	position, texcoord, normal and face arrays (polygons are fanned into triangles). Negative (relative) indices only make
+	sense once the number of elements in the chunks before is known, so they are resolved in a second parallel pass after a
+	prefix sum over the chunk counts. Face corners are then turned into vertices through a hash map keyed on the
+	position / texcoord / normal triple, so every distinct combination becomes exactly one vertex.
+
+	Only v, vt, vn and f are read, everything else (groups, materials, smoothing groups) is skipped. Meshes without normals
+	get area weighted smooth normals. threads 0 uses every hardware thread.
+*/
+Mesh importObj(const std::string& filename, uint32_t threads = 0, ObjImportStats* stats = nullptr);
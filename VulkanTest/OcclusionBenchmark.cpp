@@ -0,0 +1,695 @@
+#include "OcclusionBenchmark.h"
+#include "VulkanUtils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	const uint32_t CULL_GROUP_SIZE = 64; //cull.comp's workgroup
+	const uint32_t BOX_VERTICES = 36;
+	const int WALL_ROWS = 9;
+	const float FIRST_WALL = -20.0f; //z of the nearest row of walls
+	const float WALL_SPACING = 12.0f;
+}
+
+OcclusionBenchmark::OcclusionBenchmark(const OcclusionBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void OcclusionBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("OcclusionBenchmark");
+	createScene();
+	context.createInstance("Occlusion Benchmark", VK_API_VERSION_1_0);
+	context.createDevice({}, nullptr);
+	try {
+		createTargets();
+		createRenderPasses();
+		depthPyramid.init(context.device, context.physicalDevice, depthView, extent);
+		createBuffers();
+		createDescriptors();
+		createPipelines();
+		createFrameResources();
+
+		std::cout << "occlusion culling benchmark: " << context.properties.deviceName << ", " << objects.size() << " objects ("
+			<< objects.size() - settings.objects << " walls), " << extent.width << "x" << extent.height << ", depth pyramid "
+			<< depthPyramid.extent().width << "x" << depthPyramid.extent().height << " with " << depthPyramid.levels() << " levels" << std::endl;
+
+		std::vector<uint8_t> frustumImage, onePhaseImage, twoPhaseImage;
+		runMode(Mode::Frustum, "frustum only      ", frustumImage, nullptr);
+		runMode(Mode::OnePhase, "hi-z, one phase   ", onePhaseImage, &frustumImage);
+		runMode(Mode::TwoPhase, "hi-z, two phases  ", twoPhaseImage, &frustumImage);
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+/*
+	rows of wall segments across the view with staggered gaps, and the boxes scattered between the rows so that most
+	of them are hidden at any time and some come into view through a gap as the camera slides
+*/
+void OcclusionBenchmark::createScene()
+{
+	objects.clear();
+	for (int row = 0; row < WALL_ROWS; row++) {
+		float z = FIRST_WALL - row * WALL_SPACING;
+		float stagger = (row % 3) * 4.5f;
+		for (float x = -70.0f + stagger; x < 70.0f; x += 14.0f) {
+			objects.push_back({ glm::vec4(x, 4.0f, z, 0.0f), glm::vec4(5.0f, 4.0f, 0.25f, 0.0f) }); //10 long, 4 wide gaps
+		}
+	}
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> across(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> between(1.0f, WALL_SPACING - 1.0f); //clear of the wall slabs
+	std::uniform_real_distribution<float> size(0.15f, 0.6f);
+	std::uniform_int_distribution<int> row(0, WALL_ROWS - 1);
+	for (uint32_t i = 0; i < settings.objects; i++) {
+		glm::vec3 extent(size(random), size(random), size(random));
+		float z = FIRST_WALL - row(random) * WALL_SPACING - between(random);
+		objects.push_back({ glm::vec4(across(random), extent.y, z, 0.0f), glm::vec4(extent, 0.0f) });
+	}
+}
+
+glm::mat4 OcclusionBenchmark::viewProjection(uint32_t step) const
+{
+	float t = step / static_cast<float>(std::max(settings.warmupFrames + settings.frames, 1u));
+	glm::vec3 eye(-20.0f + 40.0f * t, 2.5f, 5.0f);
+	glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.0f, -0.05f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), extent.width / static_cast<float>(extent.height), 0.1f, 200.0f);
+	projection[1][1] *= -1; //vulkan's y points down
+	return projection * view;
+}
+
+void OcclusionBenchmark::createTargets()
+{
+	VkDevice device = context.device;
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(context.physicalDevice, depthFormat, &formatProperties);
+	VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	if ((formatProperties.optimalTilingFeatures & needed) != needed) {
+		throw std::runtime_error("failed to create depth target, D32_SFLOAT cannot be both rendered to and sampled!");
+	}
+
+	createImage(device, context.physicalDevice, extent, colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, colorTarget, colorMemory);
+	colorView = createImageView(device, colorTarget, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	createImage(device, context.physicalDevice, extent, depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, depthTarget, depthMemory);
+	depthView = createImageView(device, depthTarget, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+}
+
+/*
+	the prepass clears and writes depth and leaves it readable by the pyramid build, the main pass keeps that depth,
+	adds the second phase's objects to it and leaves it readable again for the build that feeds the next frame
+*/
+void OcclusionBenchmark::createRenderPasses()
+{
+	VkDevice device = context.device;
+
+	VkAttachmentDescription depthAttachment = {};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; //cleared every frame
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL; //sampled by the pyramid build
+	VkAttachmentReference depthAttachmentRef = { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL; //the pyramid build still reading last frame's depth
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].srcSubpass = 0; //the pyramid build and the main pass after it
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO; //struct type
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depthAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 2;
+	renderPassInfo.pDependencies = dependencies;
+	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &prepassRenderPass) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create render pass!");
+	}
+
+	VkAttachmentDescription attachments[2] = {};
+	attachments[0].format = colorFormat;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; //ready for the final readback
+	attachments[1] = depthAttachment;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD; //the prepass depth
+	attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	VkAttachmentReference colorAttachmentRef = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	depthAttachmentRef.attachment = 1;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+	renderPassInfo.attachmentCount = 2;
+	renderPassInfo.pAttachments = attachments;
+	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &mainRenderPass) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create render pass!");
+	}
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO; //struct type
+	framebufferInfo.renderPass = prepassRenderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &depthView;
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+	if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &prepassFramebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create framebuffer!");
+	}
+	VkImageView mainViews[2] = { colorView, depthView };
+	framebufferInfo.renderPass = mainRenderPass;
+	framebufferInfo.attachmentCount = 2;
+	framebufferInfo.pAttachments = mainViews;
+	if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &mainFramebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create framebuffer!");
+	}
+}
+
+void OcclusionBenchmark::createBuffers()
+{
+	VkDevice device = context.device;
+	VkDeviceSize objectsSize = sizeof(ObjectBounds) * objects.size();
+	VkBuffer staging;
+	VkDeviceMemory stagingMemory;
+	createBuffer(device, context.physicalDevice, objectsSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, stagingMemory);
+	void* mapped;
+	vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	memcpy(mapped, objects.data(), static_cast<size_t>(objectsSize));
+	vkUnmapMemory(device, stagingMemory);
+
+	createBuffer(device, context.physicalDevice, objectsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, objectBuffer, objectMemory);
+	createBuffer(device, context.physicalDevice, sizeof(uint32_t) * objects.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, stateBuffer, stateMemory);
+
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	VkBufferCopy region = { 0, 0, objectsSize };
+	vkCmdCopyBuffer(commandBuffer, staging, objectBuffer, 1, &region);
+	depthPyramid.recordClear(commandBuffer);
+	context.endSingleTimeCommands(commandBuffer);
+	vkDestroyBuffer(device, staging, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+
+	//the counters are read on the host after the frame's fence, and a draw list is only a few hundred KB
+	VkDeviceSize listSize = sizeof(DrawListHeader) + sizeof(uint32_t) * objects.size();
+	drawLists.resize(FRAMES_IN_FLIGHT * 2);
+	drawListMemory.resize(drawLists.size());
+	drawListData.resize(drawLists.size());
+	for (size_t i = 0; i < drawLists.size(); i++) {
+		createBuffer(device, context.physicalDevice, listSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, drawLists[i], drawListMemory[i]);
+		vkMapMemory(device, drawListMemory[i], 0, VK_WHOLE_SIZE, 0, &mapped);
+		drawListData[i] = static_cast<DrawListHeader*>(mapped);
+		memset(drawListData[i], 0, sizeof(DrawListHeader));
+	}
+}
+
+void OcclusionBenchmark::createDescriptors()
+{
+	VkDevice device = context.device;
+
+	VkDescriptorSetLayoutBinding cullBindings[4] = {};
+	for (uint32_t i = 0; i < 4; i++) {
+		cullBindings[i].binding = i;
+		cullBindings[i].descriptorType = i == 1 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		cullBindings[i].descriptorCount = 1;
+		cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	setLayoutInfo.bindingCount = 4;
+	setLayoutInfo.pBindings = cullBindings;
+	if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &cullSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorSetLayoutBinding drawBindings[2] = {};
+	for (uint32_t i = 0; i < 2; i++) {
+		drawBindings[i].binding = i;
+		drawBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		drawBindings[i].descriptorCount = 1;
+		drawBindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	}
+	setLayoutInfo.bindingCount = 2;
+	setLayoutInfo.pBindings = drawBindings;
+	if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &drawSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	uint32_t listCount = static_cast<uint32_t>(drawLists.size());
+	VkDescriptorPoolSize poolSizes[2] = {
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, listCount * 5 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, listCount },
+	};
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.maxSets = listCount * 2;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	std::vector<VkDescriptorSetLayout> cullLayouts(listCount, cullSetLayout);
+	std::vector<VkDescriptorSetLayout> drawLayouts(listCount, drawSetLayout);
+	cullSets.resize(listCount);
+	drawSets.resize(listCount);
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = listCount;
+	allocInfo.pSetLayouts = cullLayouts.data();
+	if (vkAllocateDescriptorSets(device, &allocInfo, cullSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor sets!");
+	}
+	allocInfo.pSetLayouts = drawLayouts.data();
+	if (vkAllocateDescriptorSets(device, &allocInfo, drawSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor sets!");
+	}
+
+	VkDescriptorBufferInfo objectInfo = { objectBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorImageInfo pyramidInfo = { depthPyramid.sampler(), depthPyramid.view(), VK_IMAGE_LAYOUT_GENERAL };
+	VkDescriptorBufferInfo stateInfo = { stateBuffer, 0, VK_WHOLE_SIZE };
+	for (uint32_t list = 0; list < listCount; list++) {
+		VkDescriptorBufferInfo listInfo = { drawLists[list], 0, VK_WHOLE_SIZE };
+		VkWriteDescriptorSet writes[6] = {};
+		for (uint32_t i = 0; i < 6; i++) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+			writes[i].dstSet = i < 4 ? cullSets[list] : drawSets[list];
+			writes[i].dstBinding = i < 4 ? i : i - 4;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		}
+		writes[0].pBufferInfo = &objectInfo;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[1].pImageInfo = &pyramidInfo;
+		writes[2].pBufferInfo = &stateInfo;
+		writes[3].pBufferInfo = &listInfo;
+		writes[4].pBufferInfo = &objectInfo;
+		writes[5].pBufferInfo = &listInfo;
+		vkUpdateDescriptorSets(device, 6, writes, 0, nullptr);
+	}
+}
+
+/*
+	the cull pipeline, and the box pipelines for the depth prepass (no fragment shader) and the colour pass
+*/
+void OcclusionBenchmark::createPipelines()
+{
+	VkDevice device = context.device;
+
+	VkPushConstantRange cullRange = pushConstantRange(context.physicalDevice, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(CullConstants));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &cullSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &cullRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &cullLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule cullModule = createShaderModule(device, readBinaryFile("../shaders/cull_comp.spv"));
+	VkComputePipelineCreateInfo computeInfo = {};
+	computeInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; //struct type
+	computeInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	computeInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computeInfo.stage.module = cullModule;
+	computeInfo.stage.pName = "main";
+	computeInfo.layout = cullLayout;
+	VkResult cullResult = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computeInfo, nullptr, &cullPipeline);
+	vkDestroyShaderModule(device, cullModule, nullptr);
+	if (cullResult != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline!");
+	}
+
+	VkPushConstantRange viewRange = pushConstantRange(context.physicalDevice, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4));
+	layoutInfo.pSetLayouts = &drawSetLayout;
+	layoutInfo.pPushConstantRanges = &viewRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &drawLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule vertModule = createShaderModule(device, readBinaryFile("../shaders/box_vert.spv"));
+	VkShaderModule fragModule = createShaderModule(device, readBinaryFile("../shaders/frag.spv"));
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertModule;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragModule;
+	stages[1].pName = "main";
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //struct type, no vertex buffers
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE; //closed boxes, the depth test hides the back faces
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO; //struct type
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	colorBlending.attachmentCount = 0; //the prepass has no colour attachment
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = drawLayout;
+	pipelineInfo.renderPass = prepassRenderPass;
+	pipelineInfo.subpass = 0;
+	VkResult depthResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &depthPipeline);
+
+	pipelineInfo.stageCount = 2;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL; //the prepass objects meet their own depth
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+	pipelineInfo.renderPass = mainRenderPass;
+	VkResult colorResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &colorPipeline);
+
+	vkDestroyShaderModule(device, vertModule, nullptr);
+	vkDestroyShaderModule(device, fragModule, nullptr);
+	if (depthResult != VK_SUCCESS || colorResult != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+void OcclusionBenchmark::createFrameResources()
+{
+	context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+	frameSteps.assign(FRAMES_IN_FLIGHT, -1);
+}
+
+void OcclusionBenchmark::recordCull(VkCommandBuffer commandBuffer, size_t frame, uint32_t phase, bool occlusion, const glm::mat4& viewProj)
+{
+	CullConstants constants;
+	constants.viewProjection = viewProj;
+	constants.pyramidSize = glm::vec2(depthPyramid.extent().width, depthPyramid.extent().height);
+	constants.pyramidLevels = depthPyramid.levels();
+	constants.objectCount = static_cast<uint32_t>(objects.size());
+	constants.phase = phase;
+	constants.occlusion = occlusion ? 1 : 0;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullLayout, 0, 1, &cullSets[frame * 2 + phase], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(commandBuffer, (constants.objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; //the draw list for the draw, the states for the second phase
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+/*
+	first phase cull -> depth prepass -> (two phases: pyramid from the prepass -> second phase cull) -> colour pass with
+	both lists -> (occlusion: pyramid from the final depth, for the next frame)
+*/
+void OcclusionBenchmark::recordFrame(VkCommandBuffer commandBuffer, Mode mode, size_t frame, uint32_t step)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //the camera moves every frame
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+	glm::mat4 viewProj = viewProjection(step);
+	bool occlusion = mode != Mode::Frustum;
+
+	DrawListHeader emptyList = { BOX_VERTICES, 0, 0, 0, 0, 0, { 0, 0 } };
+	for (uint32_t phase = 0; phase < 2; phase++) {
+		vkCmdUpdateBuffer(commandBuffer, drawLists[frame * 2 + phase], 0, sizeof(emptyList), &emptyList);
+	}
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT; //the list resets, and the previous frame's state writes
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	recordCull(commandBuffer, frame, 0, occlusion, viewProj);
+
+	VkClearValue clearValues[2] = {};
+	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+	renderPassInfo.renderPass = prepassRenderPass;
+	renderPassInfo.framebuffer = prepassFramebuffer;
+	renderPassInfo.renderArea = { { 0, 0 }, extent };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValues[1];
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthPipeline);
+	vkCmdPushConstants(commandBuffer, drawLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewProj), &viewProj);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawLayout, 0, 1, &drawSets[frame * 2], 0, nullptr);
+	vkCmdDrawIndirect(commandBuffer, drawLists[frame * 2], 0, 1, sizeof(VkDrawIndirectCommand));
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (mode == Mode::TwoPhase) {
+		depthPyramid.recordBuild(commandBuffer);
+		recordCull(commandBuffer, frame, 1, true, viewProj);
+	}
+
+	renderPassInfo.renderPass = mainRenderPass;
+	renderPassInfo.framebuffer = mainFramebuffer;
+	renderPassInfo.clearValueCount = 2; //the depth value is ignored, it is loaded
+	renderPassInfo.pClearValues = clearValues;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, colorPipeline);
+	vkCmdPushConstants(commandBuffer, drawLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewProj), &viewProj);
+	for (uint32_t phase = 0; phase < 2; phase++) { //the second list is empty unless the second phase ran
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawLayout, 0, 1, &drawSets[frame * 2 + phase], 0, nullptr);
+		vkCmdDrawIndirect(commandBuffer, drawLists[frame * 2 + phase], 0, 1, sizeof(VkDrawIndirectCommand));
+	}
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (occlusion) {
+		depthPyramid.recordBuild(commandBuffer);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; //the counters, read after the fence
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+/*
+	add the counters of the frame in flight's last submission, once its fence has signalled, when it was a timed frame
+*/
+void OcclusionBenchmark::collect(size_t frame, CullTotals& totals)
+{
+	if (frameSteps[frame] < static_cast<int64_t>(settings.warmupFrames)) {
+		return;
+	}
+	const DrawListHeader& first = *drawListData[frame * 2];
+	const DrawListHeader& second = *drawListData[frame * 2 + 1];
+	totals.frustumVisible += first.tested;
+	totals.drawnFirst += first.instanceCount;
+	totals.drawnSecond += second.instanceCount;
+	totals.frames++;
+	frameSteps[frame] = -1;
+}
+
+void OcclusionBenchmark::runMode(Mode mode, const char* name, std::vector<uint8_t>& image, const std::vector<uint8_t>* reference)
+{
+	VkDevice device = context.device;
+	VkCommandBuffer clearCommands = context.beginSingleTimeCommands();
+	depthPyramid.recordClear(clearCommands); //nothing from the previous mode may hide anything
+	context.endSingleTimeCommands(clearCommands);
+
+	CullTotals totals;
+	size_t frame = 0;
+	frameTimer.reset();
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		collect(frame, totals);
+		frameTimer.beginFrame(frame);
+		recordFrame(commandBuffers[frame], mode, frame, i);
+		frameSteps[frame] = i;
+
+		context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+	for (size_t f = 0; f < FRAMES_IN_FLIGHT; f++) {
+		collect(f, totals);
+	}
+	image = readTarget();
+
+	double frames = static_cast<double>(std::max<uint64_t>(totals.frames, 1));
+	double visible = totals.frustumVisible / frames;
+	double drawn = (totals.drawnFirst + totals.drawnSecond) / frames;
+	std::cout << "  " << name << " " << drawn << " of " << objects.size() << " objects drawn per frame, " << visible << " in the frustum";
+	if (mode != Mode::Frustum && visible > 0.0) {
+		std::cout << " (" << 100.0 * (1.0 - drawn / visible) << "% culled by occlusion)";
+	}
+	if (mode == Mode::TwoPhase) {
+		std::cout << ", " << totals.drawnSecond / frames << " recovered by the second phase";
+	}
+	std::cout << std::endl;
+	if (frameTimer.hasGpuTiming()) {
+		std::cout << "                      gpu frame " << frameTimer.gpuSummary() << std::endl;
+	}
+	if (reference != nullptr) {
+		size_t differing = 0;
+		for (size_t i = 0; i < image.size(); i += 4) {
+			differing += memcmp(&image[i], &(*reference)[i], 4) != 0;
+		}
+		std::cout << "                      " << differing << " pixels of the last frame differ from frustum culling" << std::endl;
+	}
+}
+
+/*
+	copy the colour target (left in TRANSFER_SRC_OPTIMAL by the main pass) back to the host
+*/
+std::vector<uint8_t> OcclusionBenchmark::readTarget()
+{
+	VkDevice device = context.device;
+	const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+	VkBuffer readback;
+	VkDeviceMemory readbackMemory;
+	createBuffer(device, context.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, readback, readbackMemory);
+
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	VkBufferImageCopy region = {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, colorTarget, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback, 1, &region);
+	context.endSingleTimeCommands(commandBuffer);
+
+	std::vector<uint8_t> pixels(size);
+	void* data;
+	vkMapMemory(device, readbackMemory, 0, VK_WHOLE_SIZE, 0, &data);
+	memcpy(pixels.data(), data, size);
+	vkUnmapMemory(device, readbackMemory);
+	vkDestroyBuffer(device, readback, nullptr);
+	freeDeviceMemory(device, readbackMemory, nullptr);
+	return pixels;
+}
+
+void OcclusionBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		vkDestroyPipeline(device, colorPipeline, nullptr);
+		vkDestroyPipeline(device, depthPipeline, nullptr);
+		vkDestroyPipelineLayout(device, drawLayout, nullptr);
+		vkDestroyPipeline(device, cullPipeline, nullptr);
+		vkDestroyPipelineLayout(device, cullLayout, nullptr);
+		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, drawSetLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, cullSetLayout, nullptr);
+		for (size_t i = 0; i < drawLists.size(); i++) {
+			vkDestroyBuffer(device, drawLists[i], nullptr);
+			freeDeviceMemory(device, drawListMemory[i], nullptr); //unmaps it
+		}
+		vkDestroyBuffer(device, stateBuffer, nullptr);
+		freeDeviceMemory(device, stateMemory, nullptr);
+		vkDestroyBuffer(device, objectBuffer, nullptr);
+		freeDeviceMemory(device, objectMemory, nullptr);
+		depthPyramid.cleanup();
+		vkDestroyFramebuffer(device, mainFramebuffer, nullptr);
+		vkDestroyFramebuffer(device, prepassFramebuffer, nullptr);
+		vkDestroyRenderPass(device, mainRenderPass, nullptr);
+		vkDestroyRenderPass(device, prepassRenderPass, nullptr);
+		vkDestroyImageView(device, depthView, nullptr);
+		vkDestroyImage(device, depthTarget, nullptr);
+		freeDeviceMemory(device, depthMemory, nullptr);
+		vkDestroyImageView(device, colorView, nullptr);
+		vkDestroyImage(device, colorTarget, nullptr);
+		freeDeviceMemory(device, colorMemory, nullptr);
+	}
+	context.cleanup();
+}
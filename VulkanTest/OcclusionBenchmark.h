@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "FrameTimer.h"
+#include "DepthPyramid.h"
+
+/*
+	settings for the occlusion culling benchmark, filled in from the command line
+*/
+struct OcclusionBenchmarkSettings {
+	bool enabled = false;
+	uint32_t objects = 1 << 14; //boxes scattered between the walls
+	uint32_t frames = 300; //timed frames per mode
+	uint32_t warmupFrames = 20; //untimed frames per mode
+};
+
+/*
+	Hierarchical-Z occlusion culling on the GPU
+
+	An occlusion heavy scene (rows of wall segments with gaps, thousands of boxes behind them) seen from a camera that
+	slides sideways, so objects keep appearing through the gaps. Every frame cull.comp culls every object box against
+	the frustum and, in the occlusion modes, against the DepthPyramid of the previous frame, writing the visible ones
+	into an indirect draw list that the depth prepass draws. In the two phase mode the pyramid is then rebuilt from the
+	prepass depth and the objects the first phase took as occluded are tested again, the ones that turn out visible (the
+	first phase's false negatives, mostly objects that just came out from behind a wall) are drawn in the colour pass as
+	well. The pyramid for the next frame is built from the final depth.
+
+	Runs the same camera path with frustum culling only, with one phase occlusion culling and with two phases, and
+	reports objects drawn per frame, how many the second phase recovered, GPU time per frame, and how many pixels of the
+	last frame differ from the frustum culled image (none, for a conservative cull).
+*/
+class OcclusionBenchmark
+{
+public:
+	explicit OcclusionBenchmark(const OcclusionBenchmarkSettings& settings);
+	void run();
+
+private:
+	enum class Mode { Frustum, OnePhase, TwoPhase };
+
+	/*
+		one object's bounds as cull.comp and box.vert read them
+	*/
+	struct ObjectBounds {
+		glm::vec4 center; //w unused
+		glm::vec4 extent; //half size, w unused
+	};
+
+	/*
+		the header of a draw list, a VkDrawIndirectCommand followed by the counters cull.comp keeps
+	*/
+	struct DrawListHeader {
+		uint32_t vertexCount;
+		uint32_t instanceCount;
+		uint32_t firstVertex;
+		uint32_t firstInstance;
+		uint32_t tested;
+		uint32_t occluded;
+		uint32_t padding[2];
+	};
+
+	/*
+		what cull.comp is pushed
+	*/
+	struct CullConstants {
+		glm::mat4 viewProjection;
+		glm::vec2 pyramidSize;
+		uint32_t pyramidLevels;
+		uint32_t objectCount;
+		uint32_t phase;
+		uint32_t occlusion;
+	};
+
+	/*
+		per frame totals of the counters, over the timed frames
+	*/
+	struct CullTotals {
+		uint64_t frustumVisible = 0;
+		uint64_t drawnFirst = 0;
+		uint64_t drawnSecond = 0;
+		uint64_t frames = 0;
+	};
+
+	void createScene();
+	void createTargets();
+	void createRenderPasses();
+	void createBuffers();
+	void createDescriptors();
+	void createPipelines();
+	void createFrameResources();
+	glm::mat4 viewProjection(uint32_t step) const;
+	void recordFrame(VkCommandBuffer commandBuffer, Mode mode, size_t frame, uint32_t step);
+	void recordCull(VkCommandBuffer commandBuffer, size_t frame, uint32_t phase, bool occlusion, const glm::mat4& viewProj);
+	void collect(size_t frame, CullTotals& totals);
+	void runMode(Mode mode, const char* name, std::vector<uint8_t>& image, const std::vector<uint8_t>* reference);
+	std::vector<uint8_t> readTarget();
+	void cleanup();
+
+	OcclusionBenchmarkSettings settings;
+	std::vector<ObjectBounds> objects; //the walls, then the boxes
+	HeadlessDevice context;
+	DepthPyramid depthPyramid;
+
+	VkExtent2D extent = { 512, 512 };
+	VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+	VkImage colorTarget = VK_NULL_HANDLE;
+	VkDeviceMemory colorMemory = VK_NULL_HANDLE;
+	VkImageView colorView = VK_NULL_HANDLE;
+	VkImage depthTarget = VK_NULL_HANDLE;
+	VkDeviceMemory depthMemory = VK_NULL_HANDLE;
+	VkImageView depthView = VK_NULL_HANDLE;
+	VkRenderPass prepassRenderPass = VK_NULL_HANDLE; //depth only, cleared
+	VkRenderPass mainRenderPass = VK_NULL_HANDLE; //colour, on top of the prepass depth
+	VkFramebuffer prepassFramebuffer = VK_NULL_HANDLE;
+	VkFramebuffer mainFramebuffer = VK_NULL_HANDLE;
+
+	VkBuffer objectBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory objectMemory = VK_NULL_HANDLE;
+	VkBuffer stateBuffer = VK_NULL_HANDLE; //one uint per object, the first phase's decision
+	VkDeviceMemory stateMemory = VK_NULL_HANDLE;
+	std::vector<VkBuffer> drawLists; //two per frame in flight (first phase, second phase), host visible for the counters
+	std::vector<VkDeviceMemory> drawListMemory;
+	std::vector<DrawListHeader*> drawListData;
+
+	VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;
+	VkDescriptorSetLayout drawSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> cullSets; //one per draw list
+	std::vector<VkDescriptorSet> drawSets;
+	VkPipelineLayout cullLayout = VK_NULL_HANDLE;
+	VkPipeline cullPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout drawLayout = VK_NULL_HANDLE;
+	VkPipeline depthPipeline = VK_NULL_HANDLE;
+	VkPipeline colorPipeline = VK_NULL_HANDLE;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	std::vector<int64_t> frameSteps; //the step each frame in flight last recorded, -1 for none
+	FrameTimer frameTimer;
+};
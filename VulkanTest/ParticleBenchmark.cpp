@@ -0,0 +1,193 @@
+#include "ParticleBenchmark.h"
+#include "VulkanUtils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+ParticleBenchmark::ParticleBenchmark(const ParticleBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void ParticleBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("ParticleBenchmark");
+	settings.particles = std::max(settings.particles, 1u);
+	std::vector<Particle> initial = ParticleSystem::spawn(stepParameters(0));
+	std::cout << "particle benchmark: " << settings.particles << " particles, " << settings.frames << " timed steps" << std::endl;
+	std::vector<Particle> cpuResult = runCpu(initial);
+
+	try {
+		context.createInstance("Particle Benchmark", VK_API_VERSION_1_0);
+		context.createDevice({}, nullptr);
+	}
+	catch (const std::runtime_error& e) {
+		context.cleanup();
+		std::cout << "  no usable device (" << e.what() << "), cpu path only" << std::endl;
+		return;
+	}
+	try {
+		runGpu(initial, cpuResult);
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+ParticleStep ParticleBenchmark::stepParameters(uint32_t step) const
+{
+	ParticleStep parameters;
+	parameters.frame = step;
+	parameters.count = settings.particles;
+	return parameters;
+}
+
+void ParticleBenchmark::report(const char* name, double milliseconds)
+{
+	double particlesPerSecond = milliseconds > 0.0 ? settings.particles / (milliseconds / 1000.0) : 0.0;
+	std::cout << "  " << name << ": " << milliseconds << " ms per step, " << particlesPerSecond / 1e6 << " M particles/s" << std::endl;
+}
+
+/*
+	steps 1 to warmupFrames + frames, the same steps runGpu simulates before it compares
+*/
+std::vector<Particle> ParticleBenchmark::runCpu(const std::vector<Particle>& initial)
+{
+	ThreadPool pool(settings.threads);
+	std::vector<Particle> particles = initial;
+	std::vector<double> stepTimes;
+	for (uint32_t i = 1; i <= settings.warmupFrames + settings.frames; i++) {
+		auto start = std::chrono::steady_clock::now();
+		ParticleSystem::simulate(particles, stepParameters(i), pool);
+		if (i > settings.warmupFrames) {
+			stepTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+	std::cout << "  cpu step on " << pool.threadCount() << " threads " << TimingSummary::fromSamples(stepTimes) << std::endl;
+	report("cpu step", TimingSummary::fromSamples(stepTimes).p50);
+	return particles;
+}
+
+void ParticleBenchmark::runGpu(const std::vector<Particle>& initial, const std::vector<Particle>& cpuResult)
+{
+	target = context.createOffscreenTarget(extent, VK_FORMAT_R8G8B8A8_UNORM, false);
+	particleSystem.init(context.device, context.physicalDevice, target.renderPass, extent, settings.particles);
+	context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+	std::cout << "  gpu: " << context.properties.deviceName << std::endl;
+
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	particleSystem.recordUpload(commandBuffer, initial);
+	context.endSingleTimeCommands(commandBuffer);
+
+	runFrames(1, false);
+	commandBuffer = context.beginSingleTimeCommands();
+	particleSystem.recordReadback(commandBuffer);
+	context.endSingleTimeCommands(commandBuffer);
+	std::vector<Particle> gpuResult = particleSystem.readback();
+
+	size_t identical = 0;
+	float largestDifference = 0.0f;
+	for (size_t i = 0; i < gpuResult.size(); i++) {
+		if (memcmp(&gpuResult[i], &cpuResult[i], sizeof(Particle)) == 0) {
+			identical++;
+			continue;
+		}
+		glm::vec4 difference = glm::abs(glm::vec4(gpuResult[i].position) - glm::vec4(cpuResult[i].position));
+		largestDifference = std::max({ largestDifference, difference.x, difference.y, difference.z });
+	}
+	std::cout << "  " << identical << " of " << gpuResult.size() << " particles bit identical to the cpu step";
+	if (identical != gpuResult.size()) {
+		std::cout << ", largest position difference " << largestDifference;
+	}
+	std::cout << std::endl;
+
+	runFrames(settings.warmupFrames + settings.frames + 1, true);
+}
+
+/*
+	warmupFrames + frames steps starting at firstStep, with or without the draw, and report the timed ones
+*/
+void ParticleBenchmark::runFrames(uint32_t firstStep, bool draw)
+{
+	VkDevice device = context.device;
+	size_t frame = 0;
+	frameTimer.reset();
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+			start = std::chrono::steady_clock::now();
+		}
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frame);
+		recordFrame(commandBuffers[frame], firstStep + i, draw);
+
+		context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+	double wallTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / std::max(settings.frames, 1u);
+
+	const char* name = draw ? "gpu step and draw" : "gpu step";
+	if (frameTimer.hasGpuTiming()) {
+		std::cout << "  " << name << " " << frameTimer.gpuSummary() << std::endl;
+		report(name, frameTimer.gpuSummary().p50);
+	}
+	else {
+		report(name, wallTime); //no timestamps, the submits are back to back so the wall time is close to the GPU time
+	}
+}
+
+void ParticleBenchmark::recordFrame(VkCommandBuffer commandBuffer, uint32_t step, bool draw)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //the step number changes every frame
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+	particleSystem.recordSimulate(commandBuffer, stepParameters(step));
+
+	if (draw) {
+		glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(45.0f), extent.width / static_cast<float>(extent.height), 0.1f, 100.0f);
+		projection[1][1] *= -1; //vulkan's y points down
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 16.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+		renderPassInfo.renderPass = target.renderPass;
+		renderPassInfo.framebuffer = target.framebuffer;
+		renderPassInfo.renderArea = { { 0, 0 }, extent };
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearColor;
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		particleSystem.recordDraw(commandBuffer, projection * view);
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+void ParticleBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		particleSystem.cleanup();
+		context.destroyOffscreenTarget(target);
+	}
+	context.cleanup();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "FrameTimer.h"
+#include "ParticleSystem.h"
+
+/*
+	settings for the particle benchmark, filled in from the command line
+*/
+struct ParticleBenchmarkSettings {
+	bool enabled = false;
+	uint32_t particles = 1 << 21;
+	uint32_t frames = 300; //timed steps per path
+	uint32_t warmupFrames = 20; //untimed steps per path
+	uint32_t threads = 0; //CPU path threads, 0 for all
+};
+
+/*
+	Particle simulation on the GPU against the CPU fallback
+
+	Runs the same number of ParticleSystem steps from the same particles on the CPU (SIMD, on a thread pool) and with
+	particle.comp, reads the GPU's particles back and counts how many are bit identical to the CPU's, then keeps the
+	GPU going while drawing the particles as points into an offscreen target. Reports particles per second for the CPU
+	step, the GPU step and the GPU step and draw together. Without a usable device only the CPU path runs.
+*/
+class ParticleBenchmark
+{
+public:
+	explicit ParticleBenchmark(const ParticleBenchmarkSettings& settings);
+	void run();
+
+private:
+	std::vector<Particle> runCpu(const std::vector<Particle>& initial);
+	void runGpu(const std::vector<Particle>& initial, const std::vector<Particle>& cpuResult);
+	void runFrames(uint32_t firstStep, bool draw);
+	void recordFrame(VkCommandBuffer commandBuffer, uint32_t step, bool draw);
+	ParticleStep stepParameters(uint32_t step) const;
+	void report(const char* name, double milliseconds);
+	void cleanup();
+
+	ParticleBenchmarkSettings settings;
+	HeadlessDevice context;
+	ParticleSystem particleSystem;
+
+	VkExtent2D extent = { 512, 512 };
+	OffscreenTarget target; //R8G8B8A8_UNORM, never read back
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
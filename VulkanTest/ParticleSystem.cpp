@@ -0,0 +1,383 @@
+#include "ParticleSystem.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <string>
+
+namespace {
+	const size_t SIMULATE_BATCH = 16384; //particles per parallelFor range
+
+	//the same integer hash as particle.comp
+	uint32_t hash(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	//24 random bits to [0, 1), exact in a float
+	float unitFloat(uint32_t h)
+	{
+		return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+	}
+
+	//respawn in particle.comp, component by component in the same order
+	Particle respawn(uint32_t index, const ParticleStep& step)
+	{
+		uint32_t h0 = hash(index ^ hash(step.frame));
+		uint32_t h1 = hash(h0);
+		uint32_t h2 = hash(h1);
+		uint32_t h3 = hash(h2);
+		uint32_t h4 = hash(h3);
+		uint32_t h5 = hash(h4);
+		uint32_t h6 = hash(h5);
+		float edge = step.emitter.w;
+		Particle particle;
+		particle.position = glm::aligned_vec4(step.emitter.x + (unitFloat(h0) - 0.5f) * edge, step.emitter.y + (unitFloat(h1) - 0.5f) * edge,
+			step.emitter.z + (unitFloat(h2) - 0.5f) * edge, 0.0f);
+		particle.velocity = glm::aligned_vec4((unitFloat(h3) - 0.5f) * 4.0f, 6.0f + unitFloat(h4) * 4.0f, (unitFloat(h5) - 0.5f) * 4.0f,
+			2.0f + unitFloat(h6) * 3.0f);
+		return particle;
+	}
+}
+
+std::vector<Particle> ParticleSystem::spawn(const ParticleStep& step)
+{
+	std::vector<Particle> particles(step.count);
+	for (uint32_t i = 0; i < step.count; i++) {
+		particles[i] = respawn(i, step);
+		particles[i].position.w = unitFloat(hash(i ^ 0x5bd1e995u)) * particles[i].velocity.w; //spread the respawns over the lifetimes
+	}
+	return particles;
+}
+
+void ParticleSystem::simulate(std::vector<Particle>& particles, const ParticleStep& step, ThreadPool& pool)
+{
+	Particle* data = particles.data();
+	pool.parallelFor(particles.size(), SIMULATE_BATCH, [data, &step](size_t begin, size_t end) {
+		simulateRange(data, begin, end, step);
+	});
+}
+
+/*
+	one particle per vector: xyz and the age or lifetime in w move together, the lanes that should not change are
+	multiplied by one or have zero added
+*/
+void ParticleSystem::simulateRange(Particle* particles, size_t begin, size_t end, const ParticleStep& step)
+{
+	const float dt = step.gravity.w;
+	const glm::aligned_vec4 dragScale(step.drag, step.drag, step.drag, 1.0f);
+	const glm::aligned_vec4 gravityStep(step.gravity.x * dt, step.gravity.y * dt, step.gravity.z * dt, 0.0f);
+	const glm::aligned_vec4 timeStep(dt, dt, dt, 0.0f);
+	const glm::aligned_vec4 ageStep(0.0f, 0.0f, 0.0f, dt);
+	for (size_t i = begin; i < end; i++) {
+		Particle& particle = particles[i];
+		glm::aligned_vec4 velocity = particle.velocity * dragScale + gravityStep;
+		glm::aligned_vec4 position = particle.position + velocity * timeStep + ageStep;
+		if (position.y < step.floorHeight) {
+			position.y = step.floorHeight + (step.floorHeight - position.y) * step.restitution;
+			velocity.y = -velocity.y * step.restitution;
+		}
+		if (position.w >= velocity.w) {
+			particle = respawn(static_cast<uint32_t>(i), step);
+		}
+		else {
+			particle.position = position;
+			particle.velocity = velocity;
+		}
+	}
+}
+
+void ParticleSystem::init(VkDevice device, VkPhysicalDevice physicalDevice, VkRenderPass renderPass, VkExtent2D extent, uint32_t count)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	uint64_t maxParticles = static_cast<uint64_t>(properties.limits.maxComputeWorkGroupCount[0]) * WORKGROUP_SIZE;
+	if (count == 0 || count > maxParticles) {
+		throw std::runtime_error("failed to create particle system, " + std::to_string(count) + " particles is outside 1 to " + std::to_string(maxParticles) + "!");
+	}
+	this->device = device;
+	this->physicalDevice = physicalDevice;
+	particleCount = count;
+	createBuffers();
+	createComputePipeline();
+	createGraphicsPipeline(renderPass, extent);
+}
+
+void ParticleSystem::createBuffers()
+{
+	VkDeviceSize size = sizeof(Particle) * static_cast<VkDeviceSize>(particleCount);
+	DeviceMemoryScope memoryScope("ParticleSystem", "particles");
+	createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, particleBuffer, particleMemory);
+	createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, stagingBuffer, stagingMemory);
+	vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &stagingData);
+}
+
+void ParticleSystem::createComputePipeline()
+{
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	setLayoutInfo.bindingCount = 1;
+	setLayoutInfo.pBindings = &binding;
+	if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 };
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &descriptorSetLayout;
+	if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor set!");
+	}
+
+	VkDescriptorBufferInfo bufferInfo = { particleBuffer, 0, VK_WHOLE_SIZE };
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+	write.dstSet = descriptorSet;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+	VkPushConstantRange stepRange = pushConstantRange(physicalDevice, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(ParticleStep));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &descriptorSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &stepRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &computeLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule computeModule = createShaderModule(device, readBinaryFile("../shaders/particle_comp.spv"));
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = computeLayout;
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline);
+	vkDestroyShaderModule(device, computeModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline!");
+	}
+}
+
+/*
+	points read straight from the particle buffer, blended additively so dense regions glow
+*/
+void ParticleSystem::createGraphicsPipeline(VkRenderPass renderPass, VkExtent2D extent)
+{
+	VkPushConstantRange viewRange = pushConstantRange(physicalDevice, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &viewRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &graphicsLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule vertModule = createShaderModule(device, readBinaryFile("../shaders/particle_vert.spv"));
+	VkShaderModule fragModule = createShaderModule(device, readBinaryFile("../shaders/frag.spv"));
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertModule;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragModule;
+	stages[1].pName = "main";
+
+	VkVertexInputBindingDescription bindingDescription = { 0, sizeof(Particle), VK_VERTEX_INPUT_RATE_VERTEX };
+	VkVertexInputAttributeDescription attributeDescriptions[2] = {
+		{ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Particle, position) },
+		{ 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Particle, velocity) },
+	};
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //struct type
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexAttributeDescriptionCount = 2;
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_TRUE;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; //additive
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = graphicsLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+	VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline);
+	vkDestroyShaderModule(device, vertModule, nullptr);
+	vkDestroyShaderModule(device, fragModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+void ParticleSystem::recordUpload(VkCommandBuffer commandBuffer, const std::vector<Particle>& particles)
+{
+	if (particles.size() != particleCount) {
+		throw std::runtime_error("failed to upload particles, expected " + std::to_string(particleCount) + " and got " + std::to_string(particles.size()) + "!");
+	}
+	VkDeviceSize size = sizeof(Particle) * static_cast<VkDeviceSize>(particleCount);
+	memcpy(stagingData, particles.data(), static_cast<size_t>(size));
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; //earlier steps, and the reads of earlier draws and readbacks
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	VkBufferCopy region = { 0, 0, size };
+	vkCmdCopyBuffer(commandBuffer, stagingBuffer, particleBuffer, 1, &region);
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void ParticleSystem::recordReadback(VkCommandBuffer commandBuffer)
+{
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+	VkBufferCopy region = { 0, 0, sizeof(Particle) * static_cast<VkDeviceSize>(particleCount) };
+	vkCmdCopyBuffer(commandBuffer, particleBuffer, stagingBuffer, 1, &region);
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+std::vector<Particle> ParticleSystem::readback()
+{
+	std::vector<Particle> particles(particleCount);
+	memcpy(particles.data(), stagingData, sizeof(Particle) * particles.size());
+	return particles;
+}
+
+void ParticleSystem::recordSimulate(VkCommandBuffer commandBuffer, const ParticleStep& step)
+{
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; //the previous step, and the reads of the previous draw
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	ParticleStep parameters = step;
+	parameters.count = particleCount;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout, 0, 1, &descriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(parameters), &parameters);
+	vkCmdDispatch(commandBuffer, (particleCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void ParticleSystem::recordDraw(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection)
+{
+	VkDeviceSize offset = 0;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &particleBuffer, &offset);
+	vkCmdPushConstants(commandBuffer, graphicsLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProjection);
+	vkCmdDraw(commandBuffer, particleCount, 1, 0, 0);
+}
+
+void ParticleSystem::cleanup()
+{
+	if (device == VK_NULL_HANDLE) {
+		return;
+	}
+	vkDestroyPipeline(device, graphicsPipeline, nullptr);
+	vkDestroyPipelineLayout(device, graphicsLayout, nullptr);
+	vkDestroyPipeline(device, computePipeline, nullptr);
+	vkDestroyPipelineLayout(device, computeLayout, nullptr);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	if (stagingData != nullptr) {
+		vkUnmapMemory(device, stagingMemory);
+	}
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+	vkDestroyBuffer(device, particleBuffer, nullptr);
+	freeDeviceMemory(device, particleMemory, nullptr);
+	*this = ParticleSystem();
+}
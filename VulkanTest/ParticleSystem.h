@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_aligned.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ThreadPool.h"
+
+/*
+	one particle as particle.comp and particle.vert see it (std430, 32 bytes)
+*/
+struct Particle {
+	glm::aligned_vec4 position; //xyz, w = age in seconds
+	glm::aligned_vec4 velocity; //xyz, w = lifetime in seconds, respawned at the emitter once age reaches it
+};
+
+/*
+	everything one simulation step depends on, pushed to particle.comp as is
+*/
+struct ParticleStep {
+	glm::vec4 gravity = glm::vec4(0.0f, -9.75f, 0.0f, 1.0f / 64.0f); //xyz acceleration, w = time step
+	glm::vec4 emitter = glm::vec4(0.0f, 0.0f, 0.0f, 0.5f); //xyz centre, w = edge of the spawn cube
+	float drag = 0.998f; //velocity kept per step
+	float floorHeight = -4.0f;
+	float restitution = 0.5f; //velocity kept by a bounce
+	uint32_t frame = 0; //seeds the respawns, advance it every step
+	uint32_t count = 0;
+};
+
+/*
+	Particle simulation, on the GPU with a CPU fallback
+
+	The particles live in one device local storage buffer that particle.comp integrates in place (gravity, drag, a
+	bouncing floor, respawn at the emitter once a particle's lifetime is over) and that the graphics pipeline then reads
+	again as a vertex buffer, drawing every particle as a point, so the simulated data never leaves the GPU.
+
+	simulate is the same step on the CPU for machines without a capable device and to check the GPU: glm's aligned vec4
+	(SSE where the build enables GLM_FORCE_INTRINSICS) one particle per vector, split across a thread pool. Both sides
+	only add, subtract, multiply and compare floats, which Vulkan requires to be correctly rounded, in the same order
+	(particle.comp marks its results precise so they are not fused into FMAs) and draw respawns from the same integer
+	hash, so the two paths give bit identical particles.
+*/
+class ParticleSystem
+{
+public:
+	static const uint32_t WORKGROUP_SIZE = 256;
+
+	/*
+		count particles spread over the emitter at random ages, the same on every run
+	*/
+	static std::vector<Particle> spawn(const ParticleStep& step);
+
+	/*
+		one step on the CPU, every particle independently
+	*/
+	static void simulate(std::vector<Particle>& particles, const ParticleStep& step, ThreadPool& pool);
+	static void simulateRange(Particle* particles, size_t begin, size_t end, const ParticleStep& step);
+
+	/*
+		create the particle buffer and both pipelines, the points are drawn in subpass 0 of renderPass
+	*/
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, VkRenderPass renderPass, VkExtent2D extent, uint32_t count);
+	void cleanup();
+
+	/*
+		copy particles into the particle buffer, and the particle buffer back into readback, through a host visible staging
+		buffer. recordReadback has to have completed before readback is called
+	*/
+	void recordUpload(VkCommandBuffer commandBuffer, const std::vector<Particle>& particles);
+	void recordReadback(VkCommandBuffer commandBuffer);
+	std::vector<Particle> readback();
+
+	/*
+		record one step outside a render pass, ordered after the previous step and the previous draw, and before the next draw
+	*/
+	void recordSimulate(VkCommandBuffer commandBuffer, const ParticleStep& step);
+
+	/*
+		record the draw inside the render pass
+	*/
+	void recordDraw(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection);
+
+	uint32_t size() const { return particleCount; }
+
+private:
+	void createBuffers();
+	void createComputePipeline();
+	void createGraphicsPipeline(VkRenderPass renderPass, VkExtent2D extent);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	uint32_t particleCount = 0;
+
+	VkBuffer particleBuffer = VK_NULL_HANDLE; //storage for particle.comp, vertices for particle.vert
+	VkDeviceMemory particleMemory = VK_NULL_HANDLE;
+	VkBuffer stagingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+	void* stagingData = nullptr; //persistently mapped
+
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	VkPipelineLayout computeLayout = VK_NULL_HANDLE;
+	VkPipeline computePipeline = VK_NULL_HANDLE;
+	VkPipelineLayout graphicsLayout = VK_NULL_HANDLE;
+	VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+};
@@ -0,0 +1,209 @@
+#include "PresentLatency.h"
+
+#include <stdexcept>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+namespace {
+	const double AVERAGE_WEIGHT = 0.1; //weight of the newest sample in the pacer's running averages
+	const uint64_t PRESENT_WAIT_TIMEOUT = 1000000000; //nanoseconds, a present that takes longer than this is given up on
+
+	double millisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+	{
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	}
+}
+
+const char* presentModeName(VkPresentModeKHR presentMode)
+{
+	switch (presentMode) {
+	case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+	case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+	case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+	default: return "other";
+	}
+}
+
+VkPresentModeKHR parsePresentMode(const std::string& name)
+{
+	for (VkPresentModeKHR presentMode : { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR }) {
+		if (name == presentModeName(presentMode)) {
+			return presentMode;
+		}
+	}
+	throw std::runtime_error("failed to parse present mode " + name + "!");
+}
+
+void FramePacer::reset()
+{
+	interval = 0.0;
+	work = 0.0;
+	hasPresent = false;
+}
+
+/*
+	the next present slot is the first one after the frame could be done, counted on from the last present in whole
+	intervals, and the frame starts its work plus the margin before it
+*/
+void FramePacer::waitForFrameStart()
+{
+	if (!hasPresent || interval <= 0.0) {
+		return;
+	}
+	auto now = std::chrono::steady_clock::now();
+	double busy = work + margin;
+	double sinceLastPresent = millisecondsBetween(lastPresent, now);
+	double slots = std::ceil((sinceLastPresent + busy) / interval);
+	double wait = slots * interval - busy - sinceLastPresent;
+	if (wait <= 0.0) {
+		return;
+	}
+	auto wakeUp = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(wait));
+	if (wait > 1.0) {
+		std::this_thread::sleep_until(wakeUp - std::chrono::milliseconds(1));
+	}
+	while (std::chrono::steady_clock::now() < wakeUp) {
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::frameStarted()
+{
+	start = std::chrono::steady_clock::now();
+}
+
+void FramePacer::frameSubmitted()
+{
+	double frameWork = millisecondsBetween(start, std::chrono::steady_clock::now());
+	work = work == 0.0 ? frameWork : work + (frameWork - work) * AVERAGE_WEIGHT;
+}
+
+void FramePacer::framePresented(std::chrono::steady_clock::time_point presented)
+{
+	if (hasPresent) {
+		double frameInterval = millisecondsBetween(lastPresent, presented);
+		if (frameInterval > 0.5) { //mailbox can drop frames, a later present then completes the waits of the earlier ones too
+			interval = interval == 0.0 ? frameInterval : interval + (frameInterval - interval) * AVERAGE_WEIGHT;
+		}
+	}
+	lastPresent = presented;
+	hasPresent = true;
+}
+
+/*
+	presentWait says whether the device was created with VK_KHR_present_id and VK_KHR_present_wait
+*/
+void PresentLatency::init(VkDevice device, bool presentWait, const LatencySettings& settings)
+{
+	this->device = device;
+	this->settings = settings;
+	pacer.setMargin(settings.pacingMargin);
+	waitForPresent = presentWait ? reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR")) : nullptr;
+}
+
+void PresentLatency::beginCase(bool pacing)
+{
+	this->pacing = pacing;
+	pacer.reset();
+	pending.clear();
+	warmup = settings.warmupFrames;
+	measured = 0;
+	inputToShown.clear();
+	startToShown.clear();
+	submitToShown.clear();
+}
+
+std::string PresentLatency::endCase(VkSwapchainKHR swapChain, VkPresentModeKHR presentMode)
+{
+	collect(swapChain);
+	const char* shown = usesPresentWait() ? "present" : "gpu done";
+	std::ostringstream line;
+	line << "  " << presentModeName(presentMode) << (pacing ? ", paced" : ", unpaced") << ":\n"
+		<< "    input to " << shown << " " << TimingSummary::fromSamples(inputToShown) << "\n"
+		<< "    start to " << shown << " " << TimingSummary::fromSamples(startToShown) << "\n"
+		<< "    submit to " << shown << " " << TimingSummary::fromSamples(submitToShown);
+	if (measured > 1) {
+		line << "\n    " << std::fixed << std::setprecision(1) << (measured - 1) * 1000.0 / millisecondsBetween(firstShown, lastShown) << " frames/s";
+	}
+	return line.str();
+}
+
+/*
+	with pacing the frame waits for the previous one to be shown, so it never queues behind another present, and then
+	for the pacer to place its work just before the next present slot
+*/
+void PresentLatency::waitForFrameStart(VkSwapchainKHR swapChain, VkFence previousFrameFence, uint64_t previousSerial)
+{
+	if (pacing) {
+		if (waitForPresent != nullptr && !pending.empty()) {
+			waitForPresent(device, swapChain, pending.back().serial, PRESENT_WAIT_TIMEOUT);
+			collect(swapChain);
+		}
+		else if (waitForPresent == nullptr && previousFrameFence != VK_NULL_HANDLE) {
+			vkWaitForFences(device, 1, &previousFrameFence, VK_TRUE, UINT64_MAX);
+			frameCompleted(previousSerial);
+		}
+		pacer.waitForFrameStart();
+	}
+	frameStart = std::chrono::steady_clock::now();
+	pacer.frameStarted();
+}
+
+void PresentLatency::frameSubmitted(uint64_t serial, std::chrono::steady_clock::time_point inputSampled)
+{
+	pacer.frameSubmitted();
+	pending.push_back({ serial, inputSampled, frameStart, std::chrono::steady_clock::now() });
+}
+
+void PresentLatency::collect(VkSwapchainKHR swapChain)
+{
+	while (waitForPresent != nullptr && !pending.empty()) {
+		VkResult result = waitForPresent(device, swapChain, pending.front().serial, 0);
+		if (result == VK_TIMEOUT) {
+			return; //presents complete in order, so nothing after it has either
+		}
+		if (result == VK_SUCCESS) {
+			record(pending.front(), std::chrono::steady_clock::now());
+		}
+		pending.pop_front(); //shown, or the swap chain is out of date and it never will be
+	}
+}
+
+void PresentLatency::frameCompleted(uint64_t serial)
+{
+	if (waitForPresent != nullptr) {
+		return;
+	}
+	auto now = std::chrono::steady_clock::now();
+	while (!pending.empty() && pending.front().serial <= serial) {
+		record(pending.front(), now);
+		pending.pop_front();
+	}
+}
+
+void PresentLatency::swapChainRetired()
+{
+	if (waitForPresent != nullptr) {
+		pending.clear();
+	}
+}
+
+void PresentLatency::record(const PendingFrame& frame, std::chrono::steady_clock::time_point shown)
+{
+	pacer.framePresented(shown);
+	if (warmup > 0) {
+		warmup--;
+		return;
+	}
+	if (measured == 0) {
+		firstShown = shown;
+	}
+	lastShown = shown;
+	measured++;
+	inputToShown.push_back(millisecondsBetween(frame.inputSampled, shown));
+	startToShown.push_back(millisecondsBetween(frame.started, shown));
+	submitToShown.push_back(millisecondsBetween(frame.submitted, shown));
+}
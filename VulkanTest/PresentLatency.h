@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <chrono>
+
+#include "FrameTimer.h"
+
+#ifndef VK_KHR_present_wait //headers older than 1.2.182 do not know the extension, it is then never found on the device either
+typedef VkResult (VKAPI_PTR* PFN_vkWaitForPresentKHR)(VkDevice device, VkSwapchainKHR swapchain, uint64_t presentId, uint64_t timeout);
+#endif
+
+/*
+	settings for the latency run, filled in from the command line
+*/
+struct LatencySettings {
+	bool enabled = false; //measure every present mode with and without pacing, then exit
+	uint32_t frames = 300; //frames measured per present mode and pacing setting
+	uint32_t warmupFrames = 30; //frames presented before measuring, the swap chain and the pacer settle in these
+	double pacingMargin = 1.0; //milliseconds the pacer leaves between the predicted end of a frame's CPU work and its present
+};
+
+const char* presentModeName(VkPresentModeKHR presentMode);
+VkPresentModeKHR parsePresentMode(const std::string& name); //fifo, fifo-relaxed, mailbox or immediate
+
+/*
+	Frame pacing controller
+
+	Starting a frame as soon as the previous one is submitted fills the swap chain's queue, so every frame waits a
+	whole queue of presents before it is shown and the input it was built from is that much older. The pacer instead
+	delays the start of each frame until just before the latest point at which it still makes the next present: that
+	point is predicted from the interval between the last presents (the refresh interval when the presents are paced
+	by the display) and the CPU time frames took from start to submit, plus a safety margin for the GPU.
+
+	Sleeping on Windows is only accurate to the scheduler's tick, so the last millisecond is spent yielding.
+*/
+class FramePacer
+{
+public:
+	void reset();
+	void setMargin(double milliseconds) { margin = milliseconds; }
+
+	void waitForFrameStart(); //sleeps until the predicted start of the next frame, returns straight away until there are estimates
+	void frameStarted();
+	void frameSubmitted();
+	void framePresented(std::chrono::steady_clock::time_point presented);
+
+private:
+	double margin = 1.0;
+	double interval = 0.0; //running average of the time between presents, milliseconds
+	double work = 0.0; //running average of the CPU time from frame start to submit, milliseconds
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point lastPresent;
+	bool hasPresent = false;
+};
+
+/*
+	Present latency measurement
+
+	Every frame is followed from the moment its input was sampled on the main thread, through the start of its CPU work
+	and its submit, to the moment it was shown. With VK_KHR_present_id and VK_KHR_present_wait every present carries the
+	frame's serial as its present id and vkWaitForPresentKHR tells when it reached the display. Without them the best
+	the app can see is its in-flight fence, so the end point becomes the completion of the frame's GPU work, which
+	leaves out the time spent queued for presentation.
+
+	Presents are polled without blocking after every frame, which places a present up to one frame late when nothing
+	waits for it, paced frames wait for the previous present before starting and are exact.
+*/
+class PresentLatency
+{
+public:
+	void init(VkDevice device, bool presentWait, const LatencySettings& settings);
+	bool usesPresentWait() const { return waitForPresent != nullptr; }
+
+	void beginCase(bool pacing);
+	std::string endCase(VkSwapchainKHR swapChain, VkPresentModeKHR presentMode); //a line of the report
+	bool caseComplete() const { return measured >= settings.frames; }
+
+	/*
+		render thread, once per frame in this order
+	*/
+	void waitForFrameStart(VkSwapchainKHR swapChain, VkFence previousFrameFence, uint64_t previousSerial); //pacing: wait for the previous frame, then for the pacer
+	void frameSubmitted(uint64_t serial, std::chrono::steady_clock::time_point inputSampled); //serial is the present id
+	void collect(VkSwapchainKHR swapChain); //record the frames that were presented by now
+	void frameCompleted(uint64_t serial); //without present wait: the fence of the frame with this serial has signalled
+
+	void swapChainRetired(); //presents on the old swap chain are no longer waited for
+
+private:
+	struct PendingFrame {
+		uint64_t serial;
+		std::chrono::steady_clock::time_point inputSampled, started, submitted;
+	};
+
+	void record(const PendingFrame& frame, std::chrono::steady_clock::time_point shown);
+
+	VkDevice device = VK_NULL_HANDLE;
+	PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+	LatencySettings settings;
+	FramePacer pacer;
+	bool pacing = false;
+
+	std::deque<PendingFrame> pending; //submitted, not yet known to be shown
+	std::chrono::steady_clock::time_point frameStart;
+	uint32_t warmup = 0; //frames still to be shown before measuring
+	uint32_t measured = 0;
+	std::chrono::steady_clock::time_point firstShown, lastShown;
+	std::vector<double> inputToShown, startToShown, submitToShown;
+};
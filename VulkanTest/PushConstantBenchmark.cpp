@@ -0,0 +1,321 @@
+#include "PushConstantBenchmark.h"
+#include "VulkanUtils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+PushConstantBenchmark::PushConstantBenchmark(const PushConstantBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void PushConstantBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("PushConstantBenchmark");
+	settings.draws = std::max(settings.draws, 1u);
+	context.createInstance("Push Constant Benchmark", VK_API_VERSION_1_0);
+	context.createDevice({}, nullptr);
+	try {
+		target = context.createOffscreenTarget(extent, VK_FORMAT_R8G8B8A8_UNORM, true);
+		createUniformBuffer();
+		createPipelines();
+		context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+
+		std::cout << "push constant benchmark: " << context.properties.deviceName << ", " << settings.draws << " draws per frame, "
+			<< sizeof(DrawConstants) << " bytes per draw, maxPushConstantsSize " << context.properties.limits.maxPushConstantsSize
+			<< ", minUniformBufferOffsetAlignment " << context.properties.limits.minUniformBufferOffsetAlignment << std::endl;
+
+		std::vector<uint8_t> pushImage, uniformImage;
+		runPath(Path::PushConstants, "push constants ", pushImage);
+		runPath(Path::DynamicUniform, "dynamic uniform", uniformImage);
+
+		size_t differing = 0;
+		for (size_t i = 0; i < pushImage.size(); i += 4) {
+			differing += memcmp(&pushImage[i], &uniformImage[i], 4) != 0;
+		}
+		std::cout << "  " << differing << " of " << pushImage.size() / 4 << " pixels differ between the paths" << std::endl;
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+/*
+	a host visible, persistently mapped buffer with a slice per frame in flight, and a single descriptor set whose
+	dynamic uniform binding covers one draw's data; the dynamic offset picks the draw
+*/
+void PushConstantBenchmark::createUniformBuffer()
+{
+	VkDevice device = context.device;
+	VkDeviceSize alignment = std::max<VkDeviceSize>(context.properties.limits.minUniformBufferOffsetAlignment, 1);
+	uniformStride = (sizeof(DrawConstants) + alignment - 1) / alignment * alignment;
+	createBuffer(device, context.physicalDevice, uniformStride * settings.draws * FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, uniformBuffer, uniformMemory);
+	void* mapped;
+	vkMapMemory(device, uniformMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	uniformData = static_cast<unsigned char*>(mapped);
+
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	setLayoutInfo.bindingCount = 1;
+	setLayoutInfo.pBindings = &binding;
+	if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &descriptorSetLayout;
+	if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor set!");
+	}
+
+	VkDescriptorBufferInfo bufferInfo = { uniformBuffer, 0, sizeof(DrawConstants) };
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+	write.dstSet = descriptorSet;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+/*
+	the two pipelines differ only in where perdraw.vert reads the draw's data from, and so in their layouts
+*/
+void PushConstantBenchmark::createPipelines()
+{
+	VkDevice device = context.device;
+
+	VkPushConstantRange drawRange = pushConstantRange(context.physicalDevice, VK_SHADER_STAGE_VERTEX_BIT, sizeof(DrawConstants));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &drawRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pushLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+	layoutInfo.pushConstantRangeCount = 0;
+	layoutInfo.pPushConstantRanges = nullptr;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &descriptorSetLayout;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &uniformLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule pushVertModule = createShaderModule(device, readBinaryFile("../shaders/perdraw_push_vert.spv"));
+	VkShaderModule uniformVertModule = createShaderModule(device, readBinaryFile("../shaders/perdraw_uniform_vert.spv"));
+	VkShaderModule fragModule = createShaderModule(device, readBinaryFile("../shaders/mesh_frag.spv"));
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragModule;
+	stages[1].pName = "main";
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //struct type, no vertex buffers
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE; //the triangles spin through both windings
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.renderPass = target.renderPass;
+	pipelineInfo.subpass = 0;
+
+	stages[0].module = pushVertModule;
+	pipelineInfo.layout = pushLayout;
+	VkResult pushResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pushPipeline);
+
+	stages[0].module = uniformVertModule;
+	pipelineInfo.layout = uniformLayout;
+	VkResult uniformResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &uniformPipeline);
+
+	vkDestroyShaderModule(device, pushVertModule, nullptr);
+	vkDestroyShaderModule(device, uniformVertModule, nullptr);
+	vkDestroyShaderModule(device, fragModule, nullptr);
+	if (pushResult != VK_SUCCESS || uniformResult != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+/*
+	the draws sit on a square grid and spin with the frame, so the data really changes every frame
+*/
+DrawConstants PushConstantBenchmark::drawConstants(uint32_t draw, uint32_t frame) const
+{
+	uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(settings.draws))));
+	float cell = 2.0f / columns;
+	glm::vec3 center(-1.0f + (draw % columns + 0.5f) * cell, -1.0f + (draw / columns + 0.5f) * cell, 0.0f);
+	DrawConstants constants;
+	constants.transform = glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), center), frame * 0.05f + draw * 0.1f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(cell * 0.45f));
+	constants.objectIndex = draw;
+	constants.materialId = draw * 7 % 16;
+	return constants;
+}
+
+void PushConstantBenchmark::recordFrame(VkCommandBuffer commandBuffer, Path path, size_t frameIndex, uint32_t frame)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //re-recorded every frame
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+
+	VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+	renderPassInfo.renderPass = target.renderPass;
+	renderPassInfo.framebuffer = target.framebuffer;
+	renderPassInfo.renderArea = { { 0, 0 }, extent };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearColor;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	if (path == Path::PushConstants) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pushPipeline);
+		for (uint32_t draw = 0; draw < settings.draws; draw++) {
+			DrawConstants constants = drawConstants(draw, frame);
+			vkCmdPushConstants(commandBuffer, pushLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+		}
+	}
+	else {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, uniformPipeline);
+		VkDeviceSize sliceOffset = uniformStride * settings.draws * frameIndex; //the GPU may still read the other frame's slice
+		for (uint32_t draw = 0; draw < settings.draws; draw++) {
+			DrawConstants constants = drawConstants(draw, frame);
+			VkDeviceSize offset = sliceOffset + uniformStride * draw;
+			memcpy(uniformData + offset, &constants, sizeof(constants));
+			uint32_t dynamicOffset = static_cast<uint32_t>(offset);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, uniformLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
+			vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+void PushConstantBenchmark::runPath(Path path, const char* name, std::vector<uint8_t>& image)
+{
+	VkDevice device = context.device;
+	std::vector<double> recordTimes;
+	size_t frameIndex = 0;
+	frameTimer.reset();
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+		vkWaitForFences(device, 1, &fences[frameIndex], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frameIndex);
+		auto start = std::chrono::steady_clock::now();
+		recordFrame(commandBuffers[frameIndex], path, frameIndex, i);
+		if (i >= settings.warmupFrames) {
+			recordTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		context.submitTimedFrame(frameTimer, frameIndex, commandBuffers[frameIndex], fences[frameIndex]);
+		frameIndex = (frameIndex + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+
+	VkDeviceSize written = path == Path::PushConstants ? 0 : uniformStride * settings.draws;
+	std::cout << "  " << name << " cpu record " << TimingSummary::fromSamples(recordTimes) << ", " << written / 1024 << " KB of per draw data written to memory per frame" << std::endl;
+	if (frameTimer.hasGpuTiming()) {
+		std::cout << "                  gpu frame " << frameTimer.gpuSummary() << std::endl;
+	}
+	image = context.readOffscreenTarget(target);
+}
+
+void PushConstantBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		vkDestroyPipeline(device, pushPipeline, nullptr);
+		vkDestroyPipeline(device, uniformPipeline, nullptr);
+		vkDestroyPipelineLayout(device, pushLayout, nullptr);
+		vkDestroyPipelineLayout(device, uniformLayout, nullptr);
+		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+		if (uniformData != nullptr) {
+			vkUnmapMemory(device, uniformMemory);
+		}
+		vkDestroyBuffer(device, uniformBuffer, nullptr);
+		freeDeviceMemory(device, uniformMemory, nullptr);
+		context.destroyOffscreenTarget(target);
+	}
+	context.cleanup();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "FrameTimer.h"
+
+/*
+	settings for the push constant benchmark, filled in from the command line
+*/
+struct PushConstantBenchmarkSettings {
+	bool enabled = false;
+	uint32_t draws = 20000; //draws per frame, each with its own per draw data
+	uint32_t frames = 300; //timed frames per path
+	uint32_t warmupFrames = 20; //untimed frames per path
+};
+
+/*
+	what perdraw.vert reads for every draw, 72 bytes in both the push constant (std430) and the uniform (std140) layout
+*/
+struct DrawConstants {
+	glm::mat4 transform;
+	uint32_t objectIndex;
+	uint32_t materialId;
+};
+
+/*
+	Push constants against dynamic uniform buffer offsets for per draw data
+
+	Draws many small triangles into a small offscreen target, each with its own transform, object index and material,
+	re-recording the frame every time as a renderer with moving objects would. The push constant path records the data
+	into the command buffer with vkCmdPushConstants, the dynamic uniform path writes it into the frame's slice of a
+	mapped uniform buffer, padded to minUniformBufferOffsetAlignment, and binds the one descriptor set with a new
+	dynamic offset per draw. Reports CPU time per frame (writing the data and recording), GPU time per frame, the bytes
+	of per draw data written to memory, and whether the two images match. The push constant range is checked against
+	maxPushConstantsSize.
+*/
+class PushConstantBenchmark
+{
+public:
+	explicit PushConstantBenchmark(const PushConstantBenchmarkSettings& settings);
+	void run();
+
+private:
+	enum class Path { PushConstants, DynamicUniform };
+
+	void createUniformBuffer();
+	void createPipelines();
+	DrawConstants drawConstants(uint32_t draw, uint32_t frame) const;
+	void recordFrame(VkCommandBuffer commandBuffer, Path path, size_t frameIndex, uint32_t frame);
+	void runPath(Path path, const char* name, std::vector<uint8_t>& image);
+	void cleanup();
+
+	PushConstantBenchmarkSettings settings;
+	HeadlessDevice context;
+
+	VkExtent2D extent = { 256, 256 };
+	OffscreenTarget target; //R8G8B8A8_UNORM, read back to compare the two paths
+
+	//the dynamic uniform path: one slice of draws * uniformStride bytes per frame in flight
+	VkDeviceSize uniformStride = 0;
+	VkBuffer uniformBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory uniformMemory = VK_NULL_HANDLE;
+	unsigned char* uniformData = nullptr; //persistently mapped
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+	VkPipelineLayout pushLayout = VK_NULL_HANDLE;
+	VkPipelineLayout uniformLayout = VK_NULL_HANDLE;
+	VkPipeline pushPipeline = VK_NULL_HANDLE;
+	VkPipeline uniformPipeline = VK_NULL_HANDLE;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
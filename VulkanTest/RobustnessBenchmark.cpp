@@ -0,0 +1,355 @@
+#include "RobustnessBenchmark.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	const uint32_t LINK_BLOCK = 4096; //links stay within blocks of this many elements, so the loads mostly hit the caches
+	const uint32_t WORKGROUP_SIZE = 256; //local_size_x of robust.comp
+
+	struct Parameters {
+		uint32_t count;
+		uint32_t steps;
+	};
+}
+
+RobustnessBenchmark::RobustnessBenchmark(const RobustnessBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+/*
+	the links of every block form a single cycle (Sattolo's shuffle), so no chain gets stuck in a short loop
+*/
+void RobustnessBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("RobustnessBenchmark");
+	settings.elements = std::max(settings.elements, 1u);
+	std::mt19937 random(46);
+	links.resize(settings.elements);
+	for (uint32_t begin = 0; begin < settings.elements; begin += LINK_BLOCK) {
+		uint32_t end = std::min(begin + LINK_BLOCK, settings.elements);
+		std::vector<uint32_t> order(end - begin);
+		for (uint32_t i = 0; i < order.size(); i++) {
+			order[i] = begin + i;
+		}
+		for (uint32_t i = static_cast<uint32_t>(order.size()) - 1; i > 0; i--) {
+			std::swap(order[i], order[random() % i]);
+		}
+		for (size_t i = 0; i < order.size(); i++) {
+			links[order[i]] = order[(i + 1) % order.size()];
+		}
+	}
+	std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+	values.resize(static_cast<size_t>(settings.elements) * 4);
+	for (float& v : values) {
+		v = value(random);
+	}
+
+	std::cout << "robustness benchmark: " << settings.elements << " invocations following " << settings.steps << " links each, "
+		<< settings.frames << " dispatches per device" << std::endl;
+	const struct {
+		Robustness robustness;
+		const char* name;
+	} cases[] = {
+		{ Robustness::None, "no robustness      " },
+		{ Robustness::RobustBufferAccess, "robustBufferAccess " },
+		{ Robustness::RobustBufferAccess2, "robustBufferAccess2" },
+	};
+	double baseline = 0.0;
+	uint64_t expected = 0;
+	for (const auto& benchmarkCase : cases) {
+		try {
+			if (!createDevice(benchmarkCase.robustness)) {
+				std::cout << "  " << benchmarkCase.name << " not supported by the device" << std::endl;
+				cleanup();
+				continue;
+			}
+			createBuffers();
+			createPipeline();
+			createFrameResources();
+			uint64_t checksum = 0;
+			double median = runCase(benchmarkCase.name, checksum);
+			if (benchmarkCase.robustness == Robustness::None) {
+				baseline = median;
+				expected = checksum;
+			}
+			else {
+				if (baseline > 0.0 && median > 0.0) {
+					std::cout << "    " << (median / baseline - 1.0) * 100.0 << "% slower than without robustness" << std::endl;
+				}
+				if (checksum != expected) {
+					std::cout << "    results differ from the device without robustness" << std::endl;
+				}
+			}
+		}
+		catch (...) {
+			cleanup();
+			throw;
+		}
+		cleanup();
+	}
+}
+
+/*
+	the only thing the cases change is the robustness feature, everything else the shader needs is core 1.0
+*/
+bool RobustnessBenchmark::createDevice(Robustness robustness)
+{
+	context.createInstance("Robustness Benchmark", VK_API_VERSION_1_1);
+	features.init(context.physicalDevice);
+	if (robustness == Robustness::RobustBufferAccess) {
+		if (!features.want(&VkPhysicalDeviceFeatures::robustBufferAccess, "robustBufferAccess")) {
+			return false;
+		}
+	}
+	else if (robustness == Robustness::RobustBufferAccess2) {
+#ifdef VK_EXT_robustness2
+		//robustBufferAccess2 is only allowed with robustBufferAccess
+		if (!features.supports(&VkPhysicalDeviceFeatures::robustBufferAccess) || !features.supportsExtension(VK_EXT_ROBUSTNESS_2_EXTENSION_NAME)
+			|| !features.supports(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_EXT, &VkPhysicalDeviceRobustness2FeaturesEXT::robustBufferAccess2)) {
+			return false;
+		}
+		features.require(&VkPhysicalDeviceFeatures::robustBufferAccess, "robustBufferAccess");
+		features.requireExtension(VK_EXT_ROBUSTNESS_2_EXTENSION_NAME);
+		features.require(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_EXT, &VkPhysicalDeviceRobustness2FeaturesEXT::robustBufferAccess2, "robustBufferAccess2");
+#else
+		return false; //the headers predate VK_EXT_robustness2
+#endif
+	}
+	context.createDevice(features.enabledExtensions(), features.chain(), &features.enabledCore());
+	return true;
+}
+
+/*
+	copy data into a new device local storage buffer through a temporary staging buffer
+*/
+void RobustnessBenchmark::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& memory)
+{
+	VkDevice device = context.device;
+	VkBuffer staging;
+	VkDeviceMemory stagingMemory;
+	createBuffer(device, context.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, stagingMemory);
+	void* mapped;
+	vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	memcpy(mapped, data, static_cast<size_t>(size));
+	vkUnmapMemory(device, stagingMemory);
+
+	createBuffer(device, context.physicalDevice, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, buffer, memory);
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	VkBufferCopy region = { 0, 0, size };
+	vkCmdCopyBuffer(commandBuffer, staging, buffer, 1, &region);
+	context.endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(device, staging, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+}
+
+void RobustnessBenchmark::createBuffers()
+{
+	uploadBuffer(links.data(), sizeof(uint32_t) * links.size(), linkBuffer, linkMemory);
+	uploadBuffer(values.data(), sizeof(float) * values.size(), valueBuffer, valueMemory);
+	createBuffer(context.device, context.physicalDevice, sizeof(float) * values.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, resultBuffer, resultMemory);
+}
+
+void RobustnessBenchmark::createPipeline()
+{
+	VkDevice device = context.device;
+
+	VkDescriptorSetLayoutBinding bindings[3] = {};
+	for (uint32_t i = 0; i < 3; i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO; //struct type
+	setLayoutInfo.bindingCount = 3;
+	setLayoutInfo.pBindings = bindings;
+	if (vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 };
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO; //struct type
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO; //struct type
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &descriptorSetLayout;
+	if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate descriptor set!");
+	}
+
+	VkDescriptorBufferInfo bufferInfos[3] = {
+		{ linkBuffer, 0, VK_WHOLE_SIZE },
+		{ valueBuffer, 0, VK_WHOLE_SIZE },
+		{ resultBuffer, 0, VK_WHOLE_SIZE },
+	};
+	VkWriteDescriptorSet writes[3] = {};
+	for (uint32_t i = 0; i < 3; i++) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET; //struct type
+		writes[i].dstSet = descriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+
+	VkPushConstantRange parameterRange = pushConstantRange(context.physicalDevice, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(Parameters));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &descriptorSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &parameterRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule computeModule = createShaderModule(device, readBinaryFile("../shaders/robust_comp.spv"));
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = computeModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(device, computeModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline!");
+	}
+}
+
+/*
+	the dispatch never changes, so both frames' command buffers are recorded here. the barrier orders the result writes
+	after the previous dispatch's
+*/
+void RobustnessBenchmark::createFrameResources()
+{
+	context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+
+	Parameters parameters = { settings.elements, settings.steps };
+	for (VkCommandBuffer commandBuffer : commandBuffers) {
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording command buffer!");
+		}
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER; //struct type
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(parameters), &parameters);
+		vkCmdDispatch(commandBuffer, (settings.elements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record command buffer!");
+		}
+	}
+}
+
+double RobustnessBenchmark::runCase(const char* name, uint64_t& checksum)
+{
+	VkDevice device = context.device;
+	size_t frame = 0;
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frame);
+
+		context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+	checksum = readResults();
+
+	std::cout << "  " << name << " device features: " << features.summary() << std::endl;
+	double median = 0.0;
+	if (frameTimer.hasGpuTiming()) {
+		TimingSummary gpu = frameTimer.gpuSummary();
+		median = gpu.p50;
+		double loads = static_cast<double>(settings.elements) * settings.steps * 2.0;
+		std::cout << "    gpu dispatch " << gpu << ", " << loads / (median / 1000.0) / 1e9 << " G loads/s" << std::endl;
+	}
+	return median;
+}
+
+uint64_t RobustnessBenchmark::readResults()
+{
+	VkDevice device = context.device;
+	VkDeviceSize size = sizeof(float) * values.size();
+	VkBuffer readback;
+	VkDeviceMemory readbackMemory;
+	createBuffer(device, context.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, readback, readbackMemory);
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	VkBufferCopy region = { 0, 0, size };
+	vkCmdCopyBuffer(commandBuffer, resultBuffer, readback, 1, &region);
+	context.endSingleTimeCommands(commandBuffer);
+
+	void* mapped;
+	vkMapMemory(device, readbackMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	const unsigned char* bytes = static_cast<const unsigned char*>(mapped);
+	uint64_t hash = 14695981039346656037ull;
+	for (VkDeviceSize i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull; //FNV-1a
+	}
+	vkUnmapMemory(device, readbackMemory);
+	vkDestroyBuffer(device, readback, nullptr);
+	freeDeviceMemory(device, readbackMemory, nullptr);
+	return hash;
+}
+
+void RobustnessBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		vkDestroyPipeline(device, pipeline, nullptr);
+		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+		vkDestroyBuffer(device, linkBuffer, nullptr);
+		freeDeviceMemory(device, linkMemory, nullptr);
+		vkDestroyBuffer(device, valueBuffer, nullptr);
+		freeDeviceMemory(device, valueMemory, nullptr);
+		vkDestroyBuffer(device, resultBuffer, nullptr);
+		freeDeviceMemory(device, resultMemory, nullptr);
+	}
+	context.cleanup();
+	//every case starts from null handles on a new device
+	fences.clear();
+	commandBuffers.clear();
+	pipeline = VK_NULL_HANDLE;
+	pipelineLayout = VK_NULL_HANDLE;
+	descriptorPool = VK_NULL_HANDLE;
+	descriptorSetLayout = VK_NULL_HANDLE;
+	descriptorSet = VK_NULL_HANDLE;
+	linkBuffer = valueBuffer = resultBuffer = VK_NULL_HANDLE;
+	linkMemory = valueMemory = resultMemory = VK_NULL_HANDLE;
+}
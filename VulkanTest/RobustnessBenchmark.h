@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "DeviceFeatures.h"
+#include "FrameTimer.h"
+
+/*
+	settings for the robustness benchmark, filled in from the command line
+*/
+struct RobustnessBenchmarkSettings {
+	bool enabled = false;
+	uint32_t elements = 1 << 22; //invocations, and entries in every buffer
+	uint32_t steps = 32; //links followed by every invocation
+	uint32_t frames = 100; //timed dispatches per device
+	uint32_t warmupFrames = 10; //untimed dispatches per device
+};
+
+/*
+	Robust buffer access benchmark
+
+	Runs the same load heavy compute shader (robust.comp: every invocation follows a chain of links through one
+	storage buffer and sums the entries of another) on devices created through DeviceFeatures with nothing enabled,
+	with robustBufferAccess, and with robustBufferAccess2 from VK_EXT_robustness2 when the device has it. Features
+	cannot change after device creation, so every case gets its own device. Reports the GPU time per dispatch against
+	the device without robustness and checks that every case computed the same results.
+*/
+class RobustnessBenchmark
+{
+public:
+	explicit RobustnessBenchmark(const RobustnessBenchmarkSettings& settings);
+	void run();
+
+private:
+	enum class Robustness { None, RobustBufferAccess, RobustBufferAccess2 };
+
+	bool createDevice(Robustness robustness); //false when the device does not support the case
+	void createBuffers();
+	void createPipeline();
+	void createFrameResources();
+	double runCase(const char* name, uint64_t& checksum); //median GPU time per dispatch, 0 without timestamps
+	uint64_t readResults();
+	void uploadBuffer(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceMemory& memory);
+	void cleanup();
+
+	RobustnessBenchmarkSettings settings;
+	std::vector<uint32_t> links;
+	std::vector<float> values; //four per element
+	HeadlessDevice context;
+	DeviceFeatures features;
+
+	VkBuffer linkBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory linkMemory = VK_NULL_HANDLE;
+	VkBuffer valueBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory valueMemory = VK_NULL_HANDLE;
+	VkBuffer resultBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory resultMemory = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers; //recorded once, the dispatch is the same every frame
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
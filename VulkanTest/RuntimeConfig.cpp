@@ -0,0 +1,145 @@
+#include "RuntimeConfig.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+	const char* DEFAULT_CONFIG_FILE = "VulkanTest.cfg";
+	const char* CONFIG_VARIABLE = "VULKANTEST_CONFIG";
+	const char* OPTIONS_VARIABLE = "VULKANTEST_OPTIONS";
+	const char* WHITE_SPACE = " \t\r\n";
+
+	std::string trim(const std::string& text)
+	{
+		size_t begin = text.find_first_not_of(WHITE_SPACE);
+		if (begin == std::string::npos) {
+			return std::string();
+		}
+		size_t end = text.find_last_not_of(WHITE_SPACE);
+		return text.substr(begin, end - begin + 1);
+	}
+
+	/*
+		append the arguments of source name to sources with every --config <file> replaced by the options of that file,
+		read recursively so a config file can include others. a relative path is relative to the file including it,
+		including is the chain of files being read, to catch a file that ends up including itself
+	*/
+	void expandConfigs(const std::vector<std::string>& arguments, const std::string& name, const std::filesystem::path& directory,
+		std::vector<ArgumentSource>& sources, std::vector<std::filesystem::path>& including)
+	{
+		ArgumentSource part = { name, {} }; //the arguments since the last include
+		auto flush = [&]() {
+			if (!part.arguments.empty()) {
+				sources.push_back(part);
+				part.arguments.clear();
+			}
+		};
+		for (size_t i = 0; i < arguments.size(); i++) {
+			if (arguments[i] != "--config") {
+				part.arguments.push_back(arguments[i]);
+				continue;
+			}
+			if (i + 1 >= arguments.size()) {
+				throw std::runtime_error("missing value for --config in " + name);
+			}
+			flush();
+			std::filesystem::path path = arguments[++i];
+			if (path.is_relative()) {
+				path = directory / path;
+			}
+			path = path.lexically_normal();
+			if (std::find(including.begin(), including.end(), path) != including.end()) {
+				throw std::runtime_error("config file " + path.string() + " includes itself!");
+			}
+			including.push_back(path);
+			expandConfigs(readConfigFile(path.string()), path.string(), path.parent_path(), sources, including);
+			including.pop_back();
+		}
+		flush();
+	}
+}
+
+std::vector<std::string> splitArguments(const std::string& text)
+{
+	std::vector<std::string> arguments;
+	std::istringstream stream(text);
+	std::string argument;
+	while (stream >> argument) {
+		arguments.push_back(argument);
+	}
+	return arguments;
+}
+
+std::vector<std::string> readConfigFile(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open config file " + path + "!");
+	}
+	std::vector<std::string> arguments;
+	std::string line;
+	while (std::getline(file, line)) {
+		line = trim(line);
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		size_t nameEnd = line.find_first_of(" \t=");
+		std::string name = line.substr(0, nameEnd);
+		arguments.push_back(name.compare(0, 2, "--") == 0 ? name : "--" + name);
+		if (nameEnd != std::string::npos) {
+			std::string value = trim(line.substr(nameEnd));
+			if (!value.empty() && value[0] == '=') {
+				value = trim(value.substr(1));
+			}
+			if (!value.empty()) {
+				arguments.push_back(value);
+			}
+		}
+	}
+	return arguments;
+}
+
+std::vector<ArgumentSource> gatherArguments(int argc, char* argv[])
+{
+	std::vector<std::string> commandLine;
+	std::string configFile;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--config") {
+			if (i + 1 >= argc) {
+				throw std::runtime_error("missing value for " + arg);
+			}
+			configFile = argv[++i];
+		}
+		else {
+			commandLine.push_back(arg);
+		}
+	}
+	if (configFile.empty()) {
+		const char* variable = std::getenv(CONFIG_VARIABLE);
+		if (variable != nullptr && variable[0] != '\0') {
+			configFile = variable;
+		}
+		else if (std::ifstream(DEFAULT_CONFIG_FILE).good()) {
+			configFile = DEFAULT_CONFIG_FILE;
+		}
+	}
+
+	std::vector<ArgumentSource> sources;
+	std::vector<std::filesystem::path> including;
+	if (!configFile.empty()) {
+		expandConfigs({ "--config", configFile }, "the command line", std::filesystem::path(), sources, including);
+	}
+	const char* options = std::getenv(OPTIONS_VARIABLE);
+	if (options != nullptr) {
+		expandConfigs(splitArguments(options), OPTIONS_VARIABLE, std::filesystem::path(), sources, including);
+	}
+	if (!commandLine.empty()) {
+		sources.push_back({ "the command line", commandLine });
+	}
+	return sources;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+/*
+	Runtime configuration sources
+
+	Every option is a command line argument, the other sources only supply more of them in front of the command line,
+	so later sources override earlier ones and one parser handles all of them. Every switch has a --no- form to turn it
+	off again, and the run modes (--golden, --replay, --latency and the benchmarks) replace each other: the last one
+	given wins, naming two in the same source is an error.
+
+		1. a config file: the file after --config on the command line, else the file named by VULKANTEST_CONFIG, else
+		   VulkanTest.cfg in the working directory when there is one
+		2. VULKANTEST_OPTIONS: arguments separated by white space, as they would be typed
+		3. the command line
+
+	A config file holds one option per line, written as on the command line with or without the leading dashes and
+	optionally with an = before the value, which is the rest of the line so paths may contain spaces:
+
+		# release like timing, on top of the shared settings
+		config = common.cfg
+		no-validation
+		frames-in-flight = 3
+		present-mode mailbox
+
+	A config line (or --config in VULKANTEST_OPTIONS) reads another config file in its place, a relative path being
+	relative to the file that names it, so a config file can build on a shared one. A file including itself is an error.
+	The included options form a source of their own, between the parts of the including file before and after the line.
+
+	Everything is read once before the application starts, nothing is looked up per frame.
+*/
+struct ArgumentSource {
+	std::string name; //the config file's path, VULKANTEST_OPTIONS or the command line, for error messages
+	std::vector<std::string> arguments;
+};
+std::vector<ArgumentSource> gatherArguments(int argc, char* argv[]);
+std::vector<std::string> readConfigFile(const std::string& path);
+std::vector<std::string> splitArguments(const std::string& text);
@@ -0,0 +1,122 @@
+#include "SceneBenchmark.h"
+#include "FrameTimer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cmath>
+
+namespace {
+	const double FRAME_BUDGET_MILLISECONDS = 1000.0 / 60.0;
+	const uint32_t ROOTS = 16;
+
+	double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	glm::quat randomRotation(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+		std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+		glm::vec3 axis(component(random), component(random), component(random));
+		if (glm::length(axis) < 1e-3f) {
+			axis = glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+		return glm::angleAxis(angle(random), glm::normalize(axis));
+	}
+}
+
+SceneBenchmark::SceneBenchmark(const SceneBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+/*
+	the world matrix by walking up the parents with the ordinary glm product
+*/
+glm::mat4 SceneBenchmark::referenceWorld(SceneNode node) const
+{
+	glm::mat4 world(1.0f);
+	for (SceneNode current = node; current != SceneGraph::NO_PARENT; current = scene.parent(current)) {
+		glm::mat4 local = glm::translate(glm::mat4(1.0f), scene.translation(current)) * glm::mat4_cast(scene.rotation(current));
+		world = glm::scale(local, scene.scale(current)) * world;
+	}
+	return world;
+}
+
+void SceneBenchmark::run()
+{
+	std::unique_ptr<ThreadPool> pool(new ThreadPool(settings.threads));
+	std::mt19937 random(1234);
+
+	//a random recursive tree: every node picks a parent among the nodes made before it, which gives a few long chains,
+	//many shallow leaves and parents created far from their children, so the first update has real sorting to do
+	auto buildStart = std::chrono::steady_clock::now();
+	scene.reserve(settings.nodes);
+	std::uniform_real_distribution<float> offset(-1.0f, 1.0f), size(0.9f, 1.1f);
+	for (uint32_t i = 0; i < settings.nodes; i++) {
+		SceneNode parent = i < ROOTS ? SceneGraph::NO_PARENT : static_cast<SceneNode>(random() % i);
+		scene.createNode(parent, glm::vec3(offset(random), offset(random), offset(random)), randomRotation(random), glm::vec3(size(random)));
+	}
+	double createMilliseconds = millisecondsSince(buildStart);
+	auto firstStart = std::chrono::steady_clock::now();
+	SceneUpdateStats first = scene.update(pool.get());
+	double firstMilliseconds = millisecondsSince(firstStart);
+	std::cout << "scene graph benchmark: " << scene.nodeCount() << " nodes in " << scene.levelCount() << " levels, created in "
+		<< createMilliseconds << " ms, sorted and computed in " << firstMilliseconds << " ms (" << first.recomputed << " nodes), "
+		<< pool->threadCount() << " threads" << std::endl;
+
+	//every root turns, so every node below is recomputed
+	auto timeUpdates = [&](const char* name, ThreadPool* updatePool, auto change) {
+		std::vector<double> samples;
+		size_t recomputed = 0;
+		for (uint32_t frame = 0; frame < settings.frames; frame++) {
+			change(frame);
+			auto start = std::chrono::steady_clock::now();
+			SceneUpdateStats stats = scene.update(updatePool);
+			samples.push_back(millisecondsSince(start));
+			recomputed += stats.recomputed;
+		}
+		TimingSummary summary = TimingSummary::fromSamples(samples);
+		double nodesPerFrame = static_cast<double>(recomputed) / settings.frames;
+		std::cout << "  " << name << " " << nodesPerFrame << " nodes per update, " << summary;
+		if (summary.average > 0.0) {
+			std::cout << ", " << nodesPerFrame / (summary.average * 1000.0) << "M nodes/s";
+		}
+		std::cout << ", " << summary.p95 / FRAME_BUDGET_MILLISECONDS * 100.0 << "% of a 60 Hz frame at p95" << std::endl;
+	};
+	auto turnRoots = [&](uint32_t frame) {
+		for (SceneNode root = 0; root < ROOTS; root++) {
+			scene.setRotation(root, glm::angleAxis(frame * 0.01f + root, glm::vec3(0.0f, 1.0f, 0.0f)));
+		}
+	};
+	timeUpdates("everything moves, 1 thread  ", nullptr, turnRoots);
+	timeUpdates("everything moves, pool      ", pool.get(), turnRoots);
+
+	uint32_t moving = std::max(static_cast<uint32_t>(settings.nodes * settings.movingFraction), 1u);
+	std::vector<SceneNode> movers(moving);
+	for (auto& node : movers) {
+		node = static_cast<SceneNode>(random() % settings.nodes);
+	}
+	timeUpdates("some nodes move, pool       ", pool.get(), [&](uint32_t frame) {
+		for (SceneNode node : movers) {
+			scene.setRotation(node, glm::angleAxis(frame * 0.01f, glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+	});
+	timeUpdates("nothing moves, pool         ", pool.get(), [](uint32_t) {});
+
+	float largestError = 0.0f;
+	for (int sample = 0; sample < 1000; sample++) {
+		SceneNode node = static_cast<SceneNode>(random() % settings.nodes);
+		glm::mat4 expected = referenceWorld(node), actual = scene.worldMatrix(node);
+		for (int column = 0; column < 4; column++) {
+			glm::vec4 difference = glm::abs(expected[column] - actual[column]);
+			largestError = std::max(largestError, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+		}
+	}
+	std::cout << "  largest difference from the recursive reference over 1000 nodes: " << largestError << std::endl;
+}
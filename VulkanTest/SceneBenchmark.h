@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SceneGraph.h"
+
+/*
+	settings for the scene graph benchmark, filled in from the command line
+*/
+struct SceneBenchmarkSettings {
+	bool enabled = false;
+	uint32_t nodes = 1 << 20;
+	uint32_t threads = 0; //update threads, 0 for every hardware thread
+	uint32_t frames = 60; //updates timed per case
+	float movingFraction = 0.01f; //share of the nodes given a new rotation every frame in the partial case
+};
+
+/*
+	Scene graph benchmark
+
+	Builds a random hierarchy of the given size (nodes are created in random parent order, so the first update has to sort
+	them) and times SceneGraph::update when every node moves, on one thread and on the thread pool, when a small share of
+	the nodes move and when nothing does, against a 60 Hz frame. A sample of the world matrices is checked against a
+	plain recursive evaluation. Runs on the CPU only.
+*/
+class SceneBenchmark
+{
+public:
+	explicit SceneBenchmark(const SceneBenchmarkSettings& settings);
+	void run();
+
+private:
+	glm::mat4 referenceWorld(SceneNode node) const;
+
+	SceneBenchmarkSettings settings;
+	SceneGraph scene;
+};
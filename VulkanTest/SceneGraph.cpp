@@ -0,0 +1,241 @@
+#include "SceneGraph.h"
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#include <glm/simd/matrix.h>
+#endif
+
+#include <stdexcept>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+	const size_t UPDATE_BATCH = 4096; //nodes per parallelFor range, large enough to keep the shared counter cold
+
+	template<typename T>
+	void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> sorted;
+		sorted.reserve(values.size());
+		for (uint32_t index : order) {
+			sorted.push_back(values[index]);
+		}
+		values.swap(sorted);
+	}
+}
+
+void SceneGraph::reserve(size_t nodes)
+{
+	translations.reserve(nodes);
+	rotations.reserve(nodes);
+	scales.reserve(nodes);
+	parents.reserve(nodes);
+	depths.reserve(nodes);
+	worlds.reserve(nodes);
+	dirty.reserve(nodes);
+	indexOf.reserve(nodes);
+	handleOf.reserve(nodes);
+}
+
+SceneNode SceneGraph::createNode(SceneNode parent, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+	uint32_t parentIndex = NO_PARENT;
+	uint32_t depth = 0;
+	if (parent != NO_PARENT) {
+		if (parent >= indexOf.size()) {
+			throw std::runtime_error("scene node parent does not exist!");
+		}
+		parentIndex = indexOf[parent];
+		depth = depths[parentIndex] + 1;
+	}
+
+	SceneNode handle = static_cast<SceneNode>(indexOf.size());
+	indexOf.push_back(static_cast<uint32_t>(parents.size()));
+	handleOf.push_back(handle);
+	translations.push_back(translation);
+	rotations.push_back(rotation);
+	scales.push_back(scale);
+	parents.push_back(parentIndex);
+	depths.push_back(depth);
+	worlds.push_back(glm::aligned_mat4(1.0f));
+	dirty.push_back(1); //never computed
+	unsorted = true;
+	return handle;
+}
+
+SceneNode SceneGraph::parent(SceneNode node) const
+{
+	uint32_t parentIndex = parents[indexOf[node]];
+	if (parentIndex == NO_PARENT) {
+		return NO_PARENT;
+	}
+	return handleOf[parentIndex];
+}
+
+void SceneGraph::markDirty(uint32_t index)
+{
+	dirty[index] = 1;
+	if (!unsorted) {
+		levelDirty[depths[index]] = 1;
+	}
+}
+
+void SceneGraph::setTranslation(SceneNode node, const glm::vec3& translation)
+{
+	uint32_t index = indexOf[node];
+	translations[index] = translation;
+	markDirty(index);
+}
+
+void SceneGraph::setRotation(SceneNode node, const glm::quat& rotation)
+{
+	uint32_t index = indexOf[node];
+	rotations[index] = rotation;
+	markDirty(index);
+}
+
+void SceneGraph::setScale(SceneNode node, const glm::vec3& scale)
+{
+	uint32_t index = indexOf[node];
+	scales[index] = scale;
+	markDirty(index);
+}
+
+/*
+	breadth first from the roots: each level ends up contiguous, ordered by parent, so siblings are adjacent
+*/
+void SceneGraph::sortByDepth()
+{
+	size_t count = parents.size();
+	std::vector<uint32_t> childStarts(count + 1, 0), children(count);
+	for (size_t i = 0; i < count; i++) {
+		if (parents[i] != NO_PARENT) {
+			childStarts[parents[i] + 1]++;
+		}
+	}
+	std::partial_sum(childStarts.begin(), childStarts.end(), childStarts.begin());
+	std::vector<uint32_t> fill(childStarts.begin(), childStarts.end() - 1);
+	for (uint32_t i = 0; i < count; i++) {
+		if (parents[i] != NO_PARENT) {
+			children[fill[parents[i]]++] = i;
+		}
+	}
+
+	std::vector<uint32_t> order; //order[new index] = old index
+	order.reserve(count);
+	for (uint32_t i = 0; i < count; i++) {
+		if (parents[i] == NO_PARENT) {
+			order.push_back(i);
+		}
+	}
+	for (size_t head = 0; head < order.size(); head++) {
+		uint32_t node = order[head];
+		order.insert(order.end(), children.begin() + childStarts[node], children.begin() + childStarts[node + 1]);
+	}
+
+	std::vector<uint32_t> newIndex(count);
+	for (uint32_t i = 0; i < count; i++) {
+		newIndex[order[i]] = i;
+	}
+	permute(translations, order);
+	permute(rotations, order);
+	permute(scales, order);
+	permute(worlds, order);
+	permute(dirty, order);
+	permute(handleOf, order);
+	std::vector<uint32_t> sortedParents(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t oldParent = parents[order[i]];
+		sortedParents[i] = oldParent == NO_PARENT ? NO_PARENT : newIndex[oldParent];
+		depths[i] = oldParent == NO_PARENT ? 0 : depths[sortedParents[i]] + 1; //the parent is already written
+		indexOf[handleOf[i]] = i;
+	}
+	parents.swap(sortedParents);
+
+	levelStarts.clear();
+	levelDirty.clear();
+	for (uint32_t i = 0; i < count; i++) {
+		if (i == 0 || depths[i] != depths[i - 1]) {
+			levelStarts.push_back(i);
+			levelDirty.push_back(0);
+		}
+		levelDirty.back() |= dirty[i];
+	}
+	levelStarts.push_back(static_cast<uint32_t>(count));
+	unsorted = false;
+}
+
+/*
+	recompute the nodes of [begin, end) that are dirty or have a dirty parent, all within one level
+*/
+size_t SceneGraph::updateRange(size_t begin, size_t end)
+{
+	size_t recomputed = 0;
+	for (size_t i = begin; i < end; i++) {
+		uint32_t parent = parents[i];
+		if (parent != NO_PARENT && dirty[parent]) {
+			dirty[i] = 1; //so the children see it in the next level
+		}
+		if (!dirty[i]) {
+			continue;
+		}
+
+		glm::mat3 rotation = glm::mat3_cast(rotations[i]);
+		const glm::vec3& scale = scales[i];
+		glm::aligned_mat4 local;
+		local[0] = glm::aligned_vec4(rotation[0] * scale.x, 0.0f);
+		local[1] = glm::aligned_vec4(rotation[1] * scale.y, 0.0f);
+		local[2] = glm::aligned_vec4(rotation[2] * scale.z, 0.0f);
+		local[3] = glm::aligned_vec4(translations[i], 1.0f);
+		if (parent == NO_PARENT) {
+			worlds[i] = local;
+		}
+		else {
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+			glm_mat4_mul(&worlds[parent][0].data, &local[0].data, &worlds[i][0].data);
+#else
+			worlds[i] = worlds[parent] * local;
+#endif
+		}
+		recomputed++;
+	}
+	return recomputed;
+}
+
+SceneUpdateStats SceneGraph::update(ThreadPool* pool)
+{
+	SceneUpdateStats stats;
+	if (unsorted) {
+		sortByDepth();
+		stats.resorted = true;
+	}
+
+	std::vector<uint32_t> visited;
+	bool parentLevelChanged = false;
+	for (uint32_t level = 0; level < levelCount(); level++) {
+		if (!levelDirty[level] && !parentLevelChanged) {
+			continue; //nothing here moved and nothing above it did either
+		}
+		size_t begin = levelStarts[level], end = levelStarts[level + 1];
+		size_t recomputed = 0;
+		if (pool != nullptr) {
+			std::atomic<size_t> total(0);
+			pool->parallelFor(end - begin, UPDATE_BATCH, [&](size_t first, size_t last) {
+				total += updateRange(begin + first, begin + last);
+			});
+			recomputed = total;
+		}
+		else {
+			recomputed = updateRange(begin, end);
+		}
+		stats.recomputed += recomputed;
+		stats.levelsVisited++;
+		parentLevelChanged = recomputed > 0;
+		visited.push_back(level);
+	}
+
+	for (uint32_t level : visited) {
+		std::fill(dirty.begin() + levelStarts[level], dirty.begin() + levelStarts[level + 1], 0);
+		levelDirty[level] = 0;
+	}
+	return stats;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_aligned.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ThreadPool.h"
+
+typedef uint32_t SceneNode; //stable handle, nodes move around inside the graph when it is re-sorted
+
+/*
+	what the last SceneGraph::update did
+*/
+struct SceneUpdateStats {
+	size_t recomputed = 0; //world matrices written
+	uint32_t levelsVisited = 0; //levels that had at least one dirty node or a dirty parent level
+	bool resorted = false; //nodes were added since the previous update
+};
+
+/*
+	Data oriented scene graph
+
+	Nodes are stored as parallel arrays (local translation / rotation / scale, parent index, world matrix, dirty flag) in
+	breadth first order, so every level of the hierarchy is one contiguous range and every parent sits in an earlier
+	level than its children, with siblings next to each other. update walks the levels from the roots down and splits each
+	level across the thread pool: within a level no node depends on another, and the level above is already finished.
+
+	Changing a node's local transform marks it dirty, a node is recomputed when it or its parent is dirty, and levels
+	with no dirty node under a clean level are skipped without being touched, so a static scene costs nothing to update
+	and a moving subtree costs only its own size. World matrices are 16 byte aligned and multiplied with glm's SSE
+	matrix product where the build enables it (GLM_FORCE_INTRINSICS), the plain glm product otherwise.
+
+	Nodes added since the last update are sorted into place by the next one.
+*/
+class SceneGraph
+{
+public:
+	static const SceneNode NO_PARENT = 0xFFFFFFFF;
+
+	SceneNode createNode(SceneNode parent, const glm::vec3& translation = glm::vec3(0.0f),
+		const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+	void reserve(size_t nodes);
+
+	void setTranslation(SceneNode node, const glm::vec3& translation);
+	void setRotation(SceneNode node, const glm::quat& rotation);
+	void setScale(SceneNode node, const glm::vec3& scale);
+	glm::vec3 translation(SceneNode node) const { return translations[indexOf[node]]; }
+	glm::quat rotation(SceneNode node) const { return rotations[indexOf[node]]; }
+	glm::vec3 scale(SceneNode node) const { return scales[indexOf[node]]; }
+	SceneNode parent(SceneNode node) const;
+
+	/*
+		world matrix as of the last update
+	*/
+	glm::mat4 worldMatrix(SceneNode node) const { return glm::mat4(worlds[indexOf[node]]); }
+
+	/*
+		recompute the world matrices of every dirty node and its descendants, on the pool when one is given
+	*/
+	SceneUpdateStats update(ThreadPool* pool = nullptr);
+
+	size_t nodeCount() const { return parents.size(); }
+	size_t levelCount() const { return levelStarts.empty() ? 0 : levelStarts.size() - 1; }
+
+private:
+	void markDirty(uint32_t index);
+	void sortByDepth();
+	size_t updateRange(size_t begin, size_t end);
+
+	//per node in sorted order
+	std::vector<glm::vec3> translations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+	std::vector<uint32_t> parents; //sorted index of the parent, NO_PARENT for roots
+	std::vector<uint32_t> depths;
+	std::vector<glm::aligned_mat4> worlds;
+	std::vector<uint8_t> dirty; //bytes rather than bits so threads can write neighbours without racing
+
+	std::vector<uint32_t> levelStarts; //level l is [levelStarts[l], levelStarts[l + 1])
+	std::vector<uint8_t> levelDirty; //a node of the level was changed directly
+
+	std::vector<uint32_t> indexOf; //handle to sorted index
+	std::vector<SceneNode> handleOf; //sorted index to handle
+	bool unsorted = false; //nodes were added since the last sort
+};
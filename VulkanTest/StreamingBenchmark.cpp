@@ -0,0 +1,222 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "StreamingBenchmark.h"
+#include "FrameTimer.h"
+#include "DeviceMemoryTracker.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	/*
+		stands in for a texture file: a coloured checker board with cells of 32 texels at level 0, every level generated on
+		request at roughly the cost of decoding it
+	*/
+	class ProceduralTexture : public TextureSource
+	{
+	public:
+		ProceduralTexture(uint32_t size, uint32_t seed) : size(size), seed(seed) {}
+
+		VkExtent2D extent() const override { return { size, size }; }
+
+		void loadLevel(uint32_t level, uint8_t* texels) override
+		{
+			uint32_t levelSize = std::max(size >> level, 1u);
+			uint32_t cell = std::max(32u >> level, 1u);
+			uint8_t r = static_cast<uint8_t>(seed * 67), g = static_cast<uint8_t>(seed * 131), b = static_cast<uint8_t>(seed * 197);
+			for (uint32_t y = 0; y < levelSize; y++) {
+				for (uint32_t x = 0; x < levelSize; x++) {
+					bool dark = ((x / cell) + (y / cell)) & 1;
+					texels[0] = dark ? r / 2 : r;
+					texels[1] = dark ? g / 2 : g;
+					texels[2] = dark ? b / 2 : b;
+					texels[3] = 255;
+					texels += 4;
+				}
+			}
+		}
+
+	private:
+		uint32_t size;
+		uint32_t seed;
+	};
+
+	const float TILE_SPACING = 1.25f; //tiles are 1 unit wide with a gap between them
+	const float CAMERA_HEIGHT = 0.75f;
+	const float FIELD_OF_VIEW = glm::radians(60.0f);
+	const float VIEWPORT_HEIGHT = 1080.0f; //pixels, for the screen size of a tile
+	const float FAR_DISTANCE = 24.0f; //tiles further away are treated as not visible
+}
+
+StreamingBenchmark::StreamingBenchmark(const StreamingBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void StreamingBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("StreamingBenchmark");
+	createDevice();
+	try {
+		uint32_t streamedCount = settings.textures;
+		bindless.init(context.device, context.physicalDevice, streamedCount * 4 + 16); //a texture holds a second slot while its old one is retired
+		streamer.init(context.device, context.physicalDevice, &bindless, &deletionQueue, settings.streaming, memoryBudgetExtension);
+		gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(streamedCount))));
+		for (uint32_t i = 0; i < streamedCount; i++) {
+			textures.push_back(streamer.addTexture(std::make_shared<ProceduralTexture>(settings.textureSize, i + 1)));
+		}
+		createFrameResources();
+
+		std::cout << "streaming benchmark: " << context.properties.deviceName << ", " << streamedCount << " textures of "
+			<< settings.textureSize << "x" << settings.textureSize << ", budget " << (settings.streaming.budget >> 20) << " MB"
+			<< (memoryBudgetExtension ? " (capped by VK_EXT_memory_budget)" : "") << ", " << settings.frames << " frames" << std::endl;
+
+		VkDevice device = context.device;
+		std::vector<double> updateTimes;
+		updateTimes.reserve(settings.frames);
+		uint32_t framesOverBudget = 0, framesAtFullQuality = 0;
+		VkDeviceSize peakResident = 0;
+		StreamingStats last = streamer.stats();
+		auto start = std::chrono::steady_clock::now();
+		auto intervalStart = start;
+		size_t frame = 0;
+		for (uint32_t i = 0; i < settings.frames; i++) {
+			vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+			frameTimer.beginFrame(frame);
+			completedFrames = std::max(completedFrames, frameSerials[frame]);
+			deletionQueue.collect(completedFrames);
+
+			updateDemand(i);
+
+			vkResetCommandBuffer(commandBuffers[frame], 0);
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(commandBuffers[frame], &beginInfo);
+			frameSerials[frame] = ++submittedFrames;
+			auto updateStart = std::chrono::steady_clock::now();
+			streamer.update(commandBuffers[frame], frameSerials[frame], completedFrames);
+			updateTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count());
+			if (vkEndCommandBuffer(commandBuffers[frame]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to record command buffer!");
+			}
+
+			context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+			frame = (frame + 1) % FRAMES_IN_FLIGHT;
+
+			StreamingStats stats = streamer.stats();
+			peakResident = std::max(peakResident, stats.residentBytes);
+			framesOverBudget += stats.residentBytes > stats.budget;
+			framesAtFullQuality += stats.texturesAtDesiredQuality == stats.textureCount;
+			if (settings.reportInterval != 0 && (i + 1) % settings.reportInterval == 0) {
+				auto now = std::chrono::steady_clock::now();
+				double seconds = std::chrono::duration<double>(now - intervalStart).count();
+				std::cout << "  frame " << (i + 1) << ": resident " << (stats.residentBytes >> 20) << "/" << (stats.budget >> 20) << " MB, "
+					<< stats.texturesAtDesiredQuality << "/" << stats.textureCount << " at desired quality, "
+					<< stats.missingLevels << " levels missing, " << (stats.promotions - last.promotions) << " promotions, "
+					<< (stats.evictions - last.evictions) << " evictions, "
+					<< (stats.uploadedBytes - last.uploadedBytes) / (1024.0 * 1024.0) / seconds << " MB/s uploaded" << std::endl;
+				last = stats;
+				intervalStart = now;
+			}
+		}
+		vkDeviceWaitIdle(device);
+		frameTimer.flush();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		StreamingStats stats = streamer.stats();
+		std::cout << "  cpu update  " << TimingSummary::fromSamples(updateTimes) << std::endl;
+		if (frameTimer.hasGpuTiming()) {
+			std::cout << "  gpu uploads " << frameTimer.gpuSummary() << std::endl;
+		}
+		std::cout << "  uploaded " << (stats.uploadedBytes >> 20) << " MB in " << stats.loadsCompleted << " loads ("
+			<< stats.uploadedBytes / (1024.0 * 1024.0) / seconds << " MB/s), " << stats.loadsDiscarded << " discarded" << std::endl;
+		std::cout << "  " << stats.promotions << " promotions, " << stats.evictions << " evictions, peak resident "
+			<< (peakResident >> 20) << " MB" << std::endl;
+		std::cout << "  " << framesAtFullQuality << "/" << settings.frames << " frames with every texture at its desired quality, "
+			<< framesOverBudget << " frames over budget" << std::endl;
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+/*
+	Vulkan 1.2 for descriptor indexing in core, VK_EXT_memory_budget when the device has it
+*/
+void StreamingBenchmark::createDevice()
+{
+	context.createInstance("Streaming Benchmark", VK_API_VERSION_1_2);
+
+	VkPhysicalDeviceDescriptorIndexingFeatures indexing = {};
+	indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	VkPhysicalDeviceFeatures2 supported = {};
+	supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supported.pNext = &indexing;
+	vkGetPhysicalDeviceFeatures2(context.physicalDevice, &supported);
+	if (!BindlessTextures::supported(indexing)) {
+		throw std::runtime_error("failed to run streaming benchmark, descriptor indexing is not supported!");
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeatures enabledIndexing = {};
+	enabledIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	BindlessTextures::enableFeatures(enabledIndexing);
+	VkPhysicalDeviceFeatures2 enabled = {};
+	enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	enabled.pNext = &enabledIndexing;
+
+	std::vector<const char*> extensions;
+	memoryBudgetExtension = context.supportsExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (memoryBudgetExtension) {
+		extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+	context.createDevice(extensions, &enabled);
+}
+
+void StreamingBenchmark::createFrameResources()
+{
+	context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+	frameSerials.assign(FRAMES_IN_FLIGHT, 0);
+}
+
+/*
+	the camera goes twice round a figure of eight over the grid looking ahead and slightly down, a tile in view covers
+	roughly focal length / distance pixels
+*/
+void StreamingBenchmark::updateDemand(uint32_t frame)
+{
+	float extent = gridSize * TILE_SPACING;
+	float t = 4.0f * glm::pi<float>() * frame / std::max(settings.frames, 1u);
+	glm::vec2 centre(extent * 0.5f);
+	glm::vec2 position = centre + glm::vec2(std::sin(t), std::sin(2.0f * t) * 0.5f) * extent * 0.4f;
+	glm::vec2 velocity = glm::vec2(std::cos(t), std::cos(2.0f * t)) * extent * 0.4f;
+	glm::vec3 eye(position, CAMERA_HEIGHT);
+	glm::vec3 forward = glm::normalize(glm::vec3(glm::normalize(velocity), -0.35f));
+
+	float focalLength = VIEWPORT_HEIGHT * 0.5f / std::tan(FIELD_OF_VIEW * 0.5f);
+	float cosHalfView = std::cos(FIELD_OF_VIEW * 0.75f); //a little wider than the view so tiles at the edges count
+	for (uint32_t i = 0; i < textures.size(); i++) {
+		glm::vec3 tile((i % gridSize + 0.5f) * TILE_SPACING, (i / gridSize + 0.5f) * TILE_SPACING, 0.0f);
+		glm::vec3 toTile = tile - eye;
+		float distance = glm::length(toTile);
+		bool visible = distance < FAR_DISTANCE && glm::dot(toTile / distance, forward) > cosHalfView;
+		streamer.setDemand(textures[i], visible ? focalLength / distance : 0.0f);
+	}
+}
+
+void StreamingBenchmark::cleanup()
+{
+	if (context.device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		deletionQueue.flush(); //retired textures give their slots back to the table, so before the table goes
+		streamer.cleanup();
+		bindless.cleanup();
+	}
+	context.cleanup(); //the command buffers go with the pool
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "BindlessTextures.h"
+#include "DeletionQueue.h"
+#include "TextureStreamer.h"
+
+/*
+	settings for the texture streaming benchmark, filled in from the command line
+*/
+struct StreamingBenchmarkSettings {
+	bool enabled = false;
+	uint32_t textures = 64; //laid out on a square grid of tiles
+	uint32_t textureSize = 2048; //width and height of level 0
+	uint32_t frames = 1200;
+	uint32_t reportInterval = 100; //print the streamer state every this many frames, 0 for the summary only
+	StreamingSettings streaming;
+};
+
+/*
+	Texture streaming benchmark
+
+	A camera flies a fixed path low over a grid of large procedurally generated textures. Every frame the screen size of each
+	tile is computed from its distance and whether it is in view, handed to the TextureStreamer as demand, and the streamer's
+	uploads are submitted. Nothing is drawn: the benchmark measures how quickly the resident set follows the camera, how well
+	it stays within the budget and what the per frame streaming work costs on the CPU.
+*/
+class StreamingBenchmark
+{
+public:
+	explicit StreamingBenchmark(const StreamingBenchmarkSettings& settings);
+	void run();
+
+private:
+	void createDevice();
+	void createFrameResources();
+	void updateDemand(uint32_t frame);
+	void cleanup();
+
+	StreamingBenchmarkSettings settings;
+	HeadlessDevice context;
+	bool memoryBudgetExtension = false;
+
+	BindlessTextures bindless;
+	DeletionQueue deletionQueue;
+	TextureStreamer streamer;
+	std::vector<uint32_t> textures;
+	uint32_t gridSize = 0; //tiles per side
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer; //GPU time of each frame's uploads
+	std::vector<uint64_t> frameSerials; //serial of the submission last made with each frame's fence
+	uint64_t submittedFrames = 0;
+	uint64_t completedFrames = 0;
+};
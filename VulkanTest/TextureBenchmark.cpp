@@ -0,0 +1,297 @@
+#include "TextureBenchmark.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+	/*
+		stands in for a decoded texture file: smooth colour gradients with a few hard edges so both filtering and block
+		compression have something to do
+	*/
+	TextureData generateTexture(uint32_t size, uint32_t seed)
+	{
+		TextureData texture;
+		texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+		texture.extent = { size, size };
+		texture.levels.emplace_back(static_cast<size_t>(size) * size * 4);
+		uint8_t* texels = texture.levels[0].data();
+		for (uint32_t y = 0; y < size; y++) {
+			for (uint32_t x = 0; x < size; x++) {
+				bool stripe = ((x + y * seed) / 97) & 1;
+				texels[0] = static_cast<uint8_t>(x * 255 / size);
+				texels[1] = static_cast<uint8_t>(y * 255 / size);
+				texels[2] = stripe ? static_cast<uint8_t>(seed * 53) : 0;
+				texels[3] = 255;
+				texels += 4;
+			}
+		}
+		return texture;
+	}
+
+	uint16_t pack565(const uint8_t* rgb)
+	{
+		return static_cast<uint16_t>((rgb[0] * 31 + 127) / 255 << 11 | (rgb[1] * 63 + 127) / 255 << 5 | (rgb[2] * 31 + 127) / 255);
+	}
+
+	/*
+		quick BC1 encoder: the darkest and brightest texels of each block are the endpoints and every texel takes the closest
+		of the four palette entries, good enough to stand in for the output of a texture tool
+	*/
+	std::vector<uint8_t> encodeBC1(const std::vector<uint8_t>& texels, VkExtent2D extent)
+	{
+		uint32_t blocksWide = (extent.width + 3) / 4, blocksHigh = (extent.height + 3) / 4;
+		std::vector<uint8_t> blocks(static_cast<size_t>(blocksWide) * blocksHigh * 8);
+		for (uint32_t by = 0; by < blocksHigh; by++) {
+			for (uint32_t bx = 0; bx < blocksWide; bx++) {
+				const uint8_t* block[16];
+				for (uint32_t i = 0; i < 16; i++) {
+					uint32_t x = std::min(bx * 4 + i % 4, extent.width - 1), y = std::min(by * 4 + i / 4, extent.height - 1);
+					block[i] = &texels[(static_cast<size_t>(y) * extent.width + x) * 4];
+				}
+				auto luminance = [](const uint8_t* texel) { return texel[0] * 2 + texel[1] * 5 + texel[2]; };
+				const uint8_t* brightest = block[0];
+				const uint8_t* darkest = block[0];
+				for (auto texel : block) {
+					if (luminance(texel) > luminance(brightest)) brightest = texel;
+					if (luminance(texel) < luminance(darkest)) darkest = texel;
+				}
+				uint16_t c0 = pack565(brightest), c1 = pack565(darkest);
+				if (c0 < c1) {
+					std::swap(c0, c1);
+				}
+
+				uint32_t indices = 0;
+				if (c0 != c1) { //equal endpoints leave every index at 0
+					int palette[4][3];
+					for (int channel = 0; channel < 3; channel++) {
+						int shift = channel == 0 ? 11 : (channel == 1 ? 5 : 0), bits = channel == 1 ? 63 : 31;
+						palette[0][channel] = ((c0 >> shift) & bits) * 255 / bits;
+						palette[1][channel] = ((c1 >> shift) & bits) * 255 / bits;
+						palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+						palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+					}
+					for (uint32_t i = 0; i < 16; i++) {
+						int best = 0, bestDistance = INT32_MAX;
+						for (int entry = 0; entry < 4; entry++) {
+							int distance = 0;
+							for (int channel = 0; channel < 3; channel++) {
+								int difference = block[i][channel] - palette[entry][channel];
+								distance += difference * difference;
+							}
+							if (distance < bestDistance) {
+								best = entry;
+								bestDistance = distance;
+							}
+						}
+						indices |= static_cast<uint32_t>(best) << (2 * i);
+					}
+				}
+
+				uint8_t* out = &blocks[(static_cast<size_t>(by) * blocksWide + bx) * 8];
+				out[0] = static_cast<uint8_t>(c0);
+				out[1] = static_cast<uint8_t>(c0 >> 8);
+				out[2] = static_cast<uint8_t>(c1);
+				out[3] = static_cast<uint8_t>(c1 >> 8);
+				std::memcpy(out + 4, &indices, 4);
+			}
+		}
+		return blocks;
+	}
+
+	/*
+		the BC1 version of a generated texture with every level filtered with the same 2x2 box filter as the loader's CPU path
+	*/
+	TextureData compressTexture(const TextureData& source)
+	{
+		TextureData compressed;
+		compressed.format = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		compressed.extent = source.extent;
+		std::vector<uint8_t> level = source.levels[0];
+		VkExtent2D extent = source.extent;
+		while (true) {
+			compressed.levels.push_back(encodeBC1(level, extent));
+			if (extent.width == 1 && extent.height == 1) {
+				break;
+			}
+			VkExtent2D half = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+			std::vector<uint8_t> next(static_cast<size_t>(half.width) * half.height * 4);
+			for (uint32_t y = 0; y < half.height; y++) {
+				for (uint32_t x = 0; x < half.width; x++) {
+					for (uint32_t channel = 0; channel < 4; channel++) {
+						uint32_t x1 = std::min(x * 2 + 1, extent.width - 1), y1 = std::min(y * 2 + 1, extent.height - 1);
+						uint32_t sum = level[(static_cast<size_t>(y * 2) * extent.width + x * 2) * 4 + channel] + level[(static_cast<size_t>(y * 2) * extent.width + x1) * 4 + channel]
+							+ level[(static_cast<size_t>(y1) * extent.width + x * 2) * 4 + channel] + level[(static_cast<size_t>(y1) * extent.width + x1) * 4 + channel];
+						next[(static_cast<size_t>(y) * half.width + x) * 4 + channel] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+			level.swap(next);
+			extent = half;
+		}
+		return compressed;
+	}
+
+	const char* mipDescription(const LoadedTexture& texture, MipGeneration mips)
+	{
+		if (texture.decompressed) {
+			return "decompressed on the host, the device cannot sample the format";
+		}
+		if (compressedBlockSize(texture.format) != 0) {
+			return "compressed, uploaded as stored";
+		}
+		return mips == MipGeneration::Gpu ? "mips blitted on the GPU (or filtered on the CPU without linear blit support)" : "mips filtered on the CPU";
+	}
+}
+
+TextureBenchmark::TextureBenchmark(const TextureBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void TextureBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("TextureBenchmark");
+	if (settings.count == 0 || settings.size == 0) {
+		throw std::runtime_error("texture benchmark needs at least one texture of at least one texel!");
+	}
+	createDevice();
+	try {
+		loader.init(context.device, context.physicalDevice, context.queue, context.commandPool);
+
+		//the sources stand in for files that have already been read and decoded, producing them is not timed
+		std::vector<TextureData> sources, compressedSources;
+		for (uint32_t i = 0; i < settings.count; i++) {
+			sources.push_back(generateTexture(settings.size, i + 1));
+			compressedSources.push_back(compressTexture(sources.back()));
+		}
+
+		std::cout << "texture benchmark: " << context.properties.deviceName << ", " << settings.count << " textures of "
+			<< settings.size << "x" << settings.size << std::endl;
+		runPath("rgba8, cpu mips", sources, MipGeneration::Cpu, cpuMipTextures);
+		runPath("rgba8, gpu mips", sources, MipGeneration::Gpu, gpuMipTextures);
+		runPath("bc1, stored mips", compressedSources, MipGeneration::None, compressedTextures);
+
+		//the blit's linear filter halving a level is a 2x2 box filter, only the rounding may differ
+		uint32_t checkedLevels = std::min(4u, gpuMipTextures[0].mipLevels);
+		int largestDifference = 0;
+		for (uint32_t level = 1; level < checkedLevels; level++) {
+			std::vector<uint8_t> cpu = readLevel(cpuMipTextures[0], level);
+			std::vector<uint8_t> gpu = readLevel(gpuMipTextures[0], level);
+			for (size_t i = 0; i < cpu.size(); i++) {
+				largestDifference = std::max(largestDifference, std::abs(cpu[i] - gpu[i]));
+			}
+		}
+		std::cout << "  gpu and cpu mip levels 1-" << (checkedLevels - 1) << " differ by at most " << largestDifference << std::endl;
+		if (largestDifference > 8) {
+			throw std::runtime_error("texture benchmark failed, the GPU generated mip levels do not match the CPU filtered ones!");
+		}
+
+		if (!settings.file.empty()) {
+			auto start = std::chrono::steady_clock::now();
+			TextureData data = loadTexture(settings.file);
+			auto read = std::chrono::steady_clock::now();
+			LoadedTexture texture = loader.load(data);
+			loader.flush();
+			auto done = std::chrono::steady_clock::now();
+			std::cout << "  " << settings.file << ": " << texture.extent.width << "x" << texture.extent.height << ", "
+				<< texture.mipLevels << " levels, " << mipDescription(texture, MipGeneration::Gpu) << ", read "
+				<< std::chrono::duration<double, std::milli>(read - start).count() << " ms, upload "
+				<< std::chrono::duration<double, std::milli>(done - read).count() << " ms, "
+				<< texture.memoryBytes / (1024.0 * 1024.0) << " MB of device memory" << std::endl;
+			loader.destroy(texture);
+		}
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+/*
+	BC and ETC2 are optional device features, they are turned on when present so the loader can use them
+*/
+void TextureBenchmark::createDevice()
+{
+	context.createInstance("Texture Benchmark", VK_API_VERSION_1_0);
+	VkPhysicalDeviceFeatures supported;
+	vkGetPhysicalDeviceFeatures(context.physicalDevice, &supported);
+	VkPhysicalDeviceFeatures enabled = {};
+	enabled.textureCompressionBC = supported.textureCompressionBC;
+	enabled.textureCompressionETC2 = supported.textureCompressionETC2;
+	context.createDevice({}, nullptr, &enabled);
+}
+
+void TextureBenchmark::runPath(const char* name, const std::vector<TextureData>& sources, MipGeneration mips, std::vector<LoadedTexture>& textures)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (const auto& source : sources) {
+		textures.push_back(loader.load(source, mips));
+	}
+	auto recorded = std::chrono::steady_clock::now();
+	loader.flush();
+	auto done = std::chrono::steady_clock::now();
+
+	VkDeviceSize uploaded = 0, memory = 0;
+	for (const auto& texture : textures) {
+		uploaded += texture.uploadedBytes;
+		memory += texture.memoryBytes;
+	}
+	double cpuTime = std::chrono::duration<double, std::milli>(recorded - start).count();
+	double totalTime = std::chrono::duration<double, std::milli>(done - start).count();
+	std::cout << "  " << name << ": " << mipDescription(textures[0], mips) << std::endl;
+	std::cout << "    cpu " << cpuTime << " ms, until resident " << totalTime << " ms (" << totalTime / textures.size() << " ms per texture), "
+		<< uploaded / (1024.0 * 1024.0) << " MB uploaded, " << memory / (1024.0 * 1024.0) << " MB device memory" << std::endl;
+}
+
+/*
+	copy one mip level of an RGBA8 texture back to the host, the texture is left in SHADER_READ_ONLY_OPTIMAL
+*/
+std::vector<uint8_t> TextureBenchmark::readLevel(const LoadedTexture& texture, uint32_t level)
+{
+	VkExtent2D extent = { std::max(texture.extent.width >> level, 1u), std::max(texture.extent.height >> level, 1u) };
+	VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+	VkBuffer readback;
+	VkDeviceMemory readbackMemory;
+	createBuffer(context.device, context.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, readback, readbackMemory);
+
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	imageBarrier(commandBuffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, level, 1);
+	VkBufferImageCopy region = {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback, 1, &region);
+	imageBarrier(commandBuffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, level, 1);
+	context.endSingleTimeCommands(commandBuffer);
+
+	std::vector<uint8_t> texels(static_cast<size_t>(size));
+	void* data;
+	vkMapMemory(context.device, readbackMemory, 0, size, 0, &data);
+	std::memcpy(texels.data(), data, texels.size());
+	vkUnmapMemory(context.device, readbackMemory);
+	vkDestroyBuffer(context.device, readback, nullptr);
+	freeDeviceMemory(context.device, readbackMemory, nullptr);
+	return texels;
+}
+
+void TextureBenchmark::cleanup()
+{
+	if (context.device != VK_NULL_HANDLE) {
+		vkDeviceWaitIdle(context.device);
+		for (auto* textures : { &cpuMipTextures, &gpuMipTextures, &compressedTextures }) {
+			for (auto& texture : *textures) {
+				loader.destroy(texture);
+			}
+			textures->clear();
+		}
+		loader.cleanup();
+	}
+	context.cleanup();
+}
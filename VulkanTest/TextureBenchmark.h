@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "TextureLoader.h"
+
+/*
+	settings for the texture loading benchmark, filled in from the command line
+*/
+struct TextureBenchmarkSettings {
+	bool enabled = false;
+	uint32_t size = 2048; //width and height of the generated textures
+	uint32_t count = 16; //textures loaded per path
+	std::string file; //also load this texture file (.ktx, .dds, .ppm) and report how it was uploaded
+};
+
+/*
+	Texture loading benchmark
+
+	Loads the same generated textures three ways and reports CPU time, time until the upload has completed, bytes moved
+	through staging and device memory taken:
+	- RGBA8 with the mip chain filtered on the CPU and every level uploaded
+	- RGBA8 with only level 0 uploaded and the chain blitted on the GPU
+	- BC1 with every level pre-encoded (as an offline texture tool would) and copied as is
+	and checks that the GPU generated levels match the CPU filtered ones.
+*/
+class TextureBenchmark
+{
+public:
+	explicit TextureBenchmark(const TextureBenchmarkSettings& settings);
+	void run();
+
+private:
+	void createDevice();
+	void runPath(const char* name, const std::vector<TextureData>& sources, MipGeneration mips, std::vector<LoadedTexture>& textures);
+	std::vector<uint8_t> readLevel(const LoadedTexture& texture, uint32_t level);
+	void cleanup();
+
+	TextureBenchmarkSettings settings;
+	HeadlessDevice context;
+	TextureLoader loader;
+	std::vector<LoadedTexture> cpuMipTextures;
+	std::vector<LoadedTexture> gpuMipTextures;
+	std::vector<LoadedTexture> compressedTextures;
+};
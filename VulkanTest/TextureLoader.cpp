@@ -0,0 +1,377 @@
+#include "TextureLoader.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <deque>
+
+namespace {
+	//5:6:5 endpoint to 8 bit RGB
+	void unpack565(uint16_t colour, uint8_t* rgb)
+	{
+		rgb[0] = static_cast<uint8_t>(((colour >> 11) & 31) * 255 / 31);
+		rgb[1] = static_cast<uint8_t>(((colour >> 5) & 63) * 255 / 63);
+		rgb[2] = static_cast<uint8_t>((colour & 31) * 255 / 31);
+	}
+
+	/*
+		colour part of a BC1 / BC2 / BC3 block, BC1 blocks with c0 <= c1 use three colours and transparent black
+	*/
+	void decodeColourBlock(const uint8_t* block, uint8_t texels[16][4], bool bc1)
+	{
+		uint16_t c0 = static_cast<uint16_t>(block[0] | block[1] << 8);
+		uint16_t c1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+		uint8_t palette[4][4];
+		unpack565(c0, palette[0]);
+		unpack565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+		for (int channel = 0; channel < 3; channel++) {
+			if (!bc1 || c0 > c1) {
+				palette[2][channel] = static_cast<uint8_t>((2 * palette[0][channel] + palette[1][channel]) / 3);
+				palette[3][channel] = static_cast<uint8_t>((palette[0][channel] + 2 * palette[1][channel]) / 3);
+			}
+			else {
+				palette[2][channel] = static_cast<uint8_t>((palette[0][channel] + palette[1][channel]) / 2);
+				palette[3][channel] = 0;
+			}
+		}
+		if (bc1 && c0 <= c1) {
+			palette[3][3] = 0;
+		}
+		uint32_t indices = static_cast<uint32_t>(block[4] | block[5] << 8 | block[6] << 16 | block[7] << 24);
+		for (int i = 0; i < 16; i++) {
+			std::memcpy(texels[i], palette[(indices >> (2 * i)) & 3], 4);
+		}
+	}
+
+	/*
+		BC3 alpha: two endpoints and 3 bit indices into 8 interpolated values (6 plus 0 and 255 when a0 <= a1)
+	*/
+	void decodeAlphaBlock(const uint8_t* block, uint8_t texels[16][4])
+	{
+		uint8_t alpha[8] = { block[0], block[1] };
+		for (int i = 2; i < 8; i++) {
+			alpha[i] = block[0] > block[1]
+				? static_cast<uint8_t>(((8 - i) * block[0] + (i - 1) * block[1]) / 7)
+				: (i < 6 ? static_cast<uint8_t>(((6 - i) * block[0] + (i - 1) * block[1]) / 5) : (i == 6 ? 0 : 255));
+		}
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++) {
+			indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+		}
+		for (int i = 0; i < 16; i++) {
+			texels[i][3] = alpha[(indices >> (3 * i)) & 7];
+		}
+	}
+
+	bool hostDecodable(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK: case VK_FORMAT_BC1_RGB_SRGB_BLOCK: case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC2_UNORM_BLOCK: case VK_FORMAT_BC2_SRGB_BLOCK: case VK_FORMAT_BC3_UNORM_BLOCK: case VK_FORMAT_BC3_SRGB_BLOCK:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool srgbFormat(VkFormat format)
+	{
+		return format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK || format == VK_FORMAT_BC2_SRGB_BLOCK
+			|| format == VK_FORMAT_BC3_SRGB_BLOCK;
+	}
+
+	/*
+		BC1 / BC2 / BC3 level to RGBA8, blocks hanging over the edge of the level are clipped
+	*/
+	std::vector<uint8_t> decompressLevel(VkFormat format, VkExtent2D extent, const std::vector<uint8_t>& blocks)
+	{
+		std::vector<uint8_t> texels(static_cast<size_t>(extent.width) * extent.height * 4);
+		uint32_t blockSize = compressedBlockSize(format);
+		bool bc1 = blockSize == 8;
+		bool bc2 = format == VK_FORMAT_BC2_UNORM_BLOCK || format == VK_FORMAT_BC2_SRGB_BLOCK;
+		bool opaque = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK; //the punch through texel is black, not transparent
+		uint32_t blocksWide = (extent.width + 3) / 4;
+		for (uint32_t by = 0; by < (extent.height + 3) / 4; by++) {
+			for (uint32_t bx = 0; bx < blocksWide; bx++) {
+				const uint8_t* block = blocks.data() + (static_cast<size_t>(by) * blocksWide + bx) * blockSize;
+				uint8_t decoded[16][4];
+				decodeColourBlock(bc1 ? block : block + 8, decoded, bc1);
+				if (bc2) {
+					for (int i = 0; i < 16; i++) {
+						decoded[i][3] = static_cast<uint8_t>(((block[i / 2] >> (4 * (i & 1))) & 15) * 17); //explicit 4 bit alpha
+					}
+				}
+				else if (!bc1) {
+					decodeAlphaBlock(block, decoded);
+				}
+				else if (opaque) {
+					for (int i = 0; i < 16; i++) {
+						decoded[i][3] = 255;
+					}
+				}
+				for (uint32_t y = 0; y < 4 && by * 4 + y < extent.height; y++) {
+					for (uint32_t x = 0; x < 4 && bx * 4 + x < extent.width; x++) {
+						std::memcpy(&texels[((static_cast<size_t>(by) * 4 + y) * extent.width + bx * 4 + x) * 4], decoded[y * 4 + x], 4);
+					}
+				}
+			}
+		}
+		return texels;
+	}
+
+	/*
+		next mip level with a 2x2 box filter, odd sizes repeat the last row or column
+	*/
+	std::vector<uint8_t> downsample(const std::vector<uint8_t>& texels, VkExtent2D extent)
+	{
+		VkExtent2D half = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+		std::vector<uint8_t> result(static_cast<size_t>(half.width) * half.height * 4);
+		for (uint32_t y = 0; y < half.height; y++) {
+			uint32_t y0 = std::min(y * 2, extent.height - 1), y1 = std::min(y * 2 + 1, extent.height - 1);
+			for (uint32_t x = 0; x < half.width; x++) {
+				uint32_t x0 = std::min(x * 2, extent.width - 1), x1 = std::min(x * 2 + 1, extent.width - 1);
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					uint32_t sum = texels[(static_cast<size_t>(y0) * extent.width + x0) * 4 + channel] + texels[(static_cast<size_t>(y0) * extent.width + x1) * 4 + channel]
+						+ texels[(static_cast<size_t>(y1) * extent.width + x0) * 4 + channel] + texels[(static_cast<size_t>(y1) * extent.width + x1) * 4 + channel];
+					result[(static_cast<size_t>(y) * half.width + x) * 4 + channel] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	VkExtent2D levelExtent(VkExtent2D extent, uint32_t level)
+	{
+		return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+	}
+}
+
+void TextureLoader::init(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool)
+{
+	this->device = device;
+	this->physicalDevice = physicalDevice;
+	this->queue = queue;
+	this->commandPool = commandPool;
+}
+
+void TextureLoader::cleanup()
+{
+	flush();
+	device = VK_NULL_HANDLE;
+}
+
+bool TextureLoader::formatSupported(VkFormat format) const
+{
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+	return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+bool TextureLoader::canBlit(VkFormat format) const
+{
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+	VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (properties.optimalTilingFeatures & needed) == needed;
+}
+
+LoadedTexture TextureLoader::load(const TextureData& data, MipGeneration mips)
+{
+	if (data.levels.empty()) {
+		throw std::runtime_error("failed to load texture, it has no texels!");
+	}
+
+	LoadedTexture texture;
+	texture.format = data.format;
+	texture.extent = data.extent;
+	std::vector<const std::vector<uint8_t>*> levels; //what gets uploaded
+	for (const auto& level : data.levels) {
+		levels.push_back(&level);
+	}
+	std::deque<std::vector<uint8_t>> hostLevels; //levels produced here rather than taken from data, a deque so levels keeps pointing at them
+
+	bool compressed = compressedBlockSize(data.format) != 0;
+	if (compressed && !formatSupported(data.format)) {
+		if (!hostDecodable(data.format)) {
+			throw std::runtime_error("failed to load texture, the device cannot sample its compressed format!");
+		}
+		for (uint32_t level = 0; level < data.levels.size(); level++) {
+			hostLevels.push_back(decompressLevel(data.format, levelExtent(data.extent, level), data.levels[level]));
+			levels[level] = &hostLevels.back();
+		}
+		texture.format = srgbFormat(data.format) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+		texture.decompressed = true;
+		compressed = false;
+	}
+	else if (!formatSupported(data.format)) {
+		throw std::runtime_error("failed to load texture, the device cannot sample its format!");
+	}
+
+	//compressed textures can only have the levels they were stored with, blits cannot write block compressed images
+	uint32_t fullChain = static_cast<uint32_t>(std::floor(std::log2(std::max(data.extent.width, data.extent.height)))) + 1;
+	bool gpuMips = false;
+	texture.mipLevels = static_cast<uint32_t>(levels.size());
+	if (levels.size() == 1 && !compressed && mips != MipGeneration::None && fullChain > 1) {
+		texture.mipLevels = fullChain;
+		gpuMips = mips == MipGeneration::Gpu && canBlit(texture.format);
+		if (!gpuMips) {
+			for (uint32_t level = 1; level < fullChain; level++) {
+				hostLevels.push_back(downsample(*levels.back(), levelExtent(data.extent, level - 1)));
+				levels.push_back(&hostLevels.back());
+			}
+		}
+	}
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (gpuMips) {
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //every level but the last is blitted from
+	}
+	{
+		DeviceMemoryScope memoryScope("TextureLoader", "texture " + std::to_string(data.extent.width) + "x" + std::to_string(data.extent.height));
+		createImage(device, physicalDevice, data.extent, texture.format, usage, texture.image, texture.memory, nullptr, texture.mipLevels);
+	}
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, texture.image, &memRequirements);
+	texture.memoryBytes = memRequirements.size;
+
+	VkCommandBuffer commandBuffer = batch();
+	imageBarrier(commandBuffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	upload(commandBuffer, texture.image, texture.format, data.extent, levels, texture.uploadedBytes);
+	if (gpuMips) {
+		generateMips(commandBuffer, texture.image, data.extent, texture.mipLevels);
+	}
+	else {
+		imageBarrier(commandBuffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+
+	texture.view = createImageView(device, texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+	return texture;
+}
+
+/*
+	copy the given levels into a new staging buffer and from there into the image, which must be in TRANSFER_DST_OPTIMAL
+*/
+void TextureLoader::upload(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkExtent2D extent,
+	const std::vector<const std::vector<uint8_t>*>& levels, VkDeviceSize& uploadedBytes)
+{
+	//buffer offsets have to be a multiple of the texel block size, 16 covers every format used here
+	std::vector<VkDeviceSize> offsets;
+	VkDeviceSize size = 0;
+	for (const auto* level : levels) {
+		offsets.push_back(size);
+		size += (level->size() + 15) & ~VkDeviceSize(15);
+	}
+
+	VkBuffer staging;
+	VkDeviceMemory memory;
+	DeviceMemoryScope memoryScope("TextureLoader", "staging");
+	createBuffer(device, physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, memory);
+	stagingBuffers.push_back(staging);
+	stagingMemory.push_back(memory);
+
+	void* data;
+	vkMapMemory(device, memory, 0, size, 0, &data);
+	std::vector<VkBufferImageCopy> regions;
+	for (uint32_t level = 0; level < levels.size(); level++) {
+		std::memcpy(static_cast<uint8_t*>(data) + offsets[level], levels[level]->data(), levels[level]->size());
+
+		VkExtent2D mipExtent = levelExtent(extent, level);
+		VkBufferImageCopy region = {};
+		region.bufferOffset = offsets[level]; //tightly packed, rowLength and imageHeight 0
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		region.imageExtent = { mipExtent.width, mipExtent.height, 1 }; //texels, not blocks, for compressed formats too
+		regions.push_back(region);
+	}
+	vkUnmapMemory(device, memory);
+
+	vkCmdCopyBufferToImage(commandBuffer, staging, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+	uploadedBytes += size;
+}
+
+/*
+	every level is filtered from the one above it: once level i - 1 has been written it becomes the blit source of level i and
+	is then handed over to the fragment shader, the last level only ever receives a blit
+*/
+void TextureLoader::generateMips(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint32_t mipLevels)
+{
+	for (uint32_t level = 1; level < mipLevels; level++) {
+		imageBarrier(commandBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, level - 1, 1);
+
+		VkExtent2D source = levelExtent(extent, level - 1);
+		VkExtent2D destination = levelExtent(extent, level);
+		VkImageBlit blit = {};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+		blit.srcOffsets[1] = { static_cast<int32_t>(source.width), static_cast<int32_t>(source.height), 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		blit.dstOffsets[1] = { static_cast<int32_t>(destination.width), static_cast<int32_t>(destination.height), 1 };
+		vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		imageBarrier(commandBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, level - 1, 1);
+	}
+	imageBarrier(commandBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, mipLevels - 1, 1);
+}
+
+VkCommandBuffer TextureLoader::batch()
+{
+	if (recording) {
+		return commandBuffer;
+	}
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = commandPool;
+	allocInfo.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate texture upload command buffer!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //submitted once by flush, then freed
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	recording = true;
+	return commandBuffer;
+}
+
+void TextureLoader::flush()
+{
+	if (!recording) {
+		return;
+	}
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; //struct type
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit texture uploads!");
+	}
+	vkQueueWaitIdle(queue); //the staging buffers can go once the copies have executed
+
+	vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+	recording = false;
+	for (size_t i = 0; i < stagingBuffers.size(); i++) {
+		vkDestroyBuffer(device, stagingBuffers[i], nullptr);
+		freeDeviceMemory(device, stagingMemory[i], nullptr);
+	}
+	stagingBuffers.clear();
+	stagingMemory.clear();
+}
+
+void TextureLoader::destroy(LoadedTexture& texture)
+{
+	vkDestroyImageView(device, texture.view, nullptr);
+	vkDestroyImage(device, texture.image, nullptr);
+	freeDeviceMemory(device, texture.memory, nullptr);
+	texture = LoadedTexture();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "ImageIO.h"
+
+/*
+	how the mip chain of a texture stored with a single level is produced
+*/
+enum class MipGeneration {
+	Gpu, //vkCmdBlitImage from each level to the next, falls back to Cpu when the format cannot be blitted with linear filtering
+	Cpu, //2x2 box filter on the host, every level is uploaded
+	None //only the stored levels
+};
+
+/*
+	a sampled texture created by the TextureLoader, destroy it with TextureLoader::destroy
+*/
+struct LoadedTexture {
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkImageView view = VK_NULL_HANDLE;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkExtent2D extent = { 0, 0 };
+	uint32_t mipLevels = 0;
+	VkDeviceSize memoryBytes = 0; //device memory taken by the image
+	VkDeviceSize uploadedBytes = 0; //bytes copied through the staging buffer
+	bool decompressed = false; //stored compressed, but the device does not support the format
+};
+
+/*
+	Texture uploads with GPU mip generation and compressed format passthrough
+
+	Every texture is an OPTIMAL tiling image in device local memory, left in SHADER_READ_ONLY_OPTIMAL.
+	- block compressed payloads (BCn, ETC2 / EAC) are copied to the image as they are when the device can sample the
+	  format, at a quarter to an eighth of the RGBA8 size in staging, transfer and video memory. BC1, BC2 and BC3 are
+	  decompressed on the host for devices without BC support, other formats the device lacks are rejected.
+	- uncompressed textures stored with one level upload only that level and build the rest of the chain on the GPU with a
+	  chain of vkCmdBlitImage, each level read from the one above it after a barrier, instead of filtering on the CPU and
+	  uploading a third more data.
+
+	The device has to be created with textureCompressionBC / textureCompressionETC2 enabled wherever they are supported,
+	formatSupported only looks at the format properties.
+
+	Loads are recorded into one command buffer and share one submission: call flush() to submit everything recorded so far,
+	wait for it and release the staging buffers. The textures may not be used before their flush has returned.
+*/
+class TextureLoader
+{
+public:
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, VkCommandPool commandPool);
+	void cleanup();
+
+	LoadedTexture load(const TextureData& data, MipGeneration mips = MipGeneration::Gpu);
+	void flush();
+	void destroy(LoadedTexture& texture);
+
+	/*
+		can images of this format be created with OPTIMAL tiling and sampled
+	*/
+	bool formatSupported(VkFormat format) const;
+
+private:
+	VkCommandBuffer batch(); //the command buffer loads are recorded into, begun on first use
+	bool canBlit(VkFormat format) const;
+	void upload(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, VkExtent2D extent,
+		const std::vector<const std::vector<uint8_t>*>& levels, VkDeviceSize& uploadedBytes);
+	void generateMips(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint32_t mipLevels);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	bool recording = false;
+
+	//staging buffers of the loads recorded since the last flush
+	std::vector<VkBuffer> stagingBuffers;
+	std::vector<VkDeviceMemory> stagingMemory;
+};
@@ -0,0 +1,511 @@
+#include "TextureStreamer.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	const VkFormat STREAMED_FORMAT = VK_FORMAT_R8G8B8A8_UNORM; //what TextureSource::loadLevel produces
+	const VkDeviceSize TEXEL_SIZE = 4;
+	const VkDeviceSize STAGING_ALIGNMENT = 16; //buffer to image copies need a multiple of the texel size, 16 also suits every cache line split
+}
+
+void TextureStreamer::init(VkDevice device, VkPhysicalDevice physicalDevice, BindlessTextures* table, DeletionQueue* deletionQueue,
+	const StreamingSettings& settings, bool memoryBudgetExtension)
+{
+	this->device = device;
+	this->physicalDevice = physicalDevice;
+	this->table = table;
+	this->deletionQueue = deletionQueue;
+	this->settings = settings;
+	this->memoryBudgetExtension = memoryBudgetExtension;
+
+	//textures are created in device local memory, the largest device local heap is the one the budget applies to
+	std::vector<HeapBudget> heaps = queryHeapBudgets(physicalDevice, memoryBudgetExtension);
+	for (uint32_t i = 0; i < heaps.size(); i++) {
+		if (heaps[i].deviceLocal && (!heaps[deviceLocalHeap].deviceLocal || heaps[i].size > heaps[deviceLocalHeap].size)) {
+			deviceLocalHeap = i;
+		}
+	}
+
+	DeviceMemoryScope memoryScope("TextureStreamer", "staging ring");
+	createBuffer(device, physicalDevice, settings.stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, stagingMemory);
+	void* data;
+	vkMapMemory(device, stagingMemory, 0, settings.stagingSize, 0, &data); //mapped for the streamer's whole lifetime
+	stagingData = static_cast<uint8_t*>(data);
+
+	DeviceMemoryScope placeholderScope("TextureStreamer", "placeholder");
+	createImage(device, physicalDevice, { 1, 1 }, STREAMED_FORMAT, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		placeholder, placeholderMemory);
+	placeholderView = createImageView(device, placeholder, STREAMED_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT);
+	placeholderSlot = table->add(placeholderView); //cleared by the first update, before any frame can sample it
+
+	stopLoader = false;
+	loader = std::thread(&TextureStreamer::loaderThread, this);
+}
+
+void TextureStreamer::cleanup()
+{
+	if (device == VK_NULL_HANDLE) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(loaderMutex);
+		stopLoader = true;
+	}
+	loaderWake.notify_all();
+	loader.join();
+
+	for (auto& texture : textures) {
+		if (texture.image != VK_NULL_HANDLE) {
+			table->remove(texture.slot);
+			vkDestroyImageView(device, texture.view, nullptr);
+			vkDestroyImage(device, texture.image, nullptr);
+			freeDeviceMemory(device, texture.memory, nullptr);
+		}
+	}
+	textures.clear();
+	pendingLoads.clear();
+	completedLoads.clear();
+	stagingRegions.clear();
+
+	table->remove(placeholderSlot);
+	vkDestroyImageView(device, placeholderView, nullptr);
+	vkDestroyImage(device, placeholder, nullptr);
+	freeDeviceMemory(device, placeholderMemory, nullptr);
+
+	vkUnmapMemory(device, stagingMemory);
+	vkDestroyBuffer(device, staging, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+	device = VK_NULL_HANDLE;
+}
+
+uint32_t TextureStreamer::addTexture(std::shared_ptr<TextureSource> source)
+{
+	Texture texture;
+	texture.extent = source->extent();
+	texture.source = std::move(source);
+	uint32_t largest = std::max(texture.extent.width, texture.extent.height);
+	texture.levelCount = static_cast<uint32_t>(std::floor(std::log2(largest))) + 1;
+	texture.tailLevel = 0;
+	while (texture.tailLevel + 1 < texture.levelCount && (largest >> texture.tailLevel) > settings.mipTailSize) {
+		texture.tailLevel++;
+	}
+	texture.firstResident = texture.levelCount; //nothing yet, the mip tail is requested by the next update
+	texture.desiredLevel = texture.tailLevel;
+	texture.slot = placeholderSlot;
+
+	VkDeviceSize tailBytes = 0;
+	for (uint32_t level = texture.tailLevel; level < texture.levelCount; level++) {
+		tailBytes += levelBytes(texture, level);
+	}
+	if (levelBytes(texture, 0) > settings.stagingSize || tailBytes > settings.stagingSize) {
+		throw std::runtime_error("failed to add streamed texture, its largest mip level does not fit the staging buffer!");
+	}
+
+	textures.push_back(std::move(texture));
+	return static_cast<uint32_t>(textures.size() - 1);
+}
+
+void TextureStreamer::setDemand(uint32_t textureIndex, float screenPixels)
+{
+	Texture& texture = textures[textureIndex];
+	texture.demand = screenPixels;
+	if (screenPixels <= 0.0f) {
+		texture.desiredLevel = texture.tailLevel; //not visible, the tail is all it keeps a claim on
+		return;
+	}
+	//one texel per pixel: level n is wanted once the texture covers less than half the pixels of level n - 1
+	float largest = static_cast<float>(std::max(texture.extent.width, texture.extent.height));
+	float level = std::floor(std::log2(std::max(largest / screenPixels, 1.0f)));
+	texture.desiredLevel = std::min(static_cast<uint32_t>(level), texture.tailLevel);
+}
+
+uint32_t TextureStreamer::slot(uint32_t texture) const
+{
+	return textures[texture].slot;
+}
+
+StreamingStats TextureStreamer::stats() const
+{
+	StreamingStats result = counters;
+	result.residentBytes = residentBytes;
+	result.budget = effectiveBudget();
+	result.textureCount = static_cast<uint32_t>(textures.size());
+	result.texturesAtDesiredQuality = 0;
+	result.missingLevels = 0;
+	for (const auto& texture : textures) {
+		if (texture.firstResident <= texture.desiredLevel) {
+			result.texturesAtDesiredQuality++;
+		}
+		else {
+			result.missingLevels += texture.firstResident - texture.desiredLevel;
+		}
+	}
+	return result;
+}
+
+void TextureStreamer::update(VkCommandBuffer commandBuffer, uint64_t frameSerial, uint64_t completedSerial)
+{
+	releaseStaging(completedSerial);
+	if (!placeholderUploaded) {
+		initPlaceholder(commandBuffer);
+	}
+
+	//1. turn finished loads into resident levels
+	std::vector<LoadRequest> finished;
+	{
+		std::lock_guard<std::mutex> lock(loaderMutex);
+		finished.swap(completedLoads);
+	}
+	for (const auto& request : finished) {
+		applyLoad(commandBuffer, request, frameSerial);
+	}
+
+	//2. over budget (the budget shrank, or other processes grew): give up the least valuable levels
+	VkDeviceSize budget = effectiveBudget();
+	while (residentBytes + loadingBytes > budget) {
+		uint32_t victim = UINT32_MAX;
+		for (uint32_t i = 0; i < textures.size(); i++) {
+			const Texture& texture = textures[i];
+			if (texture.firstResident >= texture.tailLevel || texture.loading) {
+				continue; //only the tail left, or about to change anyway
+			}
+			if (victim == UINT32_MAX || levelValue(texture) < levelValue(textures[victim])) {
+				victim = i;
+			}
+		}
+		if (victim == UINT32_MAX) {
+			break;
+		}
+		evictLevel(commandBuffer, victim, frameSerial);
+	}
+
+	//3. mip tails first, every texture should have something better than the placeholder before any texture gets sharper
+	for (uint32_t i = 0; i < textures.size() && loadsInFlight < settings.maxLoadsInFlight; i++) {
+		Texture& texture = textures[i];
+		if (texture.firstResident == texture.levelCount && !texture.loading) {
+			if (!requestLoad(i, texture.tailLevel, texture.levelCount)) {
+				return; //staging ring full, try again next frame
+			}
+		}
+	}
+
+	//4. one level finer for the textures missing the most, weighted by how much of the screen they cover
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < textures.size(); i++) {
+		const Texture& texture = textures[i];
+		if (!texture.loading && texture.firstResident < texture.levelCount && texture.firstResident > texture.desiredLevel) {
+			candidates.push_back(i);
+		}
+	}
+	auto priority = [&](uint32_t i) {
+		const Texture& texture = textures[i];
+		return texture.demand * static_cast<float>(texture.firstResident - texture.desiredLevel);
+	};
+	std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return priority(a) > priority(b); });
+
+	for (uint32_t candidate : candidates) {
+		if (loadsInFlight >= settings.maxLoadsInFlight) {
+			break;
+		}
+		const Texture& texture = textures[candidate];
+		VkDeviceSize needed = levelBytes(texture, texture.firstResident - 1);
+		//make room by evicting levels that are worth less than this one, stop as soon as nothing cheaper is left
+		bool fits = true;
+		while (residentBytes + loadingBytes + needed > budget) {
+			uint32_t victim = UINT32_MAX;
+			for (uint32_t i = 0; i < textures.size(); i++) {
+				const Texture& other = textures[i];
+				if (i == candidate || other.loading || other.firstResident >= other.tailLevel) {
+					continue;
+				}
+				if (victim == UINT32_MAX || levelValue(other) < levelValue(textures[victim])) {
+					victim = i;
+				}
+			}
+			if (victim == UINT32_MAX || levelValue(textures[victim]) >= priority(candidate)) {
+				fits = false;
+				break;
+			}
+			evictLevel(commandBuffer, victim, frameSerial);
+		}
+		if (!fits) {
+			break; //every later candidate has an even lower priority
+		}
+		if (!requestLoad(candidate, texture.firstResident - 1, texture.firstResident)) {
+			break;
+		}
+	}
+}
+
+/*
+	a texture's finest resident level is worth nothing when it is finer than the demand calls for, otherwise its screen coverage
+*/
+float TextureStreamer::levelValue(const Texture& texture) const
+{
+	return texture.firstResident < texture.desiredLevel ? 0.0f : texture.demand;
+}
+
+void TextureStreamer::initPlaceholder(VkCommandBuffer commandBuffer)
+{
+	imageBarrier(commandBuffer, placeholder, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	VkClearColorValue grey = { { 0.5f, 0.5f, 0.5f, 1.0f } };
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdClearColorImage(commandBuffer, placeholder, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &grey, 1, &range);
+	imageBarrier(commandBuffer, placeholder, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	placeholderUploaded = true;
+}
+
+bool TextureStreamer::requestLoad(uint32_t textureIndex, uint32_t firstLevel, uint32_t endLevel)
+{
+	Texture& texture = textures[textureIndex];
+	VkDeviceSize bytes = 0;
+	for (uint32_t level = firstLevel; level < endLevel; level++) {
+		bytes += levelBytes(texture, level);
+	}
+
+	LoadRequest request;
+	if (!allocateStaging(bytes, request.stagingOffset, request.region)) {
+		return false;
+	}
+	request.source = texture.source;
+	request.texture = textureIndex;
+	request.firstLevel = firstLevel;
+	request.endLevel = endLevel;
+
+	texture.loading = true;
+	loadsInFlight++;
+	loadingBytes += bytes;
+	{
+		std::lock_guard<std::mutex> lock(loaderMutex);
+		pendingLoads.push_back(std::move(request));
+	}
+	loaderWake.notify_one();
+	return true;
+}
+
+/*
+	a load is only used if it still extends the texture by exactly the levels it carries and they are still wanted,
+	the demand may have dropped while it was on the loader thread
+*/
+void TextureStreamer::applyLoad(VkCommandBuffer commandBuffer, const LoadRequest& request, uint64_t frameSerial)
+{
+	Texture& texture = textures[request.texture];
+	VkDeviceSize bytes = 0;
+	for (uint32_t level = request.firstLevel; level < request.endLevel; level++) {
+		bytes += levelBytes(texture, level);
+	}
+	texture.loading = false;
+	loadsInFlight--;
+	loadingBytes -= bytes;
+	counters.loadsCompleted++;
+	stagingRegions[request.region - firstRegionId].releaseSerial = frameSerial; //reused once this frame's copies have executed
+
+	bool tail = texture.firstResident == texture.levelCount;
+	if (!tail && (request.endLevel != texture.firstResident || request.firstLevel < texture.desiredLevel)) {
+		counters.loadsDiscarded++;
+		return;
+	}
+	changeResidency(commandBuffer, texture, request.firstLevel, &request, frameSerial);
+	counters.uploadedBytes += bytes;
+	if (!tail) {
+		counters.promotions++;
+	}
+}
+
+void TextureStreamer::evictLevel(VkCommandBuffer commandBuffer, uint32_t textureIndex, uint64_t frameSerial)
+{
+	Texture& texture = textures[textureIndex];
+	changeResidency(commandBuffer, texture, texture.firstResident + 1, nullptr, frameSerial);
+	counters.evictions++;
+}
+
+/*
+	move the texture to a new image holding levels [newFirstLevel, levelCount): the levels both images have are copied on the GPU,
+	the ones the old image lacks come from the staging ring, then the texture switches to a new bindless slot
+*/
+void TextureStreamer::changeResidency(VkCommandBuffer commandBuffer, Texture& texture, uint32_t newFirstLevel, const LoadRequest* upload, uint64_t frameSerial)
+{
+	uint32_t newLevelCount = texture.levelCount - newFirstLevel;
+	VkExtent2D extent = { std::max(texture.extent.width >> newFirstLevel, 1u), std::max(texture.extent.height >> newFirstLevel, 1u) };
+
+	VkImage image;
+	VkDeviceMemory memory;
+	DeviceMemoryScope memoryScope("TextureStreamer", "texture " + std::to_string(texture.extent.width) + "x" + std::to_string(texture.extent.height)
+		+ " from level " + std::to_string(newFirstLevel));
+	createImage(device, physicalDevice, extent, STREAMED_FORMAT,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, image, memory, nullptr, newLevelCount);
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+	imageBarrier(commandBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	if (texture.image != VK_NULL_HANDLE) {
+		//earlier frames may still be sampling the old image, the barrier orders the copy after them
+		imageBarrier(commandBuffer, texture.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		std::vector<VkImageCopy> copies;
+		for (uint32_t level = std::max(newFirstLevel, texture.firstResident); level < texture.levelCount; level++) {
+			VkImageCopy copy = {};
+			copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - texture.firstResident, 0, 1 };
+			copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newFirstLevel, 0, 1 };
+			copy.extent = { std::max(texture.extent.width >> level, 1u), std::max(texture.extent.height >> level, 1u), 1 };
+			copies.push_back(copy);
+		}
+		vkCmdCopyImage(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(copies.size()), copies.data());
+	}
+
+	if (upload != nullptr) {
+		std::vector<VkBufferImageCopy> regions;
+		VkDeviceSize offset = upload->stagingOffset;
+		for (uint32_t level = upload->firstLevel; level < upload->endLevel; level++) {
+			VkBufferImageCopy region = {};
+			region.bufferOffset = offset; //tightly packed, rowLength and imageHeight 0
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newFirstLevel, 0, 1 };
+			region.imageExtent = { std::max(texture.extent.width >> level, 1u), std::max(texture.extent.height >> level, 1u), 1 };
+			regions.push_back(region);
+			offset += levelBytes(texture, level);
+		}
+		vkCmdCopyBufferToImage(commandBuffer, staging, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+	}
+
+	imageBarrier(commandBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	retire(texture, frameSerial);
+	texture.image = image;
+	texture.memory = memory;
+	texture.bytes = memRequirements.size;
+	texture.view = createImageView(device, image, STREAMED_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, newLevelCount);
+	texture.slot = table->add(texture.view); //a fresh slot, the old one may still be read by frames in flight
+	texture.firstResident = newFirstLevel;
+	residentBytes += texture.bytes;
+}
+
+/*
+	hand the texture's current image, memory and slot to the deletion queue, they go once this frame has completed
+*/
+void TextureStreamer::retire(Texture& texture, uint64_t frameSerial)
+{
+	if (texture.image == VK_NULL_HANDLE) {
+		return; //still on the placeholder, which is never retired
+	}
+	residentBytes -= texture.bytes;
+	VkDevice device = this->device;
+	BindlessTextures* table = this->table;
+	VkImage image = texture.image;
+	VkImageView view = texture.view;
+	VkDeviceMemory memory = texture.memory;
+	uint32_t slot = texture.slot;
+	deletionQueue->push(frameSerial, [=]() {
+		table->remove(slot);
+		vkDestroyImageView(device, view, nullptr);
+		vkDestroyImage(device, image, nullptr);
+		freeDeviceMemory(device, memory, nullptr);
+	});
+	texture.image = VK_NULL_HANDLE;
+	texture.view = VK_NULL_HANDLE;
+	texture.memory = VK_NULL_HANDLE;
+}
+
+VkDeviceSize TextureStreamer::levelBytes(const Texture& texture, uint32_t level) const
+{
+	VkDeviceSize width = std::max(texture.extent.width >> level, 1u);
+	VkDeviceSize height = std::max(texture.extent.height >> level, 1u);
+	return width * height * TEXEL_SIZE;
+}
+
+/*
+	the configured budget, capped by the share of the device local heap that is not already used by the rest of the process
+	(the heap usage includes our own textures, so they are taken out again)
+*/
+VkDeviceSize TextureStreamer::effectiveBudget() const
+{
+	std::vector<HeapBudget> heaps = queryHeapBudgets(physicalDevice, memoryBudgetExtension);
+	const HeapBudget& heap = heaps[deviceLocalHeap];
+	VkDeviceSize otherUsage = heap.usage > residentBytes ? heap.usage - residentBytes : 0;
+	VkDeviceSize available = heap.budget > otherUsage ? heap.budget - otherUsage : 0;
+	VkDeviceSize heapLimit = static_cast<VkDeviceSize>(static_cast<double>(available) * settings.heapHeadroom);
+	return std::min(settings.budget, heapLimit);
+}
+
+/*
+	the staging buffer is used as a ring: regions are handed out at the head and released from the tail in the same order,
+	a request that does not fit between the head and the end of the buffer starts again at offset 0
+*/
+bool TextureStreamer::allocateStaging(VkDeviceSize size, VkDeviceSize& offset, uint64_t& region)
+{
+	size = (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+	if (stagingRegions.empty()) {
+		stagingHead = 0;
+		if (size > settings.stagingSize) {
+			return false;
+		}
+		offset = 0;
+	}
+	else {
+		VkDeviceSize tail = stagingRegions.front().begin;
+		bool wrapped = stagingRegions.back().begin < tail; //the head has already gone round and sits behind the tail
+		if (!wrapped && stagingHead + size <= settings.stagingSize) {
+			offset = stagingHead;
+		}
+		else if (!wrapped && size <= tail) {
+			offset = 0;
+		}
+		else if (wrapped && stagingHead + size <= tail) {
+			offset = stagingHead;
+		}
+		else {
+			return false;
+		}
+	}
+	stagingHead = offset + size;
+	stagingRegions.push_back({ offset, offset + size, UINT64_MAX });
+	region = firstRegionId + stagingRegions.size() - 1;
+	return true;
+}
+
+void TextureStreamer::releaseStaging(uint64_t completedSerial)
+{
+	while (!stagingRegions.empty() && stagingRegions.front().releaseSerial <= completedSerial) {
+		stagingRegions.pop_front();
+		firstRegionId++;
+	}
+}
+
+/*
+	takes requests in order and writes their levels into the staging ring, the render thread picks them up in update
+*/
+void TextureStreamer::loaderThread()
+{
+	while (true) {
+		LoadRequest request;
+		{
+			std::unique_lock<std::mutex> lock(loaderMutex);
+			loaderWake.wait(lock, [&]() { return stopLoader || !pendingLoads.empty(); });
+			if (stopLoader) {
+				return;
+			}
+			request = std::move(pendingLoads.front());
+			pendingLoads.pop_front();
+		}
+
+		uint8_t* texels = stagingData + request.stagingOffset;
+		VkExtent2D extent = request.source->extent();
+		for (uint32_t level = request.firstLevel; level < request.endLevel; level++) {
+			request.source->loadLevel(level, texels);
+			texels += static_cast<size_t>(std::max(extent.width >> level, 1u)) * std::max(extent.height >> level, 1u) * TEXEL_SIZE;
+		}
+
+		std::lock_guard<std::mutex> lock(loaderMutex);
+		completedLoads.push_back(std::move(request));
+	}
+}
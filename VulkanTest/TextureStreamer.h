@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "BindlessTextures.h"
+#include "DeletionQueue.h"
+
+/*
+	where the texels of a streamed texture come from (a file, a decoder, a generator)
+	loadLevel is called on the loader thread and writes the tightly packed RGBA8 texels of one mip level
+*/
+class TextureSource
+{
+public:
+	virtual ~TextureSource() = default;
+	virtual VkExtent2D extent() const = 0;
+	virtual void loadLevel(uint32_t level, uint8_t* texels) = 0;
+};
+
+/*
+	settings of the texture streamer, filled in from the command line
+*/
+struct StreamingSettings {
+	VkDeviceSize budget = 256ull << 20; //resident texture memory the streamer aims to stay under
+	float heapHeadroom = 0.9f; //fraction of the device local heap budget (VK_EXT_memory_budget) the streamer may claim
+	VkDeviceSize stagingSize = 64ull << 20; //ring of host visible memory the loader thread writes into
+	uint32_t maxLoadsInFlight = 8; //mip level loads queued or running on the loader thread
+	uint32_t mipTailSize = 64; //levels this size and smaller are loaded together when a texture is added and never evicted
+};
+
+/*
+	counters of the streamer, cumulative unless noted
+*/
+struct StreamingStats {
+	VkDeviceSize residentBytes = 0; //current
+	VkDeviceSize budget = 0; //current effective budget (configured budget capped by the heap budget)
+	uint32_t texturesAtDesiredQuality = 0; //current
+	uint32_t textureCount = 0;
+	uint32_t missingLevels = 0; //current, sum over textures of the levels wanted but not resident
+	uint64_t promotions = 0;
+	uint64_t evictions = 0;
+	uint64_t loadsCompleted = 0;
+	uint64_t loadsDiscarded = 0; //finished after the texture stopped wanting the level
+	VkDeviceSize uploadedBytes = 0;
+};
+
+/*
+	Budget aware texture streaming with mip residency
+
+	Every texture is a chain of mip levels of which only the smallest ones are resident at first (the mip tail, loaded as
+	soon as the texture is added). Each frame the caller reports how large every texture appears on screen; from that the
+	streamer derives the finest level worth having, requests the next finer level of the textures missing the most, and
+	when the resident total exceeds the budget gives up the finest level of the textures that need it least. Quality
+	therefore degrades one mip level at a time instead of failing allocations.
+
+	Levels are produced on a background loader thread straight into a persistently mapped staging ring. The render thread
+	records the copies: a residency change creates an image holding the new level range, copies the levels that are kept
+	from the old image and uploads the new one. The texture then moves to a fresh bindless slot, the old image, memory and
+	slot go to the deletion queue, so nothing that pending frames still read is touched.
+
+	The budget is the smaller of the configured one and, with VK_EXT_memory_budget, heapHeadroom of what the device local
+	heap has left for us (its budget minus what everything else in the process uses).
+*/
+class TextureStreamer
+{
+public:
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, BindlessTextures* table, DeletionQueue* deletionQueue,
+		const StreamingSettings& settings, bool memoryBudgetExtension);
+	void cleanup(); //the device must be idle
+
+	/*
+		register a texture, its mip tail is requested straight away, until it arrives the texture uses a grey placeholder
+	*/
+	uint32_t addTexture(std::shared_ptr<TextureSource> source);
+
+	/*
+		largest size in pixels the texture covers on screen this frame, 0 when it is not visible
+	*/
+	void setDemand(uint32_t texture, float screenPixels);
+
+	/*
+		once per frame: record the uploads and copies of finished loads into commandBuffer (which must execute before the
+		frame's draws), then evict and request levels. frameSerial is the serial of the submission commandBuffer goes into,
+		completedSerial the newest serial known to have completed
+	*/
+	void update(VkCommandBuffer commandBuffer, uint64_t frameSerial, uint64_t completedSerial);
+
+	/*
+		bindless slot the texture can currently be sampled through, may change after every update
+	*/
+	uint32_t slot(uint32_t texture) const;
+
+	StreamingStats stats() const;
+
+private:
+	struct Texture {
+		std::shared_ptr<TextureSource> source;
+		VkExtent2D extent;
+		uint32_t levelCount = 0;
+		uint32_t tailLevel = 0; //first level of the mip tail
+		uint32_t firstResident = 0; //finest resident level, levelCount when nothing is resident yet
+		uint32_t desiredLevel = 0; //finest level worth having at the current demand
+		float demand = 0.0f;
+		bool loading = false; //a load for this texture is queued or running
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize bytes = 0; //size of the memory allocation
+		uint32_t slot = 0;
+	};
+
+	//one or more consecutive mip levels to be written into the staging ring by the loader thread
+	struct LoadRequest {
+		std::shared_ptr<TextureSource> source; //the loader never touches the textures vector, which may grow meanwhile
+		uint32_t texture;
+		uint32_t firstLevel;
+		uint32_t endLevel; //exclusive
+		VkDeviceSize stagingOffset;
+		uint64_t region; //staging ring region, released once the upload has executed
+	};
+
+	//FIFO allocator over the staging buffer, regions are released in allocation order once their upload has completed
+	struct StagingRegion {
+		VkDeviceSize begin;
+		VkDeviceSize end;
+		uint64_t releaseSerial; //UINT64_MAX while the loader or a not yet submitted upload still needs it
+	};
+
+	bool allocateStaging(VkDeviceSize size, VkDeviceSize& offset, uint64_t& region);
+	void releaseStaging(uint64_t completedSerial);
+	bool requestLoad(uint32_t texture, uint32_t firstLevel, uint32_t endLevel); //false when the staging ring is full
+	void applyLoad(VkCommandBuffer commandBuffer, const LoadRequest& request, uint64_t frameSerial);
+	void evictLevel(VkCommandBuffer commandBuffer, uint32_t texture, uint64_t frameSerial);
+	float levelValue(const Texture& texture) const; //what losing the finest resident level would cost
+	void initPlaceholder(VkCommandBuffer commandBuffer);
+	void changeResidency(VkCommandBuffer commandBuffer, Texture& texture, uint32_t newFirstLevel, const LoadRequest* upload, uint64_t frameSerial);
+	void retire(Texture& texture, uint64_t frameSerial);
+	VkDeviceSize levelBytes(const Texture& texture, uint32_t level) const;
+	VkDeviceSize effectiveBudget() const;
+	void loaderThread();
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	BindlessTextures* table = nullptr;
+	DeletionQueue* deletionQueue = nullptr;
+	StreamingSettings settings;
+	bool memoryBudgetExtension = false;
+	uint32_t deviceLocalHeap = 0;
+
+	std::vector<Texture> textures;
+	VkDeviceSize residentBytes = 0;
+	VkDeviceSize loadingBytes = 0; //levels requested but not resident yet, counted against the budget before they arrive
+	StreamingStats counters;
+
+	//grey 1x1 texture used until a texture's mip tail is resident
+	VkImage placeholder = VK_NULL_HANDLE;
+	VkDeviceMemory placeholderMemory = VK_NULL_HANDLE;
+	VkImageView placeholderView = VK_NULL_HANDLE;
+	uint32_t placeholderSlot = 0;
+	bool placeholderUploaded = false;
+
+	VkBuffer staging = VK_NULL_HANDLE;
+	VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+	uint8_t* stagingData = nullptr; //persistently mapped
+	std::deque<StagingRegion> stagingRegions;
+	uint64_t firstRegionId = 0; //id of stagingRegions.front()
+	VkDeviceSize stagingHead = 0;
+
+	//loader thread
+	std::thread loader;
+	std::mutex loaderMutex;
+	std::condition_variable loaderWake;
+	std::deque<LoadRequest> pendingLoads; //requested, not yet started
+	std::vector<LoadRequest> completedLoads; //written to staging, waiting for the render thread
+	bool stopLoader = false;
+	uint32_t loadsInFlight = 0; //render thread only
+};
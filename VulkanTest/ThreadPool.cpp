@@ -0,0 +1,94 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threads)
+{
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	for (uint32_t i = 1; i < threads; i++) {
+		workers.emplace_back(&ThreadPool::workerThread, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::parallelFor(size_t itemCount, size_t itemBatch, const std::function<void(size_t begin, size_t end)>& loopWork)
+{
+	itemBatch = std::max<size_t>(itemBatch, 1);
+	if (workers.empty() || itemCount <= itemBatch) { //not worth waking anyone
+		if (itemCount > 0) {
+			loopWork(0, itemCount);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		work = &loopWork;
+		count = itemCount;
+		batch = itemBatch;
+		next = 0;
+		error = nullptr;
+		busy = static_cast<uint32_t>(workers.size());
+		generation++;
+	}
+	wake.notify_all();
+	runBatches();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return busy == 0; });
+	work = nullptr;
+	if (error) {
+		std::exception_ptr thrown = error;
+		error = nullptr;
+		std::rethrow_exception(thrown);
+	}
+}
+
+void ThreadPool::runBatches()
+{
+	try {
+		for (size_t begin = next.fetch_add(batch); begin < count; begin = next.fetch_add(batch)) {
+			(*work)(begin, std::min(begin + batch, count));
+		}
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!error) {
+			error = std::current_exception();
+		}
+		next = count; //the others stop after their current batch
+	}
+}
+
+void ThreadPool::workerThread()
+{
+	uint64_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+		}
+		runBatches();
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busy == 0) {
+			finished.notify_one();
+		}
+	}
+}
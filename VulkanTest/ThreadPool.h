@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+/*
+	Persistent worker threads for data parallel loops
+
+	parallelFor hands out [begin, end) ranges of batch items from a shared counter to the workers and to the calling
+	thread, and returns once every range is done, so the workers are parked between loops instead of being created for
+	each one. The first exception thrown by the work is rethrown on the calling thread. One loop runs at a time, calling
+	parallelFor from inside the work is not supported.
+*/
+class ThreadPool
+{
+public:
+	explicit ThreadPool(uint32_t threads = 0); //threads includes the calling thread, 0 uses every hardware thread
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	uint32_t threadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+	void parallelFor(size_t count, size_t batch, const std::function<void(size_t begin, size_t end)>& work);
+
+private:
+	void workerThread();
+	void runBatches();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake; //a new loop or shutdown
+	std::condition_variable finished; //the last worker left the current loop
+	uint64_t generation = 0; //counts loops, so a worker never runs the same loop twice
+	bool stopping = false;
+	uint32_t busy = 0; //workers still inside the current loop
+
+	//the current loop
+	const std::function<void(size_t, size_t)>* work = nullptr;
+	size_t count = 0;
+	size_t batch = 1;
+	std::atomic<size_t> next{ 0 };
+	std::exception_ptr error;
+};
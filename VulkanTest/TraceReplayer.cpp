@@ -0,0 +1,646 @@
+#include "TraceReplayer.h"
+#include "VulkanUtils.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+TraceReplayer::TraceReplayer(const ReplaySettings& settings) : settings(settings)
+{
+}
+
+void TraceReplayer::run()
+{
+	DeviceMemoryScope memoryScope("TraceReplayer");
+	trace = CommandTrace::load(settings.traceFile);
+	createDevice();
+	try {
+		createResources();
+		replay();
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+/*
+	minimal instance and device: no layers, no extensions, one graphics queue
+*/
+void TraceReplayer::createDevice()
+{
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO; //struct type
+	appInfo.pApplicationName = "Trace Replay";
+	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.pEngineName = "No Engine";
+	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO; //struct type
+	instanceInfo.pApplicationInfo = &appInfo;
+
+	if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create instance!");
+	}
+
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	std::vector<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+	for (const auto& candidate : devices) { //first device with a graphics queue, like TriangleApp in headless mode
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, queueFamilies.data());
+		for (uint32_t i = 0; i < queueFamilyCount; i++) {
+			if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				physicalDevice = candidate;
+				queueFamily = i;
+				timestampValidBits = queueFamilies[i].timestampValidBits;
+				break;
+			}
+		}
+		if (physicalDevice != VK_NULL_HANDLE) {
+			break;
+		}
+	}
+	if (physicalDevice == VK_NULL_HANDLE) {
+		throw std::runtime_error("failed to find a suitable GPU!");
+	}
+
+	float queuePriority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO; //struct type
+	queueInfo.queueFamilyIndex = queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &queuePriority;
+
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO; //struct type
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+
+	if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create logical device!");
+	}
+	DeviceMemoryTracker::global().registerDevice(device, physicalDevice, false);
+	vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO; //struct type
+	poolInfo.queueFamilyIndex = queueFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; //the frame is re-recorded every replay
+
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create command pool!");
+	}
+}
+
+/*
+	walk the trace, creating every traced object and collecting the commands of the frame
+*/
+void TraceReplayer::createResources()
+{
+	bool inFrame = false;
+	for (const auto& record : trace.records) {
+		switch (record.op) {
+		case TraceOp::ShaderModule: {
+			TraceReader reader(record);
+			uint32_t id = reader.get<uint32_t>();
+			std::vector<char> code = reader.getArray<char>();
+			VkShaderModuleCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO; //struct type
+			createInfo.codeSize = code.size();
+			createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data()); //vector storage is suitably aligned
+			if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModules[id]) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create shader module!");
+			}
+			break;
+		}
+		case TraceOp::RenderPass:
+			createRenderPass(record);
+			break;
+		case TraceOp::PipelineLayout:
+			createPipelineLayout(record);
+			break;
+		case TraceOp::Buffer:
+			createBuffer(record);
+			break;
+		case TraceOp::GraphicsPipeline:
+			createPipeline(record);
+			break;
+		case TraceOp::Framebuffer:
+			createFramebuffer(record);
+			break;
+		case TraceOp::BeginFrame:
+			inFrame = true;
+			break;
+		case TraceOp::EndFrame:
+			inFrame = false;
+			break;
+		default:
+			if (!inFrame) {
+				throw std::runtime_error("failed to replay trace, command recorded outside of a frame!");
+			}
+			frameCommands.push_back(&record);
+			break;
+		}
+	}
+	if (frameCommands.empty()) {
+		throw std::runtime_error("failed to replay trace, it contains no frame!");
+	}
+
+	commandBuffers.resize(FRAMES_IN_FLIGHT);
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = FRAMES_IN_FLIGHT;
+	if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO; //struct type
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; //the first wait returns immediately
+	fences.resize(FRAMES_IN_FLIGHT);
+	for (auto& fence : fences) {
+		if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create fence for a frame!");
+		}
+	}
+
+	frameTimer.init(device, physicalDevice, commandPool, FRAMES_IN_FLIGHT, timestampValidBits);
+}
+
+/*
+	there is no swap chain to present to, so attachments that ended in PRESENT_SRC end in TRANSFER_SRC instead
+*/
+void TraceReplayer::createRenderPass(const TraceRecord& record)
+{
+	TraceReader reader(record);
+	uint32_t id = reader.get<uint32_t>();
+	std::vector<VkAttachmentDescription> attachments = reader.getArray<VkAttachmentDescription>();
+	for (auto& attachment : attachments) {
+		if (attachment.finalLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
+			attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		}
+		renderPassFormats[id].push_back(attachment.format);
+	}
+
+	uint32_t subpassCount = reader.get<uint32_t>();
+	std::vector<VkSubpassDescription> subpasses(subpassCount);
+	std::vector<std::vector<VkAttachmentReference>> colorReferences(subpassCount); //keep the references alive until the pass is created
+	std::vector<std::vector<VkAttachmentReference>> depthReferences(subpassCount);
+	for (uint32_t i = 0; i < subpassCount; i++) {
+		subpasses[i] = {};
+		subpasses[i].pipelineBindPoint = reader.get<VkPipelineBindPoint>();
+		colorReferences[i] = reader.getArray<VkAttachmentReference>();
+		depthReferences[i] = reader.getArray<VkAttachmentReference>();
+		subpasses[i].colorAttachmentCount = static_cast<uint32_t>(colorReferences[i].size());
+		subpasses[i].pColorAttachments = colorReferences[i].data();
+		subpasses[i].pDepthStencilAttachment = depthReferences[i].empty() ? nullptr : depthReferences[i].data();
+	}
+	std::vector<VkSubpassDependency> dependencies = reader.getArray<VkSubpassDependency>();
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO; //struct type
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = subpassCount;
+	renderPassInfo.pSubpasses = subpasses.data();
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+
+	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPasses[id]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create render pass!");
+	}
+}
+
+void TraceReplayer::createPipelineLayout(const TraceRecord& record)
+{
+	TraceReader reader(record);
+	uint32_t id = reader.get<uint32_t>();
+	std::vector<VkPushConstantRange> pushConstantRanges = reader.getArray<VkPushConstantRange>();
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	layoutInfo.pPushConstantRanges = pushConstantRanges.data();
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayouts[id]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+}
+
+/*
+	host visible memory filled with the traced contents, replayed buffers are small (vertex data of the traced frame)
+*/
+void TraceReplayer::createBuffer(const TraceRecord& record)
+{
+	TraceReader reader(record);
+	uint32_t id = reader.get<uint32_t>();
+	VkBufferUsageFlags usage = reader.get<VkBufferUsageFlags>();
+	std::vector<uint8_t> contents = reader.getArray<uint8_t>();
+
+	VkDeviceMemory memory;
+	::createBuffer(device, physicalDevice, contents.size(), usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffers[id], memory);
+	bufferMemory.push_back(memory);
+	void* data;
+	vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data);
+	memcpy(data, contents.data(), contents.size());
+	vkUnmapMemory(device, memory);
+}
+
+/*
+	read back the state in the order CommandTraceRecorder::graphicsPipeline wrote it
+*/
+void TraceReplayer::createPipeline(const TraceRecord& record)
+{
+	TraceReader reader(record);
+	uint32_t id = reader.get<uint32_t>();
+	uint32_t renderPassId = reader.get<uint32_t>();
+	uint32_t subpass = reader.get<uint32_t>();
+	uint32_t layoutId = reader.get<uint32_t>();
+
+	uint32_t stageCount = reader.get<uint32_t>();
+	std::vector<VkPipelineShaderStageCreateInfo> stages(stageCount);
+	std::vector<std::string> entryPoints(stageCount);
+	for (uint32_t i = 0; i < stageCount; i++) {
+		stages[i] = {};
+		stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+		stages[i].stage = reader.get<VkShaderStageFlagBits>();
+		stages[i].module = shaderModules.at(reader.get<uint32_t>());
+		entryPoints[i] = reader.getString();
+	}
+	for (uint32_t i = 0; i < stageCount; i++) {
+		stages[i].pName = entryPoints[i].c_str(); //after the loop so the strings no longer move
+	}
+
+	std::vector<VkVertexInputBindingDescription> bindings = reader.getArray<VkVertexInputBindingDescription>();
+	std::vector<VkVertexInputAttributeDescription> attributes = reader.getArray<VkVertexInputAttributeDescription>();
+	VkPipelineVertexInputStateCreateInfo vertexInput = {};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //struct type
+	vertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+	vertexInput.pVertexBindingDescriptions = bindings.data();
+	vertexInput.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+	vertexInput.pVertexAttributeDescriptions = attributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = reader.get<VkPrimitiveTopology>();
+	inputAssembly.primitiveRestartEnable = reader.get<VkBool32>();
+
+	std::vector<VkViewport> viewports = reader.getArray<VkViewport>();
+	std::vector<VkRect2D> scissors = reader.getArray<VkRect2D>();
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = static_cast<uint32_t>(viewports.size());
+	viewportState.pViewports = viewports.data();
+	viewportState.scissorCount = static_cast<uint32_t>(scissors.size());
+	viewportState.pScissors = scissors.data();
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.depthClampEnable = reader.get<VkBool32>();
+	rasterizer.rasterizerDiscardEnable = reader.get<VkBool32>();
+	rasterizer.polygonMode = reader.get<VkPolygonMode>();
+	rasterizer.cullMode = reader.get<VkCullModeFlags>();
+	rasterizer.frontFace = reader.get<VkFrontFace>();
+	rasterizer.depthBiasEnable = reader.get<VkBool32>();
+	rasterizer.depthBiasConstantFactor = reader.get<float>();
+	rasterizer.depthBiasClamp = reader.get<float>();
+	rasterizer.depthBiasSlopeFactor = reader.get<float>();
+	rasterizer.lineWidth = reader.get<float>();
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = reader.get<VkSampleCountFlagBits>();
+	multisampling.sampleShadingEnable = reader.get<VkBool32>();
+	multisampling.minSampleShading = reader.get<float>();
+	multisampling.alphaToCoverageEnable = reader.get<VkBool32>();
+	multisampling.alphaToOneEnable = reader.get<VkBool32>();
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO; //struct type
+	bool hasDepthStencil = reader.get<uint32_t>() != 0;
+	if (hasDepthStencil) {
+		depthStencil.depthTestEnable = reader.get<VkBool32>();
+		depthStencil.depthWriteEnable = reader.get<VkBool32>();
+		depthStencil.depthCompareOp = reader.get<VkCompareOp>();
+		depthStencil.depthBoundsTestEnable = reader.get<VkBool32>();
+		depthStencil.stencilTestEnable = reader.get<VkBool32>();
+		depthStencil.front = reader.get<VkStencilOpState>();
+		depthStencil.back = reader.get<VkStencilOpState>();
+		depthStencil.minDepthBounds = reader.get<float>();
+		depthStencil.maxDepthBounds = reader.get<float>();
+	}
+
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+	bool hasColorBlending = reader.get<uint32_t>() != 0;
+	if (hasColorBlending) {
+		colorBlending.logicOpEnable = reader.get<VkBool32>();
+		colorBlending.logicOp = reader.get<VkLogicOp>();
+		blendAttachments = reader.getArray<VkPipelineColorBlendAttachmentState>();
+		colorBlending.attachmentCount = static_cast<uint32_t>(blendAttachments.size());
+		colorBlending.pAttachments = blendAttachments.data();
+		for (float& constant : colorBlending.blendConstants) {
+			constant = reader.get<float>();
+		}
+	}
+
+	std::vector<VkDynamicState> dynamicStates = reader.getArray<VkDynamicState>();
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO; //struct type
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = stageCount;
+	pipelineInfo.pStages = stages.data();
+	pipelineInfo.pVertexInputState = &vertexInput;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = hasDepthStencil ? &depthStencil : nullptr;
+	pipelineInfo.pColorBlendState = hasColorBlending ? &colorBlending : nullptr;
+	pipelineInfo.pDynamicState = dynamicStates.empty() ? nullptr : &dynamicState;
+	pipelineInfo.layout = pipelineLayouts.at(layoutId);
+	pipelineInfo.renderPass = renderPasses.at(renderPassId);
+	pipelineInfo.subpass = subpass;
+
+	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipelines[id]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+/*
+	the traced framebuffer pointed at swap chain images, here every attachment gets its own offscreen image
+*/
+void TraceReplayer::createFramebuffer(const TraceRecord& record)
+{
+	TraceReader reader(record);
+	uint32_t id = reader.get<uint32_t>();
+	uint32_t renderPassId = reader.get<uint32_t>();
+	VkExtent2D extent;
+	extent.width = reader.get<uint32_t>();
+	extent.height = reader.get<uint32_t>();
+	uint32_t layers = reader.get<uint32_t>();
+
+	std::vector<VkImageView> attachments;
+	for (VkFormat format : renderPassFormats.at(renderPassId)) {
+		bool depth = format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+			format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		VkImage image;
+		VkDeviceMemory memory;
+		createImage(device, physicalDevice, extent, format,
+			depth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, image, memory);
+		images.push_back(image);
+		imageMemory.push_back(memory);
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO; //struct type
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = { static_cast<VkImageAspectFlags>(depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT), 0, 1, 0, 1 };
+		VkImageView view;
+		if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create image views!");
+		}
+		imageViews.push_back(view);
+		attachments.push_back(view);
+	}
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO; //struct type
+	framebufferInfo.renderPass = renderPasses.at(renderPassId);
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = layers;
+
+	if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffers[id]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create framebuffer!");
+	}
+}
+
+/*
+	decode the traced commands straight into the command buffer
+*/
+void TraceReplayer::recordFrame(VkCommandBuffer commandBuffer)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //recorded again for the next replay
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+
+	for (const TraceRecord* record : frameCommands) {
+		TraceReader reader(*record);
+		switch (record->op) {
+		case TraceOp::CmdBeginRenderPass: {
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+			renderPassInfo.renderPass = renderPasses.at(reader.get<uint32_t>());
+			renderPassInfo.framebuffer = framebuffers.at(reader.get<uint32_t>());
+			renderPassInfo.renderArea = reader.get<VkRect2D>();
+			std::vector<VkClearValue> clearValues = reader.getArray<VkClearValue>();
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, reader.get<VkSubpassContents>());
+			break;
+		}
+		case TraceOp::CmdBindPipeline: {
+			VkPipelineBindPoint bindPoint = reader.get<VkPipelineBindPoint>();
+			vkCmdBindPipeline(commandBuffer, bindPoint, pipelines.at(reader.get<uint32_t>()));
+			break;
+		}
+		case TraceOp::CmdBindVertexBuffers: {
+			uint32_t first = reader.get<uint32_t>();
+			uint32_t count = reader.get<uint32_t>();
+			std::vector<VkBuffer> vertexBuffers(count);
+			std::vector<VkDeviceSize> offsets(count);
+			for (uint32_t i = 0; i < count; i++) {
+				vertexBuffers[i] = buffers.at(reader.get<uint32_t>());
+				offsets[i] = reader.get<VkDeviceSize>();
+			}
+			vkCmdBindVertexBuffers(commandBuffer, first, count, vertexBuffers.data(), offsets.data());
+			break;
+		}
+		case TraceOp::CmdPushConstants: {
+			VkPipelineLayout layout = pipelineLayouts.at(reader.get<uint32_t>());
+			VkShaderStageFlags stageFlags = reader.get<VkShaderStageFlags>();
+			uint32_t offset = reader.get<uint32_t>();
+			std::vector<uint8_t> values = reader.getArray<uint8_t>();
+			vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, static_cast<uint32_t>(values.size()), values.data());
+			break;
+		}
+		case TraceOp::CmdSetViewport: {
+			uint32_t first = reader.get<uint32_t>();
+			std::vector<VkViewport> viewports = reader.getArray<VkViewport>();
+			vkCmdSetViewport(commandBuffer, first, static_cast<uint32_t>(viewports.size()), viewports.data());
+			break;
+		}
+		case TraceOp::CmdSetScissor: {
+			uint32_t first = reader.get<uint32_t>();
+			std::vector<VkRect2D> scissors = reader.getArray<VkRect2D>();
+			vkCmdSetScissor(commandBuffer, first, static_cast<uint32_t>(scissors.size()), scissors.data());
+			break;
+		}
+		case TraceOp::CmdDraw: {
+			uint32_t vertexCount = reader.get<uint32_t>();
+			uint32_t instanceCount = reader.get<uint32_t>();
+			uint32_t firstVertex = reader.get<uint32_t>();
+			uint32_t firstInstance = reader.get<uint32_t>();
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+			break;
+		}
+		case TraceOp::CmdEndRenderPass:
+			vkCmdEndRenderPass(commandBuffer);
+			break;
+		default:
+			throw std::runtime_error("failed to replay trace, unknown command!");
+		}
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+/*
+	the replay loop: CPU cost is recording plus vkQueueSubmit, GPU cost comes from the frame timer's timestamps
+*/
+void TraceReplayer::replay()
+{
+	std::vector<double> submitTimes;
+	submitTimes.reserve(settings.frames);
+	size_t frame = 0;
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) { //warm up done, start from clean samples
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frame);
+
+		auto submitStart = std::chrono::steady_clock::now();
+		recordFrame(commandBuffers[frame]);
+
+		VkCommandBuffer submitCommandBuffers[3];
+		uint32_t commandBufferCount = 0;
+		if (frameTimer.beginCommandBuffer(frame) != VK_NULL_HANDLE) {
+			submitCommandBuffers[commandBufferCount++] = frameTimer.beginCommandBuffer(frame);
+		}
+		submitCommandBuffers[commandBufferCount++] = commandBuffers[frame];
+		VkCommandBuffer timerEnd = frameTimer.endCommandBuffer(frame);
+		if (timerEnd != VK_NULL_HANDLE) {
+			submitCommandBuffers[commandBufferCount++] = timerEnd;
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; //struct type
+		submitInfo.commandBufferCount = commandBufferCount;
+		submitInfo.pCommandBuffers = submitCommandBuffers;
+
+		vkResetFences(device, 1, &fences[frame]);
+		if (vkQueueSubmit(queue, 1, &submitInfo, fences[frame]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}
+		if (i >= settings.warmupFrames) {
+			submitTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count());
+		}
+
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	std::cout << "replay: " << settings.traceFile << " on " << properties.deviceName << ", " << frameCommands.size() << " commands per frame" << std::endl;
+	std::cout << "  cpu record + submit " << TimingSummary::fromSamples(submitTimes) << std::endl;
+	std::cout << "  cpu frame interval  " << frameTimer.cpuSummary() << std::endl;
+	if (frameTimer.hasGpuTiming()) {
+		std::cout << "  gpu frame           " << frameTimer.gpuSummary() << std::endl;
+	}
+	else {
+		std::cout << "  gpu frame           (timestamps not supported on this queue)" << std::endl;
+	}
+
+	if (!settings.timingsFile.empty()) {
+		std::ofstream timings(settings.timingsFile);
+		if (!timings.is_open()) {
+			throw std::runtime_error("failed to open " + settings.timingsFile + "!");
+		}
+		timings << "frame,submit_ms,gpu_ms\n";
+		const std::vector<double>& gpuTimes = frameTimer.gpuFrameTimes();
+		for (size_t i = 0; i < submitTimes.size(); i++) {
+			timings << i << "," << submitTimes[i] << ",";
+			if (i < gpuTimes.size()) timings << gpuTimes[i];
+			timings << "\n";
+		}
+	}
+}
+
+void TraceReplayer::cleanup()
+{
+	if (device != VK_NULL_HANDLE) {
+		vkDeviceWaitIdle(device);
+		frameTimer.cleanup();
+		for (auto fence : fences) {
+			vkDestroyFence(device, fence, nullptr);
+		}
+		for (auto& framebuffer : framebuffers) {
+			vkDestroyFramebuffer(device, framebuffer.second, nullptr);
+		}
+		for (auto view : imageViews) {
+			vkDestroyImageView(device, view, nullptr);
+		}
+		for (size_t i = 0; i < images.size(); i++) {
+			vkDestroyImage(device, images[i], nullptr);
+			freeDeviceMemory(device, imageMemory[i], nullptr);
+		}
+		for (auto& pipeline : pipelines) {
+			vkDestroyPipeline(device, pipeline.second, nullptr);
+		}
+		for (auto& renderPass : renderPasses) {
+			vkDestroyRenderPass(device, renderPass.second, nullptr);
+		}
+		for (auto& module : shaderModules) {
+			vkDestroyShaderModule(device, module.second, nullptr);
+		}
+		for (auto& layout : pipelineLayouts) {
+			vkDestroyPipelineLayout(device, layout.second, nullptr);
+		}
+		for (auto& buffer : buffers) {
+			vkDestroyBuffer(device, buffer.second, nullptr);
+		}
+		for (VkDeviceMemory memory : bufferMemory) {
+			freeDeviceMemory(device, memory, nullptr);
+		}
+		vkDestroyCommandPool(device, commandPool, nullptr); //also frees the command buffers
+		DeviceMemoryTracker::global().unregisterDevice(device, std::cout);
+		vkDestroyDevice(device, nullptr);
+		device = VK_NULL_HANDLE;
+	}
+	if (instance != VK_NULL_HANDLE) {
+		vkDestroyInstance(instance, nullptr);
+		instance = VK_NULL_HANDLE;
+	}
+}
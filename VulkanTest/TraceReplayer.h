@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "CommandTrace.h"
+#include "FrameTimer.h"
+
+/*
+	settings for replaying a command stream trace, filled in from the command line
+*/
+struct ReplaySettings {
+	std::string traceFile; //trace recorded with --trace-record
+	uint32_t frames = 1000; //number of timed replays of the recorded frame
+	uint32_t warmupFrames = 10; //untimed replays before timing starts
+	std::string timingsFile; //optional csv of the per frame timings
+};
+
+/*
+	Headless replay of a command stream trace
+
+	Creates its own instance and device without a window, recreates the traced resources (offscreen images stand in for
+	the swap chain images) and then re-records and submits the traced frame over and over. There is no application logic
+	in the loop, so the CPU time measured is only the cost of recording and submitting the commands, and the GPU time
+	(timestamp queries around the frame) is only the cost of executing them.
+*/
+class TraceReplayer
+{
+public:
+	explicit TraceReplayer(const ReplaySettings& settings);
+	void run();
+
+private:
+	void createDevice();
+	void createResources();
+	void createRenderPass(const TraceRecord& record);
+	void createPipelineLayout(const TraceRecord& record);
+	void createBuffer(const TraceRecord& record);
+	void createPipeline(const TraceRecord& record);
+	void createFramebuffer(const TraceRecord& record);
+	void recordFrame(VkCommandBuffer commandBuffer);
+	void replay();
+	void cleanup();
+
+	ReplaySettings settings;
+	CommandTrace trace;
+	std::vector<const TraceRecord*> frameCommands; //records between BeginFrame and EndFrame
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint32_t queueFamily = 0;
+	uint32_t timestampValidBits = 0;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+
+	//traced objects by id
+	std::map<uint32_t, VkShaderModule> shaderModules;
+	std::map<uint32_t, VkRenderPass> renderPasses;
+	std::map<uint32_t, std::vector<VkFormat>> renderPassFormats; //attachment formats, needed to create framebuffer images
+	std::map<uint32_t, VkPipelineLayout> pipelineLayouts;
+	std::map<uint32_t, VkBuffer> buffers;
+	std::vector<VkDeviceMemory> bufferMemory;
+	std::map<uint32_t, VkPipeline> pipelines;
+	std::map<uint32_t, VkFramebuffer> framebuffers;
+	std::vector<VkImage> images; //attachments of the replayed framebuffers
+	std::vector<VkImageView> imageViews;
+	std::vector<VkDeviceMemory> imageMemory;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
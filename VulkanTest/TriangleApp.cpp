@@ -1,9 +1,26 @@
 #include "TriangleApp.h"
 
+#include "VulkanUtils.h"
 
+#include <glm/gtc/matrix_transform.hpp>
 
-TriangleApp::TriangleApp()
+#include <filesystem>
+#include <sstream>
+#include <cstring>
+#include <chrono>
+#include <limits>
+
+
+TriangleApp::TriangleApp(const AppOptions& options) : options(options)
 {
+	enableValidationLayers = options.validation;
+	if (options.hostAllocator) {
+		allocationCallbacks = hostAllocator.callbacks();
+	}
+	framesInFlight = std::min(std::max(options.framesInFlight, 1u), 8u);
+	if (!options.presentMode.empty()) {
+		presentModeOverride = parsePresentMode(options.presentMode);
+	}
 }
 
 /*
@@ -11,6 +28,15 @@ TriangleApp::TriangleApp()
 */
 void TriangleApp::run()
 {
+	if (options.headless) { //no window, render the golden scenes and report
+		initVulkan();
+		bool passed = runGoldenTests();
+		cleanup();
+		if (!passed) {
+			throw std::runtime_error("golden image comparison failed!");
+		}
+		return;
+	}
 	initWindow();
 	initVulkan();
 	mainLoop();
@@ -26,19 +52,69 @@ TriangleApp::~TriangleApp()
 */
 void TriangleApp::initVulkan()
 {
+	if (enableValidationLayers) {
+		validationLog.start(options.validationLog); //before the instance, its creation is already reported through the log
+	}
 	createInstance(); //create an instance to store vulkan related state
 	setupDebugMessenger();//setup the debug messenger to hold state for the debug extension layer
-	createSurface(); //create a surface we can render images to
+	if (!options.headless) {
+		createSurfaces(); //create a surface per window we can render images to
+	}
+	else {
+		windows.resize(1); //a single offscreen target stands in for the window
+	}
 	pickPhysicalDevice(); //pick a physical device we will use for our graphics pipeline
 	createLogicalDevice(); //create a logical device wrapper with the necessary resources around the physical device
-	createSwapChain(); //create a swapchain that we can use to render images to the surface
-	createImageViews(); //create the image views that will hold additional info about the images in the swapchain
+	if (!options.traceFile.empty()) {
+		traceRecorder.begin(); //trace the objects created below and the commands of the first frame
+	}
+	for (auto& target : windows) {
+		createSwapChain(target); //create a swapchain that we can use to render images to the surface
+		createImageViews(target); //create the image views that will hold additional info about the images in the swapchain
+	}
 	createRenderPass(); //create a render pass that specifies all the stages of the render
 	createGraphicsPipeline(); //create a graphics pipeline to process drawing commands and render to the surface
-	createFramebuffers(); //create a framebuffer to represent the set of images the graphics pipeline will render to
+	for (auto& target : windows) {
+		createFramebuffers(target); //create a framebuffer to represent the set of images the graphics pipeline will render to
+	}
 	createCommandPool(); //create a command pool to manage allocation of command buffers
-	createCommandBuffers(); //create the command buffer from the pool with the appropriate commands
+	createVertexBuffer(); //upload the packed triangle
+	for (auto& target : windows) {
+		createCommandBuffers(target); //create the command buffer from the pool with the appropriate commands
+	}
 	createSyncObjects(); //create synchronization primitives to control rendering
+	if (!options.traceFile.empty()) {
+		traceRecorder.save(options.traceFile);
+		std::cout << "trace: " << traceRecorder.recordCount() << " records written to " << options.traceFile << std::endl;
+	}
+	if (options.capture.enabled) { //start the readback ring and encoder threads if we are capturing frames
+		frameCapture.init(device, physicalDevice, findQueueFamilies(physicalDevice).graphicsFamily.value(), framesInFlight, options.capture);
+	}
+	if (options.headless) { //the golden run reads back the last frame of every scene and times every frame
+		uint32_t graphicsFamily = findQueueFamilies(physicalDevice).graphicsFamily.value();
+		CaptureSettings captureSettings;
+		captureSettings.enabled = true;
+		captureSettings.outputDirectory = options.golden.outputDirectory;
+		captureSettings.encoderThreads = 1; //only one frame per scene is read back
+		frameCapture.init(device, physicalDevice, graphicsFamily, framesInFlight, captureSettings);
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+		frameTimer.init(device, physicalDevice, commandPool, framesInFlight, queueFamilies[graphicsFamily].timestampValidBits);
+	}
+	else if (options.usageReportInterval > 0.0) {
+		uint32_t graphicsFamily = findQueueFamilies(physicalDevice).graphicsFamily.value();
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+		frameTimer.init(device, physicalDevice, commandPool, framesInFlight, queueFamilies[graphicsFamily].timestampValidBits); //for the GPU share of the usage report
+	}
+	if (allocationCallbacks != nullptr) {
+		hostAllocations.init(&hostAllocator, options.hostAllocationReportInterval); //per frame counting starts once setup is done
+	}
 }
 
 /*
@@ -49,9 +125,28 @@ void TriangleApp::initWindow()
 	glfwInit(); //init glfw
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);//set glfw to no API
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);//we want the window to be resize-able
-	window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);//create the window
-	glfwSetWindowUserPointer(window, this); //set the user pointer (used to determine who is controlling the window)
-	glfwSetFramebufferSizeCallback(window, framebufferResizeCallback); //setup the window resize call back function
+	windows.resize(std::max(options.windowCount, 1u));
+	windowInputs.resize(windows.size());
+	for (size_t i = 0; i < windows.size(); i++) {
+		std::string title = i == 0 ? "Vulkan" : "Vulkan " + std::to_string(i + 1);
+		GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, title.c_str(), nullptr, nullptr);//create the window
+		if (window == nullptr) {
+			throw std::runtime_error("failed to create window!");
+		}
+		if (i > 0) { //cascade the extra windows so they do not hide each other
+			int x, y;
+			glfwGetWindowPos(windows[0].window, &x, &y);
+			glfwSetWindowPos(window, x + 40 * static_cast<int>(i), y + 40 * static_cast<int>(i));
+		}
+		glfwSetWindowUserPointer(window, this); //set the user pointer (used to determine who is controlling the window)
+		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback); //setup the window resize call back function
+		glfwSetCursorPosCallback(window, cursorPositionCallback); //track the cursor for picking
+		glfwSetMouseButtonCallback(window, mouseButtonCallback); //pick on left click, drag with the right button
+		glfwSetKeyCallback(window, keyCallback); //M dumps the device memory
+		windows[i].window = window;
+		glfwGetFramebufferSize(window, &windows[i].framebufferWidth, &windows[i].framebufferHeight); //for the first swap chain
+		windowInputs[i].window = window;
+	}
 }
 
 /*
@@ -59,14 +154,324 @@ void TriangleApp::initWindow()
 */
 void TriangleApp::mainLoop()
 {
-	//event loop
-	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
-		drawFrame();
+	//the render thread starts from the first frame state, so there is always one to read
+	simulate();
+	renderRunning = true;
+	renderThread = std::thread(&TriangleApp::renderLoop, this);
+	usageStart = std::chrono::steady_clock::now();
+	usageCpuStart = processCpuMilliseconds();
+	memoryReportStart = usageStart;
+
+	//event loop, runs until the last window is closed. waiting with a timeout wakes up as soon as input arrives, so input
+	//is handled straight away however long the render thread is blocked in acquire or on a fence. when nothing can
+	//change without an event (on demand rendering, or every window minimised) it waits for the next event instead
+	bool open = true;
+	while (open && !renderStopped) {
+		bool idle = options.onDemand || allMinimised;
+		double untilReport = std::numeric_limits<double>::infinity();
+		if (options.usageReportInterval > 0.0) {
+			untilReport = options.usageReportInterval - std::chrono::duration<double>(std::chrono::steady_clock::now() - usageStart).count();
+		}
+		if (options.memoryReportInterval > 0.0) {
+			untilReport = std::min(untilReport, options.memoryReportInterval - std::chrono::duration<double>(std::chrono::steady_clock::now() - memoryReportStart).count());
+		}
+		if (untilReport != std::numeric_limits<double>::infinity()) { //wake up for the reports as well
+			glfwWaitEventsTimeout(std::max(idle ? untilReport : std::min(untilReport, SIMULATION_STEP), 0.0));
+		}
+		else if (idle) {
+			glfwWaitEvents();
+		}
+		else {
+			glfwWaitEventsTimeout(SIMULATION_STEP);
+		}
+		open = false;
+		for (auto& input : windowInputs) {
+			if (!input.closed && glfwWindowShouldClose(input.window)) {
+				input.closed = true; //the render thread retires its resources when it sees the state
+				glfwHideWindow(input.window); //gone for the user straight away
+			}
+			open = open || !input.closed;
+		}
+		simulate();
+		if (options.usageReportInterval > 0.0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - usageStart).count() >= options.usageReportInterval) {
+			reportUsage();
+		}
+		if (options.memoryReportInterval > 0.0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - memoryReportStart).count() >= options.memoryReportInterval) {
+			DeviceMemoryTracker::global().report(device, std::cout); //the tracker is locked, the render thread may allocate meanwhile
+			memoryReportStart = std::chrono::steady_clock::now();
+		}
 	}
 
-	//cleaning up resources that are in use are bad (async code in use). we wait for the device to finish rendering before cleaning up
-	vkDeviceWaitIdle(device);
+	renderRunning = false;
+	wakeRenderThread();
+	renderThread.join();
+	//cleaning up resources that are in use are bad (async code in use). we wait for the submitted frames to finish rendering before cleaning up
+	waitForSubmittedFrames();
+	if (renderError) {
+		std::rethrow_exception(renderError);
+	}
+}
+
+/*
+	main thread: print the frame rate and how busy the process and the GPU were since the last report, then start
+	the next interval. GPU busy time is the sum of the frames' timestamp intervals
+*/
+void TriangleApp::reportUsage()
+{
+	auto now = std::chrono::steady_clock::now();
+	double cpu = processCpuMilliseconds();
+	uint64_t frames = framesPresented, gpu = gpuBusyMicroseconds;
+	double milliseconds = std::chrono::duration<double, std::milli>(now - usageStart).count();
+	if (milliseconds > 0.0) {
+		std::cout << "usage: " << (frames - usageFramesStart) * 1000.0 / milliseconds << " frames/s, CPU " << (cpu - usageCpuStart) * 100.0 / milliseconds
+			<< "% of a core, GPU " << (gpu - usageGpuStart) / 10.0 / milliseconds << "% busy" << (options.onDemand ? " (on demand)" : "") << std::endl;
+	}
+	usageStart = now;
+	usageCpuStart = cpu;
+	usageFramesStart = frames;
+	usageGpuStart = gpu;
+}
+
+/*
+	write the device memory usage per heap and subsystem and every live allocation as JSON, failures are reported rather
+	than thrown as the dump is only a diagnostic
+*/
+void TriangleApp::dumpDeviceMemory(const std::string& filename)
+{
+	try {
+		DeviceMemoryTracker::global().writeJson(device, filename);
+		std::cout << "device memory: written to " << filename << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+	}
+}
+
+/*
+	main thread: advance the simulation by a step and hand the result to the render thread
+	the triangle only moves when dragged, so the step is just the newest offset and the state of the windows. in on
+	demand mode a step that would draw the same image is not handed over, returns whether it was
+*/
+bool TriangleApp::simulate()
+{
+	FrameState& state = frameStates.writeSlot(); //an old state, every field is written again
+	state.offset = triangleOffset;
+	state.windows.resize(windowInputs.size());
+	allMinimised = true;
+	for (size_t i = 0; i < windowInputs.size(); i++) {
+		FrameState::Window& window = state.windows[i];
+		glfwGetFramebufferSize(windowInputs[i].window, &window.framebufferWidth, &window.framebufferHeight);
+		window.resizes = windowInputs[i].resizes;
+		window.closed = windowInputs[i].closed;
+		allMinimised = allMinimised && (window.closed || window.framebufferWidth == 0 || window.framebufferHeight == 0);
+	}
+	if (options.onDemand && simulationStep > 0 && state.drawsSameAs(publishedState)) {
+		return false; //nothing to draw, the slot stays ours and is written again next step
+	}
+	state.step = ++simulationStep;
+	state.sampled = std::chrono::steady_clock::now(); //the callbacks that changed the state ran just before
+	if (options.onDemand) {
+		publishedState = state;
+	}
+	frameStates.publish();
+	wakeRenderThread();
+	return true;
+}
+
+/*
+	wake the render thread if it is waiting for something to draw. the request is kept when it is not waiting, so a
+	state published while it draws is picked up straight after
+*/
+void TriangleApp::wakeRenderThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(renderWakeMutex);
+		renderWakeRequested = true;
+	}
+	renderWake.notify_one();
+}
+
+/*
+	render thread: sleep until the main thread publishes a state or stops the render thread
+*/
+void TriangleApp::waitForRenderWake()
+{
+	std::unique_lock<std::mutex> lock(renderWakeMutex);
+	renderWake.wait(lock, [this] { return renderWakeRequested || !renderRunning; });
+	renderWakeRequested = false;
+}
+
+/*
+	render thread: draw the newest frame state until the main thread says stop
+	the state is applied to the windows first: new sizes and resizes for the swap chains, closed windows are retired
+*/
+void TriangleApp::renderLoop()
+{
+	try {
+		if (options.latency.enabled) {
+			measureLatency();
+		}
+		else {
+			while (renderRunning) {
+				bool drawn = renderFrame();
+				//every window is minimised or closed, or on demand the image is up to date: sleep until a new state arrives
+				if (options.onDemand ? !redrawRequested : !drawn) {
+					waitForRenderWake();
+				}
+			}
+		}
+	}
+	catch (...) {
+		renderError = std::current_exception();
+	}
+	renderStopped = true;
+	glfwPostEmptyEvent(); //the main thread may be waiting for events
+}
+
+/*
+	render thread: apply the newest frame state to the windows (new sizes and resizes for the swap chains, closed
+	windows are retired) and draw it, returns false when nothing could be drawn
+*/
+bool TriangleApp::renderFrame()
+{
+	if (options.latency.enabled) { //the frame may be held back, so the state is taken after the wait
+		presentLatency.waitForFrameStart(windows[0].swapChain, inFlightFences[(currentFrame + framesInFlight - 1) % framesInFlight],
+			frameSerials[(currentFrame + framesInFlight - 1) % framesInFlight]);
+	}
+	frameStates.acquire(); //keeps the state we have when nothing new was published
+	const FrameState& state = frameStates.readSlot();
+	for (size_t i = 0; i < windows.size(); i++) {
+		WindowTarget& target = windows[i];
+		const FrameState::Window& window = state.windows[i];
+		if (target.closed) {
+			continue;
+		}
+		if (window.closed) {
+			closeWindow(i);
+			continue;
+		}
+		target.framebufferWidth = window.framebufferWidth;
+		target.framebufferHeight = window.framebufferHeight;
+		if (window.resizes != target.resizesSeen) {
+			target.resizesSeen = window.resizes;
+			target.framebufferResized = true;
+		}
+	}
+	return drawFrame(state);
+}
+
+/*
+	render thread, latency run: every present mode the first window's surface supports (or only the one asked for) is
+	measured for a number of frames as the app runs freely and then with the frame pacer, and the percentiles of each
+	are printed. the main thread keeps sampling input as usual, so input to present includes its polling interval
+*/
+void TriangleApp::measureLatency()
+{
+	WindowTarget& first = windows[0];
+	SwapChainSupportDetails support = querySwapChainSupport(physicalDevice, first.surface);
+	std::vector<VkPresentModeKHR> presentModes;
+	for (VkPresentModeKHR presentMode : { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR }) {
+		bool supported = std::find(support.presentModes.begin(), support.presentModes.end(), presentMode) != support.presentModes.end();
+		bool wanted = options.presentMode.empty() || presentMode == parsePresentMode(options.presentMode);
+		if (supported && wanted) {
+			presentModes.push_back(presentMode);
+		}
+	}
+	std::cout << "latency: " << framesInFlight << " frames in flight, " << options.latency.frames << " frames per case, "
+		<< (presentLatency.usesPresentWait() ? "present times from VK_KHR_present_wait" : "VK_KHR_present_wait unavailable, frames end when their fence signals") << std::endl;
+
+	for (VkPresentModeKHR presentMode : presentModes) {
+		presentModeOverride = presentMode;
+		for (auto& target : windows) {
+			if (!target.closed) {
+				recreateSwapChain(target); //the override is picked up by createSwapChain
+			}
+		}
+		for (bool pacing : { false, true }) {
+			presentLatency.beginCase(pacing);
+			while (renderRunning && !first.closed && !presentLatency.caseComplete()) {
+				if (!renderFrame()) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			}
+			if (!renderRunning || first.closed) {
+				return; //closed before the run was done
+			}
+			std::cout << presentLatency.endCase(first.swapChain, presentMode) << std::endl;
+		}
+	}
+}
+
+/*
+	render thread: a window was closed while others may still be open. its swap chain is retired as on a resize, and its
+	semaphores and surface follow once the frames and presents that could still use them are done. nothing waits here,
+	the other windows keep rendering, and the closed target is left out of every later frame's submit and present. the
+	GLFW window itself belongs to the main thread and is destroyed in cleanup
+*/
+void TriangleApp::closeWindow(size_t index)
+{
+	WindowTarget& target = windows[index];
+	cleanupSwapChain(target);
+
+	VkDevice device = this->device;
+	VkInstance instance = vkInstance;
+	const VkAllocationCallbacks* allocator = allocationCallbacks;
+	std::vector<VkSemaphore> semaphores = target.imageAvailableSemaphores;
+	semaphores.insert(semaphores.end(), target.renderFinishedSemaphores.begin(), target.renderFinishedSemaphores.end());
+	VkSurfaceKHR surface = target.surface;
+	retireAfterPresents([=]() { //after the swap chain, which was pushed first with the same serial
+		for (VkSemaphore semaphore : semaphores) {
+			vkDestroySemaphore(device, semaphore, allocator);
+		}
+		vkDestroySurfaceKHR(instance, surface, allocator);
+	});
+	target.closed = true;
+}
+
+/*
+	main thread: the input state of a GLFW window
+*/
+WindowInput* TriangleApp::findWindow(GLFWwindow* window)
+{
+	for (auto& input : windowInputs) {
+		if (input.window == window) {
+			return &input;
+		}
+	}
+	return nullptr;
+}
+
+/*
+	shutdown only: wait for every frame in flight so the deletion queue and the remaining objects can be destroyed
+*/
+void TriangleApp::waitForSubmittedFrames()
+{
+	vkWaitForFences(device, static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), VK_TRUE, UINT64_MAX);
+	completedFrames = submittedFrames;
+	vkQueueWaitIdle(presentationQueue); //presents have no fence in Vulkan 1.0 and still wait on the renderFinished semaphores
+}
+
+/*
+	the fence of a frame in flight has been seen signalled, so every submission up to the one it guarded has completed
+	and whatever was retired before it can be destroyed
+*/
+void TriangleApp::frameFenceSignalled(size_t frame)
+{
+	completedFrames = std::max(completedFrames, frameSerials[frame]);
+	deletionQueue.collect(completedFrames);
+}
+
+/*
+	hand objects that the queued presents may still use (swap chains, renderFinished semaphores) to the deletion queue
+	a frame fence only covers its queue submit, not the present that follows it and waits on the frame's renderFinished
+	semaphore, so they are tagged with the next frame's serial: that frame is submitted after the presents queued so far,
+	and once its fence has signalled the queue has got past their semaphore waits. that holds when graphics and present
+	share a queue, the usual case; with separate queues nothing orders the two, only VK_EXT_swapchain_maintenance1
+	present fences would make it exact. at shutdown waitForSubmittedFrames drains the present queue instead
+*/
+void TriangleApp::retireAfterPresents(DeletionQueue::Deleter deleter)
+{
+	deletionQueue.push(submittedFrames + 1, std::move(deleter));
 }
 
 /*
@@ -109,6 +514,33 @@ void TriangleApp::createLogicalDevice()
 	QueueFamilyIndices indices = findQueueFamilies(physicalDevice); //get the indices of the queues we want to use
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos; //store the createInfo structs for the queues we want to use on the device 
 	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+
+	//only what the app uses is enabled: the triangle needs no optional core feature, the swap chain needs its
+	//extension unless headless, and robustness costs a bounds check on every buffer access so it is only on when asked for
+	//VK_EXT_memory_budget costs nothing and gives the memory reports the driver's budget and usage per heap
+	deviceFeatures.init(physicalDevice);
+	memoryBudgetExtension = deviceFeatures.wantExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (!options.headless) {
+		for (const char* extension : deviceExtensions) {
+			deviceFeatures.requireExtension(extension);
+		}
+	}
+	if (options.robustBufferAccess) {
+		deviceFeatures.want(&VkPhysicalDeviceFeatures::robustBufferAccess, "robustBufferAccess");
+	}
+#if defined(VK_KHR_present_id) && defined(VK_KHR_present_wait)
+	//the latency run times presents with VK_KHR_present_wait where the device has it
+	if (options.latency.enabled && !options.headless
+		&& deviceFeatures.supportsExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && deviceFeatures.supportsExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+		&& deviceFeatures.supports(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR, &VkPhysicalDevicePresentIdFeaturesKHR::presentId)
+		&& deviceFeatures.supports(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR, &VkPhysicalDevicePresentWaitFeaturesKHR::presentWait)) {
+		deviceFeatures.requireExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+		deviceFeatures.requireExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+		deviceFeatures.require(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR, &VkPhysicalDevicePresentIdFeaturesKHR::presentId, "presentId");
+		deviceFeatures.require(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR, &VkPhysicalDevicePresentWaitFeaturesKHR::presentWait, "presentWait");
+		presentWaitEnabled = true;
+	}
+#endif
 	//command priority execution, determines how commands are scheduled and this is even needed in the case of 1 queue
 	float queuePriority = 1.0f; //priority of the queues we wish to create
 	for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -120,17 +552,12 @@ void TriangleApp::createLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo); //push back the struct on to our array of queue create info structs
 	}
 
-	//now we setup the features we want to use with vulkan, but nothing much as of yet
-	VkPhysicalDeviceFeatures deviceFeatures = {};
-	vkGetPhysicalDeviceFeatures(physicalDevice, &deviceFeatures); //enable all the device features available by simply querying the device for what features it supports
 	//this is like before but now we are setting the config for the device we chose
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO; //type of createInfo struct
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()); //the number of queues we wish to use
 	createInfo.pQueueCreateInfos = queueCreateInfos.data(); //the config data for the queues we wish to use
-	createInfo.pEnabledFeatures = &deviceFeatures; //features we are opting in to use
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());//the number of enabled extensions we have
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data(); //the array containing the names of all the extensions we wish to use
+	deviceFeatures.apply(createInfo); //the negotiated features and extensions, through the VkPhysicalDeviceFeatures2 chain when there are chained ones
 	if (enableValidationLayers) { //if we want to enable layers (validation in this case)
 		createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size()); //set the number of enabled layers we have (1 in this case)
 		createInfo.ppEnabledLayerNames = validationLayers.data(); // provide the names of the validation layers we want to enable
@@ -139,12 +566,16 @@ void TriangleApp::createLogicalDevice()
 		createInfo.enabledLayerCount = 0; //set it to 0 if we don't want any validation layers
 	}
 	//instantiate the logical device now
-	if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) { //if we are not successful
+	if (vkCreateDevice(physicalDevice, &createInfo, allocationCallbacks, &device) != VK_SUCCESS) { //if we are not successful
 		throw std::runtime_error("failed to create logical device!"); //stop and throw an error
 	}
+	DeviceMemoryTracker::global().registerDevice(device, physicalDevice, memoryBudgetExtension); //before anything is allocated on it
 
 	vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue); //store a reference to the graphics queue that was created on the device
 	vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentationQueue); //store a reference to the presentation queue that was created on the device
+	if (options.latency.enabled) {
+		presentLatency.init(device, presentWaitEnabled, options.latency);
+	}
 }
 
 /*
@@ -152,12 +583,18 @@ void TriangleApp::createLogicalDevice()
 */
 bool TriangleApp::isDeviceSuitable(VkPhysicalDevice device) {
 	QueueFamilyIndices indices = findQueueFamilies(device); //get the queue families we want to use
+	if (options.headless) {
+		return indices.isComplete(); //nothing is presented, any device with a graphics queue will do
+	}
 	bool deviceHasExtensions = checkDeviceExtensionSupport(device); //check if the device also supports the extensions we want to use
 	bool swapChainAdequate = false; //boolean flag to check if the swapchain is good
 	//proceed only if the device has extensions
 	if (deviceHasExtensions) {
-		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device); // get the details of the swap chain supported by the device is good for our purposes
-		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty(); //check if there are formats and presentation modes for the swap chain
+		swapChainAdequate = true;
+		for (const auto& target : windows) { //every window's surface has to be usable
+			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, target.surface); // get the details of the swap chain supported by the device is good for our purposes
+			swapChainAdequate = swapChainAdequate && !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty(); //check if there are formats and presentation modes for the swap chain
+		}
 	}
 	return indices.isComplete() && deviceHasExtensions && swapChainAdequate; //if the device has queues, extensions and a swap chain we can use we have found a suitable device
 }
@@ -177,36 +614,83 @@ void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT
 */
 void TriangleApp::cleanup()
 {
-	
-	cleanupSwapChain(); //first we clean up the swap chain and all related resources
+	frameCapture.cleanup(); //write out the remaining captured frames before the device goes away
+
+	if (!options.memoryDumpFile.empty()) {
+		dumpDeviceMemory(options.memoryDumpFile); //what the app holds in its steady state, before anything is freed
+	}
+	if (options.memoryReportInterval > 0.0) {
+		DeviceMemoryTracker::global().report(device, std::cout);
+	}
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) { //destroy all synchronization objects
-		vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
-		vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
-		vkDestroyFence(device, inFlightFences[i], nullptr);
+	for (auto& target : windows) {
+		if (!target.closed) {
+			cleanupSwapChain(target); //first we clean up the swap chains and all related resources
+		}
+	}
+	deletionQueue.flush(); //the frames have completed, destroy everything that was retired, closed windows included
+
+	for (auto& target : windows) { //destroy all synchronization objects
+		if (target.closed) {
+			continue; //went with the deletion queue
+		}
+		for (size_t i = 0; i < framesInFlight; i++) {
+			vkDestroySemaphore(device, target.renderFinishedSemaphores[i], allocationCallbacks);
+			vkDestroySemaphore(device, target.imageAvailableSemaphores[i], allocationCallbacks);
+		}
+	}
+	for (size_t i = 0; i < framesInFlight; i++) {
+		vkDestroyFence(device, inFlightFences[i], allocationCallbacks);
 	}
 
-	vkDestroyCommandPool(device, commandPool, nullptr); //destroy the command pool
+	vkDestroyPipeline(device, graphicsPipeline, allocationCallbacks); //shared by every window, so it outlives their swap chains
+	vkDestroyPipelineLayout(device, pipelineLayout, allocationCallbacks);
+	vkDestroyRenderPass(device, renderPass, allocationCallbacks);
 
-	vkDestroyDevice(device, nullptr); //destroy the logical device
+	frameTimer.cleanup(); //its command buffers come from the command pool
+
+	vkDestroyCommandPool(device, commandPool, allocationCallbacks); //destroy the command pool
+
+	vkDestroyBuffer(device, vertexBuffer, allocationCallbacks); //no frame is in flight any more, so the vertex data can go
+	freeDeviceMemory(device, vertexBufferMemory, allocationCallbacks);
+
+	DeviceMemoryTracker::global().unregisterDevice(device, std::cout); //everything allocated on the device should be freed by now
+	vkDestroyDevice(device, allocationCallbacks); //destroy the logical device
 
 	if (enableValidationLayers) {
-		DestroyDebugUtilsMessengerEXT(vkInstance, debugMessenger, nullptr); //destroy the validation layer
+		DestroyDebugUtilsMessengerEXT(vkInstance, debugMessenger, allocationCallbacks); //destroy the validation layer
 	}
 
-	vkDestroySurfaceKHR(vkInstance, surface, nullptr); //destroy the surface used for presentation
-	vkDestroyInstance(vkInstance, nullptr); //destroy the vulkan instance
+	if (!options.headless) {
+		for (auto& target : windows) {
+			if (!target.closed) {
+				vkDestroySurfaceKHR(vkInstance, target.surface, allocationCallbacks); //destroy the surface used for presentation
+			}
+		}
+	}
+	vkDestroyInstance(vkInstance, allocationCallbacks); //destroy the vulkan instance
+	validationLog.stop(); //no more messages can arrive, write the rest and the repeat summary
+
+	if (allocationCallbacks != nullptr) {
+		hostAllocations.print(std::cout); //everything the driver allocated should be freed again by now
+	}
 
-	glfwDestroyWindow(window); //destroy the window
+	if (!options.headless) {
+		for (auto& input : windowInputs) {
+			glfwDestroyWindow(input.window); //destroy the window, closed ones were only hidden
+		}
 
-	glfwTerminate(); //stop GLFW
+		glfwTerminate(); //stop GLFW
+	}
 }
 
 //get info to setup extensions
 std::vector<const char*> TriangleApp::getRequiredExtensions() {
 	uint32_t glfwExtensionCount = 0; //used as out parameter to know how many extensions are needed by GLFW
-	const char** glfwExtensions; //array of extension names needed by GLFW
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount); //method to get all extensions needed by GLFW
+	const char** glfwExtensions = nullptr; //array of extension names needed by GLFW
+	if (!options.headless) { //headless rendering has no window and needs no surface extensions
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount); //method to get all extensions needed by GLFW
+	}
 
 	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount); //create an array to hold all of the required extension names
 
@@ -239,9 +723,17 @@ QueueFamilyIndices TriangleApp::findQueueFamilies(VkPhysicalDevice device)
 	for (const auto& queueFamily : queueFamilies) {
 		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) { //if this queue has the graphics bit set
 			indices.graphicsFamily = i; //we have found the queue we will use to submit render jobs
+			if (options.headless) {
+				indices.presentFamily = i; //nothing is presented, the graphics queue stands in for the present queue
+				break;
+			}
+		}
+		VkBool32 presentSupport = true; //boolean flag to indicate queues support of presentation operations
+		for (const auto& target : windows) { //one queue presents to every window, so it has to support all of their surfaces
+			VkBool32 surfaceSupport = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, target.surface, &surfaceSupport); //query if the queue has presentation operations supported
+			presentSupport = presentSupport && surfaceSupport;
 		}
-		VkBool32 presentSupport = false; //boolean flag to indicate queues support of presentation operations
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport); //query if the queue has presentation operations supported
 		if (presentSupport) { //if it does
 			indices.presentFamily = i; //we found the queue we will use to render frames (usually the same as the graphics queue)
 		}
@@ -268,7 +760,7 @@ void TriangleApp::createInstance()
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0); //version of the application (useful for tools and drivers to act accordingly should there be a need)
 	appInfo.pEngineName = "No Engine"; //name (string nul-terminated) of the engine middleware the application is based on
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0); //version of the middleware the application is based on
-	appInfo.apiVersion = VK_API_VERSION_1_0; //version of the Vulkan API that your application is expecting to run on
+	appInfo.apiVersion = VK_API_VERSION_1_1; //version of the Vulkan API that your application is expecting to run on, 1.1 for vkGetPhysicalDeviceFeatures2
 	appInfo.pNext = nullptr; //field to provide additional arguments in a linked list like fashion, useful for extending structs without having to rewrite them entirely
 
 	//creation info
@@ -297,7 +789,7 @@ void TriangleApp::createInstance()
 		createInfo.pNext = nullptr; //field to provide additional arguments in a linked list like fashion, useful for extending structs without having to rewrite them entirely (nothing here)
 	}
 
-	VkResult result = vkCreateInstance(&createInfo, nullptr, &vkInstance); 	//issue instance creation call with info, and no callbacks
+	VkResult result = vkCreateInstance(&createInfo, allocationCallbacks, &vkInstance); 	//issue instance creation call with info, and our host allocation callbacks (nullptr when disabled)
 	
 	if (result != VK_SUCCESS) { //if the instance was not created successfully
 		throw std::runtime_error("failed to create instance!"); //throw an error and stop proceeding with setup
@@ -305,9 +797,9 @@ void TriangleApp::createInstance()
 }
 
 /*
-	create a surface that we can use to present rendered images to
+	create a surface for every window that we can use to present rendered images to
 */
-void TriangleApp::createSurface()
+void TriangleApp::createSurfaces()
 {
 	//very simple glfw method to make a surface to render to.
 	//this is used because the vk method requires us to fill in a struct with config data
@@ -315,10 +807,12 @@ void TriangleApp::createSurface()
 	//glfwGetRequiredExtensions was used earlier to setup the required platform specific extensions that need to be used to create the surface
 	//this method lets us continue writing platform independent code rather than having to specify for each platform the extensions and the appropriate
 	//calls to create the surface
-	VkResult result = glfwCreateWindowSurface(vkInstance, window, nullptr, &surface);
-	if (result!= VK_SUCCESS) {
-		std::cout << result << std::endl;
-		throw std::runtime_error("failed to create window surface");
+	for (auto& target : windows) {
+		VkResult result = glfwCreateWindowSurface(vkInstance, target.window, allocationCallbacks, &target.surface);
+		if (result != VK_SUCCESS) {
+			std::cout << result << std::endl;
+			throw std::runtime_error("failed to create window surface");
+		}
 	}
 }
 
@@ -330,12 +824,21 @@ void TriangleApp::createSurface()
 	the swap chain will then present us with 1 or more images we can use to render to the window
 	the swap chain will manage the images in a ring or circular buffer, where we can ask it to give us the next available image, while another is being rendered to the window
 */
-void TriangleApp::createSwapChain()
+void TriangleApp::createSwapChain(WindowTarget& target)
 {
-	SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice); //query what is supported by the swap chain on the physical device (we want surface capabilities, surface formats, and presentation modes) 
+	if (options.headless) { //no surface to negotiate with, render into our own images
+		createHeadlessImages(target);
+		return;
+	}
+	SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, target.surface); //query what is supported by the swap chain on the physical device (we want surface capabilities, surface formats, and presentation modes)
 	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats); //setup the surface formats (buffer properties), presentation mode (buffers) and extent (resolution of rendering)
 	VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes); //which kind of presentation mode do we want to use (MAIL_BOX etc...)
-	VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities); //choose an appropriate swapchain extent
+	VkExtent2D extent = chooseSwapExtent(target, swapChainSupport.capabilities); //choose an appropriate swapchain extent
+	for (const auto& other : windows) { //the render pass and pipeline are shared, so every window has to render to the same format
+		if (&other != &target && other.swapChainImageFormat != VK_FORMAT_UNDEFINED && other.swapChainImageFormat != surfaceFormat.format) {
+			throw std::runtime_error("failed to find a swap chain format shared by every window!");
+		}
+	}
 
 	//setting for the minimum number of images that must be in the swap chain. +1 because we don't want to wait and do nothing while the device does driver operations.
 	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1; //if this is set to 1 it means that we want to render directly to the front buffer, which is bad and not supported by all devices, 3 is recommended
@@ -346,13 +849,20 @@ void TriangleApp::createSwapChain()
 	//setup the config for the swap chain
 	VkSwapchainCreateInfoKHR createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR; //swap chain type
-	createInfo.surface = surface; //surface we are tying the swap chain to
+	createInfo.surface = target.surface; //surface we are tying the swap chain to
 	createInfo.minImageCount = imageCount; // the minimum number of images we need
 	createInfo.imageFormat = surfaceFormat.format; //the supported format (in memory representation of pixels) we wish to use to render
 	createInfo.imageColorSpace = surfaceFormat.colorSpace; //the color space which will be RGB or sRGB, whichever is supported by the surface
 	createInfo.imageExtent = extent; //dimensions of the image in the swap chain
 	createInfo.imageArrayLayers = 1; //number of layers each image consists of, can be used to present a layered image to the user, or specific layers of an image
 	createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; //how will we use the image (in addition to it being used as presentation)
+	if (options.capture.enabled) { //in capture mode the images are also copied into readback buffers
+		if (!(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+			throw std::runtime_error("capture mode requested, but the swap chain images cannot be used as a transfer source!");
+		}
+		texelSize(surfaceFormat.format); //refuse formats the capture cannot convert before anything is rendered
+		createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //allow the images to be the source of a copy command
+	}
 
 	//we need to tell vulkan how the images will be used by the queue families
 	//we have two queues, graphics and presentation.
@@ -375,17 +885,18 @@ void TriangleApp::createSwapChain()
 	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; //controls how alpha composition is handled by windowing system (for example, transparent terminals etc), this is ignored by setting it to opaque (no transparency)
 	createInfo.presentMode = presentMode; //presentation mode controls synchronization with the window system and rate at which images are presented to the surface - either immediate or mailbox 
 	createInfo.clipped = VK_TRUE; // used to optimize cases where not all of the surface might be visible - we don't care about colour of pixels that are obscured by other windows
-	createInfo.oldSwapchain = VK_NULL_HANDLE; //we need to keep a pointer to the old swap chain which might be invalidated when recreating the swap chain due to window resize events
+	createInfo.oldSwapchain = target.retiredSwapChain; //the swap chain being replaced when recreating due to window resize events, lets the presentation engine reuse its resources
 
-	if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS) { //if we did not make the swap chain successfully
+	if (vkCreateSwapchainKHR(device, &createInfo, allocationCallbacks, &target.swapChain) != VK_SUCCESS) { //if we did not make the swap chain successfully
 		throw std::runtime_error("failed to create swap chain!"); //throw an error
 	}
+	target.retiredSwapChain = VK_NULL_HANDLE; //the deletion queue destroys the old one
 
-	vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr); // get number of swap chain images in the swap chain object
-	swapChainImages.resize(imageCount); //resize the array to hold all the images in the swap chain
-	vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data()); // load the swap chain images into memory
-	swapChainImageFormat = surfaceFormat.format; //store a reference to the swap chain image format being used
-	swapChainExtent = extent; //store a reference to the size of the swap chain images
+	vkGetSwapchainImagesKHR(device, target.swapChain, &imageCount, nullptr); // get number of swap chain images in the swap chain object
+	target.swapChainImages.resize(imageCount); //resize the array to hold all the images in the swap chain
+	vkGetSwapchainImagesKHR(device, target.swapChain, &imageCount, target.swapChainImages.data()); // load the swap chain images into memory
+	target.swapChainImageFormat = surfaceFormat.format; //store a reference to the swap chain image format being used
+	target.swapChainExtent = extent; //store a reference to the size of the swap chain images
 }
 
 /*
@@ -397,7 +908,8 @@ void TriangleApp::populateDebugMessengerInfo(VkDebugUtilsMessengerCreateInfoEXT
 	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT; //type of the struct
 	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT; //the severity of messages we wish to catch
 	createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT; //the types of messages we wish to intercept
-	createInfo.pfnUserCallback = debugCallback; //static function to print validation errors to cout
+	createInfo.pfnUserCallback = ValidationLog::callback; //static function that queues the message for the log's writer thread
+	createInfo.pUserData = &validationLog; //handed to the callback
 }
 
 //this is needed to find the function vkCreateDebugMessageUtilsEXT for use. It is not automatically loaded since it is an extension function.
@@ -420,7 +932,7 @@ void TriangleApp::setupDebugMessenger()
 	if (!enableValidationLayers) return; //we don't want to debug / don't want the validation layers return and don't do any of the following setup
 	VkDebugUtilsMessengerCreateInfoEXT createInfo; //information to create the debug messenger
 	populateDebugMessengerInfo(createInfo); //populate the info with the correct setup information
-	if (CreateDebugUtilsMessengerEXT(vkInstance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) { //create the instance by providing the vkInstance handle, create info struct containing setup parameters, null allocation call back and finally a variable to hold the instance handle
+	if (CreateDebugUtilsMessengerEXT(vkInstance, &createInfo, allocationCallbacks, &debugMessenger) != VK_SUCCESS) { //create the instance by providing the vkInstance handle, create info struct containing setup parameters, host allocation callbacks and finally a variable to hold the instance handle
 		throw std::runtime_error("failed to set up debug messenger!"); //throw an error if we are unsuccessful
 	}
 }
@@ -452,7 +964,7 @@ bool TriangleApp::checkDeviceExtensionSupport(VkPhysicalDevice device)
 /*
 	helper function to check what the swap chain supports
 */
-SwapChainSupportDetails TriangleApp::querySwapChainSupport(VkPhysicalDevice device)
+SwapChainSupportDetails TriangleApp::querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
 {
 	//we use the physical device and the window surface previously created to get information
 	//on the supported swapchain features. We have to use these two because they are core parts of the swapchain
@@ -504,6 +1016,12 @@ VkSurfaceFormatKHR TriangleApp::chooseSwapSurfaceFormat(const std::vector<VkSurf
 */
 VkPresentModeKHR TriangleApp::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
+	if (presentModeOverride.has_value()) { //asked for on the command line or being measured
+		if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentModeOverride.value()) != availablePresentModes.end()) {
+			return presentModeOverride.value();
+		}
+		std::cout << "present mode " << presentModeName(presentModeOverride.value()) << " is not supported by the surface, using the default" << std::endl;
+	}
 	for (const auto& availablePresentMode : availablePresentModes) { //iterate through all presentation modes
 		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) { 
 			//when an image is ready to be shown, it is marked as pending, and when the vertical blank is finished it is then show. However, if a new image is ready to be shown before this, the pending image is discarded and updated with this new one
@@ -520,17 +1038,14 @@ VkPresentModeKHR TriangleApp::chooseSwapPresentMode(const std::vector<VkPresentM
 	some window managers allow us to differ the resolution of what we are drawing
 	by setting the currentExtent value to INT32_MAX
 */
-VkExtent2D TriangleApp::chooseSwapExtent(const VkSurfaceCapabilitiesKHR & capabilities)
+VkExtent2D TriangleApp::chooseSwapExtent(const WindowTarget& target, const VkSurfaceCapabilitiesKHR & capabilities)
 {
 	if (capabilities.currentExtent.width != UINT32_MAX) { //if the current width of the window is not equal to the max value (the window manager is allowing us to define the extents)
 		return capabilities.currentExtent; //return the surfaces current extent width and height
 	}
 	else { //we shall choose an appropriate value for the swapchain extent
-		//get the width and height of the window
-		int width, height; //width and height
-		glfwGetFramebufferSize(window, &width, &height); //get the framebuffer width and height
-
-		VkExtent2D actualExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; //create the extent struct to hold the width and height values
+		//get the width and height of the window, as last reported by the main thread
+		VkExtent2D actualExtent = { static_cast<uint32_t>(target.framebufferWidth), static_cast<uint32_t>(target.framebufferHeight) }; //create the extent struct to hold the width and height values
 
 		//here we clamp the values of the width and height between the minimum and maximum extents allowed by the implementation
 		actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
@@ -546,16 +1061,16 @@ VkExtent2D TriangleApp::chooseSwapExtent(const VkSurfaceCapabilitiesKHR & capabi
 	We create image views to hold additional information about the use of the image and use these as attachment to our Framebuffer
 	An image view is a collection of properties and a reference to a parent image
 */
-void TriangleApp::createImageViews()
+void TriangleApp::createImageViews(WindowTarget& target)
 {
-	swapChainImageViews.resize(swapChainImages.size());	//set size of image views array to the size of images available in the swap chain
+	target.swapChainImageViews.resize(target.swapChainImages.size());	//set size of image views array to the size of images available in the swap chain
 	//loop over all images in the swap chain and create an image view for each one
-	for (size_t i = 0; i < swapChainImages.size(); i++) {
+	for (size_t i = 0; i < target.swapChainImages.size(); i++) {
 		VkImageViewCreateInfo createInfo = {}; //create info struct that will contain the information for setting up the image view
 		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO; //type of the struct - image view
-		createInfo.image = swapChainImages[i]; //parent image of the view that will be created
+		createInfo.image = target.swapChainImages[i]; //parent image of the view that will be created
 		createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D; //type of the view that will be created - can be 1d, 2d, and 3d images, or even cube maps and cube map array images, there are also 1d and 2d array images
-		createInfo.format = swapChainImageFormat; //the format of the image, which will be the same as the swap chain format to ensure compatibility (this can be different however)
+		createInfo.format = target.swapChainImageFormat; //the format of the image, which will be the same as the swap chain format to ensure compatibility (this can be different however)
 
 		//component ordering in the view may be different from that in the parent
 		//each member of the components struct will refer to the child rgba components and how it should be interpreted from the parent image
@@ -572,7 +1087,7 @@ void TriangleApp::createImageViews()
 		createInfo.subresourceRange.baseArrayLayer = 0; //only used when the parent image is an array image, which in our case is not (how many layers do we want to use)
 		createInfo.subresourceRange.layerCount = 1; //we only have one layer
 
-		if (vkCreateImageView(device, &createInfo, nullptr, &swapChainImageViews[i]) != VK_SUCCESS) { //create the image view by passing the logical device, create info setup struct, null allocation callbacks and the out parameter to hold the swapchain views, if not successful stop
+		if (vkCreateImageView(device, &createInfo, allocationCallbacks, &target.swapChainImageViews[i]) != VK_SUCCESS) { //create the image view by passing the logical device, create info setup struct, host allocation callbacks and the out parameter to hold the swapchain views, if not successful stop
 			throw std::runtime_error("failed to create image views!"); //throw an error
 		}
 	}
@@ -615,12 +1130,13 @@ void TriangleApp::createGraphicsPipeline()
 
 	//describing the configuration of the newly created pipeline vertex input state -  
 	//what we are doing here is describing the layout of geometric data in memory and then having Vulkan fetch it and then feed it to the shader
+	VertexInputLayout vertexLayout = packedVertexLayout(); //one interleaved buffer of PackedVertex
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //type of struct
-	vertexInputInfo.vertexBindingDescriptionCount = 0; // number of vertex bindings used by the pipeline
-	vertexInputInfo.pVertexBindingDescriptions = nullptr; // Optional - we are not binding any vertex information
-	vertexInputInfo.vertexAttributeDescriptionCount = 0; //type of the attributes passed to the vertex shader, which binding to load them from and at which offset
-	vertexInputInfo.pVertexAttributeDescriptions = nullptr; // also not binding any attributes for the vertices
+	vertexInputInfo.vertexBindingDescriptionCount = 1; // number of vertex bindings used by the pipeline
+	vertexInputInfo.pVertexBindingDescriptions = &vertexLayout.binding; //stride of a packed vertex, advanced per vertex
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexLayout.attributes.size()); //type of the attributes passed to the vertex shader, which binding to load them from and at which offset
+	vertexInputInfo.pVertexAttributeDescriptions = vertexLayout.attributes.data(); //the packed formats, the fetch converts them to floats for the shader
 
 	//this stage will take vertex input data and groups them into primitives ready for processing
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -628,27 +1144,14 @@ void TriangleApp::createGraphicsPipeline()
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST; //type of the primitive that vertices will be grouped into, in this case a triangle
 	inputAssembly.primitiveRestartEnable = VK_FALSE; //used to allow strips and fan primitives topologies to be cut and restarted (use for optimizing draw calls) - we don't need this
 
-	//define the viewport (area to which we will render)
-	VkViewport viewport = {};
-	viewport.x = 0.0f; //origin
-	viewport.y = 0.0f; //origin
-	viewport.width = (float)swapChainExtent.width; //max width (here we are matching the swap chain width)
-	viewport.height = (float)swapChainExtent.height; //max height (here we are matching the swap chain height)
-	viewport.minDepth = 0.0f; //frame buffer depth values - we don't really use them at the moment
-	viewport.maxDepth = 1.0f; //frame buffer depth values - we don't really use them at the moment
-
-	//filter that discards pixels, we want to draw the entire image so we have a scissor angle to cover it entirely
-	VkRect2D scissor = {}; //VkRect2D is a type that defines a rectangle in vulkan, it can be used for other things as well
-	scissor.offset = { 0, 0 }; //screen offset (in our case it starts at the origin)
-	scissor.extent = swapChainExtent; // the dimensions of the swap chain image (so here we are not discarding any pixels, it covers the full extent of the swap chain image)
-
-	//combine the viewport and scissor configuration into viewport state
+	//the viewport (area to which we will render) and the scissor (filter that discards pixels) are dynamic state set in the
+	//command buffers, so the same pipeline draws into windows of any size and survives resizes
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //type of the struct
 	viewportState.viewportCount = 1; //number of view ports we want to use
-	viewportState.pViewports = &viewport; //the viewport(s)
+	viewportState.pViewports = nullptr; //dynamic, set with vkCmdSetViewport
 	viewportState.scissorCount = 1; //the number of scissors we want to use
-	viewportState.pScissors = &scissor; //the scissor(s)
+	viewportState.pScissors = nullptr; //dynamic, set with vkCmdSetScissor
 	
 	//setup rasterization stage
 	/*
@@ -725,7 +1228,7 @@ void TriangleApp::createGraphicsPipeline()
 	//dynamic state - what parameters can we change at runtime (can be nullptr if we don't have any)
 	VkDynamicState dynamicStates[] = {
 		VK_DYNAMIC_STATE_VIEWPORT, //we would like to change the viewport dimensions
-		VK_DYNAMIC_STATE_LINE_WIDTH //we would also like to change the line width on the fly
+		VK_DYNAMIC_STATE_SCISSOR //and the scissor with them, both follow the window being drawn to
 	};
 
 	/*
@@ -737,17 +1240,22 @@ void TriangleApp::createGraphicsPipeline()
 	dynamicState.dynamicStateCount = 2; //the number of states we wish to make dynamic
 	dynamicState.pDynamicStates = dynamicStates; //the states
 
-	//pipeline layout - specifies uniform layout information - which we are not using here so the struct is blank, but we still need to provide it
+	//the vertex shader's transform, which also undoes the position quantization. per draw data goes in push constants
+	//rather than a buffer, so changing it is a command and costs no memory writes; only the vertex shader reads it
+	VkPushConstantRange transformRange = pushConstantRange(physicalDevice, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4));
+
+	//pipeline layout - specifies uniform layout information - we have no descriptor sets, only the push constant transform
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
 	pipelineLayoutInfo.setLayoutCount = 0; // Optional - number of different uniform layouts
 	pipelineLayoutInfo.pSetLayouts = nullptr; // Optional - the uniform layouts
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional - a push constant is uniform variable in a shader and is used similarly, but it is vulkan owned and managed, it is set through the command buffer (number of push constant ranges)
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional - the push constant ranges that specify what stage of the pipeline will access the uniform and it also specifies the start offset and size of the uniform
+	pipelineLayoutInfo.pushConstantRangeCount = 1; // a push constant is uniform variable in a shader and is used similarly, but it is vulkan owned and managed, it is set through the command buffer (number of push constant ranges)
+	pipelineLayoutInfo.pPushConstantRanges = &transformRange; // the push constant ranges that specify what stage of the pipeline will access the uniform and it also specifies the start offset and size of the uniform
 
-	if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) { //create the pipeline layout by passing the logical device, the pipeline layout information, nullptr allocation callbacks and finally an out parameter to hold a handle to the pipeline layout, if not successful
+	if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, allocationCallbacks, &pipelineLayout) != VK_SUCCESS) { //create the pipeline layout by passing the logical device, the pipeline layout information, host allocation callbacks and finally an out parameter to hold a handle to the pipeline layout, if not successful
 		throw std::runtime_error("failed to create pipeline layout!"); //throw an error
 	}
+	traceRecorder.pipelineLayout(pipelineLayout, pipelineLayoutInfo);
 
 	//create graphics pipeline
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
@@ -762,7 +1270,7 @@ void TriangleApp::createGraphicsPipeline()
 	pipelineInfo.pMultisampleState = &multisampling; //MS stage
 	pipelineInfo.pDepthStencilState = nullptr; // Optional - depth stencil stage, we don't use this
 	pipelineInfo.pColorBlendState = &colorBlending; //colour blending stage
-	pipelineInfo.pDynamicState = nullptr; // Optional - the state which are treating as dynamic, we don't use this either
+	pipelineInfo.pDynamicState = &dynamicState; // the state which we are treating as dynamic, viewport and scissor
 	pipelineInfo.layout = pipelineLayout; // pipeline layout, we are not using any uniforms and other constants in our pipeline
 	pipelineInfo.renderPass = renderPass; // the render passes associating operations and images
 	pipelineInfo.subpass = 0; // we are not using any subpasses
@@ -772,12 +1280,13 @@ void TriangleApp::createGraphicsPipeline()
 	//more parameters are used here as multiple graphics pipelines can be created in one go by providing a list of create info structs
 	//second param is a cache which can be used to reuse data relevant to pipeline creation across multiple class
 	//the third param is the count of create info structs, in our case we only have one and only one pipeline is created
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) { //make the graphics pipeline
+	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, allocationCallbacks, &graphicsPipeline) != VK_SUCCESS) { //make the graphics pipeline
 		throw std::runtime_error("failed to create graphics pipeline!"); //throw an error if it was unsuccessful
 	}
+	traceRecorder.graphicsPipeline(graphicsPipeline, pipelineInfo); //the shader modules are still alive here, so their ids can be resolved
 
-	vkDestroyShaderModule(device, fragShaderModule, nullptr); //destroy the shader modules since they have been loaded in the pipeline
-	vkDestroyShaderModule(device, vertShaderModule, nullptr); //destroy the shader modules since they have been loaded in the pipeline
+	vkDestroyShaderModule(device, fragShaderModule, allocationCallbacks); //destroy the shader modules since they have been loaded in the pipeline
+	vkDestroyShaderModule(device, vertShaderModule, allocationCallbacks); //destroy the shader modules since they have been loaded in the pipeline
 }
 
 /*
@@ -791,9 +1300,10 @@ VkShaderModule TriangleApp::createShaderModule(const std::vector<char>& code)
 	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data()); //reinterpret cast our char array to unit32_t (needs to be aligned for int32 but it is because we used a vec)
 	VkShaderModule shaderModule; //out param
 	//in order to make the shader module we need the logical device, the setup information (compiled code), (no allocator callback) and finally an out param to hold the created shader
-	if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) { //make the shader module
+	if (vkCreateShaderModule(device, &createInfo, allocationCallbacks, &shaderModule) != VK_SUCCESS) { //make the shader module
 		throw std::runtime_error("failed to create shader module!"); //if we are unsuccessful throw an error
 	}
+	traceRecorder.shaderModule(shaderModule, code); //keep the SPIR-V in the trace, the replayer has no shader files
 	return shaderModule; //return the shader module
 }
 
@@ -813,7 +1323,7 @@ void TriangleApp::createRenderPass()
 		for graphics related application there will be at least 1 of these and in this case there will also only be one subpass
 	*/
 	VkAttachmentDescription colorAttachment = {}; //attachment information
-	colorAttachment.format = swapChainImageFormat; //match the format of the swapchain
+	colorAttachment.format = windows[0].swapChainImageFormat; //match the format of the swapchains, every window uses the same one
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT; //1 sample since we are not using any form of Anti Aliasing (AA)
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; //Clear the values to a constant at the start (what should we do when the render pass starts)
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; //Rendered contents will be stored in memory and can be read later (what to do when the render pass ends)
@@ -821,6 +1331,9 @@ void TriangleApp::createRenderPass()
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE; //don't do anything with stencil buffer (again, don't care about this part of the image)
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; //specifies which layout the image will have before the render pass begins
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // layout to automatically transition to when the render pass finishes. Images to be presented in the swap chain
+	if (options.headless) {
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; //headless images are never presented, only read back
+	}
 
 	//Subpasses and attachment references
 	/*
@@ -866,9 +1379,10 @@ void TriangleApp::createRenderPass()
 	renderPassInfo.dependencyCount = 1; //we have 1 dependency
 	renderPassInfo.pDependencies = &dependency; //the dependency info
 
-	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) { //make the render pass
+	if (vkCreateRenderPass(device, &renderPassInfo, allocationCallbacks, &renderPass) != VK_SUCCESS) { //make the render pass
 		throw std::runtime_error("failed to create render pass!"); //if we were not successful throw an error
 	}
+	traceRecorder.renderPass(renderPass, renderPassInfo);
 }
 
 /*
@@ -876,18 +1390,18 @@ void TriangleApp::createRenderPass()
 	usually there are a minimum of two but in most cases there will be more, this is called a front buffer and
 	a back buffer.
 */
-void TriangleApp::createFramebuffers()
+void TriangleApp::createFramebuffers(WindowTarget& target)
 {
 	//make space for the framebuffers
-	swapChainFramebuffers.resize(swapChainImageViews.size());
+	target.swapChainFramebuffers.resize(target.swapChainImageViews.size());
 	//iterate through all image views
-	for (size_t i = 0; i < swapChainImageViews.size(); i++) {
+	for (size_t i = 0; i < target.swapChainImageViews.size(); i++) {
 		/*
 			you can only use a framebuffer with a render pass that has the
 			same number and type of attachments
 		*/
 		VkImageView attachments[] = {
-			swapChainImageViews[i]
+			target.swapChainImageViews[i]
 		}; //getting the swap chain images
 
 		VkFramebufferCreateInfo framebufferInfo = {}; //struct to hold framebuffer creation info
@@ -895,13 +1409,14 @@ void TriangleApp::createFramebuffers()
 		framebufferInfo.renderPass = renderPass; //render pass we are binding framebuffer to
 		framebufferInfo.attachmentCount = 1; //number of attachments
 		framebufferInfo.pAttachments = attachments; //the images that we wish to manage in the frame buffer
-		framebufferInfo.width = swapChainExtent.width; //the width of the image
-		framebufferInfo.height = swapChainExtent.height; //the height of the image
+		framebufferInfo.width = target.swapChainExtent.width; //the width of the image
+		framebufferInfo.height = target.swapChainExtent.height; //the height of the image
 		framebufferInfo.layers = 1; //number of layers in image array
 
-		if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) { //create the frame buffer object
+		if (vkCreateFramebuffer(device, &framebufferInfo, allocationCallbacks, &target.swapChainFramebuffers[i]) != VK_SUCCESS) { //create the frame buffer object
 			throw std::runtime_error("failed to create framebuffer!"); //throw an error if we are unsuccessful in creating the buffer
 		}
+		traceRecorder.framebuffer(target.swapChainFramebuffers[i], framebufferInfo);
 	}
 }
 
@@ -923,22 +1438,57 @@ void TriangleApp::createCommandPool()
 	VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT: Allow command buffers to be rerecorded individually, without this flag they all have to be reset together
 
 	*/
-	poolInfo.flags = 0; // Optional - we don't have any specific requirements at this point
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; //the render thread re-records single buffers when the triangle moves
 
-	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) { //create the pool
+	if (vkCreateCommandPool(device, &poolInfo, allocationCallbacks, &commandPool) != VK_SUCCESS) { //create the pool
 		throw std::runtime_error("failed to create command pool!"); //if we are unsuccessful throw an error
 	}
 
 }
 
+/*
+	the triangle goes through the same vertex compression as imported meshes, so shader.vert has a single input format
+	it is tiny, so it lives in host visible memory (device local as well where the device has such a type) without staging
+*/
+void TriangleApp::createVertexBuffer()
+{
+	Mesh mesh;
+	mesh.vertices.resize(3);
+	const glm::vec2 positions[3] = { { 0.0f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+	const glm::vec3 colors[3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+	for (size_t i = 0; i < 3; i++) {
+		mesh.vertices[i].position = glm::vec3(positions[i], 0.0f);
+		mesh.vertices[i].normal = glm::vec3(0.0f, 0.0f, 1.0f); //facing the viewer, so the head light leaves the colours unchanged
+		mesh.vertices[i].texCoord = positions[i] + 0.5f;
+		mesh.vertices[i].color = glm::vec4(colors[i], 1.0f);
+	}
+	triangle = quantizeMesh(mesh);
+	triangleBvh.build(mesh);
+
+	VkBufferCreateInfo bufferInfo = {}; //only filled in for the trace, createBuffer builds its own
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO; //struct type
+	bufferInfo.size = sizeof(PackedVertex) * triangle.vertices.size(); //size of the vertex data in bytes
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT; //read by the vertex input stage
+	DeviceMemoryScope memoryScope("TriangleApp", "vertex buffer");
+	createBuffer(device, physicalDevice, bufferInfo.size, bufferInfo.usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory, allocationCallbacks);
+
+	void* data;
+	vkMapMemory(device, vertexBufferMemory, 0, bufferInfo.size, 0, &data); //coherent, so no flush is needed after the copy
+	memcpy(data, triangle.vertices.data(), static_cast<size_t>(bufferInfo.size));
+	vkUnmapMemory(device, vertexBufferMemory);
+	traceRecorder.buffer(vertexBuffer, bufferInfo, triangle.vertices.data());
+}
+
 /*
 	a command buffer represents a sequence of commands that are recorded and stored in a buffer.
 	this buffer after recording will then be submitted to a queue for execution (batch execution).
 	the command buffer is allocated from a command pool. So we need to have setup a command pool before we can allocate command buffers
 */
-void TriangleApp::createCommandBuffers()
+void TriangleApp::createCommandBuffers(WindowTarget& target)
 {
-	commandBuffers.resize(swapChainFramebuffers.size()); //create a buffer for each frame buffer
+	std::vector<VkCommandBuffer>& commandBuffers = target.commandBuffers;
+	commandBuffers.resize(target.swapChainFramebuffers.size()); //create a buffer for each frame buffer
 	VkCommandBufferAllocateInfo allocInfo = {}; //command buffer allocation info
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO; //struct type
 	allocInfo.commandPool = commandPool; //the command pool from which we will allocate the buffer
@@ -951,54 +1501,97 @@ void TriangleApp::createCommandBuffers()
 		throw std::runtime_error("failed to allocate command buffers!");//throw an error if we were unsuccessful
 	}
 
-	//begin recording commands for the command buffer ( we want to draw a triangle )
+	target.recordedOffsets.assign(commandBuffers.size(), glm::vec2(0.0f));
 	for (size_t i = 0; i < commandBuffers.size(); i++) {//for all command buffers
-		VkCommandBufferBeginInfo beginInfo = {}; //information needed to tell the command buffer to begin recording
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
-		beginInfo.flags = 0; // Optional - specifies how we're going to use the command buffer
-		beginInfo.pInheritanceInfo = nullptr; // Optional - relevant for secondary command buffers
+		recordCommandBuffer(target, i, target.recordedOffsets[i]);
+	}
+}
 
-		/*
-			If the command buffer was already recorded once, then a call to vkBeginCommandBuffer will implicitly reset it.
-			It's not possible to append commands to a buffer at a later time.
-		*/
-		if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {// begin recording
-			throw std::runtime_error("failed to begin recording command buffer!"); //if we didn't successfully begin recording throw an error
-		}
-
-		VkRenderPassBeginInfo renderPassInfo = {}; //create info needed to begin a render a pass
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
-		renderPassInfo.renderPass = renderPass; //render pass itself
-		renderPassInfo.framebuffer = swapChainFramebuffers[i]; //the buffer we want to render to
-		//size of the render area
-		renderPassInfo.renderArea.offset = { 0, 0 }; //origin of the buffer
-		renderPassInfo.renderArea.extent = swapChainExtent; //dimensions of the buffer - matches swap chain images
-		//clear values to use for VK_ATTACHMENT_LOAD_OP_CLEAR, which we used as load operation for the color attachment
-		VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-		renderPassInfo.clearValueCount = 1; //one clear value
-		renderPassInfo.pClearValues = &clearColor; //clear value
-		//begin render pass
-		//command buffer to record the command to
-		//specifies the details of the render pass we've just provided
-		//controls how the drawing commands within the render pass will be provided (execute in primary or secondary command buffer)
-		vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-		//bind graphics pipeline - we supply the command buffer we wish to feed to the pipeline, where we want to bind, our pipeline is a graphics pipeline
-		//so we bind it to the VK_PIPELINE_BIND_POINT_GRAPHICS and finally we provide the pipeline handle.
-		vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-		/*		
-			vkCmdDraw:
-				vertexCount: Even though we don't have a vertex buffer, we technically still have 3 vertices to draw.
-				instanceCount: Used for instanced rendering, use 1 if you're not doing that.
-				firstVertex: Used as an offset into the vertex buffer, defines the lowest value of gl_VertexIndex.
-				firstInstance: Used as an offset for instanced rendering, defines the lowest value of gl_InstanceIndex.
-		*/
-		vkCmdDraw(commandBuffers[i], 3, 1, 0, 0);
-		//end render pass
-		vkCmdEndRenderPass(commandBuffers[i]);
-		//end recording commands
-		if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-			throw std::runtime_error("failed to record command buffer!"); //throw an error if are unable to stop recording
-		}
+/*
+	record the commands to draw the triangle into the framebuffer of one swap chain image
+	the command pool allows resetting single buffers, so the render thread re-records a buffer whenever the triangle has
+	moved since it was last recorded
+*/
+void TriangleApp::recordCommandBuffer(WindowTarget& target, size_t index, const glm::vec2& offset)
+{
+	VkCommandBuffer commandBuffer = target.commandBuffers[index];
+	target.recordedOffsets[index] = offset;
+	//begin recording commands for the command buffer ( we want to draw a triangle )
+	VkCommandBufferBeginInfo beginInfo = {}; //information needed to tell the command buffer to begin recording
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = 0; // Optional - specifies how we're going to use the command buffer
+	beginInfo.pInheritanceInfo = nullptr; // Optional - relevant for secondary command buffers
+
+	/*
+		If the command buffer was already recorded once, then a call to vkBeginCommandBuffer will implicitly reset it.
+		It's not possible to append commands to a buffer at a later time.
+	*/
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {// begin recording
+		throw std::runtime_error("failed to begin recording command buffer!"); //if we didn't successfully begin recording throw an error
+	}
+	traceRecorder.beginFrame();
+
+	VkRenderPassBeginInfo renderPassInfo = {}; //create info needed to begin a render a pass
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+	renderPassInfo.renderPass = renderPass; //render pass itself
+	renderPassInfo.framebuffer = target.swapChainFramebuffers[index]; //the buffer we want to render to
+	//size of the render area
+	renderPassInfo.renderArea.offset = { 0, 0 }; //origin of the buffer
+	renderPassInfo.renderArea.extent = target.swapChainExtent; //dimensions of the buffer - matches swap chain images
+	//clear values to use for VK_ATTACHMENT_LOAD_OP_CLEAR, which we used as load operation for the color attachment
+	VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	renderPassInfo.clearValueCount = 1; //one clear value
+	renderPassInfo.pClearValues = &clearColor; //clear value
+	//begin render pass
+	//command buffer to record the command to
+	//specifies the details of the render pass we've just provided
+	//controls how the drawing commands within the render pass will be provided (execute in primary or secondary command buffer)
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	traceRecorder.cmdBeginRenderPass(renderPassInfo, VK_SUBPASS_CONTENTS_INLINE); //the first command buffer is the frame that gets traced
+	//bind graphics pipeline - we supply the command buffer we wish to feed to the pipeline, where we want to bind, our pipeline is a graphics pipeline
+	//so we bind it to the VK_PIPELINE_BIND_POINT_GRAPHICS and finally we provide the pipeline handle.
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	traceRecorder.cmdBindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	//the viewport and scissor cover this window's whole image
+	VkViewport viewport = {};
+	viewport.x = 0.0f; //origin
+	viewport.y = 0.0f; //origin
+	viewport.width = (float)target.swapChainExtent.width; //max width (here we are matching the swap chain width)
+	viewport.height = (float)target.swapChainExtent.height; //max height (here we are matching the swap chain height)
+	viewport.minDepth = 0.0f; //frame buffer depth values - we don't really use them at the moment
+	viewport.maxDepth = 1.0f; //frame buffer depth values - we don't really use them at the moment
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	traceRecorder.cmdSetViewport(0, 1, &viewport);
+	VkRect2D scissor = {}; //VkRect2D is a type that defines a rectangle in vulkan, it can be used for other things as well
+	scissor.offset = { 0, 0 }; //screen offset (in our case it starts at the origin)
+	scissor.extent = target.swapChainExtent; // the dimensions of the swap chain image (so here we are not discarding any pixels)
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	traceRecorder.cmdSetScissor(0, 1, &scissor);
+	//bind the packed vertices to binding 0 and push the transform that maps them back into clip space
+	VkDeviceSize vertexOffset = 0;
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &vertexOffset);
+	traceRecorder.cmdBindVertexBuffers(0, 1, &vertexBuffer, &vertexOffset);
+	//the triangle is already in clip space, so apart from the simulation's offset the dequantization is the whole transform
+	glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f)) * triangle.dequantization();
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), &transform);
+	traceRecorder.cmdPushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), &transform);
+	/*		
+		vkCmdDraw:
+			vertexCount: one per packed vertex in the vertex buffer.
+			instanceCount: Used for instanced rendering, use 1 if you're not doing that.
+			firstVertex: Used as an offset into the vertex buffer, defines the lowest value of gl_VertexIndex.
+			firstInstance: Used as an offset for instanced rendering, defines the lowest value of gl_InstanceIndex.
+	*/
+	uint32_t vertexCount = static_cast<uint32_t>(triangle.vertices.size());
+	vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+	traceRecorder.cmdDraw(vertexCount, 1, 0, 0);
+	//end render pass
+	vkCmdEndRenderPass(commandBuffer);
+	traceRecorder.cmdEndRenderPass();
+	traceRecorder.endFrame(); //stops recording, the other command buffers are identical apart from the framebuffer
+	//end recording commands
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!"); //throw an error if are unable to stop recording
 	}
 }
 
@@ -1022,37 +1615,44 @@ void TriangleApp::createSyncObjects()
 	//and another to signal that rendering has finished and presentation can happen
 		//we need to do this because presentation cannot occur if rendering has not completed
 	//similar pattern to previous steps when creating semaphores
+	//each window acquires and presents on its own, so the semaphores are per window
 	VkSemaphoreCreateInfo semaphoreInfo = {}; //information needed to create a semaphore
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;// struct type
-	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT); //create an array to store a semaphore for each frame that is currently available for rendering
-	renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT); //create an array to store a semaphore for each frame that is currently available for presenting
-
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		//semaphores are created by providing the logical device, the semaphore setup information, null allocation callback function, and the out parameter to store the handle
-		if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-			vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS) {//create two semaphores one for each state for each frame buffer
-			throw std::runtime_error("failed to create semaphores for a frame!"); //throw an error if either fails to be created
+	for (auto& target : windows) {
+		target.imageAvailableSemaphores.resize(framesInFlight); //create an array to store a semaphore for each frame that is currently available for rendering
+		target.renderFinishedSemaphores.resize(framesInFlight); //create an array to store a semaphore for each frame that is currently available for presenting
+
+		for (size_t i = 0; i < framesInFlight; i++) {
+			//semaphores are created by providing the logical device, the semaphore setup information, null allocation callback function, and the out parameter to store the handle
+			if (vkCreateSemaphore(device, &semaphoreInfo, allocationCallbacks, &target.imageAvailableSemaphores[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(device, &semaphoreInfo, allocationCallbacks, &target.renderFinishedSemaphores[i]) != VK_SUCCESS) {//create two semaphores one for each state for each frame buffer
+				throw std::runtime_error("failed to create semaphores for a frame!"); //throw an error if either fails to be created
+			}
 		}
 	}
 
 	//we now also have to make fence objects to sync CPU and GPU
 	//we need to create fences so that we limit the number of frames that are being processes, so we do not over submit work to the queues
 	//this solves a problem with rapidly growing memory usage due to the over-submitting of work
-	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT); //resize so there is a fence for each frame
+	//a frame of every window goes into one submit, so the fences are shared
+	inFlightFences.resize(framesInFlight); //resize so there is a fence for each frame
+	frameSerials.assign(framesInFlight, 0); //nothing submitted yet
 	/*
 		this variable below is used to keep track of which image is being used by an in-flight frame, 
 		this is done so that we avoid rendering to an in-flight image when MAX_FRAMES_INFLIGHT is 
 		higher than the number of available swap chain images or if vkAcquireNextImageKHR returns images out of order
 	*/
-	imagesInFlight.resize(swapChainImages.size(), VK_NULL_HANDLE); //resize so there is a fence for each image and init each element to NULL
+	for (auto& target : windows) {
+		target.imagesInFlight.resize(target.swapChainImages.size(), VK_NULL_HANDLE); //resize so there is a fence for each image and init each element to NULL
+	}
 
 
 	VkFenceCreateInfo fenceInfo = {}; //fence creation info
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO; //struct type
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; //we need this to be set to signaled so we can render on the very first pass (they are otherwise initialized to a not signaled state and we wait for ever)
 	
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) { //for each frame
-		if (vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) { //create a fence by providing the logical device, fence setup information, null allocation callback function and the out parameter to store the handle to the fence
+	for (size_t i = 0; i < framesInFlight; i++) { //for each frame
+		if (vkCreateFence(device, &fenceInfo, allocationCallbacks, &inFlightFences[i]) != VK_SUCCESS) { //create a fence by providing the logical device, fence setup information, host allocation callbacks and the out parameter to store the handle to the fence
 			throw std::runtime_error("failed to create fence for a frame!"); //if it is unsuccessful throw an error
 		}
 	}
@@ -1073,113 +1673,199 @@ void TriangleApp::createSyncObjects()
 	method used to recreate the swap chain
 	this is used whenever the window is resized
 */
-void TriangleApp::recreateSwapChain()
+void TriangleApp::recreateSwapChain(WindowTarget& target)
 {
 	//handle minimization events
-	//we basically wait till the window is in the foreground again
-	//this can cause an error where the width and height of the window is 0 which are invalid swap chain params
-	int width = 0, height = 0;
-	glfwGetFramebufferSize(window, &width, &height);
-	while (width == 0 || height == 0) { //while the buffer size is 0
-		glfwGetFramebufferSize(window, &width, &height); //get the buffer size
-		glfwWaitEvents(); //wait for more events
+	//a minimised window has a framebuffer of 0 x 0, which is not a valid swap chain extent. rather than waiting for it to
+	//be restored, which would stall every other window, it keeps its old swap chain, drawFrame skips it while it is
+	//minimised and the flag brings us back here once it has a size again
+	if (!options.headless) { //headless images are resized explicitly, there is no window to wait for
+		if (target.framebufferWidth == 0 || target.framebufferHeight == 0) {
+			target.framebufferResized = true;
+			return;
+		}
 	}
 
-	//wait for device to finish what it is doing
-	vkDeviceWaitIdle(device);
-
-	cleanupSwapChain(); //destroy the old swap chain and related resources
+	cleanupSwapChain(target); //retire the old swap chain and related resources, they are destroyed once the frames using them complete
+	if (options.latency.enabled && &target == &windows[0]) {
+		presentLatency.swapChainRetired();
+	}
 
-	//start to recreate the swap chain with new parameters
-	createSwapChain(); //create a new swap chain with the new window width and height
-	createImageViews(); //create new image views
-	createRenderPass(); //create a new render pass
-	createGraphicsPipeline(); //create a new graphics pipeline
-	createFramebuffers(); //create a new framebuffer
-	createCommandBuffers(); //create new command buffers (we recycle the command pool)
+	//start to recreate the swap chain with new parameters, the render pass and pipeline do not depend on its size
+	createSwapChain(target); //create a new swap chain with the new window width and height
+	createImageViews(target); //create new image views
+	createFramebuffers(target); //create a new framebuffer
+	createCommandBuffers(target); //create new command buffers (we recycle the command pool)
+	target.imagesInFlight.assign(target.swapChainImages.size(), VK_NULL_HANDLE); //the image count can change with the new swap chain
 }
 
 /*
 	destroy the swap chain and its related resources
 */
-void TriangleApp::cleanupSwapChain()
+void TriangleApp::cleanupSwapChain(WindowTarget& target)
 {
-	for (size_t i = 0; i < swapChainFramebuffers.size(); i++) { //for all the frame buffers created to manage the images in the swap chain
-		vkDestroyFramebuffer(device, swapChainFramebuffers[i], nullptr); //destroy them
+	//frames in flight may still be using these objects, so rather than idling the device they are handed to the deletion queue
+	//and destroyed once the queued frames and their presents are done. the handles are moved out so the
+	//create functions can fill in the replacements straight away
+	VkDevice device = this->device;
+	const VkAllocationCallbacks* allocator = allocationCallbacks;
+	VkCommandPool pool = commandPool;
+	std::vector<VkFramebuffer> framebuffers = std::move(target.swapChainFramebuffers);
+	std::vector<VkCommandBuffer> buffers = std::move(target.commandBuffers);
+	std::vector<VkImageView> imageViews = std::move(target.swapChainImageViews);
+	std::vector<VkImage> headlessImages;
+	std::vector<VkDeviceMemory> headlessMemory;
+	if (options.headless) { //we own the offscreen images and their memory
+		headlessImages = std::move(target.swapChainImages);
+		headlessMemory = std::move(target.headlessImageMemory);
+	}
+	else {
+		target.retiredSwapChain = target.swapChain; //passed as oldSwapchain so the presentation engine can hand over, destroyed with the rest
 	}
+	VkSwapchainKHR oldSwapChain = target.retiredSwapChain;
+	target.swapChainFramebuffers.clear();
+	target.commandBuffers.clear();
+	target.swapChainImageViews.clear();
+	target.swapChainImages.clear();
+	target.headlessImageMemory.clear();
+
+	retireAfterPresents([=]() { //the old swap chain's last present may still be waiting on its renderFinished semaphore
+		for (VkFramebuffer framebuffer : framebuffers) { //for all the frame buffers created to manage the images in the swap chain
+			vkDestroyFramebuffer(device, framebuffer, allocator); //destroy them
+		}
 
-	//do this so we don't need to allocate and new command pool, we can reuse the old one to issue new command buffers
-	//we need to provide the logical device, the pool from which we allocated the buffers and the buffers themselves
-	vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data()); //free the command buffers
+		//do this so we don't need to allocate and new command pool, we can reuse the old one to issue new command buffers
+		//we need to provide the logical device, the pool from which we allocated the buffers and the buffers themselves
+		vkFreeCommandBuffers(device, pool, static_cast<uint32_t>(buffers.size()), buffers.data()); //free the command buffers
 
-	//destroy the pipeline by providing the logical device and the pipeline handle
-	vkDestroyPipeline(device, graphicsPipeline, nullptr);
-	vkDestroyPipelineLayout(device, pipelineLayout, nullptr); //destroy any uniforms allocated by destroying the layout, provide the logical device and the pipeline layout handle
-	vkDestroyRenderPass(device, renderPass, nullptr); //destroy the render pass by providing the logical device and the render pass handle
+		for (VkImageView imageView : imageViews) {
+			vkDestroyImageView(device, imageView, allocator); //destroy all image views by providing the logical device and swap chain image views handle
+		}
 
-	for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-		vkDestroyImageView(device, swapChainImageViews[i], nullptr); //destroy all image views by providing the logical device and swap chain image views handle
-	}
+		for (size_t i = 0; i < headlessImages.size(); i++) {
+			vkDestroyImage(device, headlessImages[i], allocator);
+			freeDeviceMemory(device, headlessMemory[i], allocator);
+		}
 
-	vkDestroySwapchainKHR(device, swapChain, nullptr); //finally, destroy the swap chain by providing the logical device and the swap chain handle
+		if (oldSwapChain != VK_NULL_HANDLE) {
+			vkDestroySwapchainKHR(device, oldSwapChain, allocator); //finally, destroy the swap chain by providing the logical device and the swap chain handle
+		}
+	});
 }
 
 /*
 	draw triangles
-	Acquire an image from the swap chain
-	Execute the command buffer with that image as attachment in the framebuffer
-	Return the image to the swap chain for presentation
+	Acquire an image from the swap chain of every window
+	Execute the command buffers with those images as attachments in their framebuffers, all in one submit
+	Return the images to the swap chains for presentation, all in one present
+	runs on the render thread with the newest frame state, returns false when every window is minimised and nothing could be drawn
 */
-void TriangleApp::drawFrame()
+bool TriangleApp::drawFrame(const FrameState& state)
 {
 	//before we start drawing again, we have to wait for the previous frame to finish
 	//vkWaitForFences takes an array of fences and waits for either any, or all of them to be signaled before returning
 	//the last parameter is a timeout which we have disabled (so we wait forever, if the frame is never finishing) by setting it to uint64 max value
 	vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX); //provide a logical device, the number of frames to wait on and the array of frames, a boolean if we want to wait on all of the fences
+	if (options.latency.enabled) {
+		presentLatency.frameCompleted(frameSerials[currentFrame]);
+	}
+	frameCapture.frameCompleted(currentFrame); //the previous submission of this frame is done, so any readback submitted with it can be encoded
+	frameFenceSignalled(currentFrame); //and objects retired before it can be destroyed
+	if (options.usageReportInterval > 0.0) {
+		frameTimer.beginFrame(currentFrame); //the frame's GPU time can be read
+		for (double milliseconds : frameTimer.gpuFrameTimes()) {
+			gpuBusyMicroseconds += static_cast<uint64_t>(milliseconds * 1000.0);
+		}
+		frameTimer.reset();
+	}
+	redrawRequested = false;
+
+	//the submit and present below take arrays, one entry per window that acquired an image
+	std::vector<VkSemaphore> waitSemaphores, signalSemaphores;
+	std::vector<VkPipelineStageFlags> waitStages;
+	std::vector<VkCommandBuffer> submitCommandBuffers;
+	std::vector<VkSwapchainKHR> swapChains;
+	std::vector<uint32_t> imageIndices;
+	waitSemaphores.reserve(windows.size());
+	signalSemaphores.reserve(windows.size());
+	waitStages.reserve(windows.size());
+	submitCommandBuffers.reserve(windows.size() + 1);
+	swapChains.reserve(windows.size());
+	imageIndices.reserve(windows.size());
+
+	bool anyVisible = false;
+	for (auto& target : windows) {
+		target.acquired = false;
+		if (target.closed || target.framebufferWidth == 0 || target.framebufferHeight == 0) {
+			continue; //minimised, there is nothing to present to until it is restored
+		}
+		anyVisible = true;
 
-	uint32_t imageIndex; //variable to hold image index we will use to render to
+		//logical device, swap chain, timeout (disabled in this case) to wait for image, imageAvailable semaphore to signal that we can start drawing,
+		//finally variable to hold image index (used to get right command buffer to submit)
+		VkResult result = vkAcquireNextImageKHR(device, target.swapChain, UINT64_MAX, target.imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &target.imageIndex);
 
-	//logical device, swap chain, timeout (disabled in this case) to wait for image, imageAvailable semaphore to signal that we can start drawing, 
-	//finally variable to hold image (used to get right command buffer to submit)
-	VkResult result = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+		//if the swap chain turns out to be out of date then we have to recreate it and this window sits out the frame
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			recreateSwapChain(target);
+			redrawRequested = true;
+			continue;
+		}
+		//if the result is either a success or suboptimal value we proceed, if it is anything else, something has gone wrong and we throw an error
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+			throw std::runtime_error("failed to acquire swap chain image!");
+		}
 
-	//if the swap chain turns out to be out of date then we have to recreate the swap chain and continue in the next call
-	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-		recreateSwapChain();
-		return;
-	}
+		// Check if a previous frame is using this image (i.e. there is its fence to wait on)
+		if (target.imagesInFlight[target.imageIndex] != VK_NULL_HANDLE) {
+			vkWaitForFences(device, 1, &target.imagesInFlight[target.imageIndex], VK_TRUE, UINT64_MAX);
+		}
+		// Mark the image as now being in use by this frame
+		target.imagesInFlight[target.imageIndex] = inFlightFences[currentFrame];
+		target.acquired = true;
+		if (target.recordedOffsets[target.imageIndex] != state.offset) {
+			recordCommandBuffer(target, target.imageIndex, state.offset); //the image's last frame has completed, so its buffer is free
+		}
 
-	//if the result is either a success or suboptimal value we proceed, if it is anything else, something has gone wrong and we throw an error
-	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-		throw std::runtime_error("failed to acquire swap chain image!");
+		waitSemaphores.push_back(target.imageAvailableSemaphores[currentFrame]); //semaphore we have to wait on to commence execution
+		//the stage we are waiting on to be available, everything when timing so the first timestamp does not include the wait for the image
+		waitStages.push_back(options.usageReportInterval > 0.0 ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		submitCommandBuffers.push_back(target.commandBuffers[target.imageIndex]); //the recorded frame for the acquired image
+		signalSemaphores.push_back(target.renderFinishedSemaphores[currentFrame]); //signalled when rendering is complete, waited on by the present
+		swapChains.push_back(target.swapChain);
+		imageIndices.push_back(target.imageIndex);
+	}
+	if (swapChains.empty()) {
+		return anyVisible; //nothing acquired, so nothing is submitted and the fence stays signalled for the next attempt
 	}
 
-	// Check if a previous frame is using this image (i.e. there is its fence to wait on)
-	if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-		vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+	WindowTarget& first = windows[0];
+	if (frameCapture.isActive() && first.acquired) {
+		//the first window is captured, the copy runs in the same batch so it completes before renderFinished is signalled and the image is presented
+		VkCommandBuffer copyCommandBuffer = frameCapture.recordCopy(first.swapChainImages[first.imageIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+			first.swapChainImageFormat, first.swapChainExtent, currentFrame);
+		if (copyCommandBuffer != VK_NULL_HANDLE) {
+			submitCommandBuffers.push_back(copyCommandBuffer);
+		}
+	}
+	if (options.usageReportInterval > 0.0 && frameTimer.hasGpuTiming()) {
+		//timestamps around the whole batch measure how long the GPU was busy with the frame
+		submitCommandBuffers.insert(submitCommandBuffers.begin(), frameTimer.beginCommandBuffer(currentFrame));
+		submitCommandBuffers.push_back(frameTimer.endCommandBuffer(currentFrame));
 	}
-	// Mark the image as now being in use by this frame
-	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
 
 	VkSubmitInfo submitInfo = {}; //information needed to submit a queue for execution
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; //struct type
-
-	VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] }; //semaphore we have to wait on to commence execution
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT }; //the stage we are waiting on to be available
-	submitInfo.waitSemaphoreCount = 1; //the number of semaphores we are waiting on
-	submitInfo.pWaitSemaphores = waitSemaphores; //the semaphore(s) we are waiting on
-	submitInfo.pWaitDstStageMask = waitStages; //which stage(s) are waiting
-
-	//command buffer we are submitting
-	submitInfo.commandBufferCount = 1; //number of command buffers we are submitting
-	submitInfo.pCommandBuffers = &commandBuffers[imageIndex]; //the command buffer(s) to submit, use imageIndex from earlier to find the right one
-
-	//which semaphore should we use to signal that rendering is complete
-	VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-	submitInfo.signalSemaphoreCount = 1; //the number of semaphores we should signal when complete
-	submitInfo.pSignalSemaphores = signalSemaphores; //the semaphore we will use to signal that rendering is complete
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()); //the number of semaphores we are waiting on
+	submitInfo.pWaitSemaphores = waitSemaphores.data(); //the semaphore(s) we are waiting on
+	submitInfo.pWaitDstStageMask = waitStages.data(); //which stage(s) are waiting
+	submitInfo.commandBufferCount = static_cast<uint32_t>(submitCommandBuffers.size()); //number of command buffers we are submitting
+	submitInfo.pCommandBuffers = submitCommandBuffers.data(); //the command buffer(s) to submit
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()); //the number of semaphores we should signal when complete
+	submitInfo.pSignalSemaphores = signalSemaphores.data(); //the semaphores we will use to signal that rendering is complete
 
 	vkResetFences(device, 1, &inFlightFences[currentFrame]); //unlike with semaphores, we need to manually restore the fence to the original state
+	frameSerials[currentFrame] = ++submittedFrames; //the fence now guards this submission
 
 	//the graphics queue that will receive the  work to execute, the submit info which describes the work, the number of submissions (we can make multiple submissions in one go).
 	//The last parameter references an optional fence that will be signaled when the command buffers finish execution (CPU-GPU sync).
@@ -1187,34 +1873,259 @@ void TriangleApp::drawFrame()
 		throw std::runtime_error("failed to submit draw command buffer!"); //throw an error if could not submit it
 	}
 
-
-	VkPresentInfoKHR presentInfo = {}; //information needed to present the framebuffer
+	std::vector<VkResult> presentResults(swapChains.size(), VK_SUCCESS);
+	VkPresentInfoKHR presentInfo = {}; //information needed to present the framebuffers
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR; //struct type
+	if (options.latency.enabled && first.acquired) {
+		presentLatency.frameSubmitted(submittedFrames, state.sampled); //only the first window is measured
+	}
+#ifdef VK_KHR_present_id
+	std::vector<uint64_t> presentIds(swapChains.size(), submittedFrames); //the frame's serial, increasing on every swap chain
+	VkPresentIdKHR presentId = {};
+	presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+	presentId.swapchainCount = static_cast<uint32_t>(presentIds.size());
+	presentId.pPresentIds = presentIds.data();
+	if (presentWaitEnabled) {
+		presentInfo.pNext = &presentId;
+	}
+#endif
 	// first two parameters specify which semaphores to wait on before presentation can happen,
-	presentInfo.waitSemaphoreCount = 1; //the number of semaphores to wait on before presenting - this is so that we present a fully rendered image and not anything else
-	presentInfo.pWaitSemaphores = signalSemaphores; //semaphore(s) - the semaphores we are going to wait on
+	presentInfo.waitSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()); //the number of semaphores to wait on before presenting - this is so that we present fully rendered images and not anything else
+	presentInfo.pWaitSemaphores = signalSemaphores.data(); //semaphore(s) - the semaphores we are going to wait on
 	//next two parameters specify the swap chains to present images to and the index of the image for each swap chain
-	VkSwapchainKHR swapChains[] = { swapChain }; //swap chain we are using to present the images
-	presentInfo.swapchainCount = 1; //the number of swap chains - in this case we only have one swap chain which we are using to present
-	presentInfo.pSwapchains = swapChains; //the swap chains that will do the presenting
-	presentInfo.pImageIndices = &imageIndex; //the image index we are going to present 
+	presentInfo.swapchainCount = static_cast<uint32_t>(swapChains.size()); //the number of swap chains - one per window that acquired an image
+	presentInfo.pSwapchains = swapChains.data(); //the swap chains that will do the presenting
+	presentInfo.pImageIndices = imageIndices.data(); //the image index we are going to present for each swap chain
+	presentInfo.pResults = presentResults.data(); //the result for every individual swap chain, so only the windows that need it are rebuilt
+
+	VkResult result = vkQueuePresentKHR(presentationQueue, &presentInfo); //submits the request to present an image to each swap chain
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+		throw std::runtime_error("failed to present swap chain image!");
+	}
+	framesPresented++;
 
-	presentInfo.pResults = nullptr; // Optional allows you to specify an array of VkResult values to check for every individual swap chain if presentation was successful
+	if (options.latency.enabled && first.acquired) {
+		presentLatency.collect(first.swapChain); //before a recreate below retires the swap chain
+	}
 
-	VkResult result1 = vkQueuePresentKHR(presentationQueue, &presentInfo); //submits the request to present an image to the swap chain
-	
-	//we have to check the same conditions here and recreate the swapchain if we need to (window management)
-	if (result1 == VK_ERROR_OUT_OF_DATE_KHR || result1 == VK_SUBOPTIMAL_KHR || framebufferResized) {
-		//if the result of presentation is either a out of date or suboptimal or we have a window resize event we need to recreate the swap chain
-		framebufferResized = false; //reset the window resize flag
-		recreateSwapChain(); //recreate the swap chain
+	//we have to check the same conditions here and recreate the swap chains if we need to (window management)
+	size_t presented = 0;
+	for (auto& target : windows) {
+		if (!target.acquired) {
+			continue;
+		}
+		VkResult windowResult = presentResults[presented++];
+		if (windowResult == VK_ERROR_OUT_OF_DATE_KHR || windowResult == VK_SUBOPTIMAL_KHR || target.framebufferResized) {
+			//if the result of presentation is either a out of date or suboptimal or we have a window resize event we need to recreate the swap chain
+			target.framebufferResized = false; //reset the window resize flag
+			recreateSwapChain(target); //recreate the swap chain
+			redrawRequested = true; //what was presented may not fit the window any more
+		}
+		else if (windowResult != VK_SUCCESS) { //otherwise we have not successfully presented the image
+			throw std::runtime_error("failed to present swap chain image!"); //throw an error
+		}
 	}
-	else if (result1 != VK_SUCCESS) { //otherwise we have not successfully presented the image
-		throw std::runtime_error("failed to present swap chain image!"); //throw an error
+
+	if (allocationCallbacks != nullptr) {
+		hostAllocations.endFrame(); //count what the driver allocated during acquire, submit and present
 	}
-	
+
 	//increment the frame we're rendering
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT; //increment to the next frame to render to (circular as we are using the modulo)
+	currentFrame = (currentFrame + 1) % framesInFlight; //increment to the next frame to render to (circular as we are using the modulo)
+	return true;
+}
+
+/*
+	headless replacement for the swap chain: one offscreen image per frame in flight, so the image to render to is simply currentFrame
+	the images can be copied from so the golden run can read them back
+*/
+void TriangleApp::createHeadlessImages(WindowTarget& target)
+{
+	//prefer the format the swap chain normally uses so the output matches what is shown on screen
+	VkFormat candidates[] = { VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM };
+	VkFormat& swapChainImageFormat = target.swapChainImageFormat;
+	swapChainImageFormat = VK_FORMAT_UNDEFINED;
+	for (VkFormat candidate : candidates) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, candidate, &properties);
+		VkFormatFeatureFlags required = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT;
+		if ((properties.optimalTilingFeatures & required) == required) {
+			swapChainImageFormat = candidate;
+			break;
+		}
+	}
+	if (swapChainImageFormat == VK_FORMAT_UNDEFINED) {
+		throw std::runtime_error("failed to find a format for headless rendering!");
+	}
+
+	target.swapChainExtent = headlessExtent;
+	target.swapChainImages.resize(framesInFlight);
+	target.headlessImageMemory.resize(framesInFlight);
+	DeviceMemoryScope memoryScope("TriangleApp", "offscreen image");
+	for (size_t i = 0; i < target.swapChainImages.size(); i++) {
+		createImage(device, physicalDevice, target.swapChainExtent, swapChainImageFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			target.swapChainImages[i], target.headlessImageMemory[i], allocationCallbacks);
+	}
+}
+
+/*
+	headless version of drawFrame: no image to acquire or present, so no semaphores
+	the batch is [timer start, frame, optional readback copy, timer end] and the in-flight fence covers all of it
+*/
+void TriangleApp::drawHeadlessFrame(bool capture)
+{
+	vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX); //wait for the last use of this frame's image
+	frameCapture.frameCompleted(currentFrame); //any readback submitted with it can be converted
+	frameFenceSignalled(currentFrame); //retired objects can be destroyed
+	frameTimer.beginFrame(currentFrame); //and its timestamps can be read
+
+	WindowTarget& target = windows[0]; //the only target in headless mode
+	VkCommandBuffer submitCommandBuffers[4];
+	uint32_t commandBufferCount = 0;
+	if (frameTimer.beginCommandBuffer(currentFrame) != VK_NULL_HANDLE) {
+		submitCommandBuffers[commandBufferCount++] = frameTimer.beginCommandBuffer(currentFrame);
+	}
+	submitCommandBuffers[commandBufferCount++] = target.commandBuffers[currentFrame]; //one image per frame in flight, so the indices match
+	if (capture) {
+		VkCommandBuffer copyCommandBuffer = frameCapture.recordCopy(target.swapChainImages[currentFrame], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			target.swapChainImageFormat, target.swapChainExtent, currentFrame);
+		if (copyCommandBuffer != VK_NULL_HANDLE) {
+			submitCommandBuffers[commandBufferCount++] = copyCommandBuffer;
+		}
+	}
+	VkCommandBuffer timerEnd = frameTimer.endCommandBuffer(currentFrame);
+	if (timerEnd != VK_NULL_HANDLE) {
+		submitCommandBuffers[commandBufferCount++] = timerEnd;
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; //struct type
+	submitInfo.commandBufferCount = commandBufferCount;
+	submitInfo.pCommandBuffers = submitCommandBuffers;
+
+	vkResetFences(device, 1, &inFlightFences[currentFrame]);
+	frameSerials[currentFrame] = ++submittedFrames;
+	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit draw command buffer!");
+	}
+	if (allocationCallbacks != nullptr) {
+		hostAllocations.endFrame();
+	}
+
+	currentFrame = (currentFrame + 1) % framesInFlight;
+}
+
+/*
+	render every golden scene, compare the last frame of each against its reference and write the diff images,
+	frame timings and a report to the output directory. returns false if any scene did not match
+*/
+bool TriangleApp::runGoldenTests()
+{
+	const std::vector<GoldenScene> scenes = {
+		{ "triangle_800x600", { 800, 600 } }, //default window size
+		{ "triangle_1280x720", { 1280, 720 } },
+		{ "triangle_333x257", { 333, 257 } } //odd size catches row pitch mistakes in the readback
+	};
+
+	const GoldenSettings& golden = options.golden;
+	std::filesystem::create_directories(golden.outputDirectory);
+	if (golden.update) {
+		std::filesystem::create_directories(golden.referenceDirectory);
+	}
+
+	std::ofstream report(golden.outputDirectory + "/report.txt");
+	std::ofstream timings(golden.outputDirectory + "/timings.csv");
+	if (!report.is_open() || !timings.is_open()) {
+		throw std::runtime_error("failed to open golden image report!");
+	}
+	timings << "scene,frame,cpu_ms,gpu_ms\n";
+
+	size_t failures = 0;
+	for (const auto& scene : scenes) {
+		if (!runGoldenScene(scene, report, timings)) {
+			failures++;
+		}
+	}
+	std::cout << "golden: " << scenes.size() - failures << "/" << scenes.size() << " scenes passed, results in " << golden.outputDirectory << std::endl;
+	return failures == 0;
+}
+
+bool TriangleApp::runGoldenScene(const GoldenScene& scene, std::ostream& report, std::ostream& timings)
+{
+	const GoldenSettings& golden = options.golden;
+	headlessExtent = scene.extent;
+	recreateSwapChain(windows[0]); //rebuild the images, framebuffers and command buffers at the size of the scene
+
+	//the encoder thread converts the read back frame, drain() below makes it visible here
+	RgbImage rendered;
+	frameCapture.setFrameSink([&rendered](uint64_t, const uint8_t* texels, VkExtent2D extent, VkFormat format) {
+		rendered = rgbFromTexels(texels, extent, format);
+	});
+
+	for (uint32_t i = 0; i < golden.warmupFrames; i++) {
+		drawHeadlessFrame(false);
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+	frameTimer.reset(); //warm up frames include pipeline compilation and first touch of memory
+
+	uint32_t frames = std::max(golden.frames, 1u);
+	for (uint32_t i = 0; i < frames; i++) {
+		drawHeadlessFrame(i + 1 == frames); //only the last frame is compared
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+	frameCapture.drain();
+	frameCapture.setFrameSink(nullptr);
+
+	const std::vector<double>& cpuTimes = frameTimer.cpuFrameTimes();
+	const std::vector<double>& gpuTimes = frameTimer.gpuFrameTimes();
+	for (size_t i = 0; i < std::max(cpuTimes.size(), gpuTimes.size()); i++) {
+		timings << scene.name << "," << i << ",";
+		if (i < cpuTimes.size()) timings << cpuTimes[i];
+		timings << ",";
+		if (i < gpuTimes.size()) timings << gpuTimes[i];
+		timings << "\n";
+	}
+
+	savePPM(golden.outputDirectory + "/" + scene.name + "_actual.ppm", rendered);
+
+	std::ostringstream result;
+	bool passed = true;
+	std::string referenceFile = golden.referenceDirectory + "/" + scene.name + ".ppm";
+	if (golden.update) {
+		savePPM(referenceFile, rendered);
+		result << "reference updated";
+	}
+	else if (!std::filesystem::exists(referenceFile)) {
+		result << "FAIL missing reference " << referenceFile;
+		passed = false;
+	}
+	else {
+		ImageComparison comparison = compareImages(rendered, loadPPM(referenceFile), golden.tolerance);
+		if (!comparison.sizeMatches) {
+			result << "FAIL reference size differs";
+			passed = false;
+		}
+		else {
+			savePPM(golden.outputDirectory + "/" + scene.name + "_diff.ppm", comparison.diff);
+			passed = comparison.mismatchedPixels <= golden.maxMismatchedPixels;
+			result << (passed ? "PASS" : "FAIL") << " " << comparison.mismatchedPixels << " pixels above tolerance " << golden.tolerance
+				<< " (max difference " << comparison.maxDifference << ")";
+		}
+	}
+
+	report << scene.name << ": " << result.str() << "\n";
+	report << "  cpu " << frameTimer.cpuSummary() << "\n";
+	if (frameTimer.hasGpuTiming()) {
+		report << "  gpu " << frameTimer.gpuSummary() << "\n";
+	}
+	std::cout << scene.name << ": " << result.str() << std::endl;
+	std::cout << "  cpu " << frameTimer.cpuSummary() << std::endl;
+	if (frameTimer.hasGpuTiming()) {
+		std::cout << "  gpu " << frameTimer.gpuSummary() << std::endl;
+	}
+	return passed;
 }
 
 /*
@@ -1274,5 +2185,85 @@ bool TriangleApp::checkValidationLayerSupport()
 void TriangleApp::framebufferResizeCallback(GLFWwindow * window, int width, int height)
 {
 	auto app = reinterpret_cast<TriangleApp*>(glfwGetWindowUserPointer(window)); //get a pointer to the app instance
-	app->framebufferResized = true; //we resized the window
+	WindowInput* input = app->findWindow(window); //and to the window that was resized
+	if (input != nullptr) {
+		input->resizes++; //we resized the window, the render thread sees it with the next frame state
+	}
+}
+
+/*
+	static method to be used with GLFW to remember where the cursor is
+*/
+void TriangleApp::cursorPositionCallback(GLFWwindow* window, double x, double y)
+{
+	auto app = reinterpret_cast<TriangleApp*>(glfwGetWindowUserPointer(window));
+	WindowInput* input = app->findWindow(window);
+	if (input == nullptr) {
+		return;
+	}
+	if (input->dragging) { //the triangle follows the cursor, converted from window to normalised device coordinates
+		int width, height;
+		glfwGetWindowSize(window, &width, &height);
+		if (width > 0 && height > 0) {
+			app->triangleOffset += glm::vec2(2.0 * (x - input->cursorPosition.x) / width, 2.0 * (y - input->cursorPosition.y) / height);
+		}
+	}
+	input->cursorPosition = glm::dvec2(x, y);
+}
+
+/*
+	static method to be used with GLFW to pick whatever is under the cursor when the left button is pressed, and to drag the
+	triangle around while the right button is held
+*/
+void TriangleApp::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+	auto app = reinterpret_cast<TriangleApp*>(glfwGetWindowUserPointer(window));
+	WindowInput* input = app->findWindow(window);
+	if (input == nullptr) {
+		return;
+	}
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+		app->pick(*input);
+	}
+	else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+		input->dragging = action == GLFW_PRESS;
+	}
+}
+
+/*
+	M writes the device memory dump, on the main thread while the render thread keeps going
+*/
+void TriangleApp::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	auto app = reinterpret_cast<TriangleApp*>(glfwGetWindowUserPointer(window));
+	if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+		app->dumpDeviceMemory(app->options.memoryDumpFile.empty() ? "device_memory.json" : app->options.memoryDumpFile);
+	}
+}
+
+/*
+	cast a ray through the cursor into the scene and report the triangle it hits
+	there is no camera, the triangle is drawn straight in normalised device coordinates, so the ray starts on the near
+	plane below the cursor and runs along +z (window y and Vulkan's clip space y both point down)
+	runs on the main thread against the simulation's own offset, so it matches what the render thread is about to draw
+*/
+void TriangleApp::pick(const WindowInput& input)
+{
+	int width, height;
+	glfwGetWindowSize(input.window, &width, &height);
+	if (width == 0 || height == 0) {
+		return;
+	}
+	Ray ray;
+	glm::vec2 cursor(2.0f * static_cast<float>(input.cursorPosition.x / width) - 1.0f, 2.0f * static_cast<float>(input.cursorPosition.y / height) - 1.0f);
+	ray.origin = glm::vec3(cursor - triangleOffset, -1.0f); //into the triangle's own coordinates
+	ray.direction = glm::vec3(0.0f, 0.0f, 1.0f);
+	TriangleHit hit;
+	if (triangleBvh.raycast(ray, 2.0f, hit)) {
+		std::cout << "picked triangle " << hit.triangle << " at depth " << hit.distance - 1.0f << ", barycentric ("
+			<< 1.0f - hit.barycentric.x - hit.barycentric.y << ", " << hit.barycentric.x << ", " << hit.barycentric.y << ")" << std::endl;
+	}
+	else {
+		std::cout << "picked nothing" << std::endl;
+	}
 }
@@ -10,10 +10,34 @@
 #include <set>
 #include <algorithm>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "FrameCapture.h"
+#include "FrameTimer.h"
+#include "GoldenImage.h"
+#include "CommandTrace.h"
+#include "HostAllocator.h"
+#include "DeletionQueue.h"
+#include "VertexCompression.h"
+#include "Bvh.h"
+#include "TripleBuffer.h"
+#include "PresentLatency.h"
+#include "ValidationLog.h"
+#include "DeviceFeatures.h"
 
-#define DEBUG
 #define BLEND true
 
+#ifdef NDEBUG
+const bool DEFAULT_VALIDATION = false; //release builds are for timing
+#else
+const bool DEFAULT_VALIDATION = true;
+#endif
+
 /*
 	helper struct to hold the indices for the queues that support the graphics family and present family
 */
@@ -36,17 +60,127 @@ struct SwapChainSupportDetails {
 	std::vector<VkPresentModeKHR> presentModes; //how frames are presented to the surface
 };
 
+/*
+	runtime options for the application, filled in from the command line in main
+*/
+struct AppOptions {
+	bool validation = DEFAULT_VALIDATION; //enable the validation layer and the debug messenger
+	bool robustBufferAccess = false; //bounds check every buffer access, off as it costs time and a correct app does not need it
+	CaptureSettings capture; //readback and capture-to-disk of rendered frames
+	bool headless = false; //render into offscreen images without a window, surface or swap chain
+	GoldenSettings golden; //render the golden scenes, compare them against the references and record frame timings
+	std::string traceFile; //write the resource creations and commands of the first frame to this file for replay
+	bool hostAllocator = true; //route the driver's host allocations through HostAllocator
+	uint32_t hostAllocationReportInterval = 0; //print the host allocations per frame every this many frames, 0 only reports at exit
+	uint32_t windowCount = 1; //windows drawn with the same device, pipeline and vertex buffer
+	uint32_t framesInFlight = 2; //frames the CPU may run ahead of the GPU, fewer is lower latency, more absorbs spikes
+	std::string presentMode; //fifo, fifo-relaxed, mailbox or immediate when supported, empty prefers mailbox
+	LatencySettings latency; //measure present latency per present mode instead of running freely
+	bool onDemand = false; //only draw when the image would change, sleep otherwise
+	double usageReportInterval = 0.0; //seconds between CPU and GPU utilisation reports, 0 for none
+	double memoryReportInterval = 0.0; //seconds between device memory reports, 0 only checks for leaks at exit
+	std::string memoryDumpFile; //device memory JSON dump written by the M key (device_memory.json when empty) and, when set, at exit
+	ValidationLogSettings validationLog; //deduplication and rate limit of the validation messages
+};
+
+/*
+	everything that belongs to one window: its surface and swap chain, the views, framebuffers and pre-recorded command
+	buffers built on the swap chain images, and the semaphores of its frames in flight
+	the device, render pass, pipeline, vertex buffer, command pool and in-flight fences are shared by every window, so
+	the cost of another window is its swap chain and a few handles in the frame's single submit and present
+	in headless mode there is exactly one target, without window or surface, whose images are offscreen images
+*/
+struct WindowTarget {
+	GLFWwindow* window = nullptr;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+	VkSwapchainKHR swapChain = VK_NULL_HANDLE; //handle to the swapchain
+	VkSwapchainKHR retiredSwapChain = VK_NULL_HANDLE; //swap chain being replaced, waiting in the deletion queue
+	std::vector<VkImage> swapChainImages; //images (buffers) to use
+	std::vector<VkDeviceMemory> headlessImageMemory; //backing memory of the offscreen images in headless mode
+	VkFormat swapChainImageFormat = VK_FORMAT_UNDEFINED; //format we have decided to use
+	VkExtent2D swapChainExtent = {}; //resolution
+	std::vector<VkImageView> swapChainImageViews; //how to access the images
+	std::vector<VkFramebuffer> swapChainFramebuffers; //one per swap chain image
+	std::vector<VkCommandBuffer> commandBuffers; //pre-recorded, one per framebuffer
+
+	std::vector<VkSemaphore> imageAvailableSemaphores; //per frame in flight, signalled by the acquire
+	std::vector<VkSemaphore> renderFinishedSemaphores; //per frame in flight, signalled by the shared submit and waited on by the present
+	std::vector<VkFence> imagesInFlight; //per swap chain image, the fence of the frame last rendering to it
+
+	std::vector<glm::vec2> recordedOffsets; //per command buffer, the triangle offset it was recorded with
+
+	uint32_t imageIndex = 0; //image acquired for the frame being built
+	bool acquired = false; //whether this window takes part in the frame being built
+	bool framebufferResized = false; //the swap chain is rebuilt after the next present
+	uint32_t resizesSeen = 0; //resize count of the last frame state, a new count sets framebufferResized
+	int framebufferWidth = 0; //framebuffer size reported by the main thread, GLFW may only be asked there
+	int framebufferHeight = 0;
+	bool closed = false; //the window was closed and its resources retired
+};
+
+/*
+	a window as the main thread sees it, index for index with the render thread's WindowTargets
+*/
+struct WindowInput {
+	GLFWwindow* window = nullptr;
+	glm::dvec2 cursorPosition = glm::dvec2(0.0); //last cursor position in window coordinates
+	bool dragging = false; //right button held, the triangle follows the cursor
+	uint32_t resizes = 0; //incremented by the resize callback
+	bool closed = false;
+};
+
+/*
+	what the main thread hands the render thread every simulation step, the render thread only ever sees the newest one
+*/
+struct FrameState {
+	struct Window {
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		uint32_t resizes = 0; //a count rather than a flag, so a resize is not lost when a state is skipped
+		bool closed = false;
+	};
+
+	uint64_t step = 0; //simulation step that produced the state
+	std::chrono::steady_clock::time_point sampled; //when the input the state was built from was read
+	glm::vec2 offset = glm::vec2(0.0f); //the triangle's translation in normalised device coordinates
+	std::vector<Window> windows;
+
+	/*
+		whether the state draws exactly the image other does, in which case on demand rendering skips it
+	*/
+	bool drawsSameAs(const FrameState& other) const
+	{
+		if (offset != other.offset || windows.size() != other.windows.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < windows.size(); i++) {
+			const Window& a = windows[i];
+			const Window& b = other.windows[i];
+			if (a.framebufferWidth != b.framebufferWidth || a.framebufferHeight != b.framebufferHeight || a.resizes != b.resizes || a.closed != b.closed) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
 class TriangleApp
 {
 
 public:
 
-	TriangleApp();
+	TriangleApp(const AppOptions& options = AppOptions());
 	void run();
 	~TriangleApp();
 
 private:
 
+	//members are destroyed in reverse order, so the allocator declared first outlives every member holding driver objects,
+	//even when cleanup() is skipped because the render thread failed
+	HostAllocator hostAllocator; //pooled host memory for the driver
+	const VkAllocationCallbacks* allocationCallbacks = nullptr; //passed to every create/destroy call, nullptr uses the driver's own allocator
+
 	void initVulkan();
 	void initWindow();
 	void pickPhysicalDevice();
@@ -56,14 +190,16 @@ private:
 	*/
 	void createInstance();
 	void createLogicalDevice();
-	void createSurface();
-	void createSwapChain();
+	void createSurfaces();
+	void createSwapChain(WindowTarget& target);
 	void createRenderPass();
-	void createImageViews();
+	void createImageViews(WindowTarget& target);
 	void createGraphicsPipeline();
-	void createFramebuffers();
+	void createFramebuffers(WindowTarget& target);
 	void createCommandPool();
-	void createCommandBuffers();
+	void createVertexBuffer();
+	void createCommandBuffers(WindowTarget& target);
+	void recordCommandBuffer(WindowTarget& target, size_t index, const glm::vec2& offset);
 	void createSyncObjects();
 
 	VkShaderModule createShaderModule(const std::vector<char>& code);
@@ -71,15 +207,35 @@ private:
 	void populateDebugMessengerInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 	void setupDebugMessenger();
 	bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+	SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
 	VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 	VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
-	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
-	void recreateSwapChain();
-	void cleanupSwapChain();
+	VkExtent2D chooseSwapExtent(const WindowTarget& target, const VkSurfaceCapabilitiesKHR& capabilities);
+	void recreateSwapChain(WindowTarget& target);
+	void cleanupSwapChain(WindowTarget& target);
+	void closeWindow(size_t index);
+	WindowInput* findWindow(GLFWwindow* window);
 	void cleanup();
 
-	void drawFrame();
+	//the main thread polls events and simulates, the render thread draws the newest frame state
+	bool simulate();
+	void wakeRenderThread();
+	void waitForRenderWake();
+	void reportUsage();
+	void dumpDeviceMemory(const std::string& filename);
+	void renderLoop();
+	bool renderFrame();
+	void measureLatency();
+	bool drawFrame(const FrameState& state);
+	void frameFenceSignalled(size_t frame);
+	void retireAfterPresents(DeletionQueue::Deleter deleter);
+	void waitForSubmittedFrames();
+
+	//headless golden image run
+	bool runGoldenTests();
+	bool runGoldenScene(const GoldenScene& scene, std::ostream& report, std::ostream& timings);
+	void drawHeadlessFrame(bool capture);
+	void createHeadlessImages(WindowTarget& target);
 
 	static std::vector<char> readFile(const std::string& filename);
 	
@@ -88,9 +244,36 @@ private:
 	std::vector<const char*> getRequiredExtensions();
 	QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
 	
-	GLFWwindow * window;
+	AppOptions options; //runtime options the application was started with
+
+	std::vector<WindowTarget> windows; //the windows being drawn to, or the single offscreen target in headless mode, owned by the render thread
+	std::vector<WindowInput> windowInputs; //the same windows, owned by the main thread
+
+	glm::vec2 triangleOffset = glm::vec2(0.0f); //simulation state, moved by dragging with the right button
+	uint64_t simulationStep = 0;
+	TripleBuffer<FrameState> frameStates; //main thread to render thread, neither ever waits for the other
+	std::thread renderThread;
+	std::atomic<bool> renderRunning{ false }; //cleared by the main thread to stop the render thread
+	std::atomic<bool> renderStopped{ false }; //set by the render thread when it returns, on an exception or when the latency run is done
+	std::exception_ptr renderError; //rethrown on the main thread once the render thread has been joined
+	FrameState publishedState; //copy of the last state handed over, on demand rendering only hands over changes
+	bool allMinimised = false; //every open window has an empty framebuffer, nothing is drawn until one is restored
+	std::mutex renderWakeMutex;
+	std::condition_variable renderWake; //the render thread sleeps on this when it has nothing to draw
+	bool renderWakeRequested = false;
+	bool redrawRequested = false; //render thread: a window missed the last frame (swap chain rebuilt), draw again without waiting
+
+	//utilisation report: counted by the render thread, printed by the main thread
+	std::atomic<uint64_t> framesPresented{ 0 };
+	std::atomic<uint64_t> gpuBusyMicroseconds{ 0 };
+	std::chrono::steady_clock::time_point usageStart;
+	double usageCpuStart = 0.0;
+	uint64_t usageFramesStart = 0;
+	uint64_t usageGpuStart = 0;
+	std::chrono::steady_clock::time_point memoryReportStart;
 	const int WIDTH = 800;
 	const int HEIGHT = 600;
+	const double SIMULATION_STEP = 1.0 / 240.0; //seconds between simulation steps when no input arrives
 
 	/*
 		 Layers are used to intercept the Vulkan API and provide logging, profiling, debugging, or other additional features.
@@ -104,11 +287,7 @@ private:
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
-#ifdef DEBUG
-	const bool enableValidationLayers = true;
-#else
-	const bool enableValidationLayers = false;
-#endif // DEBUG
+	bool enableValidationLayers = false; //from the options, fixed once the instance is created
 	bool checkValidationLayerSupport();
 
 	//vulkan API handle
@@ -139,65 +318,59 @@ private:
 		Application will spend most of its time interacting with logical device
 	*/
 	VkDevice device;
+	DeviceFeatures deviceFeatures; //what the device was created with, negotiated in createLogicalDevice
 
 	//queue handle
 	VkQueue graphicsQueue;
 
 	//debug messenger handle
 	VkDebugUtilsMessengerEXT debugMessenger;
-
-	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-		VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-		VkDebugUtilsMessageTypeFlagsEXT messageType,
-		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-		void* pUserData) {
-
-		std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
-
-		return VK_FALSE;
-	}
-
-	VkSurfaceKHR surface;
+	ValidationLog validationLog; //the messenger's callback only queues messages here, its thread writes them out
 
 	VkQueue presentationQueue;
 
-	VkSwapchainKHR swapChain; //handle to the swapchain
-	std::vector<VkImage> swapChainImages; //images (buffers) to use
-	VkFormat swapChainImageFormat;//format we have decided to use
-	VkExtent2D swapChainExtent;//resolution
-	//image views: how to access and how to and which part to access
-	std::vector<VkImageView> swapChainImageViews;
-
-	VkRenderPass renderPass;
+	VkRenderPass renderPass; //shared by every window, so their swap chains must agree on the image format
 	VkPipelineLayout pipelineLayout;
-	VkPipeline graphicsPipeline;
-	/*
-		a frame buffer wraps an attachment
-		an attachment is represented in the pipeline by an image returned by the swap chain
-		so we need to make an array of framebuffers as this is dependent on which image is returned
-		by the swap chain (double buffered or more so there might be more than one framebuffer to draw to depending on this setup)
-	*/
-	std::vector<VkFramebuffer> swapChainFramebuffers;
+	VkPipeline graphicsPipeline; //viewport and scissor are dynamic, so one pipeline serves windows of any size
+
+	QuantizedMesh triangle; //the triangle in the packed vertex format, its dequantization is the push constant transform
+	TriangleBvh triangleBvh; //the triangle's full precision positions, which are already in normalised device coordinates, for picking
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
 	/*
 		pool of commands to execute
 		batch
 	*/
 	VkCommandPool commandPool;
 
-	/*
-		per framebuffer recording of commands
-	*/
-	std::vector<VkCommandBuffer> commandBuffers;
-
-	//synchronization with render operations
-	std::vector<VkSemaphore> imageAvailableSemaphores; //is the image available to render to? we use this to make sure we do not render to a frame that is being presented
-	std::vector<VkSemaphore> renderFinishedSemaphores; //is the rendering finished? we use this to make sure that we do not render to an image that is already being rendered to
-	std::vector<VkFence> inFlightFences; //used to sync CPU-GPU so we don't use in-flight frames
-	std::vector<VkFence> imagesInFlight; //used to track which images are in flight
-	const int MAX_FRAMES_IN_FLIGHT = 2; //number of frames that can be processed concurrently
+	//synchronization with render operations, the semaphores belong to the windows
+	std::vector<VkFence> inFlightFences; //used to sync CPU-GPU so we don't use in-flight frames, one submit covers every window
+	uint32_t framesInFlight = 2; //number of frames that can be processed concurrently, from the options
+	std::vector<uint64_t> frameSerials; //serial of the submission each in-flight fence currently guards
+	uint64_t submittedFrames = 0; //serial of the newest submission, objects retired now are tagged with it
+	uint64_t completedFrames = 0; //serial of the newest submission known to have completed
+	DeletionQueue deletionQueue; //objects retired while frames in flight may still use them (swap chain recreation)
 	size_t currentFrame = 0; //variable to hold which frame we are currently rendering, it is circular so ranges between 0 - 1 (since we only have 2 frames to switch between)
-	//we use this to handle resize events explicitly - whenever the window is resized this flag is set and then reset when the event is handled
-	bool framebufferResized = false;
+	//we use this to handle resize events explicitly - whenever a window is resized its flag is set and then reset when the event is handled
 	static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
+	static void cursorPositionCallback(GLFWwindow* window, double x, double y);
+	static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	void pick(const WindowInput& input);
+
+	FrameCapture frameCapture; //copies rendered frames back to the host and writes them to disk in capture mode
+
+	//in headless mode the "swap chain" images are plain offscreen images, one per frame in flight
+	VkExtent2D headlessExtent = { 800, 600 }; //size of the offscreen images, set per golden scene
+	FrameTimer frameTimer; //CPU and GPU frame times of the golden run
+
+	CommandTraceRecorder traceRecorder; //records the first frame when a trace file was requested
+
+	bool memoryBudgetExtension = false; //the device was created with VK_EXT_memory_budget, the memory reports show the driver's budget
+	bool presentWaitEnabled = false; //the device was created with VK_KHR_present_id and VK_KHR_present_wait (latency runs only)
+	std::optional<VkPresentModeKHR> presentModeOverride; //from the options, or the mode being measured by the latency run
+	PresentLatency presentLatency;
+
+	FrameAllocationTracker hostAllocations; //host allocations made by the driver per frame
 };
 
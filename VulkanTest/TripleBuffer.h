@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+	Lock-free triple buffer handing the newest value from one producer thread to one consumer thread
+
+	The producer always has a slot of its own to write into and the consumer always has one to read from, the third
+	holds the newest published value. publish() and acquire() swap a private slot with the shared one in a single atomic
+	exchange, so neither side ever waits for the other: a producer running ahead replaces values the consumer never saw,
+	a consumer running ahead keeps reading the value it already has. Only the newest value survives, which is what frame
+	state needs; anything where every value has to arrive needs a queue instead.
+
+	After publish() the producer gets back whichever slot was shared, holding an old value, so it has to write the whole
+	value again rather than patch it.
+*/
+template<typename T>
+class TripleBuffer
+{
+public:
+	T& writeSlot() { return slots[writeIndex]; }
+	const T& readSlot() const { return slots[readIndex]; }
+
+	/*
+		producer: make the value in writeSlot() the newest one
+	*/
+	void publish()
+	{
+		uint8_t previous = shared.exchange(static_cast<uint8_t>(writeIndex | FRESH), std::memory_order_acq_rel);
+		writeIndex = previous & INDEX_MASK;
+	}
+
+	/*
+		consumer: move readSlot() to the newest value if one was published since the last call, returns whether it moved
+	*/
+	bool acquire()
+	{
+		if (!(shared.load(std::memory_order_relaxed) & FRESH)) {
+			return false;
+		}
+		uint8_t previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+		readIndex = previous & INDEX_MASK;
+		return true;
+	}
+
+private:
+	static const uint8_t INDEX_MASK = 3;
+	static const uint8_t FRESH = 4; //set when the shared slot was published and not yet acquired
+
+	T slots[3];
+	alignas(64) uint8_t writeIndex = 0; //owned by the producer
+	alignas(64) uint8_t readIndex = 1; //owned by the consumer
+	alignas(64) std::atomic<uint8_t> shared{ 2 };
+};
@@ -0,0 +1,228 @@
+#include "ValidationLog.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+namespace {
+	const auto WRITE_INTERVAL = std::chrono::milliseconds(10); //how long the writer sleeps when the ring is empty
+
+	const char* severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+	{
+		if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) return "error";
+		if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) return "warning";
+		if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) return "info";
+		return "verbose";
+	}
+
+	void copyString(char* destination, size_t size, const char* source)
+	{
+		if (source == nullptr) {
+			destination[0] = '\0';
+			return;
+		}
+		size_t length = std::strlen(source);
+		length = length < size - 1 ? length : size - 1;
+		std::memcpy(destination, source, length);
+		destination[length] = '\0';
+	}
+}
+
+ValidationLog::~ValidationLog()
+{
+	stop();
+}
+
+void ValidationLog::start(const ValidationLogSettings& settings)
+{
+	if (isRunning()) {
+		return;
+	}
+	this->settings = settings;
+	size_t size = 1;
+	while (size < settings.ringSize) {
+		size <<= 1;
+	}
+	slots.reset(new Slot[size]);
+	for (size_t i = 0; i < size; i++) {
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	mask = size - 1;
+	enqueuePosition = 0;
+	dequeuePosition = 0;
+	repeats.reset(new RepeatCount[REPEAT_TABLE_SIZE]);
+	stopping = false;
+	writer = std::thread(&ValidationLog::writerThread, this);
+	running = true;
+}
+
+void ValidationLog::stop()
+{
+	if (!isRunning()) {
+		return;
+	}
+	stopping = true;
+	writer.join();
+	running = false;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL ValidationLog::callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType,
+	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData)
+{
+	ValidationLog* log = static_cast<ValidationLog*>(pUserData);
+	if (log != nullptr && log->isRunning()) {
+		log->post(messageSeverity, pCallbackData);
+	}
+	else {
+		std::cerr << "validation layer: " << pCallbackData->pMessage << "\n"; //no writer thread, e.g. while the instance is destroyed after a failed start
+	}
+	return VK_FALSE;
+}
+
+void ValidationLog::post(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT* data)
+{
+	if (!admit(severity, data->messageIdNumber)) {
+		return;
+	}
+	if (!push(severity, data)) {
+		ringDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/*
+	the repeat count of an id lives in an open addressed table, an entry is claimed with a compare and swap on its key.
+	when the table is full the id is simply not deduplicated. the rate limit counts messages in the current second of
+	the steady clock, the thread that notices a new second restarts the count, which may let a few extra through
+*/
+bool ValidationLog::admit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, int32_t id)
+{
+	if (settings.maxRepeats > 0 && id != 0) {
+		uint64_t key = static_cast<uint32_t>(id) | (1ull << 32);
+		size_t index = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 54) & (REPEAT_TABLE_SIZE - 1);
+		for (size_t probe = 0; probe < REPEAT_TABLE_SIZE; probe++) {
+			RepeatCount& entry = repeats[(index + probe) & (REPEAT_TABLE_SIZE - 1)];
+			uint64_t current = entry.key.load(std::memory_order_acquire);
+			if (current == 0 && entry.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+				current = key;
+			}
+			if (current == key) {
+				if (entry.seen.fetch_add(1, std::memory_order_relaxed) >= settings.maxRepeats) {
+					return false; //counted, listed in the summary
+				}
+				break;
+			}
+		}
+	}
+
+	if (settings.maxPerSecond > 0 && !(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)) {
+		int64_t second = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		int64_t window = rateWindow.load(std::memory_order_relaxed);
+		if (window != second && rateWindow.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+			rateCount.store(0, std::memory_order_relaxed);
+		}
+		if (rateCount.fetch_add(1, std::memory_order_relaxed) >= settings.maxPerSecond) {
+			rateDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+	a slot whose sequence equals the enqueue position is free for that position. the producer that moves the position on
+	owns the slot, fills it and hands it to the writer by setting the sequence one past the position
+*/
+bool ValidationLog::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT* data)
+{
+	uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &slots[position & mask];
+		uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+		int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+		if (difference == 0) {
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		}
+		else if (difference < 0) {
+			return false; //the writer has not emptied this slot since the last time round, the ring is full
+		}
+		else {
+			position = enqueuePosition.load(std::memory_order_relaxed); //another producer took it
+		}
+	}
+	slot->message.severity = severity;
+	slot->message.id = data->messageIdNumber;
+	copyString(slot->message.name, NAME_SIZE, data->pMessageIdName);
+	copyString(slot->message.text, MESSAGE_SIZE, data->pMessage);
+	slot->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+bool ValidationLog::pop(Message& message)
+{
+	Slot& slot = slots[dequeuePosition & mask];
+	if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+		return false; //empty, or the producer is still filling it
+	}
+	message = slot.message;
+	slot.sequence.store(dequeuePosition + mask + 1, std::memory_order_release); //free for the position one lap on
+	dequeuePosition++;
+	return true;
+}
+
+void ValidationLog::writerThread()
+{
+	while (!stopping.load()) {
+		writeQueued();
+		std::this_thread::sleep_for(WRITE_INTERVAL);
+	}
+	writeQueued(); //whatever was posted before stop, the instance is destroyed by now so nothing follows
+	writeSummary();
+}
+
+/*
+	everything queued is written as one block with a single flush
+*/
+void ValidationLog::writeQueued()
+{
+	Message message;
+	std::string block;
+	while (pop(message)) {
+		block += "validation layer: [";
+		block += severityName(message.severity);
+		block += "] ";
+		block += message.text;
+		block += "\n";
+		if (settings.maxRepeats > 0 && message.id != 0 && names.find(message.id) == names.end()) {
+			names.emplace(message.id, message.name[0] != '\0' ? message.name : std::to_string(message.id));
+		}
+	}
+	uint64_t rate = rateDropped.load(std::memory_order_relaxed), ring = ringDropped.load(std::memory_order_relaxed);
+	if (rate != reportedRateDropped || ring != reportedRingDropped) {
+		block += "validation layer: " + std::to_string(rate - reportedRateDropped) + " messages over the rate limit and "
+			+ std::to_string(ring - reportedRingDropped) + " with the log full were dropped\n";
+		reportedRateDropped = rate;
+		reportedRingDropped = ring;
+	}
+	if (!block.empty()) {
+		std::cerr << block << std::flush;
+	}
+}
+
+void ValidationLog::writeSummary()
+{
+	for (size_t i = 0; i < REPEAT_TABLE_SIZE; i++) {
+		uint64_t key = repeats[i].key.load(std::memory_order_acquire);
+		uint32_t seen = repeats[i].seen.load(std::memory_order_relaxed);
+		if (key == 0 || seen <= settings.maxRepeats) {
+			continue;
+		}
+		int32_t id = static_cast<int32_t>(static_cast<uint32_t>(key));
+		auto name = names.find(id);
+		std::cerr << "validation layer: " << (name != names.end() ? name->second : std::to_string(id)) << " repeated "
+			<< seen - settings.maxRepeats << " more times\n";
+	}
+	std::cerr << std::flush;
+}
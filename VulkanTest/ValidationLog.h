@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+/*
+	settings for the validation log, filled in from the command line
+*/
+struct ValidationLogSettings {
+	uint32_t maxRepeats = 5; //messages written per message id, later ones are only counted, 0 writes every one
+	uint32_t maxPerSecond = 200; //warnings and below written per second, errors are never rate limited, 0 for no limit
+	uint32_t ringSize = 1024; //messages waiting for the writer thread, more are dropped and counted
+};
+
+/*
+	Asynchronous validation message log
+
+	The debug messenger callback runs on whichever thread made the Vulkan call, in the middle of it, so writing to
+	std::cerr with std::endl there stalls the frame on a console flush for every message. Under heavy validation output
+	this dominates the frame time. Instead the callback only copies the message into a fixed size ring and returns:
+
+		message id seen more than maxRepeats times -> counted, not queued
+		more than maxPerSecond messages this second -> counted, not queued (errors always pass)
+		ring full -> counted, not queued
+
+	The ring is a bounded multi producer, single consumer queue with a sequence number per slot, so producers only
+	claim a slot with a compare and swap and never block or allocate. A writer thread formats and writes whatever is
+	queued every few milliseconds, reports the messages dropped by the rate limit or a full ring as they happen, and
+	when the log stops it lists how often every repeated message id was suppressed.
+
+	Messages longer than the slot are cut short. Message id 0 is used by the loader and by general messages that have
+	no id, those are never deduplicated.
+*/
+class ValidationLog
+{
+public:
+	~ValidationLog();
+
+	void start(const ValidationLogSettings& settings);
+	void stop(); //writes what is still queued and the repeat summary, then joins the writer thread
+	bool isRunning() const { return running.load(); }
+
+	//any thread, never blocks
+	void post(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT* data);
+
+	//the debug messenger callback, pUserData is the ValidationLog
+	static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType,
+		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData);
+
+private:
+	static const size_t MESSAGE_SIZE = 1024;
+	static const size_t NAME_SIZE = 96;
+	static const size_t REPEAT_TABLE_SIZE = 1024; //distinct message ids counted, a power of two
+
+	struct Message {
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+		int32_t id;
+		char name[NAME_SIZE];
+		char text[MESSAGE_SIZE];
+	};
+
+	struct Slot {
+		std::atomic<uint64_t> sequence{ 0 }; //position it can next be written at, or that position + 1 once it holds a message
+		Message message;
+	};
+
+	struct RepeatCount {
+		std::atomic<uint64_t> key{ 0 }; //message id with bit 32 set, 0 while the entry is free
+		std::atomic<uint32_t> seen{ 0 };
+	};
+
+	bool admit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, int32_t id); //dedup and rate limit
+	bool push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT* data);
+	bool pop(Message& message);
+	void writerThread();
+	void writeQueued();
+	void writeSummary();
+
+	ValidationLogSettings settings;
+	std::unique_ptr<Slot[]> slots;
+	uint64_t mask = 0;
+	alignas(64) std::atomic<uint64_t> enqueuePosition{ 0 };
+	alignas(64) uint64_t dequeuePosition = 0; //writer thread only
+
+	std::unique_ptr<RepeatCount[]> repeats;
+	std::atomic<int64_t> rateWindow{ 0 }; //second of the steady clock the count below belongs to
+	std::atomic<uint32_t> rateCount{ 0 };
+	std::atomic<uint64_t> rateDropped{ 0 };
+	std::atomic<uint64_t> ringDropped{ 0 };
+
+	std::thread writer;
+	std::atomic<bool> running{ false }; //read by the callback on any thread
+	std::atomic<bool> stopping{ false };
+	uint64_t reportedRateDropped = 0, reportedRingDropped = 0; //writer thread only
+	std::unordered_map<int32_t, std::string> names; //writer thread only, the name of every deduplicated id written
+};
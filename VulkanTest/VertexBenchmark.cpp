@@ -0,0 +1,352 @@
+#include "VertexBenchmark.h"
+#include "VulkanUtils.h"
+#include "ObjImporter.h"
+#include "MeshOptimizer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	/*
+		stands in for an imported mesh: a torus with a smooth normal, a texture coordinate and a colour per vertex
+	*/
+	Mesh generateTorus(uint32_t rings, uint32_t sides)
+	{
+		Mesh torus;
+		for (uint32_t ring = 0; ring <= rings; ring++) {
+			float u = ring * glm::two_pi<float>() / rings;
+			for (uint32_t side = 0; side <= sides; side++) {
+				float v = side * glm::two_pi<float>() / sides;
+				MeshVertex vertex;
+				vertex.normal = glm::vec3(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v), std::sin(v));
+				vertex.position = glm::vec3(std::cos(u), std::sin(u), 0.0f) + vertex.normal * 0.3f;
+				vertex.texCoord = glm::vec2(static_cast<float>(ring) / rings, static_cast<float>(side) / sides);
+				vertex.color = glm::vec4(0.5f + 0.5f * std::cos(u), 0.5f + 0.5f * std::sin(v), 0.8f, 1.0f);
+				torus.vertices.push_back(vertex);
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ring++) {
+			for (uint32_t side = 0; side < sides; side++) {
+				uint32_t a = ring * (sides + 1) + side, b = a + sides + 1;
+				uint32_t quad[6] = { a, b, b + 1, a, b + 1, a + 1 };
+				torus.indices.insert(torus.indices.end(), quad, quad + 6);
+			}
+		}
+		return torus;
+	}
+}
+
+VertexBenchmark::VertexBenchmark(const VertexBenchmarkSettings& settings) : settings(settings)
+{
+}
+
+void VertexBenchmark::run()
+{
+	DeviceMemoryScope memoryScope("VertexBenchmark");
+	if (settings.file.empty()) {
+		mesh = generateTorus(512, 256);
+	}
+	else {
+		ObjImportStats importStats;
+		mesh = importObj(settings.file, 0, &importStats);
+		std::cout << "imported " << settings.file << ": " << importStats << std::endl;
+	}
+	//the order a mesh pipeline would leave it in, so the post transform cache is not what is being measured
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	optimizeVertexFetch(mesh);
+	packedMesh = quantizeMesh(mesh);
+
+	createDevice();
+	try {
+		createBuffers();
+		target = context.createOffscreenTarget(extent, VK_FORMAT_R8G8B8A8_UNORM, true);
+		createPipelines();
+		context.createFrameResources(FRAMES_IN_FLIGHT, commandBuffers, fences, frameTimer);
+
+		QuantizationError error = measureQuantizationError(mesh, packedMesh);
+		glm::vec3 extent = packedMesh.boundsExtent;
+		std::cout << "vertex compression benchmark: " << context.properties.deviceName << ", " << mesh.vertices.size() << " vertices, "
+			<< mesh.triangleCount() << " triangles, " << settings.copies << " copies per frame" << std::endl;
+		std::cout << "  stride " << sizeof(MeshVertex) << " -> " << sizeof(PackedVertex) << " bytes, largest errors: position "
+			<< error.position << " (" << error.position / std::max(extent.x, std::max(extent.y, extent.z)) * 100.0f << "% of the bounds), normal "
+			<< error.normalDegrees << " degrees, texcoord " << error.texCoord << ", colour " << error.color << std::endl;
+
+		std::vector<uint8_t> fullImage, packedImage;
+		VkDeviceSize fullBytes = sizeof(MeshVertex) * mesh.vertices.size();
+		VkDeviceSize packedBytes = sizeof(PackedVertex) * packedMesh.vertices.size();
+		double fullTime = runFormat(Format::Full, "full precision", fullBytes, fullImage);
+		double packedTime = runFormat(Format::Packed, "packed        ", packedBytes, packedImage);
+
+		double savedMegabytes = static_cast<double>(fullBytes - packedBytes) * settings.copies / (1024.0 * 1024.0);
+		std::cout << "  " << savedMegabytes << " MB less vertex data read per frame (" << (1.0 - static_cast<double>(packedBytes) / fullBytes) * 100.0 << "%)";
+		if (fullTime > 0.0 && packedTime > 0.0) {
+			std::cout << ", gpu frame " << (1.0 - packedTime / fullTime) * 100.0 << "% faster";
+		}
+		std::cout << std::endl;
+
+		size_t differing = 0;
+		for (size_t i = 0; i < fullImage.size(); i += 4) {
+			for (size_t channel = 0; channel < 3; channel++) {
+				if (std::abs(fullImage[i + channel] - packedImage[i + channel]) > 8) {
+					differing++;
+					break;
+				}
+			}
+		}
+		std::cout << "  " << differing << " of " << fullImage.size() / 4 << " pixels differ by more than 8 between the formats" << std::endl;
+	}
+	catch (...) {
+		cleanup();
+		throw;
+	}
+	cleanup();
+}
+
+void VertexBenchmark::createDevice()
+{
+	context.createInstance("Vertex Compression Benchmark", VK_API_VERSION_1_0);
+	context.createDevice({}, nullptr);
+}
+
+/*
+	copy data into a new device local buffer through a temporary staging buffer
+*/
+void VertexBenchmark::uploadBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory)
+{
+	VkDevice device = context.device;
+	VkBuffer staging;
+	VkDeviceMemory stagingMemory;
+	createBuffer(device, context.physicalDevice, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, staging, stagingMemory);
+	void* mapped;
+	vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapped);
+	memcpy(mapped, data, static_cast<size_t>(size));
+	vkUnmapMemory(device, stagingMemory);
+
+	createBuffer(device, context.physicalDevice, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, buffer, memory);
+	VkCommandBuffer commandBuffer = context.beginSingleTimeCommands();
+	VkBufferCopy region = { 0, 0, size };
+	vkCmdCopyBuffer(commandBuffer, staging, buffer, 1, &region);
+	context.endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(device, staging, nullptr);
+	freeDeviceMemory(device, stagingMemory, nullptr);
+}
+
+void VertexBenchmark::createBuffers()
+{
+	uploadBuffer(mesh.vertices.data(), sizeof(MeshVertex) * mesh.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, fullVertexBuffer, fullVertexMemory);
+	uploadBuffer(packedMesh.vertices.data(), sizeof(PackedVertex) * packedMesh.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, packedVertexBuffer, packedVertexMemory);
+	uploadBuffer(mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexMemory);
+}
+
+/*
+	the two pipelines differ only in the vertex shader and the vertex input layout
+*/
+void VertexBenchmark::createPipelines()
+{
+	VkDevice device = context.device;
+
+	VkPushConstantRange transformRange = pushConstantRange(context.physicalDevice, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4));
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO; //struct type
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &transformRange;
+	if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	VkShaderModule fullVertModule = createShaderModule(device, readBinaryFile("../shaders/mesh_vert.spv"));
+	VkShaderModule packedVertModule = createShaderModule(device, readBinaryFile("../shaders/vert.spv"));
+	VkShaderModule fragModule = createShaderModule(device, readBinaryFile("../shaders/mesh_frag.spv"));
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //struct type
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragModule;
+	stages[1].pName = "main";
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO; //struct type
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.vertexAttributeDescriptionCount = 4;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO; //struct type
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO; //struct type
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = &viewport;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO; //struct type
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE; //imported meshes come with either winding
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO; //struct type
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	VkPipelineColorBlendStateCreateInfo colorBlending = {};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO; //struct type
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO; //struct type
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = target.renderPass;
+	pipelineInfo.subpass = 0;
+
+	VertexInputLayout fullLayout = fullVertexLayout();
+	stages[0].module = fullVertModule;
+	vertexInputInfo.pVertexBindingDescriptions = &fullLayout.binding;
+	vertexInputInfo.pVertexAttributeDescriptions = fullLayout.attributes.data();
+	VkResult fullResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &fullPipeline);
+
+	VertexInputLayout packedLayout = packedVertexLayout();
+	stages[0].module = packedVertModule;
+	vertexInputInfo.pVertexBindingDescriptions = &packedLayout.binding;
+	vertexInputInfo.pVertexAttributeDescriptions = packedLayout.attributes.data();
+	VkResult packedResult = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &packedPipeline);
+
+	vkDestroyShaderModule(device, fullVertModule, nullptr);
+	vkDestroyShaderModule(device, packedVertModule, nullptr);
+	vkDestroyShaderModule(device, fragModule, nullptr);
+	if (fullResult != VK_SUCCESS || packedResult != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline!");
+	}
+}
+
+/*
+	the copies sit on a square grid, each turned a little further so they are not identical on screen
+	the packed path multiplies the dequantization into the transform, the full path draws mesh space positions directly
+*/
+void VertexBenchmark::recordFrame(VkCommandBuffer commandBuffer, Format format)
+{
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO; //struct type
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //re-recorded every frame
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
+	}
+
+	VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO; //struct type
+	renderPassInfo.renderPass = target.renderPass;
+	renderPassInfo.framebuffer = target.framebuffer;
+	renderPassInfo.renderArea = { { 0, 0 }, extent };
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearColor;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	VkBuffer vertexBuffer = format == Format::Full ? fullVertexBuffer : packedVertexBuffer;
+	VkDeviceSize offset = 0;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, format == Format::Full ? fullPipeline : packedPipeline);
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(settings.copies))));
+	glm::vec3 center = packedMesh.boundsMin + packedMesh.boundsExtent * 0.5f;
+	float radius = std::max(glm::length(packedMesh.boundsExtent) * 0.5f, 1e-6f);
+	glm::mat4 projection = glm::orthoRH_ZO(0.0f, static_cast<float>(columns), 0.0f, static_cast<float>(columns), -1.0f, 1.0f);
+	glm::mat4 meshToUnit = glm::scale(glm::mat4(1.0f), glm::vec3(0.45f / radius)) * glm::translate(glm::mat4(1.0f), -center);
+	if (format == Format::Packed) {
+		meshToUnit = meshToUnit * packedMesh.dequantization();
+	}
+	for (uint32_t i = 0; i < settings.copies; i++) {
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(i % columns + 0.5f, i / columns + 0.5f, 0.0f));
+		model = glm::rotate(model, 0.3f + i * 0.1f, glm::normalize(glm::vec3(1.0f, 0.5f, 0.2f)));
+		glm::mat4 transform = projection * model * meshToUnit;
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), &transform);
+		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mesh.indices.size()), 1, 0, 0, 0);
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+}
+
+/*
+	returns the median GPU frame time, 0 when the queue has no timestamps
+*/
+double VertexBenchmark::runFormat(Format format, const char* name, VkDeviceSize vertexBytes, std::vector<uint8_t>& image)
+{
+	VkDevice device = context.device;
+	size_t frame = 0;
+	for (uint32_t i = 0; i < settings.warmupFrames + settings.frames; i++) {
+		if (i == settings.warmupFrames) {
+			vkDeviceWaitIdle(device);
+			frameTimer.flush();
+			frameTimer.reset();
+		}
+		vkWaitForFences(device, 1, &fences[frame], VK_TRUE, UINT64_MAX);
+		frameTimer.beginFrame(frame);
+		recordFrame(commandBuffers[frame], format);
+
+		context.submitTimedFrame(frameTimer, frame, commandBuffers[frame], fences[frame]);
+		frame = (frame + 1) % FRAMES_IN_FLIGHT;
+	}
+	vkDeviceWaitIdle(device);
+	frameTimer.flush();
+
+	//every copy reads the whole vertex buffer at least once, more if vertices fall out of the post transform cache
+	double megabytesPerFrame = static_cast<double>(vertexBytes) * settings.copies / (1024.0 * 1024.0);
+	std::cout << "  " << name << " " << vertexBytes / 1024 << " KB vertex buffer, at least " << megabytesPerFrame << " MB of vertex data read per frame" << std::endl;
+	double median = 0.0;
+	if (frameTimer.hasGpuTiming()) {
+		TimingSummary gpu = frameTimer.gpuSummary();
+		median = gpu.p50;
+		std::cout << "    gpu frame " << gpu << ", " << megabytesPerFrame / 1024.0 / (median / 1000.0) << " GB/s of vertex fetch" << std::endl;
+	}
+	image = context.readOffscreenTarget(target);
+	return median;
+}
+
+void VertexBenchmark::cleanup()
+{
+	VkDevice device = context.device;
+	if (device != VK_NULL_HANDLE) {
+		context.destroyFrameResources(fences, frameTimer);
+		vkDestroyPipeline(device, fullPipeline, nullptr);
+		vkDestroyPipeline(device, packedPipeline, nullptr);
+		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		context.destroyOffscreenTarget(target);
+		vkDestroyBuffer(device, fullVertexBuffer, nullptr);
+		freeDeviceMemory(device, fullVertexMemory, nullptr);
+		vkDestroyBuffer(device, packedVertexBuffer, nullptr);
+		freeDeviceMemory(device, packedVertexMemory, nullptr);
+		vkDestroyBuffer(device, indexBuffer, nullptr);
+		freeDeviceMemory(device, indexMemory, nullptr);
+	}
+	context.cleanup();
+}
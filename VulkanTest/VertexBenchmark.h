@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "HeadlessDevice.h"
+#include "FrameTimer.h"
+#include "Mesh.h"
+#include "VertexCompression.h"
+
+/*
+	settings for the vertex compression benchmark, filled in from the command line
+*/
+struct VertexBenchmarkSettings {
+	bool enabled = false;
+	std::string file; //OBJ to draw, a generated torus when empty
+	uint32_t copies = 64; //draws of the mesh per frame
+	uint32_t frames = 300; //timed frames per format
+	uint32_t warmupFrames = 20; //untimed frames per format
+};
+
+/*
+	Vertex compression benchmark
+
+	Draws many copies of one mesh into a small offscreen target (so the frame is bound by vertex work rather than by
+	pixels) from a full precision MeshVertex buffer through mesh.vert and from a PackedVertex buffer through shader.vert,
+	and reports the GPU frame time, the vertex data read per frame and the effective fetch bandwidth of both, along with
+	the largest quantisation errors and how many pixels of the two images differ.
+*/
+class VertexBenchmark
+{
+public:
+	explicit VertexBenchmark(const VertexBenchmarkSettings& settings);
+	void run();
+
+private:
+	enum class Format { Full, Packed };
+
+	void createDevice();
+	void createBuffers();
+	void createPipelines();
+	void recordFrame(VkCommandBuffer commandBuffer, Format format);
+	double runFormat(Format format, const char* name, VkDeviceSize vertexBytes, std::vector<uint8_t>& image);
+	void uploadBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& memory);
+	void cleanup();
+
+	VertexBenchmarkSettings settings;
+	HeadlessDevice context;
+	Mesh mesh;
+	QuantizedMesh packedMesh;
+
+	VkBuffer fullVertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory fullVertexMemory = VK_NULL_HANDLE;
+	VkBuffer packedVertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory packedVertexMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+
+	VkExtent2D extent = { 256, 256 };
+	OffscreenTarget target; //R8G8B8A8_UNORM, read back to compare the two vertex formats
+
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE; //one mat4 push constant, shared by both pipelines
+	VkPipeline fullPipeline = VK_NULL_HANDLE;
+	VkPipeline packedPipeline = VK_NULL_HANDLE;
+
+	static const int FRAMES_IN_FLIGHT = 2;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkFence> fences;
+	FrameTimer frameTimer;
+};
@@ -0,0 +1,153 @@
+#include "VertexCompression.h"
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	glm::vec2 octahedralSquare(const glm::vec3& normal)
+	{
+		glm::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+		glm::vec2 square(n.x, n.y);
+		if (n.z < 0.0f) { //fold the lower hemisphere over the diagonals
+			square.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+			square.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return square;
+	}
+
+	glm::vec3 octahedralNormal(const glm::vec2& square)
+	{
+		glm::vec3 n(square.x, square.y, 1.0f - std::abs(square.x) - std::abs(square.y));
+		float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+}
+
+glm::mat4 QuantizedMesh::dequantization() const
+{
+	return glm::scale(glm::translate(glm::mat4(1.0f), boundsMin), boundsExtent);
+}
+
+uint32_t packOctahedral(const glm::vec3& normal)
+{
+	glm::vec2 square = octahedralSquare(normal);
+	glm::vec2 scaled = square * 32767.0f;
+	uint32_t best = 0;
+	float bestCosine = -2.0f;
+	for (int i = 0; i < 4; i++) {
+		glm::vec2 candidate((i & 1) ? std::ceil(scaled.x) : std::floor(scaled.x), (i & 2) ? std::ceil(scaled.y) : std::floor(scaled.y));
+		uint32_t packed = glm::packSnorm2x16(glm::clamp(candidate / 32767.0f, -1.0f, 1.0f));
+		float cosine = glm::dot(unpackOctahedral(packed), normal);
+		if (cosine > bestCosine) {
+			bestCosine = cosine;
+			best = packed;
+		}
+	}
+	return best;
+}
+
+glm::vec3 unpackOctahedral(uint32_t packed)
+{
+	return octahedralNormal(glm::unpackSnorm2x16(packed));
+}
+
+QuantizedMesh quantizeMesh(const Mesh& mesh)
+{
+	QuantizedMesh quantized;
+	quantized.indices = mesh.indices;
+	if (mesh.vertices.empty()) {
+		return quantized;
+	}
+
+	glm::vec3 boundsMin = mesh.vertices[0].position, boundsMax = mesh.vertices[0].position;
+	for (const auto& vertex : mesh.vertices) {
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	glm::vec3 extent = boundsMax - boundsMin;
+	for (int axis = 0; axis < 3; axis++) {
+		if (extent[axis] <= 0.0f) {
+			extent[axis] = 1.0f; //every position on this axis encodes to 0, which decodes to boundsMin exactly
+		}
+	}
+	quantized.boundsMin = boundsMin;
+	quantized.boundsExtent = extent;
+
+	quantized.vertices.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		const MeshVertex& vertex = mesh.vertices[i];
+		PackedVertex& packed = quantized.vertices[i];
+		uint64_t position = glm::packUnorm4x16(glm::vec4((vertex.position - boundsMin) / extent, 0.0f));
+		std::memcpy(packed.position, &position, sizeof(position)); //kept as four halves so the struct stays 4 byte aligned
+		float length = glm::length(vertex.normal);
+		packed.normal = packOctahedral(length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 0.0f, 1.0f));
+		packed.texCoord = glm::packHalf2x16(vertex.texCoord);
+		packed.color = glm::packUnorm4x8(vertex.color);
+	}
+	return quantized;
+}
+
+MeshVertex unpackVertex(const PackedVertex& vertex, const QuantizedMesh& mesh)
+{
+	MeshVertex unpacked;
+	uint64_t position;
+	std::memcpy(&position, vertex.position, sizeof(position));
+	unpacked.position = mesh.boundsMin + glm::vec3(glm::unpackUnorm4x16(position)) * mesh.boundsExtent;
+	unpacked.normal = unpackOctahedral(vertex.normal);
+	unpacked.texCoord = glm::unpackHalf2x16(vertex.texCoord);
+	unpacked.color = glm::unpackUnorm4x8(vertex.color);
+	return unpacked;
+}
+
+QuantizationError measureQuantizationError(const Mesh& source, const QuantizedMesh& quantized)
+{
+	QuantizationError error;
+	for (size_t i = 0; i < source.vertices.size() && i < quantized.vertices.size(); i++) {
+		const MeshVertex& original = source.vertices[i];
+		MeshVertex decoded = unpackVertex(quantized.vertices[i], quantized);
+		error.position = std::max(error.position, glm::length(decoded.position - original.position));
+		float length = glm::length(original.normal);
+		if (length > 0.0f) {
+			float cosine = glm::clamp(glm::dot(decoded.normal, original.normal / length), -1.0f, 1.0f);
+			error.normalDegrees = std::max(error.normalDegrees, glm::degrees(std::acos(cosine)));
+		}
+		glm::vec2 texCoordError = glm::abs(decoded.texCoord - original.texCoord);
+		error.texCoord = std::max(error.texCoord, std::max(texCoordError.x, texCoordError.y));
+		glm::vec4 colorError = glm::abs(decoded.color - original.color);
+		error.color = std::max(error.color, std::max(std::max(colorError.x, colorError.y), std::max(colorError.z, colorError.w)));
+	}
+	return error;
+}
+
+VertexInputLayout packedVertexLayout(uint32_t binding)
+{
+	VertexInputLayout layout;
+	layout.binding = { binding, sizeof(PackedVertex), VK_VERTEX_INPUT_RATE_VERTEX };
+	layout.attributes = {
+		{ 0, binding, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position) },
+		{ 1, binding, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal) },
+		{ 2, binding, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, texCoord) },
+		{ 3, binding, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color) }
+	};
+	return layout;
+}
+
+VertexInputLayout fullVertexLayout(uint32_t binding)
+{
+	VertexInputLayout layout;
+	layout.binding = { binding, sizeof(MeshVertex), VK_VERTEX_INPUT_RATE_VERTEX };
+	layout.attributes = {
+		{ 0, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, position) },
+		{ 1, binding, VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshVertex, normal) },
+		{ 2, binding, VK_FORMAT_R32G32_SFLOAT, offsetof(MeshVertex, texCoord) },
+		{ 3, binding, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(MeshVertex, color) }
+	};
+	return layout;
+}
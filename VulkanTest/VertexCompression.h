@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "Mesh.h"
+
+/*
+	compressed vertex, 20 bytes against the 48 of a full precision MeshVertex
+	the vertex input formats convert every field back to floats on fetch, so the shader only has to undo the position
+	scale and bias (folded into its transform) and the octahedral mapping of the normal
+*/
+struct PackedVertex {
+	uint16_t position[4]; //unorm16x4 within the mesh bounds, w unused (three component 16 bit formats are rarely supported for vertex input)
+	uint32_t normal; //octahedral snorm16x2
+	uint32_t texCoord; //half2
+	uint32_t color; //unorm8x4
+};
+
+/*
+	indexed triangle list with packed vertices and the bounds needed to decode their positions
+*/
+struct QuantizedMesh {
+	std::vector<PackedVertex> vertices;
+	std::vector<uint32_t> indices;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsExtent = glm::vec3(1.0f); //never zero, flat axes get an extent of 1
+
+	/*
+		maps the unorm positions back into mesh space, multiply it into the model matrix so decoding costs the shader nothing
+	*/
+	glm::mat4 dequantization() const;
+};
+
+QuantizedMesh quantizeMesh(const Mesh& mesh);
+
+/*
+	CPU decode that mirrors shader.vert, for checking the error introduced by quantisation
+*/
+MeshVertex unpackVertex(const PackedVertex& vertex, const QuantizedMesh& mesh);
+
+/*
+	unit vector to the octahedral square in [-1, 1]^2 and back. the encode rounds to whichever of the four nearest snorm16
+	pairs decodes closest to the input rather than the nearest pair, which roughly halves the worst case angular error
+*/
+uint32_t packOctahedral(const glm::vec3& normal);
+glm::vec3 unpackOctahedral(uint32_t packed);
+
+/*
+	largest error over all vertices of a quantized mesh against its source
+*/
+struct QuantizationError {
+	float position = 0.0f; //in mesh units
+	float normalDegrees = 0.0f;
+	float texCoord = 0.0f;
+	float color = 0.0f;
+};
+QuantizationError measureQuantizationError(const Mesh& source, const QuantizedMesh& quantized);
+
+/*
+	binding and attributes of a vertex buffer, locations 0 to 3 are position, normal, texcoord and colour in both layouts
+*/
+struct VertexInputLayout {
+	VkVertexInputBindingDescription binding;
+	std::vector<VkVertexInputAttributeDescription> attributes;
+};
+
+VertexInputLayout packedVertexLayout(uint32_t binding = 0); //matches shader.vert
+VertexInputLayout fullVertexLayout(uint32_t binding = 0); //matches mesh.vert
@@ -0,0 +1,203 @@
+#include "VulkanUtils.h"
+
+#include <fstream>
+
+/*
+	every physical device exposes a number of memory types, each belonging to a heap and having a set of properties
+	(device local, host visible, coherent, cached...), the resource tells us which types it can live in through a bitmask
+*/
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memProperties; //the memory types and heaps available on the device
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+		//the type must be allowed by the resource and must have every property we asked for
+		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("failed to find suitable memory type!");
+}
+
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+{
+	VkPhysicalDeviceMemoryProperties memProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) { //first pass looks for a type with both the required and the preferred properties
+		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & (required | preferred)) == (required | preferred)) {
+			return i;
+		}
+	}
+
+	return findMemoryType(physicalDevice, typeFilter, required); //otherwise settle for the required properties only
+}
+
+void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+	const VkAllocationCallbacks* allocator)
+{
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO; //struct type
+	bufferInfo.size = size; //size of the buffer in bytes
+	bufferInfo.usage = usage; //what the buffer will be used for (transfer destination, vertex data...)
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; //only used by the graphics queue
+
+	if (vkCreateBuffer(device, &bufferInfo, allocator, &buffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create buffer!");
+	}
+
+	//the buffer has no memory yet, ask it how much it needs and which memory types it can use
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO; //struct type
+	allocInfo.allocationSize = memRequirements.size; //size might be larger than requested because of alignment
+	allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, required, preferred);
+
+	if (allocateDeviceMemory(device, &allocInfo, allocator, &bufferMemory) != VK_SUCCESS) {
+		vkDestroyBuffer(device, buffer, allocator);
+		throw std::runtime_error("failed to allocate buffer memory!");
+	}
+
+	vkBindBufferMemory(device, buffer, bufferMemory, 0); //bind the allocation to the buffer at offset 0
+}
+
+void createImage(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+	VkImage& image, VkDeviceMemory& imageMemory, const VkAllocationCallbacks* allocator, uint32_t mipLevels)
+{
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO; //struct type
+	imageInfo.imageType = VK_IMAGE_TYPE_2D; //2D texel grid
+	imageInfo.extent = { extent.width, extent.height, 1 }; //dimensions, depth is 1 for 2D images
+	imageInfo.mipLevels = mipLevels; //1 for no mip chain
+	imageInfo.arrayLayers = 1; //not an array
+	imageInfo.format = format; //texel format
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL; //implementation defined layout, fastest for the GPU to access
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; //contents are discarded on the first transition
+	imageInfo.usage = usage; //what the image will be used for (attachment, copy source, sampling...)
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT; //no multisampling
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; //only used by the graphics queue
+
+	if (vkCreateImage(device, &imageInfo, allocator, &image) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create image!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO; //struct type
+	allocInfo.allocationSize = memRequirements.size; //optimal tiling usually needs more than width * height * texel size
+	allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (allocateDeviceMemory(device, &allocInfo, allocator, &imageMemory) != VK_SUCCESS) {
+		vkDestroyImage(device, image, allocator);
+		throw std::runtime_error("failed to allocate image memory!");
+	}
+
+	vkBindImageMemory(device, image, imageMemory, 0);
+}
+
+std::vector<char> readBinaryFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::ate | std::ios::binary); //start at the end so the position is the size
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open file " + filename + "!");
+	}
+	size_t fileSize = static_cast<size_t>(file.tellg());
+	std::vector<char> buffer(fileSize);
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+	return buffer;
+}
+
+VkPushConstantRange pushConstantRange(VkPhysicalDevice physicalDevice, VkShaderStageFlags stages, uint32_t size)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	if (size > properties.limits.maxPushConstantsSize) {
+		throw std::runtime_error("failed to create push constant range, " + std::to_string(size) + " bytes is more than the device's maxPushConstantsSize of "
+			+ std::to_string(properties.limits.maxPushConstantsSize) + "!");
+	}
+	return { stages, 0, size };
+}
+
+VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code)
+{
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO; //struct type
+	createInfo.codeSize = code.size(); //size in bytes
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data()); //vector storage is suitably aligned for uint32_t
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module!");
+	}
+	return shaderModule;
+}
+
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t mipLevels, uint32_t baseMipLevel)
+{
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO; //struct type
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = aspect; //colour or depth
+	viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create image view!");
+	}
+	return imageView;
+}
+
+void imageBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageAspectFlags aspect, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+	uint32_t baseMipLevel, uint32_t levelCount)
+{
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER; //struct type
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED; //no ownership transfer
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = aspect;
+	barrier.subresourceRange.baseMipLevel = baseMipLevel;
+	barrier.subresourceRange.levelCount = levelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+std::vector<HeapBudget> queryHeapBudgets(VkPhysicalDevice physicalDevice, bool memoryBudgetExtension)
+{
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	VkPhysicalDeviceMemoryProperties2 properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	properties.pNext = memoryBudgetExtension ? &budgetProperties : nullptr;
+	vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties);
+
+	const VkPhysicalDeviceMemoryProperties& memProperties = properties.memoryProperties;
+	std::vector<HeapBudget> heaps(memProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+		heaps[i].size = memProperties.memoryHeaps[i].size;
+		heaps[i].budget = memoryBudgetExtension ? budgetProperties.heapBudget[i] : memProperties.memoryHeaps[i].size;
+		heaps[i].usage = memoryBudgetExtension ? budgetProperties.heapUsage[i] : 0;
+		heaps[i].deviceLocal = (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	}
+	return heaps;
+}
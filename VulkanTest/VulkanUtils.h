@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+#include "DeviceMemoryTracker.h" //every allocation below goes through allocateDeviceMemory
+
+/*
+	small helpers shared by the subsystems that need to create their own buffers outside of TriangleApp
+*/
+
+/*
+	find the index of a memory type on the physical device that is allowed by typeFilter (a bitmask from VkMemoryRequirements)
+	and has all of the requested property flags, throws if there is no such memory type
+*/
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+/*
+	same as above, but first tries the preferred flags (for example HOST_CACHED for readback) and falls back to the required flags
+*/
+uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred);
+
+/*
+	create a buffer of the given size and usage and back it with a dedicated allocation from a memory type with the requested properties
+	allocator is passed through to the buffer and memory creation, the caller must destroy them with the same callbacks
+*/
+void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+	const VkAllocationCallbacks* allocator = nullptr);
+
+/*
+	create a single layer 2D image with optimal tiling and back it with a dedicated device local allocation
+	allocator is passed through to the image and memory creation, the caller must destroy them with the same callbacks
+*/
+void createImage(VkDevice device, VkPhysicalDevice physicalDevice, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+	VkImage& image, VkDeviceMemory& imageMemory, const VkAllocationCallbacks* allocator = nullptr, uint32_t mipLevels = 1);
+
+/*
+	read a whole binary file (SPIR-V, textures, traces), throws if it cannot be opened
+*/
+std::vector<char> readBinaryFile(const std::string& filename);
+
+/*
+	push constant range of the given size at offset 0, throws if it is more than the device's maxPushConstantsSize
+	(at least 128 bytes on every device)
+*/
+VkPushConstantRange pushConstantRange(VkPhysicalDevice physicalDevice, VkShaderStageFlags stages, uint32_t size);
+
+/*
+	wrap SPIR-V code in a shader module
+*/
+VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code);
+
+/*
+	2D view over mipLevels levels of an image, starting at baseMipLevel
+*/
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t mipLevels = 1, uint32_t baseMipLevel = 0);
+
+/*
+	record a layout transition (and the memory dependency that goes with it) for a range of mip levels of a single layer image
+*/
+void imageBarrier(VkCommandBuffer commandBuffer, VkImage image, VkImageAspectFlags aspect, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+	uint32_t baseMipLevel = 0, uint32_t levelCount = VK_REMAINING_MIP_LEVELS);
+
+/*
+	how much of a memory heap this process may use and how much it is using, from VK_EXT_memory_budget when it was enabled,
+	otherwise the heap size and an unknown (zero) usage
+*/
+struct HeapBudget {
+	VkDeviceSize size = 0;
+	VkDeviceSize budget = 0;
+	VkDeviceSize usage = 0;
+	bool deviceLocal = false;
+};
+std::vector<HeapBudget> queryHeapBudgets(VkPhysicalDevice physicalDevice, bool memoryBudgetExtension);
@@ -4,17 +4,558 @@
 #include <glm/mat4x4.hpp>
 
 #include <iostream>
+#include <string>
+#include <algorithm>
+#include <iterator>
 
 #include "TriangleApp.h"
+#include "TraceReplayer.h"
+#include "BindlessBenchmark.h"
+#include "StreamingBenchmark.h"
+#include "TextureBenchmark.h"
+#include "MeshBenchmark.h"
+#include "VertexBenchmark.h"
+#include "LodBenchmark.h"
+#include "SceneBenchmark.h"
+#include "BvhBenchmark.h"
+#include "JobBenchmark.h"
+#include "RobustnessBenchmark.h"
+#include "PushConstantBenchmark.h"
+#include "ParticleBenchmark.h"
+#include "OcclusionBenchmark.h"
+#include "RuntimeConfig.h"
 
-int main() {
-	TriangleApp app;
+/*
+	the modes that run instead of the application, at most one of them is enabled
+*/
+struct RunModes {
+	ReplaySettings replay;
+	BindlessBenchmarkSettings bindless;
+	StreamingBenchmarkSettings streaming;
+	TextureBenchmarkSettings texture;
+	MeshBenchmarkSettings mesh;
+	VertexBenchmarkSettings vertex;
+	LodBenchmarkSettings lod;
+	SceneBenchmarkSettings scene;
+	BvhBenchmarkSettings bvh;
+	JobBenchmarkSettings jobs;
+	RobustnessBenchmarkSettings robustness;
+	PushConstantBenchmarkSettings pushConstants;
+	ParticleBenchmarkSettings particles;
+	OcclusionBenchmarkSettings occlusion;
+};
+
+/*
+	the options that replace the normal run, each also has a --no- form that drops it again
+*/
+const char* const RUN_MODES[] = {
+	"--golden", "--replay", "--latency", "--bindless-bench", "--streaming-bench", "--texture-bench", "--mesh-bench", "--vertex-bench",
+	"--lod-bench", "--scene-bench", "--bvh-bench", "--job-bench", "--robust-bench", "--push-bench", "--particle-bench", "--occlusion-bench",
+};
+
+/*
+	read the runtime options, gathered from the config file, the environment and the command line (see RuntimeConfig.h)
+	the options without a value, --capture and the run modes (RUN_MODES) also have a --no- form that turns them off again,
+	and of the run modes the one given last is run
+		--config <file>             read options from this file, before VULKANTEST_OPTIONS and the command line
+		--validation                enable the validation layer, the default in debug builds
+		--no-validation             disable it, the default in release builds
+		--robust-buffer-access      enable robustBufferAccess on the device, off by default
+		--capture <dir>             capture every rendered frame to <dir>
+		--capture-format ppm|png|raw
+		--capture-frames <n>        stop capturing after n frames
+		--capture-threads <n>       number of encoder threads
+		--capture-ring <n>          number of readback buffers
+		--capture-drop              drop frames instead of waiting when the encoders fall behind
+		--golden <dir>              render the golden scenes headlessly and compare them against the references in <dir>
+		--golden-update             write the rendered images as the new references
+		--golden-out <dir>          where actual images, diff images, timings.csv and report.txt are written
+		--golden-tolerance <n>      largest per channel difference that still matches
+		--golden-max-mismatch <n>   pixels allowed above the tolerance before a scene fails
+		--golden-frames <n>         timed frames per scene
+		--golden-warmup <n>         untimed frames per scene
+		--trace-record <file>       write the first frame's resource creations and commands to a trace file
+		--replay <file>             replay a trace headlessly instead of running the application
+		--replay-frames <n>         timed replays of the traced frame
+		--replay-timings <file>     write the per frame replay timings as csv
+		--no-host-allocator         let the driver use its own host allocator instead of HostAllocator, --host-allocator is the default
+		--host-alloc-report <n>     print the driver's host allocations per frame every n frames
+		--windows <n>               open n windows drawn with one submit and one present per frame
+		--frames-in-flight <n>      frames the CPU may queue ahead of the GPU, 1 to 8
+		--present-mode <mode>       fifo, fifo-relaxed, mailbox or immediate, mailbox when available otherwise
+		--latency                   measure input and submit to present latency for each present mode, then exit
+		--latency-frames <n>        frames measured per present mode, without and with pacing
+		--latency-warmup <n>        frames presented before measuring
+		--pacing-margin <ms>        time the pacer leaves for the GPU between submit and present
+		--on-demand                 only draw when something changed and sleep while idle
+		--usage-report <seconds>    print frame rate, CPU and GPU utilisation every so many seconds
+		--memory-report <seconds>   print device memory per heap against its budget and per subsystem every so many seconds
+		--memory-dump <file>        write device memory and every live allocation as JSON here at exit and when M is pressed
+		--log-repeats <n>           validation messages written per message id, 0 writes every one
+		--log-rate <n>              validation warnings written per second, 0 for no limit
+		--bindless-bench            compare per material descriptor sets against bindless textures headlessly
+		--bindless-materials <n>    number of distinct textures
+		--bindless-draws <n>        quads per frame
+		--bindless-frames <n>       timed frames per path
+		--streaming-bench           stream mip levels of many large textures for a moving camera headlessly
+		--streaming-textures <n>    number of streamed textures
+		--streaming-size <n>        width and height of their largest level
+		--streaming-frames <n>      frames to run
+		--streaming-budget <MB>     resident texture memory budget
+		--streaming-report <n>      print the streaming state every n frames
+		--texture-bench             compare CPU mips, GPU blitted mips and BC1 passthrough texture loading headlessly
+		--texture-size <n>          width and height of the generated textures
+		--texture-count <n>         textures loaded per path
+		--texture-file <file>       also load a .ktx, .dds or .ppm texture
+		--mesh-bench                import an OBJ in parallel and compare vertex cache orders
+		--mesh-file <file>          OBJ to import instead of a generated torus
+		--mesh-threads <n>          import threads, 0 for all
+		--mesh-cache-size <n>       simulated vertex cache size
+		--vertex-bench              compare full precision and packed vertex fetch headlessly
+		--vertex-file <file>        OBJ to draw instead of a generated torus
+		--vertex-copies <n>         draws of the mesh per frame
+		--vertex-frames <n>         timed frames per vertex format
+		--lod-bench                 build a LOD chain and compare full detail with selected levels over an instanced field
+		--lod-file <file>           OBJ to instance instead of a generated sphere
+		--lod-grid <n>              the field is n x n instances
+		--lod-pixel-error <pixels>  largest projected error of a selected level
+		--scene-bench               time scene graph transform propagation
+		--scene-nodes <n>           nodes in the generated hierarchy
+		--scene-threads <n>         update threads, 0 for all
+		--scene-moving <fraction>   share of the nodes moving each frame in the partial update
+		--bvh-bench                 time BVH builds, refits, frustum culling and picking
+		--bvh-objects <n>           boxes in the object hierarchy
+		--bvh-terrain <n>           the picking mesh is an n x n quad terrain
+		--bvh-rays <n>              rays per picking test
+		--bvh-moving <fraction>     share of the objects moved before each refit
+		--job-bench                 time a frame's task graph on the job system from 1 to n threads
+		--job-objects <n>           objects transformed, culled and uploaded every frame
+		--job-views <n>             views culled and recorded every frame
+		--job-threads <n>           largest thread count, 0 for all
+		--job-batch <n>             objects per job
+		--robust-bench              time a load heavy compute shader without and with robust buffer access
+		--robust-elements <n>       invocations and buffer entries
+		--robust-steps <n>          links followed by every invocation
+		--robust-frames <n>         timed dispatches per device
+		--push-bench                time per draw data in push constants against dynamic uniform buffer offsets
+		--push-draws <n>            draws per frame
+		--push-frames <n>           timed frames per path
+		--particle-bench            time the particle step on the CPU and the GPU and check they agree
+		--particle-count <n>        particles simulated
+		--particle-frames <n>       timed steps per path
+		--particle-threads <n>      CPU threads, 0 for all
+		--occlusion-bench           compare frustum culling with one and two phase hi-z occlusion culling on the GPU
+		--occlusion-objects <n>     boxes hidden between the walls
+		--occlusion-frames <n>      timed frames per mode
+*/
+AppOptions parseArguments(const std::vector<ArgumentSource>& sources, RunModes& modes) {
+	AppOptions options;
+	std::string runMode, runModeSource; //the run mode flag given last and where it came from, empty for the application
+	for (const ArgumentSource& source : sources) {
+		const std::vector<std::string>& arguments = source.arguments;
+		auto selectRunMode = [&](const std::string& mode) {
+			if (!runMode.empty() && runMode != mode && runModeSource == source.name) {
+				throw std::runtime_error(runMode + " cannot be combined with " + mode + " in " + source.name + ", only one run mode can be selected");
+			}
+			runMode = mode;
+			runModeSource = source.name;
+		};
+		for (size_t i = 0; i < arguments.size(); i++) {
+			const std::string& arg = arguments[i];
+			auto value = [&]() -> std::string { //the argument following the current option
+				if (i + 1 >= arguments.size()) {
+					throw std::runtime_error("missing value for " + arg);
+				}
+				return arguments[++i];
+			};
+
+			if (arg == "--validation") {
+				options.validation = true;
+			}
+			else if (arg == "--no-validation") {
+				options.validation = false;
+			}
+			else if (arg == "--robust-buffer-access" || arg == "--no-robust-buffer-access") {
+				options.robustBufferAccess = arg == "--robust-buffer-access";
+			}
+			else if (arg == "--capture") {
+				options.capture.enabled = true;
+				options.capture.outputDirectory = value();
+			}
+			else if (arg == "--no-capture") {
+				options.capture.enabled = false;
+			}
+			else if (arg == "--capture-format") {
+				std::string format = value();
+				if (format == "ppm") options.capture.format = CaptureFormat::PPM;
+				else if (format == "png") options.capture.format = CaptureFormat::PNG;
+				else if (format == "raw") options.capture.format = CaptureFormat::RAW;
+				else throw std::runtime_error("unknown capture format " + format);
+			}
+			else if (arg == "--capture-frames") {
+				options.capture.maxFrames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--capture-threads") {
+				options.capture.encoderThreads = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--capture-ring") {
+				options.capture.ringSize = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--capture-drop" || arg == "--no-capture-drop") {
+				options.capture.dropWhenFull = arg == "--capture-drop";
+			}
+			else if (arg == "--golden") {
+				options.golden.referenceDirectory = value();
+				selectRunMode(arg);
+			}
+			else if (arg == "--golden-update" || arg == "--no-golden-update") {
+				options.golden.update = arg == "--golden-update";
+			}
+			else if (arg == "--golden-out") {
+				options.golden.outputDirectory = value();
+			}
+			else if (arg == "--golden-tolerance") {
+				options.golden.tolerance = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--golden-max-mismatch") {
+				options.golden.maxMismatchedPixels = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--golden-frames") {
+				options.golden.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--golden-warmup") {
+				options.golden.warmupFrames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--trace-record") {
+				options.traceFile = value();
+			}
+			else if (arg == "--replay") {
+				modes.replay.traceFile = value();
+				selectRunMode(arg);
+			}
+			else if (arg == "--replay-frames") {
+				modes.replay.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--replay-timings") {
+				modes.replay.timingsFile = value();
+			}
+			else if (arg == "--host-allocator" || arg == "--no-host-allocator") {
+				options.hostAllocator = arg == "--host-allocator";
+			}
+			else if (arg == "--host-alloc-report") {
+				options.hostAllocationReportInterval = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--windows") {
+				options.windowCount = static_cast<uint32_t>(std::stoul(value()));
+				if (options.windowCount == 0) {
+					throw std::runtime_error("--windows needs at least one window");
+				}
+			}
+			else if (arg == "--frames-in-flight") {
+				options.framesInFlight = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--present-mode") {
+				options.presentMode = value();
+			}
+			else if (arg == "--latency") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--latency-frames") {
+				options.latency.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--latency-warmup") {
+				options.latency.warmupFrames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--pacing-margin") {
+				options.latency.pacingMargin = std::stod(value());
+			}
+			else if (arg == "--on-demand" || arg == "--no-on-demand") {
+				options.onDemand = arg == "--on-demand";
+			}
+			else if (arg == "--usage-report") {
+				options.usageReportInterval = std::stod(value());
+			}
+			else if (arg == "--memory-report") {
+				options.memoryReportInterval = std::stod(value());
+			}
+			else if (arg == "--memory-dump") {
+				options.memoryDumpFile = value();
+			}
+			else if (arg == "--log-repeats") {
+				options.validationLog.maxRepeats = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--log-rate") {
+				options.validationLog.maxPerSecond = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--bindless-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--bindless-materials") {
+				modes.bindless.materials = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--bindless-draws") {
+				modes.bindless.draws = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--bindless-frames") {
+				modes.bindless.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--streaming-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--streaming-textures") {
+				modes.streaming.textures = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--streaming-size") {
+				modes.streaming.textureSize = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--streaming-frames") {
+				modes.streaming.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--streaming-budget") {
+				modes.streaming.streaming.budget = static_cast<VkDeviceSize>(std::stoull(value())) << 20;
+			}
+			else if (arg == "--streaming-report") {
+				modes.streaming.reportInterval = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--texture-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--texture-size") {
+				modes.texture.size = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--texture-count") {
+				modes.texture.count = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--texture-file") {
+				modes.texture.file = value();
+			}
+			else if (arg == "--mesh-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--mesh-file") {
+				modes.mesh.file = value();
+			}
+			else if (arg == "--mesh-threads") {
+				modes.mesh.threads = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--mesh-cache-size") {
+				modes.mesh.cacheSize = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--vertex-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--vertex-file") {
+				modes.vertex.file = value();
+			}
+			else if (arg == "--vertex-copies") {
+				modes.vertex.copies = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--vertex-frames") {
+				modes.vertex.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--lod-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--lod-file") {
+				modes.lod.file = value();
+			}
+			else if (arg == "--lod-grid") {
+				modes.lod.grid = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--lod-pixel-error") {
+				modes.lod.pixelError = std::stof(value());
+			}
+			else if (arg == "--scene-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--scene-nodes") {
+				modes.scene.nodes = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--scene-threads") {
+				modes.scene.threads = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--scene-moving") {
+				modes.scene.movingFraction = std::stof(value());
+			}
+			else if (arg == "--bvh-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--bvh-objects") {
+				modes.bvh.objects = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--bvh-terrain") {
+				modes.bvh.terrainSize = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--bvh-rays") {
+				modes.bvh.rays = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--bvh-moving") {
+				modes.bvh.movingFraction = std::stof(value());
+			}
+			else if (arg == "--job-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--job-objects") {
+				modes.jobs.objects = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--job-views") {
+				modes.jobs.views = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--job-threads") {
+				modes.jobs.threads = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--job-batch") {
+				modes.jobs.batch = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--robust-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--robust-elements") {
+				modes.robustness.elements = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--robust-steps") {
+				modes.robustness.steps = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--robust-frames") {
+				modes.robustness.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--push-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--push-draws") {
+				modes.pushConstants.draws = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--push-frames") {
+				modes.pushConstants.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--particle-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--particle-count") {
+				modes.particles.particles = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--particle-frames") {
+				modes.particles.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--particle-threads") {
+				modes.particles.threads = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--occlusion-bench") {
+				selectRunMode(arg);
+			}
+			else if (arg == "--occlusion-objects") {
+				modes.occlusion.objects = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg == "--occlusion-frames") {
+				modes.occlusion.frames = static_cast<uint32_t>(std::stoul(value()));
+			}
+			else if (arg.compare(0, 5, "--no-") == 0 && std::find(std::begin(RUN_MODES), std::end(RUN_MODES), "--" + arg.substr(5)) != std::end(RUN_MODES)) {
+				if (runMode == "--" + arg.substr(5)) {
+					runMode.clear(); //back to the application
+				}
+			}
+			else {
+				throw std::runtime_error("unknown argument " + arg);
+			}
+		}
+	}
+
+	//the golden run, the latency run, a replay and the benchmarks each replace the normal run, only the one selected last is kept
+	options.golden.enabled = runMode == "--golden";
+	options.latency.enabled = runMode == "--latency";
+	if (runMode != "--replay") {
+		modes.replay.traceFile.clear();
+	}
+	modes.bindless.enabled = runMode == "--bindless-bench";
+	modes.streaming.enabled = runMode == "--streaming-bench";
+	modes.texture.enabled = runMode == "--texture-bench";
+	modes.mesh.enabled = runMode == "--mesh-bench";
+	modes.vertex.enabled = runMode == "--vertex-bench";
+	modes.lod.enabled = runMode == "--lod-bench";
+	modes.scene.enabled = runMode == "--scene-bench";
+	modes.bvh.enabled = runMode == "--bvh-bench";
+	modes.jobs.enabled = runMode == "--job-bench";
+	modes.robustness.enabled = runMode == "--robust-bench";
+	modes.pushConstants.enabled = runMode == "--push-bench";
+	modes.particles.enabled = runMode == "--particle-bench";
+	modes.occlusion.enabled = runMode == "--occlusion-bench";
+	if (options.golden.enabled) {
+		if (options.capture.enabled) {
+			throw std::runtime_error("--capture cannot be combined with --golden");
+		}
+		options.headless = true; //the golden run never opens a window
+	}
+	return options;
+}
+
+int main(int argc, char* argv[]) {
 	try {
-		app.run();
+		RunModes modes;
+		AppOptions options = parseArguments(gatherArguments(argc, argv), modes);
+		if (!modes.replay.traceFile.empty()) { //replaying needs none of the application, only the trace
+			TraceReplayer replayer(modes.replay);
+			replayer.run();
+		}
+		else if (modes.bindless.enabled) {
+			BindlessBenchmark benchmark(modes.bindless);
+			benchmark.run();
+		}
+		else if (modes.streaming.enabled) {
+			StreamingBenchmark benchmark(modes.streaming);
+			benchmark.run();
+		}
+		else if (modes.texture.enabled) {
+			TextureBenchmark benchmark(modes.texture);
+			benchmark.run();
+		}
+		else if (modes.mesh.enabled) {
+			MeshBenchmark benchmark(modes.mesh);
+			benchmark.run();
+		}
+		else if (modes.vertex.enabled) {
+			VertexBenchmark benchmark(modes.vertex);
+			benchmark.run();
+		}
+		else if (modes.lod.enabled) {
+			LodBenchmark benchmark(modes.lod);
+			benchmark.run();
+		}
+		else if (modes.scene.enabled) {
+			SceneBenchmark benchmark(modes.scene);
+			benchmark.run();
+		}
+		else if (modes.bvh.enabled) {
+			BvhBenchmark benchmark(modes.bvh);
+			benchmark.run();
+		}
+		else if (modes.jobs.enabled) {
+			JobBenchmark benchmark(modes.jobs);
+			benchmark.run();
+		}
+		else if (modes.robustness.enabled) {
+			RobustnessBenchmark benchmark(modes.robustness);
+			benchmark.run();
+		}
+		else if (modes.pushConstants.enabled) {
+			PushConstantBenchmark benchmark(modes.pushConstants);
+			benchmark.run();
+		}
+		else if (modes.particles.enabled) {
+			ParticleBenchmark benchmark(modes.particles);
+			benchmark.run();
+		}
+		else if (modes.occlusion.enabled) {
+			OcclusionBenchmark benchmark(modes.occlusion);
+			benchmark.run();
+		}
+		else {
+			TriangleApp app(options);
+			app.run();
+		}
 	}
 	catch (std::exception e) {
 		std::cout << e.what() << std::endl;
 		return EXIT_FAILURE;
 	}
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : enable //runtime sized descriptor arrays
+
+layout(set = 1, binding = 0) uniform sampler textureSampler;
+layout(set = 1, binding = 1) uniform texture2D textures[]; //partially bound, sized when the set is allocated
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragMaterial;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    //the material is the same for every fragment of a draw, so the index is dynamically uniform and needs no nonuniformEXT
+    outColor = texture(sampler2D(textures[fragMaterial], textureSampler), fragTexCoord);
+}
@@ -0,0 +1,35 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//per draw data, indexed by the draw's firstInstance so one indirect call can cover draws with different materials
+struct DrawData {
+    vec4 rect; //xy corner, zw size in normalised device coordinates
+    uint material; //texture slot
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Draws {
+    DrawData draws[];
+};
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragMaterial;
+
+vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0),
+    vec2(1.0, 0.0),
+    vec2(1.0, 1.0),
+    vec2(1.0, 1.0),
+    vec2(0.0, 1.0),
+    vec2(0.0, 0.0)
+);
+
+void main() {
+    DrawData draw = draws[gl_InstanceIndex];
+    vec2 corner = corners[gl_VertexIndex];
+    gl_Position = vec4(draw.rect.xy + corner * draw.rect.zw, 0.0, 1.0);
+    fragTexCoord = corner;
+    fragMaterial = draw.material;
+}
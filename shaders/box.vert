@@ -0,0 +1,39 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//one instance per object in a cull.comp draw list, 36 vertices of a box each, no vertex buffer
+struct Object {
+    vec4 center;
+    vec4 extent;
+};
+
+layout(set = 0, binding = 0) readonly buffer Objects { Object objects[]; };
+layout(set = 0, binding = 1) readonly buffer DrawList {
+    uint command[4];
+    uint counters[4];
+    uint visible[];
+} drawList;
+
+layout(push_constant) uniform View {
+    mat4 viewProjection;
+} view;
+
+layout(location = 0) out vec3 fragColor;
+
+//the depth prepass and the colour pass have to produce exactly the same depth
+invariant gl_Position;
+
+const uint faces[36] = uint[](
+    0u, 2u, 1u, 1u, 2u, 3u, 4u, 5u, 6u, 5u, 7u, 6u, //-z, +z
+    0u, 1u, 4u, 1u, 5u, 4u, 2u, 6u, 3u, 3u, 6u, 7u, //-y, +y
+    0u, 4u, 2u, 2u, 4u, 6u, 1u, 3u, 5u, 3u, 7u, 5u //-x, +x
+);
+
+void main() {
+    uint index = drawList.visible[gl_InstanceIndex];
+    uint corner = faces[gl_VertexIndex];
+    vec3 side = vec3((corner & 1u) != 0u ? 1.0 : -1.0, (corner & 2u) != 0u ? 1.0 : -1.0, (corner & 4u) != 0u ? 1.0 : -1.0);
+    gl_Position = view.viewProjection * vec4(objects[index].center.xyz + objects[index].extent.xyz * side, 1.0);
+    uint colour = index * 2654435761u;
+    fragColor = vec3(float(colour & 255u), float((colour >> 8) & 255u), float((colour >> 16) & 255u)) / 255.0 * (0.6 + 0.1 * float(gl_VertexIndex / 12));
+}
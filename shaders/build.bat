@@ -1,3 +1,17 @@
 C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe shader.vert -o vert.spv
 C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe shader.frag -o frag.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe bindless.vert -o bindless_vert.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe bindless.frag -o bindless_frag.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe material.frag -o material_frag.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe mesh.vert -o mesh_vert.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe mesh.frag -o mesh_frag.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe lod.vert -o lod_vert.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe robust.comp -o robust_comp.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe perdraw.vert -o perdraw_push_vert.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe -DDYNAMIC_UNIFORM perdraw.vert -o perdraw_uniform_vert.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe particle.comp -o particle_comp.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe particle.vert -o particle_vert.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe hiz.comp -o hiz_comp.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe cull.comp -o cull_comp.spv
+C:\VulkanSDK\1.2.131.2\Bin32\glslc.exe box.vert -o box_vert.spv
 pause
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//full precision vertex (MeshVertex in Mesh.h) drawn once per instance of the LOD benchmark field
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec4 inColor;
+layout(location = 4) in vec4 inPlacement; //per instance: xyz translation, w uniform scale
+
+layout(push_constant) uniform Transform {
+    mat4 viewProj;
+};
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    gl_Position = viewProj * vec4(inPosition * inPlacement.w + inPlacement.xyz, 1.0);
+    fragColor = inColor.rgb * (0.3 + 0.7 * max(normalize(inNormal).y, 0.0));
+    fragTexCoord = inTexCoord;
+}
@@ -0,0 +1,12 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 1, binding = 0) uniform sampler2D materialTexture; //one descriptor set per material
+
+layout(location = 0) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(materialTexture, fragTexCoord);
+}
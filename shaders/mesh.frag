@@ -0,0 +1,13 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    //a fine checker board, so the texture coordinates have to be fetched and interpolated like a real material would
+    float checker = mod(floor(fragTexCoord.x * 64.0) + floor(fragTexCoord.y * 32.0), 2.0);
+    outColor = vec4(fragColor * (0.75 + 0.25 * checker), 1.0);
+}
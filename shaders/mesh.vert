@@ -0,0 +1,21 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//full precision vertex (MeshVertex in Mesh.h), the reference shader.vert is compared against
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec4 inColor;
+
+layout(push_constant) uniform Transform {
+    mat4 transform;
+};
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    gl_Position = transform * vec4(inPosition, 1.0);
+    fragColor = inColor.rgb * abs(normalize(inNormal).z);
+    fragTexCoord = inTexCoord;
+}
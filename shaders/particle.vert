@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//the particle buffer read as vertices, one point per particle
+layout(push_constant) uniform View {
+    mat4 viewProjection;
+} view;
+
+layout(location = 0) in vec4 inPosition; //xyz, w = age
+layout(location = 1) in vec4 inVelocity; //xyz, w = lifetime
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = view.viewProjection * vec4(inPosition.xyz, 1.0);
+    gl_PointSize = 1.0;
+    float life = clamp(inPosition.w / inVelocity.w, 0.0, 1.0);
+    fragColor = mix(vec3(1.0, 0.8, 0.3), vec3(0.5, 0.1, 0.05), life) * 0.25; //blended additively
+}
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//per draw data (DrawConstants in PushConstantBenchmark.h): pushed with the draw, or with DYNAMIC_UNIFORM defined read
+//from a uniform buffer at the draw's dynamic offset. the members sit directly in the block so that it is 72 bytes in
+//both layouts, a nested struct would be padded to 80 under std140
+#ifdef DYNAMIC_UNIFORM
+layout(set = 0, binding = 0) uniform Draw {
+#else
+layout(push_constant) uniform Draw {
+#endif
+    mat4 transform;
+    uint objectIndex;
+    uint materialId;
+} draw;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+//no vertex buffer, every draw is one small triangle
+const vec2 corners[3] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(0.0, 1.0));
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    gl_Position = draw.transform * vec4(corner, 0.0, 1.0);
+    float material = float(draw.materialId % 16u) / 15.0;
+    fragColor = vec3(material, 1.0 - material, float(draw.objectIndex & 255u) / 255.0);
+    fragTexCoord = corner * 0.5 + 0.5;
+}
@@ -1,21 +1,31 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(location = 0) out vec3 fragColor;
+//packed vertex (PackedVertex in VertexCompression.h), the fixed function fetch has already turned every field into floats
+layout(location = 0) in vec4 inPosition; //unorm16x4, 0..1 within the mesh bounds
+layout(location = 1) in vec2 inNormal; //snorm16x2, octahedral
+layout(location = 2) in vec2 inTexCoord; //half2
+layout(location = 3) in vec4 inColor; //unorm8x4
+
+//model view projection with the dequantization (bounds scale and bias) multiplied in
+layout(push_constant) uniform Transform {
+    mat4 transform;
+};
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-}
\ No newline at end of file
+    gl_Position = transform * vec4(inPosition.xyz, 1.0);
+    vec3 normal = decodeOctahedral(inNormal);
+    fragColor = inColor.rgb * abs(normal.z); //head light, faces looking straight down z keep their colour
+    fragTexCoord = inTexCoord;
+}